@@ -0,0 +1,704 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * LIBRARY CHECKS
+ * Run instead of the training procedure when one of the CHECK_* flags is set (see Makefile).
+**/
+
+#include "pulp_train.h"
+#include "net.h"
+
+
+
+#ifdef CHECK_MHSA_KV
+// Sizes of the MHSA check
+// A full and a partial flash tile, so that the online softmax rescales its partial results
+#define KV_L (MHSA_FLASH_TILE+4)
+#define KV_E 16
+#define KV_HEADS 2
+#define KV_F 8
+#define KV_TOLERANCE 1e-5f
+// The online softmax rescales the partial sums by exp(old_max - new_max), where fastexp (ACT_FAST) is not exact
+#define KV_FLASH_TOLERANCE 1e-4f
+
+// Deterministic data, as there is no golden model for this check
+static uint32_t check_seed = 12345;
+
+static float check_rand()
+{
+  check_seed = check_seed * 1664525 + 1013904223;
+  return (float) (check_seed >> 8) / 16777216.0f - 0.5f;
+}
+
+static void check_fill(float * tensor, int size)
+{
+  for (int i=0; i<size; i++) tensor[i] = check_rand();
+}
+
+PI_L1 float kv_in[KV_L*KV_E], kv_in_diff[KV_L*KV_E];
+PI_L1 float kv_win[KV_E*3*KV_F], kv_win_diff[KV_E*3*KV_F];
+PI_L1 float kv_wout[KV_E*KV_F], kv_wout_diff[KV_E*KV_F];
+PI_L1 float kv_qkv[3*KV_F*KV_L], kv_qkv_diff[3*KV_F*KV_L];
+PI_L1 float kv_att[KV_F*KV_L], kv_att_diff[KV_F*KV_L];
+PI_L1 float kv_out[KV_L*KV_E], kv_out_diff[KV_L*KV_E];
+PI_L1 float kv_head[KV_HEADS*KV_L*KV_L], kv_head_diff[KV_HEADS*KV_L*KV_L];
+PI_L1 float kv_softmax[KV_HEADS*KV_L*KV_L];
+PI_L1 float kv_grad[KV_L*KV_L];
+// Log-sum-exp and delta of the flash forward and backward
+PI_L1 float kv_lse[KV_HEADS*KV_L], kv_delta[KV_HEADS*KV_L];
+// Cache of the incremental forward
+PI_L1 float kv_cache_k[KV_F*KV_L], kv_cache_v[KV_F*KV_L], kv_cache_scores[KV_HEADS*KV_L];
+PI_L1 float kv_token_out[KV_E];
+// Reference results
+PI_L1 float kv_ref_out[KV_L*KV_E], kv_ref_in_diff[KV_L*KV_E], kv_ref_win_diff[KV_E*3*KV_F], kv_ref_wout_diff[KV_E*KV_F];
+PI_L1 float kv_ref_lse[KV_HEADS*KV_L];
+
+/**
+ * Compares the MHSA paths on the same data: pulp_mhsa_fp32_fw_cl()/bw_cl() against the head-parallel and the flash
+ * forward and backward (and the lse saved by the flash forward against the log-sum-exp of the scores of fw_cl()),
+ * then the incremental (KV cache) forward of every token t against row t of pulp_mhsa_fp32_fw_cl() over tokens 0..t.
+ */
+static int check_mhsa_kv()
+{
+  int errors = 0;
+
+  struct blob in, out, win, wout, qkv, att, head, softmax;
+  struct mhsa_kv_cache cache;
+  struct Mhsa_args args;
+
+  check_fill(kv_in, KV_L*KV_E);
+  check_fill(kv_win, KV_E*3*KV_F);
+  check_fill(kv_wout, KV_E*KV_F);
+
+  in.data = kv_in;  in.diff = kv_in_diff;  in.dim = KV_L*KV_E;  in.W = KV_E;  in.H = KV_L;  in.C = 1;
+  out.data = kv_out;  out.diff = kv_out_diff;  out.dim = KV_L*KV_E;  out.W = KV_E;  out.H = KV_L;  out.C = 1;
+  win.data = kv_win;  win.diff = kv_win_diff;  win.dim = KV_E*3*KV_F;
+  wout.data = kv_wout;  wout.diff = kv_wout_diff;  wout.dim = KV_E*KV_F;
+  qkv.data = kv_qkv;  qkv.diff = kv_qkv_diff;  qkv.dim = 3*KV_F*KV_L;
+  att.data = kv_att;  att.diff = kv_att_diff;  att.dim = KV_F*KV_L;  att.W = KV_F;  att.H = KV_L;  att.C = 1;
+  head.data = kv_head;  head.diff = kv_head_diff;  head.dim = KV_HEADS*KV_L*KV_L;
+  softmax.data = kv_softmax;  softmax.dim = KV_HEADS*KV_L*KV_L;
+
+  args.input = &in;
+  args.n_heads = KV_HEADS;
+  args.opt_matmul_type_fw = 0;
+  args.opt_matmul_type_wg = 0;
+  args.opt_matmul_type_ig = 0;
+  args.output = &out;
+  args.coeff_in = &win;
+  args.coeff_out = &wout;
+  args.qkv = &qkv;
+  args.attention_map = &att;
+  args.grad = kv_grad;
+  args.head_buffer = &head;
+  args.softmax_buffer = &softmax;
+  args.kv_cache = &cache;
+  args.lse = kv_lse;
+  args.delta = kv_delta;
+
+  // Full forward and backward against the head-parallel ones
+  check_fill(kv_out_diff, KV_L*KV_E);
+  pulp_mhsa_fp32_fw_cl(&args);
+  pulp_mhsa_fp32_bw_cl(&args);
+  for (int i=0; i<KV_L*KV_E; i++) {kv_ref_out[i] = kv_out[i]; kv_ref_in_diff[i] = kv_in_diff[i];}
+  for (int i=0; i<KV_E*3*KV_F; i++) kv_ref_win_diff[i] = kv_win_diff[i];
+  for (int i=0; i<KV_E*KV_F; i++) kv_ref_wout_diff[i] = kv_wout_diff[i];
+  // head_buffer keeps the scaled scores of every head, keys on the rows and queries on the columns
+  for (int h=0; h<KV_HEADS; h++) {
+    for (int l=0; l<KV_L; l++) {
+      float * scores = kv_head + h*KV_L*KV_L + l;
+      float max = scores[0];
+      for (int j=1; j<KV_L; j++) if (scores[j*KV_L] > max) max = scores[j*KV_L];
+      float sum = 0.0f;
+      for (int j=0; j<KV_L; j++) sum += expf(scores[j*KV_L] - max);
+      kv_ref_lse[h*KV_L+l] = max + logf(sum);
+    }
+  }
+
+  pulp_mhsa_heads_fp32_fw_cl(&args);
+  pulp_mhsa_heads_fp32_bw_cl(&args);
+  errors += verify_tensor(kv_out, kv_ref_out, KV_L*KV_E, KV_TOLERANCE);
+  errors += verify_tensor(kv_in_diff, kv_ref_in_diff, KV_L*KV_E, KV_TOLERANCE);
+  errors += verify_tensor(kv_win_diff, kv_ref_win_diff, KV_E*3*KV_F, KV_TOLERANCE);
+  errors += verify_tensor(kv_wout_diff, kv_ref_wout_diff, KV_E*KV_F, KV_TOLERANCE);
+
+  // Flash (online softmax) forward and backward
+  pulp_mhsa_flash_fp32_fw_cl(&args);
+  pulp_mhsa_flash_fp32_bw_cl(&args);
+  errors += verify_tensor(kv_out, kv_ref_out, KV_L*KV_E, KV_FLASH_TOLERANCE);
+  errors += verify_tensor(kv_lse, kv_ref_lse, KV_HEADS*KV_L, KV_FLASH_TOLERANCE);
+  errors += verify_tensor(kv_in_diff, kv_ref_in_diff, KV_L*KV_E, KV_FLASH_TOLERANCE);
+  errors += verify_tensor(kv_win_diff, kv_ref_win_diff, KV_E*3*KV_F, KV_FLASH_TOLERANCE);
+  errors += verify_tensor(kv_wout_diff, kv_ref_wout_diff, KV_E*KV_F, KV_FLASH_TOLERANCE);
+
+  // Incremental forward, one token at a time, against the full forward over the same prefix
+  cache.k = kv_cache_k;
+  cache.v = kv_cache_v;
+  cache.scores = kv_cache_scores;
+  cache.L_max = KV_L;
+  cache.length = 0;
+  cache.next = 0;
+
+  for (int t=0; t<KV_L; t++) {
+    in.data = kv_in + t*KV_E;  in.H = 1;  in.dim = KV_E;
+    out.data = kv_token_out;  out.H = 1;  out.dim = KV_E;
+    pulp_mhsa_fp32_fw_incremental_cl(&args);
+
+    in.data = kv_in;  in.H = t+1;  in.dim = (t+1)*KV_E;
+    out.data = kv_out;  out.H = t+1;  out.dim = (t+1)*KV_E;
+    att.H = t+1;  att.dim = KV_F*(t+1);
+    pulp_mhsa_fp32_fw_cl(&args);
+    errors += verify_tensor(kv_token_out, kv_out + t*KV_E, KV_E, KV_TOLERANCE);
+  }
+
+  if (errors > 0)
+    printf("\n*** MHSA HEADS, FLASH OR INCREMENTAL NOT MATCHING THE FULL FORWARD/BACKWARD ***\n");
+  else
+    printf("\nMHSA check passed (%d tokens).\n", KV_L);
+
+  return errors;
+}
+
+
+
+// FP16 MHSA on the same data, against the fp32 results of check_mhsa_kv()
+#define KV_FP16_TOLERANCE 2e-2f
+// Largest matrix transposed through the temporary buffer: QKV (3F x L), Win gradient (3F x E) or output (L x E)
+#define KV_TEMP_SIZE (3*KV_F*(KV_L > KV_E ? KV_L : KV_E))
+
+PI_L1 fp16 kv16_in[KV_L*KV_E] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_in_diff[KV_L*KV_E] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_win[KV_E*3*KV_F] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_win_diff[KV_E*3*KV_F] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_wout[KV_E*KV_F] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_wout_diff[KV_E*KV_F] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_qkv[3*KV_F*KV_L] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_qkv_diff[3*KV_F*KV_L] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_att[KV_F*KV_L] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_att_diff[KV_F*KV_L] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_out[KV_L*KV_E] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_out_diff[KV_L*KV_E] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_head[KV_HEADS*KV_L*KV_L] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_head_diff[KV_HEADS*KV_L*KV_L] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_softmax[KV_HEADS*KV_L*KV_L] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_grad[KV_L*KV_L] __attribute__((aligned(4)));
+PI_L1 fp16 kv16_temp[KV_TEMP_SIZE] __attribute__((aligned(4)));
+// Results of pulp_mhsa_fp16_fw_cl()/bw_cl(), converted to fp32
+PI_L1 float kv16_ref_out[KV_L*KV_E], kv16_ref_in_diff[KV_L*KV_E], kv16_ref_win_diff[KV_E*3*KV_F], kv16_ref_wout_diff[KV_E*KV_F];
+
+static void kv_fp16_to_fp32(fp16 * tensor, float * result, int size)
+{
+  for (int i=0; i<size; i++) result[i] = (float) tensor[i];
+}
+
+/**
+ * Runs pulp_mhsa_fp16_fw_cl()/bw_cl() on the data of check_mhsa_kv() and compares them against its fp32 forward
+ * and backward, then compares the head-parallel fp16 forward and backward against fp16 fw_cl()/bw_cl().
+ * Must run after check_mhsa_kv().
+ */
+static int check_mhsa_fp16()
+{
+  int errors = 0;
+
+  struct blob_fp16 in, out, win, wout, qkv, att, head, softmax;
+  struct Mhsa_args_fp16 args;
+
+  for (int i=0; i<KV_L*KV_E; i++) {kv16_in[i] = (fp16) kv_in[i]; kv16_out_diff[i] = (fp16) kv_out_diff[i];}
+  for (int i=0; i<KV_E*3*KV_F; i++) kv16_win[i] = (fp16) kv_win[i];
+  for (int i=0; i<KV_E*KV_F; i++) kv16_wout[i] = (fp16) kv_wout[i];
+
+  in.data = kv16_in;  in.diff = kv16_in_diff;  in.dim = KV_L*KV_E;  in.W = KV_E;  in.H = KV_L;  in.C = 1;
+  out.data = kv16_out;  out.diff = kv16_out_diff;  out.dim = KV_L*KV_E;  out.W = KV_E;  out.H = KV_L;  out.C = 1;
+  win.data = kv16_win;  win.diff = kv16_win_diff;  win.dim = KV_E*3*KV_F;
+  wout.data = kv16_wout;  wout.diff = kv16_wout_diff;  wout.dim = KV_E*KV_F;
+  qkv.data = kv16_qkv;  qkv.diff = kv16_qkv_diff;  qkv.dim = 3*KV_F*KV_L;
+  att.data = kv16_att;  att.diff = kv16_att_diff;  att.dim = KV_F*KV_L;  att.W = KV_F;  att.H = KV_L;  att.C = 1;
+  head.data = kv16_head;  head.diff = kv16_head_diff;  head.dim = KV_HEADS*KV_L*KV_L;
+  softmax.data = kv16_softmax;  softmax.dim = KV_HEADS*KV_L*KV_L;
+
+  args.input = &in;
+  args.n_heads = KV_HEADS;
+  args.opt_matmul_type_fw = 0;
+  args.opt_matmul_type_wg = 0;
+  args.opt_matmul_type_ig = 0;
+  args.output = &out;
+  args.coeff_in = &win;
+  args.coeff_out = &wout;
+  args.qkv = &qkv;
+  args.attention_map = &att;
+  args.temp_buffer = kv16_temp;
+  args.grad = kv16_grad;
+  args.head_buffer = &head;
+  args.softmax_buffer = &softmax;
+
+  // Per-head forward and backward against fp32
+  pulp_mhsa_fp16_fw_cl(&args);
+  pulp_mhsa_fp16_bw_cl(&args);
+  kv_fp16_to_fp32(kv16_out, kv16_ref_out, KV_L*KV_E);
+  kv_fp16_to_fp32(kv16_in_diff, kv16_ref_in_diff, KV_L*KV_E);
+  kv_fp16_to_fp32(kv16_win_diff, kv16_ref_win_diff, KV_E*3*KV_F);
+  kv_fp16_to_fp32(kv16_wout_diff, kv16_ref_wout_diff, KV_E*KV_F);
+  errors += verify_tensor(kv16_ref_out, kv_ref_out, KV_L*KV_E, KV_FP16_TOLERANCE);
+  errors += verify_tensor(kv16_ref_in_diff, kv_ref_in_diff, KV_L*KV_E, KV_FP16_TOLERANCE);
+  errors += verify_tensor(kv16_ref_win_diff, kv_ref_win_diff, KV_E*3*KV_F, KV_FP16_TOLERANCE);
+  errors += verify_tensor(kv16_ref_wout_diff, kv_ref_wout_diff, KV_E*KV_F, KV_FP16_TOLERANCE);
+
+  // Head-parallel forward and backward against the per-head ones (fp32 buffers of check_mhsa_kv() reused for the conversion)
+  pulp_mhsa_heads_fp16_fw_cl(&args);
+  pulp_mhsa_heads_fp16_bw_cl(&args);
+  kv_fp16_to_fp32(kv16_out, kv_out, KV_L*KV_E);
+  kv_fp16_to_fp32(kv16_in_diff, kv_in_diff, KV_L*KV_E);
+  kv_fp16_to_fp32(kv16_win_diff, kv_win_diff, KV_E*3*KV_F);
+  kv_fp16_to_fp32(kv16_wout_diff, kv_wout_diff, KV_E*KV_F);
+  errors += verify_tensor(kv_out, kv16_ref_out, KV_L*KV_E, KV_FP16_TOLERANCE);
+  errors += verify_tensor(kv_in_diff, kv16_ref_in_diff, KV_L*KV_E, KV_FP16_TOLERANCE);
+  errors += verify_tensor(kv_win_diff, kv16_ref_win_diff, KV_E*3*KV_F, KV_FP16_TOLERANCE);
+  errors += verify_tensor(kv_wout_diff, kv16_ref_wout_diff, KV_E*KV_F, KV_FP16_TOLERANCE);
+
+  if (errors > 0)
+    printf("\n*** FP16 MHSA NOT MATCHING FP32 OR HEAD-PARALLEL NOT MATCHING PER-HEAD ***\n");
+  else
+    printf("\nFP16 MHSA check passed (%d tokens).\n", KV_L);
+
+  return errors;
+}
+#endif
+
+
+
+#ifdef CHECK_RNN_FP16
+// Golden model of a tanh nn.RNN, dumped by GM.py (rnn_check = True)
+#include "rnn_data.h"
+#define RNN_TOLERANCE 1e-2f
+#define RNN_TEMP_SIZE (RNN_N*RNN_M + RNN_N*(RNN_K > RNN_M ? RNN_K : RNN_M))
+
+PI_L1 fp16 rnn_in[RNN_N*RNN_K] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_in_diff[RNN_N*RNN_K] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_state[RNN_N*RNN_M] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_out[RNN_N*RNN_M] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_out_diff[RNN_N*RNN_M] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_wx[RNN_K*RNN_M] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_wx_diff[RNN_K*RNN_M] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_ws[RNN_M*RNN_M] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_ws_diff[RNN_M*RNN_M] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_grad[RNN_N*RNN_M] __attribute__((aligned(4)));
+PI_L1 fp16 rnn_temp[RNN_TEMP_SIZE] __attribute__((aligned(4)));
+PI_L1 float rnn_result[RNN_N*RNN_K + RNN_N*RNN_M + RNN_K*RNN_M + RNN_M*RNN_M];
+
+// Compares an fp16 tensor with its fp32 golden model
+static int check_fp16_tensor(fp16 * tensor, float * reference, int size, float tolerance)
+{
+  for (int i=0; i<size; i++) rnn_result[i] = (float) tensor[i];
+  return verify_tensor(rnn_result, reference, size, tolerance);
+}
+
+/**
+ * Compares pulp_rnn_fp16_fw_cl()/bw_cl() (full BPTT) against the outputs and gradients of torch.nn.RNN.
+ */
+static int check_rnn_fp16()
+{
+  int errors = 0;
+
+  struct blob_fp16 in, state, out, wx, ws;
+  struct Rnn_args_fp16 args;
+
+  for (int i=0; i<RNN_N*RNN_K; i++) rnn_in[i] = (fp16) RNN_INPUT[i];
+  for (int i=0; i<RNN_M; i++) rnn_state[i] = (fp16) RNN_H0[i];
+  for (int i=0; i<RNN_K*RNN_M; i++) rnn_wx[i] = (fp16) RNN_WX[i];
+  for (int i=0; i<RNN_M*RNN_M; i++) rnn_ws[i] = (fp16) RNN_WS[i];
+  for (int i=0; i<RNN_N*RNN_M; i++) rnn_out_diff[i] = (fp16) RNN_OUTPUT_DIFF[i];
+
+  in.data = rnn_in;  in.diff = rnn_in_diff;  in.dim = RNN_N*RNN_K;  in.W = RNN_K;  in.H = RNN_N;  in.C = 1;
+  state.data = rnn_state;  state.dim = RNN_N*RNN_M;  state.W = RNN_M;  state.H = RNN_N;  state.C = 1;
+  out.data = rnn_out;  out.diff = rnn_out_diff;  out.dim = RNN_N*RNN_M;  out.W = RNN_M;  out.H = RNN_N;  out.C = 1;
+  wx.data = rnn_wx;  wx.diff = rnn_wx_diff;  wx.dim = RNN_K*RNN_M;  wx.W = RNN_M;  wx.H = RNN_K;  wx.C = 1;
+  ws.data = rnn_ws;  ws.diff = rnn_ws_diff;  ws.dim = RNN_M*RNN_M;  ws.W = RNN_M;  ws.H = RNN_M;  ws.C = 1;
+
+  args.input = &in;
+  args.state = &state;
+  args.output = &out;
+  args.coeff_x = &wx;
+  args.coeff_s = &ws;
+  args.grad_buffer = rnn_grad;
+  args.temp_buffer = rnn_temp;
+  args.bptt_window = 0;
+
+  pulp_rnn_fp16_fw_cl(&args);
+  errors += check_fp16_tensor(rnn_out, RNN_OUTPUT, RNN_N*RNN_M, RNN_TOLERANCE);
+
+  pulp_rnn_fp16_bw_cl(&args);
+  errors += check_fp16_tensor(rnn_in_diff, RNN_INPUT_DIFF, RNN_N*RNN_K, RNN_TOLERANCE);
+  errors += check_fp16_tensor(rnn_wx_diff, RNN_WX_DIFF, RNN_K*RNN_M, RNN_TOLERANCE);
+  errors += check_fp16_tensor(rnn_ws_diff, RNN_WS_DIFF, RNN_M*RNN_M, RNN_TOLERANCE);
+
+  if (errors > 0)
+    printf("\n*** FP16 RNN NOT MATCHING GOLDEN MODEL ***\n");
+  else
+    printf("\nFP16 RNN check passed (N=%d, K=%d, M=%d).\n", RNN_N, RNN_K, RNN_M);
+
+  return errors;
+}
+#endif
+
+
+
+#ifdef CHECK_BF16
+// Golden models of the bf16 primitives, computed by torch in torch.bfloat16 and dumped by GM.py (bf16_check = True)
+#include "bf16_data.h"
+#define BF16_TOLERANCE 2e-2f
+#define BF16_CONV_KER (BF16_CONV_COUT*BF16_CONV_CIN*3*3)
+#define BF16_CONV_IN_SIZE (BF16_CONV_CIN*BF16_CONV_HIN*BF16_CONV_WIN)
+#define BF16_CONV_OUT_SIZE (BF16_CONV_COUT*BF16_CONV_HOUT*BF16_CONV_WOUT)
+#define BF16_LIN_KER (BF16_LIN_OUT*BF16_LIN_IN)
+
+PI_L1 bf16 bf16_mm_a[BF16_MM_N*BF16_MM_K], bf16_mm_b[BF16_MM_K*BF16_MM_M], bf16_mm_c[BF16_MM_N*BF16_MM_M];
+PI_L1 bf16 bf16_conv_in[BF16_CONV_IN_SIZE], bf16_conv_in_diff[BF16_CONV_IN_SIZE];
+PI_L1 bf16 bf16_conv_wgt[BF16_CONV_KER], bf16_conv_wgt_diff[BF16_CONV_KER];
+PI_L1 bf16 bf16_conv_out[BF16_CONV_OUT_SIZE], bf16_conv_out_diff[BF16_CONV_OUT_SIZE];
+PI_L1 bf16 bf16_lin_in[BF16_LIN_IN], bf16_lin_in_diff[BF16_LIN_IN];
+PI_L1 bf16 bf16_lin_wgt[BF16_LIN_KER], bf16_lin_wgt_diff[BF16_LIN_KER];
+PI_L1 bf16 bf16_lin_out[BF16_LIN_OUT], bf16_lin_out_diff[BF16_LIN_OUT];
+PI_L1 bf16 bf16_act_in[BF16_ACT_SIZE], bf16_act_in_diff[BF16_ACT_SIZE];
+PI_L1 bf16 bf16_act_out[BF16_ACT_SIZE], bf16_act_out_diff[BF16_ACT_SIZE];
+PI_L1 bf16 bf16_loss_out[BF16_LOSS_SIZE], bf16_loss_out_diff[BF16_LOSS_SIZE], bf16_loss_target[BF16_LOSS_SIZE];
+PI_L1 float bf16_result[BF16_CONV_IN_SIZE > BF16_LIN_KER ? BF16_CONV_IN_SIZE : BF16_LIN_KER];
+
+// The golden data holds bf16 values, so the conversion is exact
+static void bf16_load(bf16 * tensor, float * data, int size)
+{
+  for (int i=0; i<size; i++) tensor[i] = fp32_to_bf16(data[i]);
+}
+
+// Compares a bf16 tensor with its golden model
+static int check_bf16_tensor(bf16 * tensor, float * reference, int size, float tolerance)
+{
+  for (int i=0; i<size; i++) bf16_result[i] = bf16_to_fp32(tensor[i]);
+  return verify_tensor(bf16_result, reference, size, tolerance);
+}
+
+/**
+ * Compares the bf16 matmul, conv2d, linear, ReLU, sigmoid, MSE, cross entropy and gradient descent against torch.
+ */
+static int check_bf16()
+{
+  int errors = 0;
+
+  // Matmul
+  struct matMul_args_bf16 mm_args;
+  bf16_load(bf16_mm_a, BF16_MM_A, BF16_MM_N*BF16_MM_K);
+  bf16_load(bf16_mm_b, BF16_MM_B, BF16_MM_K*BF16_MM_M);
+  mm_args.A = bf16_mm_a;
+  mm_args.B = bf16_mm_b;
+  mm_args.C = bf16_mm_c;
+  mm_args.N = BF16_MM_N;
+  mm_args.K = BF16_MM_K;
+  mm_args.M = BF16_MM_M;
+  mm_args.trans_B = 0;
+  pi_cl_team_fork(NUM_CORES, mm_bf16, &mm_args);
+  errors += check_bf16_tensor(bf16_mm_c, BF16_MM_C, BF16_MM_N*BF16_MM_M, BF16_TOLERANCE);
+  pi_cl_team_fork(NUM_CORES, mm_M_bf16, &mm_args);
+  errors += check_bf16_tensor(bf16_mm_c, BF16_MM_C, BF16_MM_N*BF16_MM_M, BF16_TOLERANCE);
+
+  // Conv2d (3x3, stride 2, padding 1)
+  struct blob_bf16 conv_in, conv_wgt, conv_out;
+  struct Conv2D_args_bf16 conv_args;
+  bf16_load(bf16_conv_in, BF16_CONV_IN, BF16_CONV_IN_SIZE);
+  bf16_load(bf16_conv_wgt, BF16_CONV_WGT, BF16_CONV_KER);
+  bf16_load(bf16_conv_out_diff, BF16_CONV_OUT_DIFF, BF16_CONV_OUT_SIZE);
+  conv_in.data = bf16_conv_in;  conv_in.diff = bf16_conv_in_diff;  conv_in.dim = BF16_CONV_IN_SIZE;  conv_in.C = BF16_CONV_CIN;  conv_in.H = BF16_CONV_HIN;  conv_in.W = BF16_CONV_WIN;
+  conv_wgt.data = bf16_conv_wgt;  conv_wgt.diff = bf16_conv_wgt_diff;  conv_wgt.dim = BF16_CONV_KER;  conv_wgt.C = BF16_CONV_CIN;  conv_wgt.H = 3;  conv_wgt.W = 3;
+  conv_out.data = bf16_conv_out;  conv_out.diff = bf16_conv_out_diff;  conv_out.dim = BF16_CONV_OUT_SIZE;  conv_out.C = BF16_CONV_COUT;  conv_out.H = BF16_CONV_HOUT;  conv_out.W = BF16_CONV_WOUT;
+  conv_args.input = &conv_in;
+  conv_args.coeff = &conv_wgt;
+  conv_args.output = &conv_out;
+  conv_args.Lpad = 1;
+  conv_args.Rpad = 1;
+  conv_args.Upad = 1;
+  conv_args.Dpad = 1;
+  conv_args.stride_h = 2;
+  conv_args.stride_w = 2;
+  conv_args.skip_in_grad = 0;
+  pulp_conv2d_bf16_fw_cl(&conv_args);
+  errors += check_bf16_tensor(bf16_conv_out, BF16_CONV_OUT, BF16_CONV_OUT_SIZE, BF16_TOLERANCE);
+  pulp_conv2d_bf16_bw_cl(&conv_args);
+  errors += check_bf16_tensor(bf16_conv_wgt_diff, BF16_CONV_WGT_DIFF, BF16_CONV_KER, BF16_TOLERANCE);
+  errors += check_bf16_tensor(bf16_conv_in_diff, BF16_CONV_IN_DIFF, BF16_CONV_IN_SIZE, BF16_TOLERANCE);
+
+  // Linear
+  struct blob_bf16 lin_in, lin_wgt, lin_out;
+  struct Linear_args_bf16 lin_args;
+  bf16_load(bf16_lin_in, BF16_LIN_IN_DATA, BF16_LIN_IN);
+  bf16_load(bf16_lin_wgt, BF16_LIN_WGT, BF16_LIN_KER);
+  bf16_load(bf16_lin_out_diff, BF16_LIN_OUT_DIFF, BF16_LIN_OUT);
+  lin_in.data = bf16_lin_in;  lin_in.diff = bf16_lin_in_diff;  lin_in.dim = BF16_LIN_IN;
+  lin_wgt.data = bf16_lin_wgt;  lin_wgt.diff = bf16_lin_wgt_diff;  lin_wgt.dim = BF16_LIN_KER;
+  lin_out.data = bf16_lin_out;  lin_out.diff = bf16_lin_out_diff;  lin_out.dim = BF16_LIN_OUT;
+  lin_args.input = &lin_in;
+  lin_args.coeff = &lin_wgt;
+  lin_args.output = &lin_out;
+  lin_args.skip_in_grad = 0;
+  pulp_linear_bf16_fw_cl(&lin_args);
+  errors += check_bf16_tensor(bf16_lin_out, BF16_LIN_OUT_DATA, BF16_LIN_OUT, BF16_TOLERANCE);
+  pulp_linear_bf16_bw_cl(&lin_args);
+  errors += check_bf16_tensor(bf16_lin_wgt_diff, BF16_LIN_WGT_DIFF, BF16_LIN_KER, BF16_TOLERANCE);
+  errors += check_bf16_tensor(bf16_lin_in_diff, BF16_LIN_IN_DIFF, BF16_LIN_IN, BF16_TOLERANCE);
+
+  // Gradient descent step on the linear weights (in place, no master copy)
+  struct optim_args_bf16 opt_args;
+  opt_args.weights = &lin_wgt;
+  opt_args.learning_rate = BF16_LR;
+  opt_args.master = NULL;
+  pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_bf16, &opt_args);
+  errors += check_bf16_tensor(bf16_lin_wgt, BF16_LIN_WGT_UPDATED, BF16_LIN_KER, BF16_TOLERANCE);
+
+  // ReLU and sigmoid
+  struct blob_bf16 act_in, act_out;
+  struct act_args_bf16 act_args;
+  bf16_load(bf16_act_in, BF16_ACT_IN, BF16_ACT_SIZE);
+  bf16_load(bf16_act_out_diff, BF16_ACT_OUT_DIFF, BF16_ACT_SIZE);
+  act_in.data = bf16_act_in;  act_in.diff = bf16_act_in_diff;  act_in.dim = BF16_ACT_SIZE;
+  act_out.data = bf16_act_out;  act_out.diff = bf16_act_out_diff;  act_out.dim = BF16_ACT_SIZE;
+  act_args.input = &act_in;
+  act_args.output = &act_out;
+  pulp_relu_bf16_fw_cl(&act_args);
+  errors += check_bf16_tensor(bf16_act_out, BF16_RELU_OUT, BF16_ACT_SIZE, BF16_TOLERANCE);
+  pulp_relu_bf16_bw_cl(&act_args);
+  errors += check_bf16_tensor(bf16_act_in_diff, BF16_RELU_IN_DIFF, BF16_ACT_SIZE, BF16_TOLERANCE);
+  pulp_sigmoid_bf16_fw_cl(&act_args);
+  errors += check_bf16_tensor(bf16_act_out, BF16_SIGMOID_OUT, BF16_ACT_SIZE, BF16_TOLERANCE);
+  pulp_sigmoid_bf16_bw_cl(&act_args);
+  errors += check_bf16_tensor(bf16_act_in_diff, BF16_SIGMOID_IN_DIFF, BF16_ACT_SIZE, BF16_TOLERANCE);
+
+  // MSE and cross entropy (the loss is returned in fp32)
+  struct blob_bf16 loss_out;
+  struct loss_args_bf16 loss_args;
+  float loss = 0;
+  bf16_load(bf16_loss_out, BF16_MSE_OUT, BF16_LOSS_SIZE);
+  bf16_load(bf16_loss_target, BF16_LOSS_TARGET, BF16_LOSS_SIZE);
+  loss_out.data = bf16_loss_out;  loss_out.diff = bf16_loss_out_diff;  loss_out.dim = BF16_LOSS_SIZE;
+  loss_args.output = &loss_out;
+  loss_args.target = bf16_loss_target;
+  loss_args.wr_loss = &loss;
+  pulp_MSELoss_bf16(&loss_args);
+  errors += verify_tensor(&loss, &BF16_MSE_LOSS, 1, BF16_TOLERANCE);
+  errors += check_bf16_tensor(bf16_loss_out_diff, BF16_MSE_OUT_DIFF, BF16_LOSS_SIZE, BF16_TOLERANCE);
+  bf16_load(bf16_loss_out, BF16_CE_OUT, BF16_LOSS_SIZE);
+  bf16_load(bf16_loss_target, BF16_CE_TARGET, BF16_LOSS_SIZE);
+  pulp_CrossEntropyLoss_bf16(&loss_args);
+  errors += verify_tensor(&loss, &BF16_CE_LOSS, 1, BF16_TOLERANCE);
+  errors += check_bf16_tensor(bf16_loss_out_diff, BF16_CE_OUT_DIFF, BF16_LOSS_SIZE, BF16_TOLERANCE);
+
+  if (errors > 0)
+    printf("\n*** BF16 PRIMITIVES NOT MATCHING GOLDEN MODEL ***\n");
+  else
+    printf("\nBF16 check passed (matmul, conv2d, linear, gradient descent, ReLU, sigmoid, MSE, cross entropy).\n");
+
+  return errors;
+}
+#endif
+
+
+#ifdef CHECK_NET_OFFLOAD
+// Chain of conv2d (3x3, padding 1) and ReLU layers with the same activation size, so that activations 1..N-1-OFFLOAD_WINDOW go to L2
+#define OFF_LAYERS 6
+#define OFF_C 4
+#define OFF_HW 4
+#define OFF_ACT (OFF_C*OFF_HW*OFF_HW)
+#define OFF_KER (OFF_C*OFF_C*3*3)
+#define OFF_CONVS (OFF_LAYERS/2)
+#define OFF_TOLERANCE 1e-5f
+
+// Deterministic data, as there is no golden model for this check
+static uint32_t off_seed = 12345;
+
+static void off_fill(float * tensor, int size)
+{
+  for (int i=0; i<size; i++) {
+    off_seed = off_seed * 1664525 + 1013904223;
+    tensor[i] = (float) (off_seed >> 8) / 16777216.0f - 0.5f;
+  }
+}
+
+PI_L1 float off_act[OFF_LAYERS+1][OFF_ACT], off_act_diff[OFF_LAYERS+1][OFF_ACT];
+PI_L1 float off_ker[OFF_CONVS][OFF_KER], off_ker_diff[OFF_CONVS][OFF_KER];
+PI_L1 float off_i2c[OFF_C*3*3*OFF_HW*OFF_HW], off_bt[OFF_KER];
+PI_L1 float off_window[OFFLOAD_WINDOW*OFF_ACT];
+PI_L2 float off_l2[OFF_LAYERS*OFF_ACT];
+// Results of the run without offload
+PI_L1 float off_ref_out[OFF_ACT], off_ref_ker_diff[OFF_CONVS][OFF_KER];
+
+PI_L1 struct blob off_blobs[OFF_LAYERS+1], off_wgt[OFF_CONVS];
+PI_L1 struct Conv2D_args off_conv_args[OFF_CONVS];
+PI_L1 struct act_args off_relu_args[OFF_CONVS];
+PI_L1 struct net_layer off_layers[OFF_LAYERS];
+PI_L1 struct net_args off_net;
+
+// Forward and backward of the chain, from freshly cleared gradients
+static void off_step(struct net_args * net)
+{
+  for (int c=0; c<OFF_CONVS; c++)
+    for (int i=0; i<OFF_KER; i++) off_ker_diff[c][i] = 0;
+  for (int k=0; k<OFF_LAYERS; k++)
+    for (int i=0; i<OFF_ACT; i++) off_act_diff[k][i] = 0;
+
+  pulp_net_fp32_fw(net);
+  pulp_net_fp32_bw(net);
+}
+
+/**
+ * Runs the forward and backward of a chain of OFF_LAYERS layers with the activations offloaded to L2
+ * (pulp_net_offload_bind()) and compares the output and the weight gradients against the run with every
+ * activation in L1.
+ */
+static int check_net_offload()
+{
+  int errors = 0;
+
+  for (int k=0; k<=OFF_LAYERS; k++) {
+    off_blobs[k].data = off_act[k];  off_blobs[k].diff = off_act_diff[k];  off_blobs[k].dim = OFF_ACT;
+    off_blobs[k].C = OFF_C;  off_blobs[k].H = OFF_HW;  off_blobs[k].W = OFF_HW;
+  }
+  off_fill(off_act[0], OFF_ACT);
+  off_fill(off_act_diff[OFF_LAYERS], OFF_ACT);
+
+  for (int k=0; k<OFF_LAYERS; k++) {
+    struct net_layer * layer = &off_layers[k];
+    int c = k/2;
+    layer->input = &off_blobs[k];
+    layer->output = &off_blobs[k+1];
+    layer->trainable = 1;
+    layer->fw_cost = 0;
+    layer->update_rows = NULL;
+    layer->num_update_rows = 0;
+    layer->bias = NULL;
+    layer->lora_A = NULL;
+    layer->lora_B = NULL;
+    layer->skip_wgt_grad = 0;
+
+    if (k % 2 == 0) {
+      struct Conv2D_args * args = &off_conv_args[c];
+      off_fill(off_ker[c], OFF_KER);
+      off_wgt[c].data = off_ker[c];  off_wgt[c].diff = off_ker_diff[c];  off_wgt[c].dim = OFF_KER;
+      off_wgt[c].C = OFF_C;  off_wgt[c].H = 3;  off_wgt[c].W = 3;
+      args->input = &off_blobs[k];
+      args->coeff = &off_wgt[c];
+      args->output = &off_blobs[k+1];
+      args->Lpad = 1;  args->Rpad = 1;  args->Upad = 1;  args->Dpad = 1;
+      args->stride_h = 1;  args->stride_w = 1;
+      args->i2c_buffer = off_i2c;
+      args->bt_buffer = off_bt;
+      args->skip_in_grad = (k == 0);
+      args->HWC = 0;
+      args->opt_matmul_type_fw = 0;  args->opt_matmul_type_wg = 0;  args->opt_matmul_type_ig = 0;
+      args->USE_IM2COL = 1;
+      args->USE_DMA_IM2COL = 0;
+      args->update_rows = NULL;
+      args->num_update_rows = 0;
+      args->bias = NULL;
+      args->skip_wgt_grad = 0;
+      args->lora_A = NULL;
+      args->lora_B = NULL;
+      layer->fw = pulp_conv2d_fp32_fw_cl;
+      layer->bw = pulp_conv2d_fp32_bw_cl;
+      layer->bw_param = pulp_conv2d_fp32_bw_param_grads_cl;
+      layer->bw_input = pulp_conv2d_fp32_bw_input_grads_cl;
+      layer->args = args;
+      layer->coeff = &off_wgt[c];
+    }
+    else {
+      off_relu_args[c].input = &off_blobs[k];
+      off_relu_args[c].output = &off_blobs[k+1];
+      layer->fw = pulp_relu_fp32_fw_cl;
+      layer->bw = pulp_relu_fp32_bw_cl;
+      layer->bw_param = NULL;
+      layer->bw_input = NULL;
+      layer->args = &off_relu_args[c];
+      layer->coeff = NULL;
+    }
+  }
+
+  off_net.layers = off_layers;
+  off_net.num_layers = OFF_LAYERS;
+  off_net.checkpoint = NULL;
+  off_net.arena = NULL;
+  off_net.offload = 0;
+  off_net.l2_buffer = NULL;
+
+  // Every activation in L1
+  off_step(&off_net);
+  for (int i=0; i<OFF_ACT; i++) off_ref_out[i] = off_act[OFF_LAYERS][i];
+  for (int c=0; c<OFF_CONVS; c++)
+    for (int i=0; i<OFF_KER; i++) off_ref_ker_diff[c][i] = off_ker_diff[c][i];
+
+  // Activations in a window of OFFLOAD_WINDOW L1 slots, parked in L2 between forward and backward
+  int window_size = 0, l2_size = 0;
+  pulp_net_offload_size(&off_net, &window_size, &l2_size);
+  if (window_size > OFFLOAD_WINDOW*OFF_ACT || l2_size > OFF_LAYERS*OFF_ACT || l2_size == 0) {
+    printf("\n*** OFFLOAD BUFFERS NOT MATCHING THE CHAIN (window %d, L2 %d) ***\n", window_size, l2_size);
+    return 1;
+  }
+  off_net.offload = 1;
+  off_net.arena = off_window;
+  off_net.l2_buffer = off_l2;
+  pulp_net_offload_bind(&off_net);
+
+  for (int i=0; i<OFF_ACT; i++) off_act[OFF_LAYERS][i] = 0;
+  off_step(&off_net);
+  errors += verify_tensor(off_act[OFF_LAYERS], off_ref_out, OFF_ACT, OFF_TOLERANCE);
+  for (int c=0; c<OFF_CONVS; c++)
+    errors += verify_tensor(off_ker_diff[c], off_ref_ker_diff[c], OFF_KER, OFF_TOLERANCE);
+
+  if (errors > 0)
+    printf("\n*** OFFLOADED FORWARD/BACKWARD NOT MATCHING THE RUN IN L1 ***\n");
+  else
+    printf("\nOffload check passed (%d layers, %d activation elements in L2).\n", OFF_LAYERS, l2_size);
+
+  return errors;
+}
+#endif
+
+
+
+// Runs the enabled checks on the cluster
+void check_step()
+{
+  int errors = 0;
+
+  #ifdef CHECK_MHSA_KV
+  printf("\nChecking MHSA full, head-parallel, flash and incremental forward..\n");
+  errors += check_mhsa_kv();
+  printf("\nChecking FP16 MHSA per-head and head-parallel forward/backward..\n");
+  errors += check_mhsa_fp16();
+  #endif
+
+  #ifdef CHECK_RNN_FP16
+  printf("\nChecking FP16 RNN against the golden model..\n");
+  errors += check_rnn_fp16();
+  #endif
+
+  #ifdef CHECK_BF16
+  printf("\nChecking BF16 primitives against the golden model..\n");
+  errors += check_bf16();
+  #endif
+
+  #ifdef CHECK_NET_OFFLOAD
+  printf("\nChecking activation offload against the run in L1..\n");
+  errors += check_net_offload();
+  #endif
+
+  printf("\nChecks done: %d failed.\n", errors);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Activation functions configuration structure
+ */
+
+/**
+ * @brief Structure for activation functions
+ * @param input blob structure for the input data of the activation layer
+ * @param output blob structure for the output data of the activation layer
+ */
+struct act_args_bf16 {
+    struct blob_bf16 * input;
+    struct blob_bf16 * output;
+};
+
+
+
+/**
+ * Parallel activation functions in BF16, both FW and BW. The math is done in fp32.
+ * Call them from the cluster master core: they fork internally on NUM_CORES. 
+ **/
+
+/**
+ * @brief ReLU forward.
+ * @param act_args_bf16 pointer to an act_args_bf16 structure
+*/
+void pulp_relu_bf16_fw_cl( void * act_args_bf16 );
+
+/**
+ * @brief ReLU backward.
+ * @param act_args_bf16 pointer to an act_args_bf16 structure
+*/
+void pulp_relu_bf16_bw_cl( void * act_args_bf16 );
+
+/**
+ * @brief Sigmoid forward, output = 1/(1+exp(-input)). The approximation is selected by ACT_APPROX (see pulp_train_defines.h).
+ * @param act_args_bf16 pointer to an act_args_bf16 structure
+*/
+void pulp_sigmoid_bf16_fw_cl( void * act_args_bf16 );
+
+/**
+ * @brief Sigmoid backward, computed from the output of the forward.
+ * @param act_args_bf16 pointer to an act_args_bf16 structure
+*/
+void pulp_sigmoid_bf16_bw_cl( void * act_args_bf16 );
+
+
+/**
+ * @brief Parallel cores of the activation functions above. Use pi_cl_team_fork(NUM_CORES, xxx_core_fw_bf16, &args) to call them directly.
+ */
+void relu_core_fw_bf16( void * act_args_bf16 );
+void relu_core_bw_bf16( void * act_args_bf16 );
+void sigmoid_core_fw_bf16( void * act_args_bf16 );
+void sigmoid_core_bw_bf16( void * act_args_bf16 );
@@ -18,6 +18,8 @@
  * Authors: Davide Nadalini, Leonardo Ravaglia
 */ 
 
+#include "math.h"
+
 /**
  * Activation functions configuration structure
  */
@@ -32,6 +34,18 @@ struct act_args_fp16 {
     struct blob_fp16 * output;
 };
 
+/**
+ * @brief Structure for the LeakyReLU activation function
+ * @param input blob structure for the input data of the activation layer
+ * @param output blob structure for the output data of the activation layer
+ * @param negative_slope slope of the activation for negative inputs
+ */
+struct leakyrelu_args_fp16 {
+    struct blob_fp16 * input;
+    struct blob_fp16 * output;
+    fp16 negative_slope;
+};
+
 
 
 /**
@@ -66,4 +80,176 @@ void pulp_softmax_fp16_fw_cl( void * act_args_fp16 );
  * @param input Input for softmax.
  * @param output Output of softmax.
 */
-void pulp_softmax_fp16_bw_cl( void * act_args_fp16 );
\ No newline at end of file
+void pulp_softmax_fp16_bw_cl( void * act_args_fp16 );
+
+/**
+ * @brief Forward pass function that parallelizes the fp16 tanh (selected by ACT_APPROX) on a vector.
+ * @param pointer to a tanh_args_fp16 struct
+*/
+void tanh_prll_fp16(
+    void * args
+);
+
+
+
+/**
+ * Parallel SIMD activation functions, both FW and BW. 
+ * Call them from the cluster master core: they fork internally on NUM_CORES. 
+ * Data are processed as v2f16 pairs (tensors must be 4-byte aligned). 
+ * The tanh/sigmoid approximation is selected at compile time with ACT_APPROX (see pulp_train_defines.h).
+ **/
+
+/**
+ * @brief Sigmoid forward, output = 1/(1+exp(-input)).
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_sigmoid_fp16_fw_cl( void * act_args_fp16 );
+
+/**
+ * @brief Sigmoid backward, computed from the forward output: in_diff = out_diff * out * (1-out).
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_sigmoid_fp16_bw_cl( void * act_args_fp16 );
+
+/**
+ * @brief Tanh forward.
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_tanh_fp16_fw_cl( void * act_args_fp16 );
+
+/**
+ * @brief Tanh backward, computed from the forward output: in_diff = out_diff * (1-out^2).
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_tanh_fp16_bw_cl( void * act_args_fp16 );
+
+/**
+ * @brief GELU forward (tanh approximation).
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_gelu_fp16_fw_cl( void * act_args_fp16 );
+
+/**
+ * @brief GELU backward (tanh approximation), computed from the forward input.
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_gelu_fp16_bw_cl( void * act_args_fp16 );
+
+/**
+ * @brief SiLU (Swish) forward, output = x*sigmoid(x).
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_silu_fp16_fw_cl( void * act_args_fp16 );
+
+/**
+ * @brief SiLU (Swish) backward, computed from the forward input.
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_silu_fp16_bw_cl( void * act_args_fp16 );
+
+/**
+ * @brief LeakyReLU forward, output = x>0 ? x : negative_slope*x.
+ * @param leakyrelu_args_fp16 pointer to a leakyrelu_args_fp16 structure
+*/
+void pulp_leakyrelu_fp16_fw_cl( void * leakyrelu_args_fp16 );
+
+/**
+ * @brief LeakyReLU backward.
+ * @param leakyrelu_args_fp16 pointer to a leakyrelu_args_fp16 structure
+*/
+void pulp_leakyrelu_fp16_bw_cl( void * leakyrelu_args_fp16 );
+
+/**
+ * @brief ReLU6 forward, output = min(max(x,0),6).
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_relu6_fp16_fw_cl( void * act_args_fp16 );
+
+/**
+ * @brief ReLU6 backward.
+ * @param act_args_fp16 pointer to an act_args_fp16 structure
+*/
+void pulp_relu6_fp16_bw_cl( void * act_args_fp16 );
+
+/**
+ * @brief Parallel cores of the activation functions above. Use pi_cl_team_fork(NUM_CORES, xxx_core_fw_fp16, &args) to call them directly.
+ * @param act_args_fp16 pointer to an act_args_fp16 (leakyrelu_args_fp16 for LeakyReLU) structure
+ */
+void sigmoid_core_fw_fp16( void * act_args_fp16 );
+void sigmoid_core_bw_fp16( void * act_args_fp16 );
+void tanh_core_fw_fp16( void * act_args_fp16 );
+void tanh_core_bw_fp16( void * act_args_fp16 );
+void gelu_core_fw_fp16( void * act_args_fp16 );
+void gelu_core_bw_fp16( void * act_args_fp16 );
+void silu_core_fw_fp16( void * act_args_fp16 );
+void silu_core_bw_fp16( void * act_args_fp16 );
+void leakyrelu_core_fw_fp16( void * leakyrelu_args_fp16 );
+void leakyrelu_core_bw_fp16( void * leakyrelu_args_fp16 );
+void relu6_core_fw_fp16( void * act_args_fp16 );
+void relu6_core_bw_fp16( void * act_args_fp16 );
+
+
+
+/**
+ * Fast fp16 transcendental functions
+ **/
+
+/**
+ * @brief Rational (Pade) approximation of tanh, x*(27+x^2)/(27+9x^2), exact at the +-3 clipping points. Uses only fp16 multiplications, additions and a division.
+ * @param fp16 value
+*/
+static inline fp16 fasttanh_fp16 (fp16 p)
+{
+  fp16 c = (p > (fp16) 3.0f) ? (fp16) 3.0f : ((p < (fp16) -3.0f) ? (fp16) -3.0f : p);
+  fp16 c2 = c * c;
+  return c * ((fp16) 27.0f + c2) / ((fp16) 27.0f + (fp16) 9.0f * c2);
+}
+
+/**
+ * @brief SIMD version of fasttanh_fp16(), computing the tanh of two packed fp16 values.
+ * @param v2f16 packed values
+*/
+static inline v2f16 fasttanh_v2f16 (v2f16 p)
+{
+  v2f16 k27 = (v2f16) {27.0f, 27.0f};
+  v2f16 k9  = (v2f16) {9.0f, 9.0f};
+  v2f16 c;
+  c[0] = (p[0] > (fp16) 3.0f) ? (fp16) 3.0f : ((p[0] < (fp16) -3.0f) ? (fp16) -3.0f : p[0]);
+  c[1] = (p[1] > (fp16) 3.0f) ? (fp16) 3.0f : ((p[1] < (fp16) -3.0f) ? (fp16) -3.0f : p[1]);
+  v2f16 c2 = c * c;
+  return c * (k27 + c2) / (k27 + k9 * c2);
+}
+
+/**
+ * @brief Tanh and sigmoid selected by ACT_APPROX (rational approximation or libm), scalar and SIMD. Use them inside the kernels of the library.
+ * @param fp16 / v2f16 value
+*/
+static inline fp16 act_tanh_fp16 (fp16 p)
+{
+  #if ACT_APPROX == ACT_FAST
+  return fasttanh_fp16(p);
+  #else
+  return (fp16) tanhf((float) p);
+  #endif
+}
+
+static inline v2f16 act_tanh_v2f16 (v2f16 p)
+{
+  #if ACT_APPROX == ACT_FAST
+  return fasttanh_v2f16(p);
+  #else
+  return (v2f16) {(fp16) tanhf((float) p[0]), (fp16) tanhf((float) p[1])};
+  #endif
+}
+
+static inline fp16 act_sigmoid_fp16 (fp16 p)
+{
+  // sigmoid(x) = 0.5 + 0.5*tanh(x/2)
+  return (fp16) 0.5f + (fp16) 0.5f * act_tanh_fp16((fp16) 0.5f * p);
+}
+
+static inline v2f16 act_sigmoid_v2f16 (v2f16 p)
+{
+  v2f16 half = (v2f16) {0.5f, 0.5f};
+  return half + half * act_tanh_v2f16(half * p);
+}
@@ -18,6 +18,8 @@
  * Authors: Davide Nadalini, Leonardo Ravaglia, Alberto Dequino
 */ 
 
+#include "math.h"
+
 /**
  * Activation functions configuration structure
  */
@@ -32,6 +34,18 @@ struct act_args {
     struct blob * output;
 };
 
+/**
+ * @brief Structure for the LeakyReLU activation function
+ * @param input blob structure for the input data of the activation layer
+ * @param output blob structure for the output data of the activation layer
+ * @param negative_slope slope of the activation for negative inputs
+ */
+struct leakyrelu_args {
+    struct blob * input;
+    struct blob * output;
+    float negative_slope;
+};
+
 /**
  * @brief Arguments for exponential and softmax in parallel
  * @param input   pointer to input vector
@@ -107,28 +121,178 @@ void tanh_prll(
 );
 
 
+
 /**
- * @brief A tanh implementation exploiting bit manipulation and "magic numbers" to be a bit faster.
- * @param float value
+ * Parallel activation functions, both FW and BW. 
+ * Call them from the cluster master core: they fork internally on NUM_CORES. 
+ * The exp/tanh approximation is selected at compile time with ACT_APPROX (see pulp_train_defines.h).
+ **/
+
+/**
+ * @brief Sigmoid forward, output = 1/(1+exp(-input)).
+ * @param act_args pointer to an act_args structure
 */
-static inline float fasttanh (
-    float p
-);
+void pulp_sigmoid_fp32_fw_cl( void * act_args );
+
+/**
+ * @brief Sigmoid backward, computed from the forward output: in_diff = out_diff * out * (1-out).
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_sigmoid_fp32_bw_cl( void * act_args );
+
+/**
+ * @brief Tanh forward.
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_tanh_fp32_fw_cl( void * act_args );
+
+/**
+ * @brief Tanh backward, computed from the forward output: in_diff = out_diff * (1-out^2).
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_tanh_fp32_bw_cl( void * act_args );
+
+/**
+ * @brief GELU forward (tanh approximation), output = 0.5*x*(1+tanh(sqrt(2/pi)*(x+0.044715*x^3))).
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_gelu_fp32_fw_cl( void * act_args );
+
+/**
+ * @brief GELU backward (tanh approximation), computed from the forward input.
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_gelu_fp32_bw_cl( void * act_args );
+
+/**
+ * @brief SiLU (Swish) forward, output = x*sigmoid(x).
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_silu_fp32_fw_cl( void * act_args );
+
+/**
+ * @brief SiLU (Swish) backward, computed from the forward input.
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_silu_fp32_bw_cl( void * act_args );
+
+/**
+ * @brief LeakyReLU forward, output = x>0 ? x : negative_slope*x.
+ * @param leakyrelu_args pointer to a leakyrelu_args structure
+*/
+void pulp_leakyrelu_fp32_fw_cl( void * leakyrelu_args );
+
+/**
+ * @brief LeakyReLU backward.
+ * @param leakyrelu_args pointer to a leakyrelu_args structure
+*/
+void pulp_leakyrelu_fp32_bw_cl( void * leakyrelu_args );
+
+/**
+ * @brief ReLU6 forward, output = min(max(x,0),6).
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_relu6_fp32_fw_cl( void * act_args );
+
+/**
+ * @brief ReLU6 backward.
+ * @param act_args pointer to an act_args structure
+*/
+void pulp_relu6_fp32_bw_cl( void * act_args );
+
+/**
+ * @brief Parallel cores of the activation functions above. Use pi_cl_team_fork(NUM_CORES, xxx_core_fw_fp32, &args) to call them directly.
+ * @param act_args pointer to an act_args (leakyrelu_args for LeakyReLU) structure
+ */
+void sigmoid_core_fw_fp32( void * act_args );
+void sigmoid_core_bw_fp32( void * act_args );
+void tanh_core_fw_fp32( void * act_args );
+void tanh_core_bw_fp32( void * act_args );
+void gelu_core_fw_fp32( void * act_args );
+void gelu_core_bw_fp32( void * act_args );
+void silu_core_fw_fp32( void * act_args );
+void silu_core_bw_fp32( void * act_args );
+void leakyrelu_core_fw_fp32( void * leakyrelu_args );
+void leakyrelu_core_bw_fp32( void * leakyrelu_args );
+void relu6_core_fw_fp32( void * act_args );
+void relu6_core_bw_fp32( void * act_args );
+
+
+
+/**
+ * Fast transcendental functions
+ **/
 
 /**
  * @brief A power of 2 implementation exploiting bit manipulation and "magic numbers" to be a bit faster.
  * @param float value
 */
-static inline float fastpow2 (
-    float p
-);
+static inline float fastpow2 (float p)
+{
+  float offset = (p < 0) ? 1.0f : 0.0f;
+  // Clip both ends to keep the result inside the range of the exponent field
+  float clipp = (p < -126) ? -126.0f : ((p > 126) ? 126.0f : p);
+  int w = clipp;
+  float z = clipp - w + offset;
+  union { uint32_t i; float f; } v = { (uint32_t) ( (1 << 23) * (clipp + 121.2740575f + 27.7280233f / (4.84252568f - z) - 1.49012907f * z) ) };
+
+  return v.f;
+}
 
 /**
  * @brief An exponential implementation exploiting bit manipulation and "magic numbers" to be a bit faster.
  * @param float value
 */
-static inline float fastexp (
-    float p
-);
+static inline float fastexp (float p)
+{
+  return fastpow2 (1.442695040f * p);
+}
+
+/**
+ * @brief A tanh implementation exploiting bit manipulation and "magic numbers" to be a bit faster.
+ * @param float value
+*/
+static inline float fasttanh (float p)
+{
+  return -1.0f + 2.0f / (1.0f + fastexp (-2.0f * p));
+}
+
+/**
+ * @brief A sigmoid implementation built on fastexp().
+ * @param float value
+*/
+static inline float fastsigmoid (float p)
+{
+  return 1.0f / (1.0f + fastexp (-p));
+}
+
+/**
+ * @brief Exponential, tanh and sigmoid selected by ACT_APPROX (fast approximation or libm). Use them inside the kernels of the library.
+ * @param float value
+*/
+static inline float act_exp (float p)
+{
+  #if ACT_APPROX == ACT_FAST
+  return fastexp(p);
+  #else
+  return expf(p);
+  #endif
+}
 
+static inline float act_tanh (float p)
+{
+  #if ACT_APPROX == ACT_FAST
+  return fasttanh(p);
+  #else
+  return tanhf(p);
+  #endif
+}
 
+static inline float act_sigmoid (float p)
+{
+  #if ACT_APPROX == ACT_FAST
+  return fastsigmoid(p);
+  #else
+  return 1.0f / (1.0f + expf(-p));
+  #endif
+}
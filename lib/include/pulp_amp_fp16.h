@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Mixed-precision training. Forward and backward run on the fp16 primitives, while the optimizer updates fp32 master
+ * copies of the weights. To keep small gradients representable in fp16, the output gradient is multiplied by a loss
+ * scale, which is removed in the update. The scale is adapted at run time (dynamic loss scaling):
+ *
+ *   fp32 loss -> output grad * scale (fp16) -> fp16 backward -> overflow/NaN in the grads ? scale * backoff, skip the step
+ *                                                                                         : master -= lr/scale * grad,
+ *                                                                                           weights = (fp16) master
+ *
+ * and the scale grows by growth_factor after growth_interval steps without overflow.
+ */
+
+/**
+ * @brief Dynamic loss scaling state
+ * @param scale current loss scale
+ * @param growth_factor factor applied to the scale after growth_interval steps without overflow (e.g. 2)
+ * @param backoff_factor factor applied to the scale when the gradients overflow (e.g. 0.5)
+ * @param growth_interval number of consecutive steps without overflow before the scale grows
+ * @param min_scale lower bound of the scale
+ * @param max_scale upper bound of the scale
+ * @param flags L1 array of NUM_CORES integers for the overflow check
+ * @param good_steps (internal) consecutive steps without overflow
+ * @param steps (internal) number of calls to pulp_amp_update()
+ * @param skipped (internal) number of steps skipped because of an overflow
+ */
+struct amp_args {
+  float scale;
+  float growth_factor;
+  float backoff_factor;
+  int growth_interval;
+  float min_scale;
+  float max_scale;
+  int * flags;
+  int good_steps;
+  int steps;
+  int skipped;
+};
+
+/**
+ * @brief Trainable tensor in mixed precision
+ * @param master fp32 master weights (data), updated by the optimizer
+ * @param weights fp16 copy of the weights (data) used by the primitives, and their scaled fp16 gradient (diff)
+ */
+struct amp_param {
+  struct blob * master;
+  struct blob_fp16 * weights;
+};
+
+/**
+ * @brief Arguments of the mixed-precision kernels
+ * @param master fp32 master weights
+ * @param weights fp16 weights
+ * @param grad fp16 (scaled) gradient
+ * @param source fp32 tensor to be scaled and cast
+ * @param factor lr/scale for the update, scale for the cast
+ * @param flags per-core overflow flags
+ * @param size number of elements
+ */
+struct amp_kernel_args {
+  float * master;
+  fp16 * weights;
+  fp16 * grad;
+  float * source;
+  float factor;
+  int * flags;
+  int size;
+};
+
+
+/**
+ * @brief Resets the statistics of the loss scaling. scale, factors, interval, bounds and flags must be set.
+ * @param args loss scaling state
+ */
+void pulp_amp_init( struct amp_args * args );
+
+/**
+ * @brief Multiplies an fp32 gradient (typically the output gradient of the loss) by the loss scale and casts it to fp16. To be called on the cluster.
+ * @param args loss scaling state
+ * @param grad fp32 gradient
+ * @param scaled fp16 scaled gradient, starting point of the fp16 backward
+ * @param size number of elements
+ */
+void pulp_amp_scale_grad( struct amp_args * args, float * grad, fp16 * scaled, int size );
+
+/**
+ * @brief Checks the fp16 gradients of the parameters for overflows (Inf) and NaN. To be called on the cluster.
+ * @param args loss scaling state
+ * @param params trainable tensors
+ * @param num_params number of trainable tensors
+ * @return 1 if any gradient is not finite, 0 otherwise
+ */
+int pulp_amp_check_overflow( struct amp_args * args, struct amp_param * params, int num_params );
+
+/**
+ * @brief Mixed-precision gradient descent step. If the gradients overflow, the step is skipped and the scale reduced; otherwise the master weights are updated with the unscaled gradients and cast back to fp16 in the same pass. To be called on the cluster.
+ * @param args loss scaling state
+ * @param params trainable tensors
+ * @param num_params number of trainable tensors
+ * @param learning_rate learning rate of the gradient descent
+ * @return 1 if the weights have been updated, 0 if the step has been skipped
+ */
+int pulp_amp_update( struct amp_args * args, struct amp_param * params, int num_params, float learning_rate );
+
+/**
+ * @brief Prints the current loss scale and the number of skipped steps
+ * @param args loss scaling state
+ */
+void pulp_amp_report( struct amp_args * args );
+
+
+/**
+ * Mixed-precision kernels, forked on the cluster
+ */
+
+/**
+ * @brief Computes (fp16) (factor * source). Use pi_cl_team_fork(NUM_CORES, pulp_amp_cast_scaled_fp16, &args).
+ * @param (void *) (struct amp_kernel_args void_args)
+ */
+void pulp_amp_cast_scaled_fp16( void * void_args );
+
+/**
+ * @brief Sets flags[core] if the slice of grad of the core contains an Inf or a NaN. Use pi_cl_team_fork(NUM_CORES, pulp_amp_check_fp16, &args).
+ * @param (void *) (struct amp_kernel_args void_args)
+ */
+void pulp_amp_check_fp16( void * void_args );
+
+/**
+ * @brief Fused update and cast: master -= factor * grad, weights = (fp16) master. Use pi_cl_team_fork(NUM_CORES, pulp_amp_update_fp16, &args).
+ * @param (void *) (struct amp_kernel_args void_args)
+ */
+void pulp_amp_update_fp16( void * void_args );
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * 2D Convolution layer configuration structure
+ */
+
+/**
+ * @brief Structure for 2D Convolution Training in BF16 (CHW layout, naive kernels with fp32 accumulation)
+ * @param input input feature maps for the conv2d layer
+ * @param coeff weight matrix 
+ * @param output output feature maps for the conv2d layer 
+ * @param Lpad left padding
+ * @param Rpad right padding
+ * @param Upad upper padding
+ * @param Dpad lower padding
+ * @param stride_w stride in input width
+ * @param stride_h stride in input height
+ * @param skip_in_grad skips the computation of the input grad (1st DNN layer)
+ */
+struct Conv2D_args_bf16 {
+	struct blob_bf16 * input; 
+	struct blob_bf16 * coeff;
+	struct blob_bf16 * output; 
+	int Lpad;
+	int Rpad;
+	int Upad;
+	int Dpad;
+	int stride_h;
+	int stride_w;
+	int skip_in_grad;
+};
+
+
+
+/**
+ * Convolutional layer training functions, grouped into FW and BW
+ */
+
+
+// FORWARD FUNCTIONS
+
+/**
+ * @brief Forward pass function, forked on PULP cluster.
+ * @param input input feauture maps for the conv2d layer
+ * @param coeff weight matrix 
+ * @param output output feature maps for the conv2d layer
+ * @param Lpad, Rpad, Upad, Dpad padding
+ * @param stride_w, stride_h strides
+ */
+void pulp_conv2d_bf16_fw_cl( void * Conv2D_args_bf16 );
+
+
+// BACKWARD FUNCTIONS
+
+/**
+ * @brief Backward pass function, which internally calls both weight gradient and input gradient calculation
+ * @param input input feauture maps for the conv2d layer
+ * @param coeff weight matrix 
+ * @param output output feature maps for the conv2d layer 
+ * @param Lpad, Rpad, Upad, Dpad padding
+ * @param stride_w, stride_h strides
+ * @param skip_in_grad skips the computation of the input grad (1st DNN layer)
+ */
+void pulp_conv2d_bf16_bw_cl( void * Conv2D_args_bf16 );
+
+/**
+ * @brief Backward pass function which computes weight's gradient only
+ * @param input input feauture maps for the conv2d layer
+ * @param coeff weight matrix 
+ * @param output output feature maps for the conv2d layer 
+ * @param Lpad, Rpad, Upad, Dpad padding
+ * @param stride_w, stride_h strides
+ */
+void pulp_conv2d_bf16_bw_param_grads_cl( void * Conv2D_args_bf16 );
+
+/**
+ * @brief Backward pass function which computes input's gradient only
+ * @param input input feauture maps for the conv2d layer
+ * @param coeff weight matrix 
+ * @param output output feature maps for the conv2d layer 
+ * @param Lpad, Rpad, Upad, Dpad padding
+ * @param stride_w, stride_h strides
+ */
+void pulp_conv2d_bf16_bw_input_grads_cl( void * Conv2D_args_bf16 );
@@ -43,6 +43,14 @@
  * @param opt_matmul_type_ig number of the optimizer matmul to be chosen by the mm_manager for the input gradient primitive (see mm_manager_list.txt)
  * @param USE_IM2COL if set to 0, the convd kernel calls for the naive implementation, if set to 1 for the im2col+matmul optimized execution
  * @param USE_DMA_IM2COL in case the primitive uses IM2COL + MM, select if to perform im2col using DMA-managed transfers from L2 to L1 (input and output gradient tensors need to be stored in L2, im2col_buffer in L1)
+ * @param update_rows sparse update: list of the output channels whose weight gradient is computed (NULL to compute all of them). coeff->diff then stores num_update_rows compact rows (only im2col kernels)
+ * @param num_update_rows sparse update: number of elements of update_rows
+ * @param bias bias blob (C_out elements, gradient in diff), added by the forward matmul epilogue (only im2col kernels). NULL for no bias
+ * @param skip_wgt_grad skips the weight gradient (frozen weights: only the bias and/or the adapter are trained)
+ * @param lora_A low-rank adapter, "up" matrix (C_out x lora_rank, gradient in diff). The layer convolves with W + lora_A*lora_B, lora_B having the layout of a row of W (im2col kernels, CHW only). NULL for no adapter
+ * @param lora_B low-rank adapter, "down" matrix (lora_rank x C_in*pH*pW, gradient in diff)
+ * @param lora_rank rank of the adapter
+ * @param lora_buffer L1 buffer for the adapter: 2*lora_rank*H_out*W_out elements, plus C_out*C_in*pH*pW for the merged weights if the input grad is computed
  */
 struct Conv2D_args {
 	struct blob * input; 
@@ -63,6 +71,14 @@ struct Conv2D_args {
 	int opt_matmul_type_ig;
 	int USE_IM2COL;
 	int USE_DMA_IM2COL;
+	int * update_rows;
+	int num_update_rows;
+	struct blob * bias;
+	int skip_wgt_grad;
+	struct blob * lora_A;
+	struct blob * lora_B;
+	int lora_rank;
+	float * lora_buffer;
 };
 
 
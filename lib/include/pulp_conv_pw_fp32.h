@@ -34,6 +34,8 @@
  * @param opt_matmul_type_wg number of the optimizer matmul to be chosen by the mm_manager for the weight gradient primitive (see mm_manager_list.txt)
  * @param opt_matmul_type_ig number of the optimizer matmul to be chosen by the mm_manager for the input gradient primitive (see mm_manager_list.txt)
  * @param HWC parameter to set HWC (=1) or CHW (=0) primitive for the PointWise Convolution
+ * @param update_rows sparse update: list of the output channels whose weight gradient is computed (NULL to compute all of them). coeff->diff then stores num_update_rows compact rows (CHW only)
+ * @param num_update_rows sparse update: number of elements of update_rows
  */
 struct PointWise_Conv_args {
 	struct blob * input; 
@@ -45,6 +47,8 @@ struct PointWise_Conv_args {
 	int opt_matmul_type_wg;
 	int opt_matmul_type_ig;
 	int HWC;
+	int * update_rows;
+	int num_update_rows;
 };
 
 
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Streaming dataset for on-device training. Samples (input + label) are stored in L2 and streamed into a double
+ * buffer in L1: while the network trains on the sample of one half, the cluster DMA loads the next sample into
+ * the other half. The samples are visited through an index table, reshuffled at each epoch.
+ *
+ *   L2:  [in 0][in 1] ... [in N-1]    [lab 0][lab 1] ... [lab N-1]
+ *                  |  DMA (next)              |
+ *   L1:  [in A][lab A] <- training    [in B][lab B] <- loading
+ */
+
+/**
+ * @brief Streaming dataset structure
+ * @param inputs L2 array of num_samples inputs of input_size elements each
+ * @param labels L2 array of num_samples labels of label_size elements each
+ * @param num_samples number of samples of the dataset
+ * @param input_size number of elements of an input
+ * @param label_size number of elements of a label
+ * @param index array of num_samples indices of the samples, in visiting order
+ * @param l1_buffer L1 double buffer of 2*(input_size+label_size) elements
+ * @param shuffle set to 1 to shuffle the visiting order at each epoch
+ * @param seed state of the random generator of the shuffle (must not be 0)
+ * @param input blob of the first layer: its data is pointed to the current input by pulp_dataset_next()
+ * @param label current label, set by pulp_dataset_next()
+ * @param cursor (internal) position in index of the next sample to be loaded
+ * @param slot (internal) half of l1_buffer being loaded
+ * @param epoch (internal) number of completed passes over the dataset
+ * @param dma_input (internal) DMA transfer of the input being loaded
+ * @param dma_label (internal) DMA transfer of the label being loaded
+ */
+struct dataset_args {
+  float * inputs;
+  float * labels;
+  int num_samples;
+  int input_size;
+  int label_size;
+  int * index;
+  float * l1_buffer;
+  int shuffle;
+  unsigned int seed;
+  struct blob * input;
+  float * label;
+  int cursor;
+  int slot;
+  int epoch;
+  pi_cl_dma_copy_t dma_input;
+  pi_cl_dma_copy_t dma_label;
+};
+
+
+/**
+ * @brief Initializes the index table (shuffled if required) and starts loading the first sample. To be called on the cluster.
+ * @param args dataset to be initialized
+ */
+void pulp_dataset_init( struct dataset_args * args );
+
+/**
+ * @brief Shuffles the index table of the dataset (Fisher-Yates, xorshift random generator)
+ * @param args dataset to be shuffled
+ */
+void pulp_dataset_shuffle( struct dataset_args * args );
+
+/**
+ * @brief Waits for the sample being loaded, exposes it in args->input and args->label, and starts loading the next one in the other half of the L1 buffer. The index table is reshuffled when an epoch ends.
+ * @param args dataset to be read
+ * @return index of the exposed sample in the dataset
+ */
+int pulp_dataset_next( struct dataset_args * args );
+
+/**
+ * @brief Waits for the sample prefetched by the last pulp_dataset_next(), so that no DMA transfer is left pending on the L1 buffer. To be called after the training loop.
+ * @param args dataset to be released
+ */
+void pulp_dataset_finish( struct dataset_args * args );
+
+#ifdef DATASET_HOSTFS
+/**
+ * @brief Reads a binary file from the host file system (GVSoC semi-hosting) into an L2 buffer, as a stand-in for external memory. To be called on the fabric controller, before sending the training task to the cluster.
+ * @param path path of the file on the host (e.g. the dataset.bin dumped by GM.py: all the inputs, then all the labels, in float32)
+ * @param buffer L2 buffer receiving the data
+ * @param size number of bytes to be read
+ * @return 0 if the file has been read, -1 otherwise
+ */
+int pulp_dataset_load_file( const char * path, float * buffer, int size );
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Recurrent layer training functions, grouped into FW and BW
+*/
+
+
+/**
+ * GRU layer configuration structure
+ */
+
+/**
+ * @brief Structure for GRU Training in FP32. The three gates are concatenated in the order (r, z, n), so that
+ * each weight matrix has 3*M columns and the gate projections are computed with a single matmul. The candidate
+ * state is n = tanh(x*Wxn + r*(h*Wsn)), the new state is h = (1-z)*n + z*h_prev.
+ * @param input             Input sequence (N timesteps of K elements).
+ * @param state             Previous hidden state of each timestep (N*M); row 0 is the initial hidden state. Its diff receives the gradient of the previous hidden state of each timestep.
+ * @param output            Hidden state produced at each timestep (N*M).
+ * @param coeff_x           Concatenated input weights (K*3M).
+ * @param coeff_s           Concatenated state weights (M*3M).
+ * @param gate_buffer       Buffer of the activated gates of each timestep (N*3M), filled in the FW step and used in the BW step.
+ * @param hn_buffer         Buffer of the state projection of the candidate gate (N*M), filled in the FW step and reused for its gradient in the BW step.
+ * @param grad_buffer       Buffer of the pre-activation gate gradients (N*3M), used in the BW step.
+ * @param bptt_window       Truncated-BPTT window: the recurrent gradient is cut every bptt_window timesteps (0 backpropagates through the whole sequence).
+ */
+struct Gru_args {
+    struct blob * input;
+    struct blob * state;
+    struct blob * output;
+    struct blob * coeff_x;
+    struct blob * coeff_s;
+    float * gate_buffer;
+    float * hn_buffer;
+    float * grad_buffer;
+    int bptt_window;
+};
+
+
+
+
+/**
+ * GRU layer training functions, grouped into FW and BW
+ */
+
+// FORWARD FUNCTIONS
+
+/**
+ * @brief Forward pass function, forked on PULP cluster. The input projection of all the timesteps is computed with
+ * one matmul, then the recurrence runs in the same fork with the state projection, the gate nonlinearities and the
+ * state update fused in a single pass per timestep.
+ * @param Gru_args pointer to a Gru_args structure
+ */
+void pulp_gru_fp32_fw_cl(void * Gru_args);
+
+
+// BACKWARD FUNCTIONS
+
+/**
+ * @brief Backward-through-time function, which computes the weight gradients, the input gradient and the gradient
+ * of the initial hidden state.
+ * @param Gru_args pointer to a Gru_args structure
+ */
+void pulp_gru_fp32_bw_cl(void * Gru_args);
+
+
+
+// PARALLEL KERNELS
+
+/**
+ * @brief Forward kernel, parallelized over the hidden units with one barrier per timestep.
+ * @param Gru_args pointer to a Gru_args structure
+ */
+void pulp_gru_fp32_fw_kernel(void * Gru_args);
+
+/**
+ * @brief Backward kernel, parallelized over the hidden units with one barrier per timestep, followed by the weight and input gradient matmuls.
+ * @param Gru_args pointer to a Gru_args structure
+ */
+void pulp_gru_fp32_bw_kernel(void * Gru_args);
@@ -32,6 +32,14 @@
  * @param opt_matmul_type_fw number of the optimizer matmul to be chosen by the mm_manager for the forward primitive (see mm_manager_list.txt)
  * @param opt_matmul_type_wg number of the optimizer matmul to be chosen by the mm_manager for the weight gradient primitive (see mm_manager_list.txt)
  * @param opt_matmul_type_ig number of the optimizer matmul to be chosen by the mm_manager for the input gradient primitive (see mm_manager_list.txt)
+ * @param update_rows sparse update: list of the output neurons whose weight gradient is computed (NULL to compute all of them). coeff->diff then stores num_update_rows compact rows
+ * @param num_update_rows sparse update: number of elements of update_rows
+ * @param bias bias blob (output->dim elements, gradient in diff), added by the forward matmul epilogue. NULL for no bias
+ * @param skip_wgt_grad skips the weight gradient (frozen weights: only the bias and/or the adapter are trained)
+ * @param lora_A low-rank adapter, "up" matrix (Co x lora_rank, gradient in diff). The layer computes (W + lora_A*lora_B)*x. NULL for no adapter
+ * @param lora_B low-rank adapter, "down" matrix (lora_rank x Ci, gradient in diff)
+ * @param lora_rank rank of the adapter
+ * @param lora_buffer L1 buffer of 2*lora_rank elements for the adapter activations (kept from forward to backward)
  */
 struct Linear_args {
 	struct blob * input; 
@@ -41,6 +49,14 @@ struct Linear_args {
 	int opt_matmul_type_fw;
 	int opt_matmul_type_wg;
 	int opt_matmul_type_ig;
+	int * update_rows;
+	int num_update_rows;
+	struct blob * bias;
+	int skip_wgt_grad;
+	struct blob * lora_A;
+	struct blob * lora_B;
+	int lora_rank;
+	float * lora_buffer;
 };
 
 
@@ -35,6 +35,28 @@ struct loss_args {
     float * wr_loss;
 };
 
+/**
+ * @brief Structure used internally by the parallel loss functions to split the work among the cluster cores
+ * @param output pointer to the blob structure of the output data (data: prediction or logits, diff: output gradient)
+ * @param target current sample's label
+ * @param partial_loss array of NUM_CORES elements in which each core stores its partial loss
+ * @param partial_max array of NUM_CORES elements in which each core stores its local maximum (fused softmax only)
+ * @param partial_sum array of NUM_CORES elements in which each core stores its local exponential sum (fused softmax only)
+ * @param partial_target_sum array of NUM_CORES elements in which each core stores its local sum of the label (fused softmax only)
+ * @param max global maximum of the logits (fused softmax only)
+ * @param scale global scaling factor of the exponentials, sum(target)/sum(exp) (fused softmax only)
+ */
+struct loss_parallel_args {
+    struct blob * output;
+    float * target;
+    float * partial_loss;
+    float * partial_max;
+    float * partial_sum;
+    float * partial_target_sum;
+    float max;
+    float scale;
+};
+
 
 
 /**
@@ -55,4 +77,58 @@ void pulp_CrossEntropyLoss( void * loss_args );
  * @param target output label
  * @param wr_loss variable to retrieve the value of the calculated loss
  */
-void pulp_MSELoss( void * loss_args );
\ No newline at end of file
+void pulp_MSELoss( void * loss_args );
+
+
+
+/**
+ * Parallel loss functions (loss and output gradient are computed in a single pass)
+ */
+
+/**
+ * @brief Mean Squared Error Loss function, computing loss and output gradient in a single parallel pass. Partial losses are combined with a deterministic tree reduction. Call it from the cluster master core (it forks internally on NUM_CORES).
+ * @param output pointer to output data
+ * @param target output label
+ * @param wr_loss variable to retrieve the value of the calculated loss
+ */
+void pulp_MSELoss_cl( void * loss_args );
+
+/**
+ * @brief Cross Entropy Loss function on a probability distribution (e.g. the output of a softmax), computing loss and output gradient in a single parallel pass. Call it from the cluster master core (it forks internally on NUM_CORES).
+ * @param output pointer to output data
+ * @param target output label
+ * @param wr_loss variable to retrieve the value of the calculated loss
+ */
+void pulp_CrossEntropyLoss_cl( void * loss_args );
+
+/**
+ * @brief Fused Softmax + Cross Entropy Loss function. Takes the raw logits in output->data and computes the loss with a numerically stable log-sum-exp, and the gradient with respect to the logits in output->diff. No explicit softmax layer is required before it. Call it from the cluster master core (it forks internally on NUM_CORES).
+ * @param output pointer to the logits
+ * @param target output label
+ * @param wr_loss variable to retrieve the value of the calculated loss
+ */
+void pulp_SoftmaxCrossEntropyLoss_cl( void * loss_args );
+
+/**
+ * @brief Parallel kernel of pulp_MSELoss_cl(). Use pi_cl_team_fork(NUM_CORES, pulp_MSELoss_fp32_kernel, &args) to parallelize.
+ * @param (void *) (struct loss_parallel_args void_args)
+ */
+void pulp_MSELoss_fp32_kernel( void * loss_parallel_args );
+
+/**
+ * @brief Parallel kernel of pulp_CrossEntropyLoss_cl(). Use pi_cl_team_fork(NUM_CORES, pulp_CrossEntropyLoss_fp32_kernel, &args) to parallelize.
+ * @param (void *) (struct loss_parallel_args void_args)
+ */
+void pulp_CrossEntropyLoss_fp32_kernel( void * loss_parallel_args );
+
+/**
+ * @brief First parallel kernel of pulp_SoftmaxCrossEntropyLoss_cl(): computes the local maximum, the local (online-rescaled) exponential sum and the partial target-weighted logits of each core. Use pi_cl_team_fork(NUM_CORES, pulp_SoftmaxCrossEntropy_stats_fp32_kernel, &args) to parallelize.
+ * @param (void *) (struct loss_parallel_args void_args)
+ */
+void pulp_SoftmaxCrossEntropy_stats_fp32_kernel( void * loss_parallel_args );
+
+/**
+ * @brief Second parallel kernel of pulp_SoftmaxCrossEntropyLoss_cl(): writes the gradient with respect to the logits. Use pi_cl_team_fork(NUM_CORES, pulp_SoftmaxCrossEntropy_grad_fp32_kernel, &args) to parallelize.
+ * @param (void *) (struct loss_parallel_args void_args)
+ */
+void pulp_SoftmaxCrossEntropy_grad_fp32_kernel( void * loss_parallel_args );
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Recurrent layer training functions, grouped into FW and BW
+*/
+
+
+/**
+ * LSTM layer configuration structure
+ */
+
+/**
+ * @brief Structure for LSTM Training in FP32. The four gates are concatenated in the order (i, f, g, o), so that
+ * each weight matrix has 4*M columns and the gate projections are computed with a single matmul.
+ * @param input             Input sequence (N timesteps of K elements).
+ * @param state             Previous hidden state of each timestep (N*M); row 0 is the initial hidden state. Its diff receives the gradient of the previous hidden state of each timestep.
+ * @param cell              Cell state ((N+1)*M); row 0 is the initial cell state, row t+1 is the cell state of timestep t. Its diff receives the corresponding gradients.
+ * @param output            Hidden state produced at each timestep (N*M).
+ * @param coeff_x           Concatenated input weights (K*4M).
+ * @param coeff_s           Concatenated state weights (M*4M).
+ * @param gate_buffer       Buffer of the activated gates of each timestep (N*4M), filled in the FW step and used in the BW step.
+ * @param grad_buffer       Buffer of the pre-activation gate gradients (N*4M), used in the BW step.
+ * @param bptt_window       Truncated-BPTT window: the recurrent gradient is cut every bptt_window timesteps (0 backpropagates through the whole sequence).
+ */
+struct Lstm_args {
+    struct blob * input;
+    struct blob * state;
+    struct blob * cell;
+    struct blob * output;
+    struct blob * coeff_x;
+    struct blob * coeff_s;
+    float * gate_buffer;
+    float * grad_buffer;
+    int bptt_window;
+};
+
+
+
+
+/**
+ * LSTM layer training functions, grouped into FW and BW
+ */
+
+// FORWARD FUNCTIONS
+
+/**
+ * @brief Forward pass function, forked on PULP cluster. The input projection of all the timesteps is computed with
+ * one matmul, then the recurrence runs in the same fork with the state projection, the gate nonlinearities and the
+ * cell update fused in a single pass per timestep.
+ * @param Lstm_args pointer to a Lstm_args structure
+ */
+void pulp_lstm_fp32_fw_cl(void * Lstm_args);
+
+
+// BACKWARD FUNCTIONS
+
+/**
+ * @brief Backward-through-time function, which computes the weight gradients, the input gradient and the gradients
+ * of the initial hidden and cell states.
+ * @param Lstm_args pointer to a Lstm_args structure
+ */
+void pulp_lstm_fp32_bw_cl(void * Lstm_args);
+
+
+
+// PARALLEL KERNELS
+
+/**
+ * @brief Forward kernel, parallelized over the hidden units with one barrier per timestep.
+ * @param Lstm_args pointer to a Lstm_args structure
+ */
+void pulp_lstm_fp32_fw_kernel(void * Lstm_args);
+
+/**
+ * @brief Backward kernel, parallelized over the hidden units with one barrier per timestep, followed by the weight and input gradient matmuls.
+ * @param Lstm_args pointer to a Lstm_args structure
+ */
+void pulp_lstm_fp32_bw_kernel(void * Lstm_args);
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Matrix multiply and naive convolution kernels in BF16. Operands are bf16, products and sums are computed in fp32
+ * and rounded to bf16 once, when the result is stored.
+ * Use pi_cl_team_fork(NUM_CORES, MM_NAME, &args) to parallelize.
+ */
+
+/**
+ * @brief Matrix multiply with fp32 accumulation, performing C=A*B (C is N*M, A is N*K, B is K*M), or C=A*Bt if trans_B is set (B is M*K). Parallelizes on N.
+ * @param void_args pointer to a matMul_args_bf16 structure (please refer to this to setup the args)
+ */
+void mm_bf16(
+    void * void_args
+);
+
+/**
+ * @brief Matrix multiply with fp32 accumulation, performing C=A*B (C is N*M, A is N*K, B is K*M), or C=A*Bt if trans_B is set (B is M*K). Parallelizes on M.
+ * @param void_args pointer to a matMul_args_bf16 structure (please refer to this to setup the args)
+ */
+void mm_M_bf16(
+    void * void_args
+);
+
+/**
+ * @brief Naive conv2d kernel for forward propagation (CHW format), with stride and padding. A is the input, B the weights (C_out*C_in*pH*pW), C the output. Parallelizes on the output channels.
+ * @param matMul_args pointer to a matMul_args_bf16 structure
+ */
+void naive_conv2d_fw_kernel_CHW_bf16(
+    void * matMul_args
+);
+
+/**
+ * @brief Naive conv2d kernel for the computation of the weight gradient (CHW format), with stride and padding. A is the input, B the weight gradient, C the output gradient. Parallelizes on the output channels.
+ * @param matMul_args pointer to a matMul_args_bf16 structure
+ */
+void naive_conv2d_param_grad_kernel_CHW_bf16(
+    void * matMul_args
+);
+
+/**
+ * @brief Naive conv2d kernel for the computation of the input gradient (CHW format), with stride and padding. A is the input gradient, B the weights, C the output gradient. Parallelizes on the input channels.
+ * @param matMul_args pointer to a matMul_args_bf16 structure
+ */
+void naive_conv2d_in_grad_kernel_CHW_bf16(
+    void * matMul_args
+);
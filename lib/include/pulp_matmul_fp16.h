@@ -40,6 +40,14 @@ void mm_M_fp16(
 	void * void_args
 );
 
+/**
+ * @brief Naive matrix multiply algorithm with transposed A, performing C=At*B (C is N*M, A is K*N, B is K*M), or C=At*Bt if trans_B is set (B is M*K). Parallelizes on N.
+ * @param void_args pointer to a matMul_args_fp16 structure (please refer to this to setup the args)
+ */
+void mm_trans_A_fp16(
+	void * void_args
+);
+
 /**
  * @brief Naive core kernel for Depthwise Convolution (forward). Parallelizes on the channels.
  * @param matMul_DW_args_fp16  pointer to a matMul_DW_args structure (please refer to pulp_train_utils_fp16.h)
@@ -106,7 +114,7 @@ void naive_conv2d_in_grad_kernel_CHW_fp16(
 // =====> PARALLELISM ON N <=====
 
 /**
- * @brief SIMD matmul which unrolls 2 elements of A and 4 of B. Parallelizes on N. 
+ * @brief SIMD matmul which unrolls 2 elements of A and 4 of B. Parallelizes on N. Supports any N, M, K and trans_B, with the leftovers on fp16 pairs too.
  * @param void_args pointer to a matMul_args_fp16 structure (please refer to this to setup the args)
  */
 void __attribute__((noinline)) mm_fp16_SIMD_2x4 (
@@ -127,7 +135,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_4x8 (
 // =====> PARALLELISM ON M <=====
 
 /**
- * @brief SIMD matmul which unrolls 2 elements of A and 4 of B. Parallelizes on M. 
+ * @brief SIMD matmul which unrolls 2 elements of A and 4 of B. Parallelizes on M. Supports any N, M, K and trans_B, with the leftovers on fp16 pairs too.
  * @param void_args pointer to a matMul_args_fp16 structure (please refer to this to setup the args)
  */
 void __attribute__((noinline)) mm_M_fp16_SIMD_2x4 (
@@ -141,3 +149,39 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_2x4 (
 void __attribute__((noinline)) mm_M_fp16_SIMD_4x8 (
     void * void_args
 );
+
+
+
+// =====> FP32 ACCUMULATION <=====
+
+/**
+ * @brief SIMD matmul which loads pairs of fp16 elements and accumulates 2x2 blocks of C in fp32, then stores C in fp16. Parallelizes on N. Use it for long K (e.g. weight gradients, where K = H_out*W_out).
+ * @param void_args pointer to a matMul_args_fp16 structure (please refer to this to setup the args)
+ */
+void __attribute__((noinline)) mm_fp16_SIMD_2x2_fp32acc (
+    void * void_args
+);
+
+/**
+ * @brief SIMD matmul which loads pairs of fp16 elements and accumulates 2x2 blocks of C in fp32, then stores C in fp16. Parallelizes on M.
+ * @param void_args pointer to a matMul_args_fp16 structure (please refer to this to setup the args)
+ */
+void __attribute__((noinline)) mm_M_fp16_SIMD_2x2_fp32acc (
+    void * void_args
+);
+
+/**
+ * @brief Same as mm_fp16_SIMD_2x2_fp32acc, but stores C in fp32: args->C has to point to an fp32 buffer of N*M elements (cast to fp16 *). Parallelizes on N.
+ * @param void_args pointer to a matMul_args_fp16 structure (please refer to this to setup the args)
+ */
+void __attribute__((noinline)) mm_fp16_SIMD_2x2_fp32out (
+    void * void_args
+);
+
+/**
+ * @brief Same as mm_M_fp16_SIMD_2x2_fp32acc, but stores C in fp32: args->C has to point to an fp32 buffer of N*M elements (cast to fp16 *). Parallelizes on M.
+ * @param void_args pointer to a matMul_args_fp16 structure (please refer to this to setup the args)
+ */
+void __attribute__((noinline)) mm_M_fp16_SIMD_2x2_fp32out (
+    void * void_args
+);
@@ -294,3 +294,88 @@ void mm_M_unroll_2x4(
 void mm_M_unroll_4x4(
     void * matMul_args
 );
+
+
+
+/**
+ * Matmuls with transposed A operand, performing C=At*B (C is N*M, A is K*N, B is K*M) or C=At*Bt if trans_B is set (B is M*K).
+ * They avoid explicit transpositions of the operands (e.g. in the MHSA layer).
+ */
+
+/**
+ * @brief Naive matmul with transposed A, performing C=At*B (or C=At*Bt if trans_B is set). Parallelizes on N.
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_trans_A(
+    void * matMul_args
+);
+
+/**
+ * @brief Matmul with transposed A and unrolling, parallelizes on N. Unrolls 4 columns of B.
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_trans_A_unroll_1x4(
+    void * matMul_args
+);
+
+/**
+ * @brief Matmul with transposed A and unrolling, parallelizes on N. Unrolls 4 columns of A (rows of C).
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_trans_A_unroll_4x1(
+    void * matMul_args
+);
+
+/**
+ * @brief Matmul with transposed A and unrolling, parallelizes on N. Unrolls 2 columns of A, 2 columns of B.
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_trans_A_unroll_2x2(
+    void * matMul_args
+);
+
+/**
+ * @brief Naive matmul with transposed A, performing C=At*B (or C=At*Bt if trans_B is set). Parallelizes on M.
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_M_trans_A(
+    void * matMul_args
+);
+
+/**
+ * @brief Matmul with transposed A and unrolling, parallelizes on M. Unrolls 4 columns of B.
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_M_trans_A_unroll_1x4(
+    void * matMul_args
+);
+
+/**
+ * @brief Matmul with transposed A and unrolling, parallelizes on M. Unrolls 4 columns of A (rows of C).
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_M_trans_A_unroll_4x1(
+    void * matMul_args
+);
+
+/**
+ * @brief Matmul with transposed A and unrolling, parallelizes on M. Unrolls 2 columns of A, 2 columns of B.
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_M_trans_A_unroll_2x2(
+    void * matMul_args
+);
+
+
+
+/**
+ * Matmul on a subset of the rows of A, for sparse weight updates
+ */
+
+/**
+ * @brief Naive matmul on the rows of A listed in row_idx, performing C[i] = A[row_idx[i]]*B (or *Bt if trans_B is set) for i < N. C is compact (N*M). Parallelizes on M.
+ * @param matMul_args pointer to a matMul_args structure (please refer to this to setup the args)
+ */
+void mm_sparse_rows(
+    void * matMul_args
+);
@@ -63,6 +63,57 @@ struct Mhsa_args_fp16 {
 
 
 
+/**
+ * @brief Arguments for the head-parallel attention kernels in FP16. q, k and v point to the first head chunk (H x L, heads stored contiguously), as produced by the QKV projection.
+ * @param q                 Query matrix (F x L)
+ * @param k                 Key matrix (F x L)
+ * @param v                 Value matrix (F x L)
+ * @param head_buffer       Attention scores of every head (n_heads x L x L, keys on the rows)
+ * @param softmax_buffer    Attention probabilities of every head (n_heads x L x L, keys on the rows)
+ * @param grad              Gradient of the attention scores of every head (n_heads x L x L)
+ * @param output            Attention map before the output projection (F x L)
+ * @param q_diff            Query gradient (F x L)
+ * @param k_diff            Key gradient (F x L)
+ * @param v_diff            Value gradient (F x L)
+ * @param output_diff       Gradient of the attention map (F x L)
+ * @param scaling           Score scaling factor (1/sqrt(H))
+ * @param L                 Sequence length
+ * @param H                 Head size
+ * @param n_heads           Number of heads
+ */
+struct mhsa_heads_args_fp16 {
+    fp16 * q;
+    fp16 * k;
+    fp16 * v;
+    fp16 * head_buffer;
+    fp16 * softmax_buffer;
+    fp16 * grad;
+    fp16 * output;
+    fp16 * q_diff;
+    fp16 * k_diff;
+    fp16 * v_diff;
+    fp16 * output_diff;
+    fp16 scaling;
+    int L;
+    int H;
+    int n_heads;
+};
+
+
+
+/**
+ * @brief Arguments for the per-query softmax kernels of the MHSA in FP16, on the (L x L) scores of one head (keys on the rows, queries on the columns)
+ * @param input     Attention scores (data) and their gradient (diff)
+ * @param output    Attention probabilities (data) and their gradient (diff)
+ * @param L         Sequence length
+ */
+struct mhsa_softmax_args_fp16 {
+    struct blob_fp16 * input;
+    struct blob_fp16 * output;
+    int L;
+};
+
+
 
 /**
  * MHSA layer training functions, grouped into FW and BW
@@ -71,16 +122,69 @@ struct Mhsa_args_fp16 {
 // FORWARD FUNCTIONS
 
 /**
- * @brief Forward pass function, forked on PULP cluster.
+ * @brief Forward pass function, forked on PULP cluster. The softmax normalizes the scores of every query over the keys, as in pulp_mhsa_heads_fp16_fw_cl().
  * @param Mhsa_args_fp16 structure configuring the MHSA layer.
  */
 void pulp_mhsa_fp16_fw_cl(void * Mhsa_args_fp16);
 
 
+/**
+ * @brief Forward pass function with head-parallel attention: a single fork computes scores, softmax (over the keys of every query) and attention map of all the heads, each core owning whole heads or blocks of (head, query) pairs. Avoids the per-head forks of pulp_mhsa_fp16_fw_cl().
+ * @param Mhsa_args_fp16 structure configuring the MHSA layer.
+ */
+void pulp_mhsa_heads_fp16_fw_cl(void * Mhsa_args_fp16);
+
+
 // BACKWARD FUNCTIONS
 
 /**
- * @brief Backward pass function, which internally calculate both weight gradient and input gradient.
+ * @brief Backward pass function matching pulp_mhsa_fp16_fw_cl(), which internally calculate both weight gradient and input gradient.
  * @param Mhsa_args_fp16 structure configuring the MHSA layer.
  */
 void pulp_mhsa_fp16_bw_cl(void * Mhsa_args_fp16);
+
+
+/**
+ * @brief Backward pass function matching pulp_mhsa_heads_fp16_fw_cl(). The attention gradients of all the heads are computed in two forks (query gradients, then key and value gradients), using head_buffer->diff to store the score gradients.
+ * temp_buffer must hold max(L*F, 3*F*E, L*E) elements (the largest gradient transposed through it).
+ * @param Mhsa_args_fp16 structure configuring the MHSA layer.
+ */
+void pulp_mhsa_heads_fp16_bw_cl(void * Mhsa_args_fp16);
+
+
+
+// HEAD-PARALLEL ATTENTION KERNELS
+
+/**
+ * @brief Head-parallel attention forward kernel: every core computes scores, softmax and attention map columns of its (head, query) pairs. Use pi_cl_team_fork(NUM_CORES, mhsa_heads_fp16_fw_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_heads_args_fp16 void_args)
+ */
+void mhsa_heads_fp16_fw_kernel(void * mhsa_heads_args_fp16);
+
+/**
+ * @brief First head-parallel attention backward kernel: every core computes the score gradients and the Query gradients of its (head, query) pairs. Use pi_cl_team_fork(NUM_CORES, mhsa_heads_fp16_bw_q_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_heads_args_fp16 void_args)
+ */
+void mhsa_heads_fp16_bw_q_kernel(void * mhsa_heads_args_fp16);
+
+/**
+ * @brief Second head-parallel attention backward kernel: every core computes the Key and Value gradients of its (head, key) pairs. Use pi_cl_team_fork(NUM_CORES, mhsa_heads_fp16_bw_kv_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_heads_args_fp16 void_args)
+ */
+void mhsa_heads_fp16_bw_kv_kernel(void * mhsa_heads_args_fp16);
+
+
+
+// SOFTMAX KERNELS
+
+/**
+ * @brief Softmax of every query over the keys of one head: normalizes each column of the (L x L) scores (input->data) into output->data, with the exponentials summed in fp32. Use pi_cl_team_fork(NUM_CORES, mhsa_softmax_fp16_fw_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_softmax_args_fp16 void_args)
+ */
+void mhsa_softmax_fp16_fw_kernel(void * mhsa_softmax_args_fp16);
+
+/**
+ * @brief Backward of mhsa_softmax_fp16_fw_kernel(): computes the score gradients (input->diff) from the probabilities (output->data) and their gradients (output->diff), column by column. Use pi_cl_team_fork(NUM_CORES, mhsa_softmax_fp16_bw_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_softmax_args_fp16 void_args)
+ */
+void mhsa_softmax_fp16_bw_kernel(void * mhsa_softmax_args_fp16);
@@ -28,6 +28,24 @@
  * Multi-Head Self Attention layer configuration structure
  */
 
+/**
+ * @brief Ring buffer caching the Keys and Values of the last L_max tokens, for incremental decoding. Initialize length and next to 0 before the first token.
+ * @param k         Cached Keys (F x L_max, one column per token, heads stored contiguously)
+ * @param v         Cached Values (F x L_max, one column per token, heads stored contiguously)
+ * @param scores    Support buffer for the attention scores of the new query (n_heads x L_max)
+ * @param L_max     Capacity of the cache (maximum attention window)
+ * @param length    Number of valid tokens in the cache
+ * @param next      Slot that will be overwritten by the next token (the oldest one when the cache is full)
+ */
+struct mhsa_kv_cache {
+    float * k;
+    float * v;
+    float * scores;
+    int L_max;
+    int length;
+    int next;
+};
+
 /**
  * @brief Structure for MHSA Training in FP32
  * @param input             Input vector for the MHSA layer.
@@ -35,11 +53,13 @@
  * @param output            Output vector.
  * @param coeff_in          Weight for input projection.
  * @param coeff_out         Weight for output projection.
- * @param qkv               Query, Key and Values extracted from the input and packed into a single matrix
+ * @param qkv               Query, Key and Values extracted from the input and packed into a single matrix, in head-major (3F x L) layout
  * @param attention_map     Output of the MHSA module, pre-projection
- * @param temp_buffer       Support buffer used to save transposed matrices
  * @param grad              Support buffer used when calculating gradients for each computational head during MHSA backprop
  * @param head_buffer       Attention scores for every head
+ * @param lse               Log-sum-exp of the attention scores of every head and query (n_heads x L), saved by the flash forward and used by the flash backward
+ * @param delta             Support buffer (n_heads x L) used by the flash backward to store the row-wise dot product between output and output gradient
+ * @param kv_cache          Key/Value cache used by the incremental (single token) forward
  * 
  */
 
@@ -54,15 +74,108 @@ struct Mhsa_args {
     struct blob * coeff_out;
     struct blob * qkv;
     struct blob * attention_map;
-    float * temp_buffer;
     float * grad;
     struct blob * head_buffer;
     struct blob * softmax_buffer;
     float * global_max;
     float * partial_exp_sum;
+    float * lse;
+    float * delta;
+    struct mhsa_kv_cache * kv_cache;
+};
+
+
+/**
+ * @brief Arguments for the tiled (flash) attention kernels. q, k and v point to the first head chunk (H x L, heads stored contiguously), as produced by the QKV projection.
+ * @param q             Query matrix (F x L)
+ * @param k             Key matrix (F x L)
+ * @param v             Value matrix (F x L)
+ * @param output        Attention map before the output projection (F x L)
+ * @param q_diff        Query gradient (F x L)
+ * @param k_diff        Key gradient (F x L)
+ * @param v_diff        Value gradient (F x L)
+ * @param output_diff   Gradient of the attention map (F x L)
+ * @param lse           Log-sum-exp of the scores of every head and query (n_heads x L)
+ * @param delta         Row-wise dot product between output and output gradient (n_heads x L)
+ * @param scaling       Score scaling factor (1/sqrt(H))
+ * @param L             Sequence length
+ * @param H             Head size
+ * @param n_heads       Number of heads
+ */
+struct flash_attn_args {
+    float * q;
+    float * k;
+    float * v;
+    float * output;
+    float * q_diff;
+    float * k_diff;
+    float * v_diff;
+    float * output_diff;
+    float * lse;
+    float * delta;
+    float scaling;
+    int L;
+    int H;
+    int n_heads;
+};
+
+
+
+/**
+ * @brief Arguments for the head-parallel attention kernels. q, k and v point to the first head chunk (H x L, heads stored contiguously), as produced by the QKV projection.
+ * @param q                 Query matrix (F x L)
+ * @param k                 Key matrix (F x L)
+ * @param v                 Value matrix (F x L)
+ * @param head_buffer       Attention scores of every head (n_heads x L x L, keys on the rows)
+ * @param softmax_buffer    Attention probabilities of every head (n_heads x L x L, keys on the rows)
+ * @param grad              Gradient of the attention scores of every head (n_heads x L x L)
+ * @param output            Attention map before the output projection (F x L)
+ * @param q_diff            Query gradient (F x L)
+ * @param k_diff            Key gradient (F x L)
+ * @param v_diff            Value gradient (F x L)
+ * @param output_diff       Gradient of the attention map (F x L)
+ * @param scaling           Score scaling factor (1/sqrt(H))
+ * @param L                 Sequence length
+ * @param H                 Head size
+ * @param n_heads           Number of heads
+ */
+struct mhsa_heads_args {
+    float * q;
+    float * k;
+    float * v;
+    float * head_buffer;
+    float * softmax_buffer;
+    float * grad;
+    float * output;
+    float * q_diff;
+    float * k_diff;
+    float * v_diff;
+    float * output_diff;
+    float scaling;
+    int L;
+    int H;
+    int n_heads;
 };
 
 
+/**
+ * @brief Arguments for the incremental decoding kernels.
+ * @param q         Query of the new token (F)
+ * @param cache     Key/Value cache, already containing the new token
+ * @param output    Attention map of the new token, before the output projection (F)
+ * @param scaling   Score scaling factor (1/sqrt(H))
+ * @param H         Head size
+ * @param n_heads   Number of heads
+ */
+struct mhsa_decode_args {
+    float * q;
+    struct mhsa_kv_cache * cache;
+    float * output;
+    float scaling;
+    int H;
+    int n_heads;
+};
+
 
 
 /**
@@ -72,7 +185,7 @@ struct Mhsa_args {
 // FORWARD FUNCTIONS
 
 /**
- * @brief Forward pass function, forked on PULP cluster.
+ * @brief Forward pass function, forked on PULP cluster. The softmax normalizes the scores of every query over the keys, as in pulp_mhsa_heads_fp32_fw_cl() and pulp_mhsa_flash_fp32_fw_cl().
  * @param Mhsa_args structure configuring the MHSA layer.
  */
 void pulp_mhsa_fp32_fw_cl(void * Mhsa_args);
@@ -85,10 +198,133 @@ void pulp_mhsa_fp32_fw_cl(void * Mhsa_args);
 void pulp_mhsa_fp32_fw_cl_2(void * Mhsa_args);
 
 
+/**
+ * @brief Forward pass function using tiled (flash) attention: K and V are streamed in blocks of MHSA_FLASH_TILE keys with an online softmax, so head_buffer and softmax_buffer are not used and no L x L matrix is materialized. Saves the log-sum-exp of every query in lse for the backward.
+ * @param Mhsa_args structure configuring the MHSA layer.
+ */
+void pulp_mhsa_flash_fp32_fw_cl(void * Mhsa_args);
+
+
+/**
+ * @brief Forward pass function with head-parallel attention: a single fork computes scores, softmax (over the keys of every query) and attention map of all the heads, each core owning whole heads or blocks of (head, query) pairs. Avoids the per-head forks of pulp_mhsa_fp32_fw_cl().
+ * @param Mhsa_args structure configuring the MHSA layer.
+ */
+void pulp_mhsa_heads_fp32_fw_cl(void * Mhsa_args);
+
+
+/**
+ * @brief Incremental forward pass for a single new token (input is 1 x E, output is 1 x E, qkv holds 3F and attention_map F elements). Projects the token, appends its Key and Value to the ring buffer kv_cache (overwriting the oldest token when full), computes the attention of its Query over the cached tokens and projects the result. The cost per token is linear in the cache length. Until the cache wraps, the output of the t-th token is row t of the full forward (pulp_mhsa_fp32_fw_cl(), heads or flash) over tokens 0..t, since there is no causal mask.
+ * @param Mhsa_args structure configuring the MHSA layer.
+ */
+void pulp_mhsa_fp32_fw_incremental_cl(void * Mhsa_args);
+
+
 // BACKWARD FUNCTIONS
 
 /**
- * @brief Backward pass function, which internally calculate both weight gradient and input gradient.
+ * @brief Backward pass function matching pulp_mhsa_fp32_fw_cl(), which internally calculate both weight gradient and input gradient.
  * @param Mhsa_args structure configuring the MHSA layer.
  */
 void pulp_mhsa_fp32_bw_cl(void * Mhsa_args);
+
+
+/**
+ * @brief Backward pass function matching pulp_mhsa_flash_fp32_fw_cl(). The attention probabilities are recomputed block by block from Q, K and the saved lse, so no L x L buffer (head_buffer, softmax_buffer, grad) is required.
+ * @param Mhsa_args structure configuring the MHSA layer.
+ */
+void pulp_mhsa_flash_fp32_bw_cl(void * Mhsa_args);
+
+
+/**
+ * @brief Backward pass function matching pulp_mhsa_heads_fp32_fw_cl(). The attention gradients of all the heads are computed in two forks (query gradients, then key and value gradients), using head_buffer->diff to store the score gradients.
+ * @param Mhsa_args structure configuring the MHSA layer.
+ */
+void pulp_mhsa_heads_fp32_bw_cl(void * Mhsa_args);
+
+
+
+// SOFTMAX KERNELS
+
+/**
+ * @brief Softmax of every query over the keys of one head: normalizes each column of the (L x L) scores (input->data) into output->data. Use pi_cl_team_fork(NUM_CORES, mhsa_softmax_fp32_fw_kernel, &args) to parallelize.
+ * @param (void *) (struct softmax_args void_args)
+ */
+void mhsa_softmax_fp32_fw_kernel(void * softmax_args);
+
+/**
+ * @brief Backward of mhsa_softmax_fp32_fw_kernel(): computes the score gradients (input->diff) from the probabilities (output->data) and their gradients (output->diff), column by column. Use pi_cl_team_fork(NUM_CORES, mhsa_softmax_fp32_bw_kernel, &args) to parallelize.
+ * @param (void *) (struct softmax_args void_args)
+ */
+void mhsa_softmax_fp32_bw_kernel(void * softmax_args);
+
+
+
+// TILED ATTENTION KERNELS
+
+/**
+ * @brief Tiled attention forward kernel: every core computes whole query columns of the attention map with an online softmax over blocks of keys. Use pi_cl_team_fork(NUM_CORES, mhsa_flash_fp32_fw_kernel, &args) to parallelize.
+ * @param (void *) (struct flash_attn_args void_args)
+ */
+void mhsa_flash_fp32_fw_kernel(void * flash_attn_args);
+
+/**
+ * @brief First tiled attention backward kernel: computes delta = rowsum(dO * O) for every head and query. Use pi_cl_team_fork(NUM_CORES, mhsa_flash_fp32_bw_delta_kernel, &args) to parallelize.
+ * @param (void *) (struct flash_attn_args void_args)
+ */
+void mhsa_flash_fp32_bw_delta_kernel(void * flash_attn_args);
+
+/**
+ * @brief Second tiled attention backward kernel: every core owns whole key columns and accumulates their Key and Value gradients over blocks of queries. Use pi_cl_team_fork(NUM_CORES, mhsa_flash_fp32_bw_kv_kernel, &args) to parallelize.
+ * @param (void *) (struct flash_attn_args void_args)
+ */
+void mhsa_flash_fp32_bw_kv_kernel(void * flash_attn_args);
+
+/**
+ * @brief Third tiled attention backward kernel: every core owns whole query columns and accumulates their Query gradients over blocks of keys. Use pi_cl_team_fork(NUM_CORES, mhsa_flash_fp32_bw_q_kernel, &args) to parallelize.
+ * @param (void *) (struct flash_attn_args void_args)
+ */
+void mhsa_flash_fp32_bw_q_kernel(void * flash_attn_args);
+
+
+
+// HEAD-PARALLEL ATTENTION KERNELS
+
+/**
+ * @brief Head-parallel attention forward kernel: every core computes scores, softmax and attention map columns of its (head, query) pairs. Use pi_cl_team_fork(NUM_CORES, mhsa_heads_fp32_fw_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_heads_args void_args)
+ */
+void mhsa_heads_fp32_fw_kernel(void * mhsa_heads_args);
+
+/**
+ * @brief First head-parallel attention backward kernel: every core computes the score gradients and the Query gradients of its (head, query) pairs. Use pi_cl_team_fork(NUM_CORES, mhsa_heads_fp32_bw_q_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_heads_args void_args)
+ */
+void mhsa_heads_fp32_bw_q_kernel(void * mhsa_heads_args);
+
+/**
+ * @brief Second head-parallel attention backward kernel: every core computes the Key and Value gradients of its (head, key) pairs. Use pi_cl_team_fork(NUM_CORES, mhsa_heads_fp32_bw_kv_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_heads_args void_args)
+ */
+void mhsa_heads_fp32_bw_kv_kernel(void * mhsa_heads_args);
+
+
+
+// INCREMENTAL DECODING KERNELS
+
+/**
+ * @brief Computes the scores of the new query against every cached Key, parallelizing on the (head, token) pairs. Use pi_cl_team_fork(NUM_CORES, mhsa_decode_fp32_scores_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_decode_args void_args)
+ */
+void mhsa_decode_fp32_scores_kernel(void * mhsa_decode_args);
+
+/**
+ * @brief Applies the softmax to the scores of every head, parallelizing on the heads. Use pi_cl_team_fork(NUM_CORES, mhsa_decode_fp32_softmax_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_decode_args void_args)
+ */
+void mhsa_decode_fp32_softmax_kernel(void * mhsa_decode_args);
+
+/**
+ * @brief Computes the attention map of the new token as the softmax-weighted sum of the cached Values, parallelizing on the F output elements. Use pi_cl_team_fork(NUM_CORES, mhsa_decode_fp32_av_kernel, &args) to parallelize.
+ * @param (void *) (struct mhsa_decode_args void_args)
+ */
+void mhsa_decode_fp32_av_kernel(void * mhsa_decode_args);
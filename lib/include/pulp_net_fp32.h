@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Network-level training helpers for a chain of layers (layer i consumes the output of layer i-1).
+ *
+ * Gradient checkpointing: only the inputs of the layers marked in "checkpoint" are kept alive between
+ * forward and backward. A segment goes from a checkpointed layer to the layer before the next checkpoint.
+ * The activations inside a segment live in a shared arena: during backward, each segment re-runs its forward
+ * to refill the arena, then back-propagates through its layers in reverse order.
+ *
+ *   layer:       0      1      2      3      4
+ *   checkpoint:  1      0      0      1      0
+ *   segments:   |<----- S0 ------>|  |<-- S1 -->|
+ *   arena:          [in1]  [in2]         [in4]
+ *
+ * Peak activation memory = sum of the checkpointed inputs + the largest segment arena.
+ * Extra compute         = forward of every layer of a segment, except its last one. The last segment is
+ *                         still in the arena after the forward, so it is not recomputed.
+ *
+ * Activation offload: the arena is a sliding window of OFFLOAD_WINDOW L1 slots, activation k (input of layer k)
+ * living in slot k % OFFLOAD_WINDOW. In forward, once layer k has run, its input is DMA'd to L2 if a later
+ * activation will reuse its slot. In backward, the input of layer k-1 is prefetched back from L2 while the 
+ * backward of layer k runs (its slot held the input of layer k+2, which is no longer needed). Only activations
+ * 1..N-1-OFFLOAD_WINDOW are offloaded, so at least OFFLOAD_WINDOW+2 layers are needed for any transfer.
+ *
+ * Frozen layers: the backward starts from the last layer and stops at the lowest trainable layer. Frozen layers
+ * above it only propagate the input gradient, the lowest trainable layer only computes its weight gradient, and
+ * the layers below it are not visited (nor recomputed, nor prefetched). The update skips the frozen layers.
+ *
+ * Sparse update: a trainable layer may update only a subset of its output channels (update_rows, which must also
+ * be set in the args of the layer). Its weight gradient then holds only the selected rows, and the update touches
+ * only those rows of the weights.
+ *
+ * Parameter-efficient training: a trainable layer with skip_wgt_grad (also set in the args of the layer) keeps its
+ * weights frozen and only trains its bias and/or its low-rank adapter (lora_A, lora_B).
+ */
+
+#define CHECKPOINT_MAX_LAYERS 16
+#define OFFLOAD_WINDOW 3
+// Size in bytes of the DMA transfers of an offloaded activation, below the per-transfer limit of the cluster DMA
+#ifndef OFFLOAD_DMA_CHUNK
+#define OFFLOAD_DMA_CHUNK 32768
+#endif
+
+/**
+ * @brief Description of a layer of the network, as seen by the network-level functions
+ * @param fw forward function of the layer (e.g. pulp_conv2d_fp32_fw_cl)
+ * @param bw backward function of the layer (e.g. pulp_conv2d_fp32_bw_cl), used if bw_param and bw_input are not set
+ * @param bw_param weight gradient function of the layer (e.g. pulp_conv2d_fp32_bw_param_grads_cl), NULL for layers without weights
+ * @param bw_input input gradient function of the layer (e.g. pulp_conv2d_fp32_bw_input_grads_cl), NULL for layers without weights
+ * @param args configuration structure of the layer, passed to fw and bw
+ * @param input input blob of the layer (shares its data with the output blob of the previous layer)
+ * @param output output blob of the layer
+ * @param coeff weight blob of the layer, NULL for layers without weights
+ * @param trainable set to 1 to train the weights of the layer, 0 to freeze them
+ * @param fw_cost estimated cost of the forward of the layer (e.g. its MACs), used by the checkpoint planner. If 0, output->dim is used
+ * @param update_rows sparse update: output channels to be updated (the same list as in the args of the layer), NULL to update all of them
+ * @param num_update_rows sparse update: number of elements of update_rows
+ * @param bias bias blob of the layer (the same as in the args of the layer), NULL if none
+ * @param lora_A "up" matrix of the low-rank adapter of the layer (the same as in the args of the layer), NULL if none
+ * @param lora_B "down" matrix of the low-rank adapter of the layer
+ * @param skip_wgt_grad set to 1 if the weights are frozen while the bias and/or the adapter are trained (the same as in the args of the layer)
+ */
+struct net_layer {
+  void (*fw)(void *);
+  void (*bw)(void *);
+  void (*bw_param)(void *);
+  void (*bw_input)(void *);
+  void * args;
+  struct blob * input;
+  struct blob * output;
+  struct blob * coeff;
+  int trainable;
+  int fw_cost;
+  int * update_rows;
+  int num_update_rows;
+  struct blob * bias;
+  struct blob * lora_A;
+  struct blob * lora_B;
+  int skip_wgt_grad;
+};
+
+/**
+ * @brief Arguments of the network-level functions
+ * @param layers array of num_layers layer descriptions, in forward order
+ * @param num_layers number of layers of the network
+ * @param checkpoint array of num_layers flags. checkpoint[i]=1 keeps the input of layer i alive until backward (checkpoint[0] is always 1). Set to NULL to keep every activation (no recomputation)
+ * @param arena L1 buffer holding the non-checkpointed activations (sized with pulp_net_checkpoint_cost()) or the offload window (sized with pulp_net_offload_size())
+ * @param offload set to 1 to park the activations in L2 between forward and backward (checkpoint has to be NULL)
+ * @param l2_buffer L2 buffer receiving the offloaded activations (sized with pulp_net_offload_size())
+ */
+struct net_args {
+  struct net_layer * layers;
+  int num_layers;
+  int * checkpoint;
+  float * arena;
+  int offload;
+  float * l2_buffer;
+};
+
+
+/**
+ * Gradient checkpointing
+ */
+
+/**
+ * @brief Evaluates the cost model of the current checkpoint marks. Activation sizes are taken from the input blobs of the layers.
+ * @param args network whose checkpoint array has to be evaluated
+ * @param memory if not NULL, returns the peak number of activation elements kept in L1 (sample input and network output excluded)
+ * @param arena_size if not NULL, returns the number of elements the arena has to hold
+ * @return cost of the forward recomputations of a training step
+ */
+int pulp_net_checkpoint_cost( struct net_args * args, int * memory, int * arena_size );
+
+/**
+ * @brief Selects the checkpoints which minimize the recomputation cost while fitting an L1 activation budget. Fills args->checkpoint (max CHECKPOINT_MAX_LAYERS layers).
+ * @param args network to be planned (checkpoint must point to an array of num_layers integers)
+ * @param budget maximum number of activation elements to be kept in L1 (as computed by pulp_net_checkpoint_cost())
+ * @return recomputation cost of the chosen plan, -1 if no plan fits the budget (checkpoint is then set to the plan with the smallest memory)
+ */
+int pulp_net_checkpoint_plan( struct net_args * args, int budget );
+
+/**
+ * @brief Maps the non-checkpointed activations into the arena (sets the data of the input blob of the layer and of the output blob of the previous one). Call it after planning and before the first forward.
+ * @param args network to be bound (its arena needs the size returned by pulp_net_checkpoint_cost())
+ */
+void pulp_net_checkpoint_bind( struct net_args * args );
+
+
+/**
+ * Activation offload to L2
+ */
+
+/**
+ * @brief Computes the buffer sizes needed to offload the activations of a network
+ * @param args network to be offloaded
+ * @param window_size if not NULL, returns the number of elements of the L1 window (args->arena)
+ * @param l2_size if not NULL, returns the number of elements of the L2 buffer (args->l2_buffer)
+ */
+void pulp_net_offload_size( struct net_args * args, int * window_size, int * l2_size );
+
+/**
+ * @brief Maps the intermediate activations onto the slots of the L1 window. Call it once before the first forward.
+ * @param args network to be bound (with offload set and arena sized by pulp_net_offload_size())
+ */
+void pulp_net_offload_bind( struct net_args * args );
+
+
+/**
+ * Training functions
+ */
+
+/**
+ * @brief Forward pass of the whole network, layer by layer. With offload, the consumed activations are DMA'd to L2 while the next layers run.
+ * @param args network to be run
+ */
+void pulp_net_fp32_fw( struct net_args * args );
+
+/**
+ * @brief Backward pass of the network, down to its lowest trainable layer. With checkpointing, the forward of each segment is re-run before its backward. With offload, the activations are prefetched from L2 one layer ahead.
+ * @param args network to be run (the gradient of the output of the last layer has to be already computed)
+ */
+void pulp_net_fp32_bw( struct net_args * args );
+
+/**
+ * @brief Gradient descent update of the trainable layers of the network: weights (only the selected rows of the layers with update_rows, none if skip_wgt_grad is set), bias and adapter
+ * @param args network to be updated
+ * @param learning_rate learning rate of the update
+ */
+void pulp_net_fp32_update( struct net_args * args, float learning_rate );
+
+/**
+ * @brief Returns the lowest layer with trainable weights (the backward stops there)
+ * @param args network to be inspected
+ * @return index of the layer, num_layers if no layer is trainable
+ */
+int pulp_net_lowest_trainable( struct net_args * args );
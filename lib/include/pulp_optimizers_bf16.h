@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Optimizer configuration structure
+ */
+
+/**
+ * @brief Parameters for optimizer functions for every single layer in BF16
+ * @param weights blob of the weights (with their gradient inside)
+ * @param learning_rate the learning rate of the optimizer
+ * @param master optional fp32 master copy of the weights (NULL if not used). Updates smaller than half a bf16 ulp of a weight are lost when rounding in place, while they accumulate in the master copy.
+ */
+struct optim_args_bf16 {
+  struct blob_bf16 * weights;
+  float learning_rate;
+  float * master;
+};
+
+
+
+/**
+ * Optimizers
+ **/
+
+/**
+ * @brief Gradient descent optimizer for a single layer, computed in fp32. If master is set, the fp32 master weights are updated and cast to bf16, otherwise the bf16 weights are updated in place. Use pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_bf16, &args) to parallelize.
+ * @param optim_args pointer to optim_args_bf16 structure
+ */
+void pulp_gradient_descent_bf16(
+    void * optim_args
+);
@@ -27,10 +27,16 @@
  * @brief Structure for optimizers
  * @param weights blob of the weights (with their gradient inside)
  * @param learning_rate the learning rate of the optimizer
+ * @param update_rows sparse update: list of the weight rows to be updated (pulp_gradient_descent_fp32_sparse only)
+ * @param num_update_rows sparse update: number of elements of update_rows
+ * @param row_size sparse update: number of weights of a row (e.g. C_in*pH*pW for a conv2d)
  */
 struct optim_args {
   struct blob * weights;
   float learning_rate;
+  int * update_rows;
+  int num_update_rows;
+  int row_size;
 };
 
 
@@ -46,3 +52,11 @@ struct optim_args {
 void pulp_gradient_descent_fp32(
     void * optim_args
 );
+
+/**
+ * @brief Gradient descent optimizer for a sparse update: weight row update_rows[r] is updated with row r of the (compact) weight gradient, the other rows are left untouched. Use pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_fp32_sparse, &args) to parallelize.
+ * @param optim_args pointer to optim_args structure (see pulp_train_utils_fp32.h) 
+ */
+void pulp_gradient_descent_fp32_sparse(
+    void * optim_args
+);
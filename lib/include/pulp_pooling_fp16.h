@@ -30,6 +30,12 @@
  * @param Wker horizontal size of the pooling kernel
  * @param Hstride controls the vertical stride of the kernel
  * @param Wstride controls the horizontal stride of the kernel
+ * @param Lpad left padding of the input
+ * @param Rpad right padding of the input
+ * @param Upad upper padding of the input
+ * @param Dpad lower padding of the input (padded elements are ignored by the maxpool and count as zeros in the avgpool)
+ * @param HWC tells the pooling if the input/output tensors are in CHW layout (HWC=0) or HWC format (HWC=1)
+ * @param argmax (maxpool only) optional buffer of output->dim elements where the forward stores the position of the maximum inside each pooling window (wk + hk*Wker). If not NULL, the backward routes the gradient with these indices instead of searching the maximum again. Requires Hker*Wker <= 256.
  */
 struct pool_args_fp16 {
   struct blob_fp16 * input;
@@ -38,11 +44,18 @@ struct pool_args_fp16 {
   int Wker;
   int Hstride;
   int Wstride;
+  int Lpad;
+  int Rpad;
+  int Upad;
+  int Dpad;
+  int HWC;
+  uint8_t * argmax;
 };
 
 
 /**
- * Pooling functions
+ * Pooling functions. They are parallelized over the output rows of all the channels (forward) or over the input rows of 
+ * all the channels (backward, gathering from the windows covering each input), so that they scale also when C < NUM_CORES.
  **/
 
 /**
@@ -52,19 +65,33 @@ struct pool_args_fp16 {
 void pulp_avgpool_fp16_fw_cl(void * pool_args);
 
 /**
- * @brief Backward pass function (parallelize with pi_cl_team_fork(NUM_CORES, pulp_avgpool_fp16_bw_cl, &args);)
+ * @brief Backward pass function (parallelize with pi_cl_team_fork(NUM_CORES, pulp_avgpool_fp16_bw_cl, &args);). Writes each input gradient once, without a zeroing pass.
  * @param pool_args pointer to a struct pool_args structure.
 */
 void pulp_avgpool_fp16_bw_cl(void * pool_args);
 
 /**
- * @brief Forward pass function (parallelize with pi_cl_team_fork(NUM_CORES, pulp_avgpool_fp16_fw_cl, &args);)
+ * @brief Forward pass function (parallelize with pi_cl_team_fork(NUM_CORES, pulp_maxpool_fp16_fw_cl, &args);). Stores the argmax of each window if args->argmax is set.
  * @param pool_args pointer to a struct pool_args structure.
 */
 void pulp_maxpool_fp16_fw_cl(void * pool_args);
 
 /**
- * @brief Backward pass function (parallelize with pi_cl_team_fork(NUM_CORES, pulp_avgpool_fp16_bw_cl, &args);)
+ * @brief Backward pass function (parallelize with pi_cl_team_fork(NUM_CORES, pulp_maxpool_fp16_bw_cl, &args);). With args->argmax set, each input gathers the 
+ * gradient of the windows that selected it from the stored indices and is written once, without a zeroing pass. Otherwise the maximum is searched again, in parallel over the channels.
+ * @param pool_args pointer to a struct pool_args structure.
+*/
+void pulp_maxpool_fp16_bw_cl(void * pool_args);
+
+/**
+ * @brief Global average pooling forward, output[c] = mean of input channel c (output is C x 1 x 1). Uses input, output and HWC of the pool_args structure.
+ * Parallelizes over the channels, or over the spatial positions (with a final reduction) when C < NUM_CORES. Parallelize with pi_cl_team_fork(NUM_CORES, pulp_global_avgpool_fp16_fw_cl, &args);
+ * @param pool_args pointer to a struct pool_args structure.
+*/
+void pulp_global_avgpool_fp16_fw_cl(void * pool_args);
+
+/**
+ * @brief Global average pooling backward, broadcasting output_diff[c] / (H*W) to the whole channel. Parallelizes over the whole input.
  * @param pool_args pointer to a struct pool_args structure.
 */
-void pulp_maxpool_fp16_bw_cl(void * pool_args);
\ No newline at end of file
+void pulp_global_avgpool_fp16_bw_cl(void * pool_args);
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Latent replay buffer for continual learning. Instead of raw inputs, the buffer stores the activations entering
+ * the trainable tail of the network (the "latent" activations), so replayed samples skip the frozen front layers.
+ * Activations are compressed (fp16 or int8 with a per-sample scale) and kept in L2, one record per sample:
+ *
+ *   record:  [ compressed activation (padded to 4 bytes) | scale (float) | label (label_size floats) ]
+ *
+ * Records are compressed on the cluster into an L1 staging area and DMA'd to L2. Replayed records are DMA'd back
+ * one sample ahead (double buffering), then decompressed into the input blob of the tail.
+ */
+
+#define REPLAY_FP16   0
+#define REPLAY_INT8   1
+
+#define REPLAY_RESERVOIR        0
+#define REPLAY_CLASS_BALANCED   1
+
+// Size in bytes of a record of the replay buffer
+#define REPLAY_RECORD_BYTES(act_size, label_size, format) \
+  (((((format) == REPLAY_INT8 ? 1 : 2) * (act_size) + 3) & ~3) + 4 + 4 * (label_size))
+
+/**
+ * @brief Latent replay buffer structure
+ * @param storage L2 buffer of capacity records (REPLAY_RECORD_BYTES() bytes each)
+ * @param capacity maximum number of stored samples
+ * @param act_size number of elements of a latent activation
+ * @param label_size number of elements of a label
+ * @param format compression of the activations (REPLAY_FP16 or REPLAY_INT8)
+ * @param policy replacement policy when the buffer is full (REPLAY_RESERVOIR or REPLAY_CLASS_BALANCED)
+ * @param num_classes number of classes (REPLAY_CLASS_BALANCED only)
+ * @param classes array of capacity integers with the class of each record (REPLAY_CLASS_BALANCED only)
+ * @param class_count array of 2*num_classes integers: stored and seen samples per class (REPLAY_CLASS_BALANCED only)
+ * @param l1_buffer L1 staging area of 3 records (2 for the replay double buffer, 1 for the insertion)
+ * @param partial L1 array of NUM_CORES floats for the int8 scale reduction
+ * @param seed state of the random generator (must not be 0)
+ * @param output blob receiving the replayed activation (the input of the first trainable layer)
+ * @param label label of the replayed activation, set by pulp_replay_next()
+ * @param count (internal) number of stored samples
+ * @param seen (internal) number of samples offered to the buffer
+ * @param slot (internal) staging record being loaded
+ * @param next_record (internal) record being loaded, -1 if none
+ * @param pending (internal) DMA transfers in flight (bit 0: record being loaded, bit 1: record being stored)
+ * @param dma_read (internal) DMA transfer of the record being loaded
+ * @param dma_write (internal) DMA transfer of the record being stored
+ */
+struct replay_args {
+  uint8_t * storage;
+  int capacity;
+  int act_size;
+  int label_size;
+  int format;
+  int policy;
+  int num_classes;
+  int * classes;
+  int * class_count;
+  uint8_t * l1_buffer;
+  float * partial;
+  unsigned int seed;
+  struct blob * output;
+  float * label;
+  int count;
+  int seen;
+  int slot;
+  int next_record;
+  int pending;
+  pi_cl_dma_copy_t dma_read;
+  pi_cl_dma_copy_t dma_write;
+};
+
+/**
+ * @brief Arguments of the replay compression kernels
+ * @param data fp32 activation
+ * @param packed compressed activation (fp16 or int8)
+ * @param scale int8 quantization step
+ * @param partial per-core maxima of |data|
+ * @param size number of elements
+ */
+struct replay_pack_args {
+  float * data;
+  void * packed;
+  float scale;
+  float * partial;
+  int size;
+};
+
+
+/**
+ * @brief Empties the replay buffer. To be called on the cluster.
+ * @param args replay buffer to be initialized
+ */
+void pulp_replay_init( struct replay_args * args );
+
+/**
+ * @brief Offers a sample to the replay buffer. The activation is compressed and stored in L2 if the replacement policy accepts it.
+ * @param args replay buffer
+ * @param activation latent activation of the sample (act_size elements, L1)
+ * @param label label of the sample (label_size elements)
+ * @param class class of the sample (used by REPLAY_CLASS_BALANCED)
+ * @return index of the record that has been written, -1 if the sample has been discarded
+ */
+int pulp_replay_add( struct replay_args * args, float * activation, float * label, int class );
+
+/**
+ * @brief Decompresses a random stored sample into args->output and args->label, and starts loading the next one in the other staging record.
+ * @param args replay buffer (not empty)
+ * @return index of the replayed record
+ */
+int pulp_replay_next( struct replay_args * args );
+
+
+/**
+ * Compression kernels, forked on the cluster
+ */
+
+/**
+ * @brief Casts an fp32 activation to fp16. Use pi_cl_team_fork(NUM_CORES, pulp_replay_pack_fp16, &args).
+ * @param (void *) (struct replay_pack_args void_args)
+ */
+void pulp_replay_pack_fp16( void * void_args );
+
+/**
+ * @brief Casts an fp16 activation back to fp32. Use pi_cl_team_fork(NUM_CORES, pulp_replay_unpack_fp16, &args).
+ * @param (void *) (struct replay_pack_args void_args)
+ */
+void pulp_replay_unpack_fp16( void * void_args );
+
+/**
+ * @brief Computes the per-core maxima of |data| into partial. Use pi_cl_team_fork(NUM_CORES, pulp_replay_absmax, &args).
+ * @param (void *) (struct replay_pack_args void_args)
+ */
+void pulp_replay_absmax( void * void_args );
+
+/**
+ * @brief Quantizes an fp32 activation to int8 (round to nearest, step scale). Use pi_cl_team_fork(NUM_CORES, pulp_replay_pack_int8, &args).
+ * @param (void *) (struct replay_pack_args void_args)
+ */
+void pulp_replay_pack_int8( void * void_args );
+
+/**
+ * @brief Dequantizes an int8 activation to fp32. Use pi_cl_team_fork(NUM_CORES, pulp_replay_unpack_int8, &args).
+ * @param (void *) (struct replay_pack_args void_args)
+ */
+void pulp_replay_unpack_int8( void * void_args );
@@ -39,6 +39,11 @@
  *     |
  *   Output
  * 
+ * Zero-copy backward: the two branches of the residual connection only read the output gradient, so their diff
+ * pointers can alias activation2->diff. pulp_residualconn_fp32_bw() then skips the corresponding copies (it becomes
+ * a no-op if both branches alias). On the sum node, activation2->diff can alias activation0->diff or 
+ * activation1->diff to accumulate the gradient in place instead of writing a third buffer.
+ * 
  */
 
 /**
@@ -46,11 +51,13 @@
  * @param activation0 first activation to be summed 
  * @param activation1 second activation to be summed
  * @param activation2 output sum activation (forward: activation data, backward: activation gradient)
+ * @param scale scaling factor of activation0 (used only by the skip-add + scale primitives)
  */
 struct SkipConn_args {
     struct blob * activation0;
     struct blob * activation1;
     struct blob * activation2;
+    float scale;
 };
 
 
@@ -74,12 +81,31 @@ void pulp_sumnode_fp32_fw( void * SkipConn_args );
  */
 void pulp_residualconn_fp32_fw( void * SkipConn_args );
 
+/**
+ * @brief Fused residual connection and ReLU, activation2 = max(activation0 + activation1, 0), in a single pass
+ * 
+ * @param activation0 activation coming from the layers
+ * @param activation1 input activation of the skipped layer
+ * @param activation2 output activation data
+ */
+void pulp_residualconn_relu_fp32_fw( void * SkipConn_args );
+
+/**
+ * @brief Fused residual connection with scaled branch, activation2 = scale * activation0 + activation1, in a single pass
+ * 
+ * @param activation0 activation coming from the layers (scaled)
+ * @param activation1 input activation of the skipped layer
+ * @param activation2 output activation data
+ * @param scale scaling factor of activation0
+ */
+void pulp_residualconn_scale_fp32_fw( void * SkipConn_args );
+
 
 
 // BACKWARD FUNCTIONS
 
 /**
- * @brief Accumulates the output gradients on an input gradient 
+ * @brief Accumulates the output gradients on an input gradient. activation2->diff may alias one of the two gradients.
  * 
  * @param activation0 first activation to be summed
  * @param activation1 second activation to be summed
@@ -88,10 +114,51 @@ void pulp_residualconn_fp32_fw( void * SkipConn_args );
 void pulp_sumnode_fp32_bw( void * SkipConn_args );
 
 /**
- * @brief Dispatches the gradient coming from the output of a residual connection sum node to the layers and their input
+ * @brief Dispatches the gradient coming from the output of a residual connection sum node to the layers and their input.
+ * Branches whose diff aliases activation2->diff are skipped; two distinct branches are written in a single pass.
  * 
  * @param activation0 gradient going to the skipped layers
  * @param activation1 gradient going to the input of the skipped layers
  * @param activation2 output gradient to be dispatched to the input grads
  */
 void pulp_residualconn_fp32_bw( void * SkipConn_args );
+
+/**
+ * @brief Backward of the fused residual connection and ReLU: applies the ReLU mask (from activation2 data) to the output
+ * gradient once and writes it to both branches in the same pass. The branch diffs may alias activation2->diff.
+ * 
+ * @param activation0 gradient going to the skipped layers
+ * @param activation1 gradient going to the input of the skipped layers
+ * @param activation2 output activation (data) and gradient to be dispatched (diff)
+ */
+void pulp_residualconn_relu_fp32_bw( void * SkipConn_args );
+
+/**
+ * @brief Backward of the residual connection with scaled branch: activation0 receives scale * gradient, activation1 the gradient,
+ * in a single pass. activation1->diff may alias activation2->diff.
+ * 
+ * @param activation0 gradient going to the skipped layers
+ * @param activation1 gradient going to the input of the skipped layers
+ * @param activation2 output gradient to be dispatched to the input grads
+ * @param scale scaling factor of activation0
+ */
+void pulp_residualconn_scale_fp32_bw( void * SkipConn_args );
+
+
+
+// PARALLEL KERNELS
+
+/**
+ * @brief Copies the output gradient (activation2) into the gradients of both branches (activation0, activation1) with a single read.
+ * @param SkipConn_args pointer to a SkipConn_args structure
+ */
+void residualconn_fp32_bw_kernel( void * SkipConn_args );
+
+/**
+ * @brief Parallel kernels of the fused residual primitives (use the pulp_residualconn_*_fp32 functions above)
+ * @param SkipConn_args pointer to a SkipConn_args structure
+ */
+void residualconn_relu_fp32_fw_kernel( void * SkipConn_args );
+void residualconn_relu_fp32_bw_kernel( void * SkipConn_args );
+void residualconn_scale_fp32_fw_kernel( void * SkipConn_args );
+void residualconn_scale_fp32_bw_kernel( void * SkipConn_args );
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Recurrent layer training functions, grouped into FW and BW
+*/
+
+/**
+ * Authors: Francesco Conoscenti, Alberto Dequino
+*/ 
+
+
+/**
+ * Recursive Neural Network layer configuration structure
+ */
+
+/**
+ * @brief Structure for RNN Training in FP16
+ * @param input             Input vector for the RNN layer.
+ * @param state             Vector of current hidden state.
+ * @param output            Output vector & next current state.
+ * @param coeff_x           Weight for input vector.
+ * @param coeff_s           Weight for state vector.
+ * @param grad_buffer       Buffer used for saving the pre-activation gradient of each timestep in the BW step (N*M).
+ * @param temp_buffer       Buffer for the transposed operands of the BW weight gradient matmuls (N*M + N*max(K,M)).
+ * @param bptt_window       Truncated-BPTT window: the recurrent gradient is cut every bptt_window timesteps (0 backpropagates through the whole sequence).
+ */
+
+struct Rnn_args_fp16 {
+    struct blob_fp16 * input;
+    struct blob_fp16 * state; 
+    struct blob_fp16 * output;
+    struct blob_fp16 * coeff_x;
+    struct blob_fp16 * coeff_s;
+    fp16 * grad_buffer; 
+    fp16 * temp_buffer;
+    int bptt_window;
+};
+
+
+
+
+/**
+ * RNN layer training functions, grouped into FW and BW
+ */
+
+// FORWARD FUNCTIONS
+
+/**
+ * @brief Forward pass function, forked on PULP cluster. Computes the input projection of the whole sequence with a
+ * SIMD matmul (scalar when K or M is odd), then runs the recurrence h_t = tanh(x_t*Wx + h_(t-1)*Ws) over the N
+ * timesteps of the input inside the same fork, so that Ws stays resident for the whole sequence. Row 0 of state must
+ * contain the initial hidden state; rows 1..N-1 are filled with h_0..h_(N-2) for the backward step.
+ * @param input     Input sequence (N timesteps of K elements).
+ * @param state     Previous hidden state of each timestep (N*M).
+ * @param output    Hidden state produced at each timestep (N*M); its last row is the final state.
+ * @param coeff_x   Weight for input vector (K*M).
+ * @param coeff_s   Weight for state vector (M*M).
+ */
+void pulp_rnn_fp16_fw_cl(void * Rnn_args_fp16);
+
+
+// BACKWARD FUNCTIONS
+
+/**
+ * @brief Backward-through-time function, which internally calculate both weight gradient and input gradient.
+ * The timestep gradients are computed in a single fork, then the weight and input gradients are obtained with
+ * three SIMD matmuls on the stored gradients (scalar ones when a row length is odd).
+ * @param input     Input sequence.
+ * @param state     Previous hidden state of each timestep, as stored by the forward step.
+ * @param output    Hidden state of each timestep and its gradient.
+ * @param coeff_x   weight input matrix 
+ * @param coeff_s   weight state matrix
+ * @param grad_buffer   Buffer for the pre-activation gradients (N*M)
+ * @param temp_buffer   Buffer for the transposed operands
+ * @param bptt_window   Truncated-BPTT window (0 for full BPTT)
+ */
+void pulp_rnn_fp16_bw_cl(void * Rnn_args_fp16);
+
+
+
+// PARALLEL KERNELS
+
+/**
+ * @brief Forward recurrence, parallelized over pairs of hidden units (single units when M is odd, as the rows
+ * of the states and of Ws are then not 4-byte aligned). Each step fuses the state projection
+ * with the precomputed input projection and the fp16 tanh; the cores synchronize once per timestep.
+ * @param Rnn_args_fp16 pointer to a Rnn_args_fp16 structure
+ */
+void pulp_rnn_fp16_fw_kernel(void * Rnn_args_fp16);
+
+/**
+ * @brief Backward recurrence, parallelized over the hidden units. Computes grad_t = (1 - h_t^2) * (dh_t + grad_(t+1)*Ws^T)
+ * from the last timestep to the first (on fp16 pairs when M is even), cutting the recurrent term at the truncated-BPTT window boundaries, then the
+ * weight and input gradients with SIMD matmuls on transposed operands.
+ * @param Rnn_args_fp16 pointer to a Rnn_args_fp16 structure
+ */
+void pulp_rnn_fp16_bw_kernel(void * Rnn_args_fp16);
@@ -35,8 +35,8 @@
  * @param output            Output vector & next current state.
  * @param coeff_x           Weight for input vector.
  * @param coeff_s           Weight for state vector.
- * @param temp_buffer       Temporary vector for BW transpose operations.
- * @param grad_buffer       Buffer used for saving the output gradient in the BW step.
+ * @param grad_buffer       Buffer used for saving the pre-activation gradient of each timestep in the BW step (N*M).
+ * @param bptt_window       Truncated-BPTT window: the recurrent gradient is cut every bptt_window timesteps (0 backpropagates through the whole sequence).
  */
 
 struct Rnn_args {
@@ -45,8 +45,8 @@ struct Rnn_args {
     struct blob * output;
     struct blob * coeff_x;
     struct blob * coeff_s;
-    float * temp_buffer;
     float * grad_buffer; 
+    int bptt_window;
 };
 
 
@@ -59,12 +59,14 @@ struct Rnn_args {
 // FORWARD FUNCTIONS
 
 /**
- * @brief Forward pass function, forked on PULP cluster.
- * @param input     Input vector.
- * @param state     Vector of current hidden state.
- * @param output    Output vector & next current state.
- * @param coeff_x   Weight for input vector.
- * @param coeff_s   Weight for state vector.
+ * @brief Forward pass function, forked on PULP cluster. Runs the recurrence h_t = tanh(x_t*Wx + h_(t-1)*Ws) over the
+ * N timesteps of the input inside a single fork, so that Ws stays resident for the whole sequence. Row 0 of state must
+ * contain the initial hidden state; rows 1..N-1 are filled with h_0..h_(N-2) for the backward step.
+ * @param input     Input sequence (N timesteps of K elements).
+ * @param state     Previous hidden state of each timestep (N*M).
+ * @param output    Hidden state produced at each timestep (N*M); its last row is the final state.
+ * @param coeff_x   Weight for input vector (K*M).
+ * @param coeff_s   Weight for state vector (M*M).
  */
 void pulp_rnn_fp32_fw_cl(void * Rnn_args);
 
@@ -72,11 +74,33 @@ void pulp_rnn_fp32_fw_cl(void * Rnn_args);
 // BACKWARD FUNCTIONS
 
 /**
- * @brief Backward pass function, which internally calculate both weight gradient and input gradient.
- * @param input     Input vector.
- * @param state     Vector current hidden state.
- * @param output    Output vector & next current state.
+ * @brief Backward-through-time function, which internally calculate both weight gradient and input gradient.
+ * The timestep gradients are computed in a single fork, then the weight and input gradients are obtained with
+ * three matmuls on the stored gradients.
+ * @param input     Input sequence.
+ * @param state     Previous hidden state of each timestep, as stored by the forward step.
+ * @param output    Hidden state of each timestep and its gradient.
  * @param coeff_x   weight input matrix 
  * @param coeff_s   weight state matrix
+ * @param grad_buffer   Buffer for the pre-activation gradients (N*M)
+ * @param bptt_window   Truncated-BPTT window (0 for full BPTT)
  */
 void pulp_rnn_fp32_bw_cl(void * Rnn_args);
+
+
+
+// PARALLEL KERNELS
+
+/**
+ * @brief Forward recurrence, parallelized over the hidden units. Each step fuses the input and state projections
+ * with the tanh activation; the cores synchronize once per timestep.
+ * @param Rnn_args pointer to a Rnn_args structure
+ */
+void pulp_rnn_fp32_fw_kernel(void * Rnn_args);
+
+/**
+ * @brief Backward recurrence, parallelized over the hidden units. Computes grad_t = (1 - h_t^2) * (dh_t + grad_(t+1)*Ws^T)
+ * from the last timestep to the first, cutting the recurrent term at the truncated-BPTT window boundaries.
+ * @param Rnn_args pointer to a Rnn_args structure
+ */
+void pulp_rnn_fp32_bw_kernel(void * Rnn_args);
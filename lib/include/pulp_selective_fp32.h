@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Selective backpropagation: after the loss of a sample has been computed, a policy decides whether the sample
+ * is worth its backward and weight update. Easy samples (low loss) are skipped, saving the backward (about 2x
+ * the forward) and the update. Policies:
+ *
+ *   SELECT_THRESHOLD   backprop if loss >= threshold
+ *   SELECT_PERCENTILE  backprop if the loss is above the given percentile of the recent losses
+ *   SELECT_PROB        backprop with probability rank^beta, rank being the fraction of recent losses below the
+ *                      loss of the sample (rank-based selection: hard samples are almost always kept)
+ *
+ * Recent losses are kept in a ring buffer of history_size entries (all the samples, selected or not).
+ */
+
+#define SELECT_THRESHOLD    0
+#define SELECT_PERCENTILE   1
+#define SELECT_PROB         2
+
+/**
+ * @brief Selective backpropagation structure
+ * @param policy selection policy (SELECT_THRESHOLD, SELECT_PERCENTILE or SELECT_PROB)
+ * @param threshold SELECT_THRESHOLD: minimum loss of a backpropagated sample
+ * @param percentile SELECT_PERCENTILE: percentile of the recent losses (0..1) a sample has to exceed, e.g. 0.5 keeps about half of the samples
+ * @param beta SELECT_PROB: exponent of the selection probability (higher values skip more samples)
+ * @param history array of history_size floats for the recent losses (SELECT_PERCENTILE and SELECT_PROB)
+ * @param history_size number of recent losses used to rank a sample
+ * @param seed state of the random generator (SELECT_PROB, must not be 0)
+ * @param count (internal) number of valid entries of history
+ * @param pos (internal) next entry of history to be written
+ * @param seen number of samples offered to the policy
+ * @param selected number of backpropagated samples
+ * @param bp_cycles cycles spent in backward and update by the selected samples (accumulated by the caller)
+ */
+struct selective_args {
+  int policy;
+  float threshold;
+  float percentile;
+  float beta;
+  float * history;
+  int history_size;
+  unsigned int seed;
+  int count;
+  int pos;
+  int seen;
+  int selected;
+  unsigned long bp_cycles;
+};
+
+
+/**
+ * @brief Empties the loss history and resets the counters
+ * @param args selective backpropagation structure to be initialized
+ */
+void pulp_selective_init( struct selective_args * args );
+
+/**
+ * @brief Decides whether a sample has to be backpropagated, and records its loss
+ * @param args selective backpropagation structure
+ * @param loss loss of the sample
+ * @return 1 if backward and update have to be run, 0 if the sample is skipped
+ */
+int pulp_selective_select( struct selective_args * args, float loss );
+
+/**
+ * @brief Prints the skipped fraction and the estimated cycles saved (skipped samples times the average backward and update cycles of the selected ones)
+ * @param args selective backpropagation structure
+ */
+void pulp_selective_report( struct selective_args * args );
@@ -32,15 +32,21 @@
 #include "pulp_conv_dw_fp32.h"
 #include "pulp_conv_pw_fp32.h"
 #include "pulp_conv2d_fp32.h"
+#include "pulp_dataset_fp32.h"
 #include "pulp_im2col_fp32.h"
 #include "pulp_linear_fp32.h"
 #include "pulp_losses_fp32.h"
 #include "pulp_matmul_fp32.h"
 #include "pulp_optimizers_fp32.h"
 #include "pulp_pooling_fp32.h"
+#include "pulp_replay_fp32.h"
 #include "pulp_residual_fp32.h"
 #include "pulp_rnn_fp32.h"
+#include "pulp_selective_fp32.h"
+#include "pulp_lstm_fp32.h"
+#include "pulp_gru_fp32.h"
 #include "pulp_mhsa_fp32.h"
+#include "pulp_net_fp32.h"
 
 
 // FP16 structures
@@ -58,4 +64,19 @@
 #include "pulp_pooling_fp16.h"
 #include "pulp_residual_fp16.h"
 #include "pulp_mhsa_fp16.h"
+#include "pulp_rnn_fp16.h"
+#include "pulp_lstm_fp16.h"
+#include "pulp_gru_fp16.h"
+#include "pulp_amp_fp16.h"
+
+
+// BF16 structures
+#include "pulp_train_utils_bf16.h"
+// BF16 primitives
+#include "pulp_act_bf16.h"
+#include "pulp_conv2d_bf16.h"
+#include "pulp_linear_bf16.h"
+#include "pulp_losses_bf16.h"
+#include "pulp_matmul_bf16.h"
+#include "pulp_optimizers_bf16.h"
 
@@ -29,6 +29,7 @@
  */
 typedef float16 fp16;                                    // Standard IEEE FP16 format
 typedef fp16 v2f16 __attribute__((vector_size (4)));        // Vectorized fp16 for SIMD
+typedef uint16_t bf16;                                   // Brain floating point (bfloat16), stored as raw bits (see bf16_to_fp32() / fp32_to_bf16())
 /**
  * @}
  */
@@ -65,4 +66,27 @@ typedef fp16 v2f16 __attribute__((vector_size (4)));        // Vectorized fp16 f
  * @}
  */
 
-    
\ No newline at end of file
+    
+/**
+ * @defgroup Selects the accuracy/speed trade-off of the transcendental functions (exp, tanh, sigmoid) used by the activations. Override with -DACT_APPROX=ACT_EXACT.
+ * @{
+ */
+#define ACT_EXACT 0                                     // libm expf() / tanhf()
+#define ACT_FAST 1                                      // Bit-manipulation approximations (fastexp, fasttanh, rational tanh for fp16)
+#ifndef ACT_APPROX
+#define ACT_APPROX ACT_FAST
+#endif
+/**
+ * @}
+ */
+
+/**
+ * @defgroup Number of keys (or queries) processed per block by the tiled (flash) attention kernels. Each core keeps one block of scores on its stack.
+ * @{
+ */
+#ifndef MHSA_FLASH_TILE
+#define MHSA_FLASH_TILE 16
+#endif
+/**
+ * @}
+ */
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * BF16 (bfloat16) keeps the 8-bit exponent of fp32 and truncates the mantissa to 7 bits: same range as fp32, half
+ * the memory. Values are stored as raw bits (uint16_t) and the primitives compute and accumulate in fp32, so no
+ * hardware support is needed: a bf16 is the upper half of an fp32.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_defines.h"
+
+/**
+ * =====> BACKEND STRUCTURES <=====
+ */
+
+/**
+ * @brief "Bunch of data" structure, grouping a tensor and its gradient and sizes.
+ * @param data pointer to the input data array
+ * @param diff pointer to the input diff array
+ * @param dim size of data as a 1-D array on memory
+ * @param W width of data
+ * @param H height of data
+ * @param C number of channels of data
+ */
+struct blob_bf16 {
+   bf16 * data;
+   bf16 * diff;
+   int dim;
+   int W;
+   int H;
+   int C;
+};
+
+/**
+ * @brief Arguments for the matmuls and the naive convolution kernels in BF16 (C=A*B, C is N*M, A is N*K, B is K*M, or M*K if trans_B)
+ * @param A matrix A
+ * @param B matrix B
+ * @param C matrix C
+ * @param N rows of A and C
+ * @param M columns of B and C
+ * @param K columns of A, rows of B
+ * @param trans_B set to 1 if B is stored transposed (M*K)
+ * @param H, W, pW, pH, pCin, pCout, stride_h, stride_w, Lpad, Rpad, Upad, Dpad sizes of the naive convolution kernels
+ */
+struct matMul_args_bf16 {
+  bf16 * __restrict__ A;
+  bf16 * __restrict__ B;
+  bf16 * __restrict__ C;
+  int N;
+  int M;
+  int K;
+  int trans_B;
+  // For the naive conv2d kernels
+  int H;
+  int W;
+  int pW;
+  int pH;
+  int pCin;
+  int pCout;
+  int stride_h;
+  int stride_w;
+  int Lpad;
+  int Rpad;
+  int Upad;
+  int Dpad;
+};
+
+/**
+ * @brief Arguments to cast a FP32 tensor to BF16
+ * @param source FP32 tensor
+ * @param destination BF16 tensor (4-byte aligned)
+ * @param size number of elements
+ */
+struct cast_32tbf16_args {
+  float * source;
+  bf16 * destination;
+  int size;
+};
+
+/**
+ * @brief Arguments to cast a BF16 tensor to FP32
+ * @param source BF16 tensor (4-byte aligned)
+ * @param destination FP32 tensor
+ * @param size number of elements
+ */
+struct cast_bf16t32_args {
+  bf16 * source;
+  float * destination;
+  int size;
+};
+
+
+
+/**
+ * =====> CONVERSIONS <=====
+ */
+
+/**
+ * @brief Converts a BF16 to FP32 (exact)
+ */
+static inline float bf16_to_fp32 (bf16 x)
+{
+  union { uint32_t u; float f; } v;
+  v.u = ((uint32_t) x) << 16;
+  return v.f;
+}
+
+/**
+ * @brief Converts a FP32 to BF16, rounding to nearest even (NaNs stay quiet NaNs)
+ */
+static inline bf16 fp32_to_bf16 (float x)
+{
+  union { uint32_t u; float f; } v;
+  v.f = x;
+  if ((v.u & 0x7fffffff) > 0x7f800000) return (bf16) ((v.u >> 16) | 0x0040);
+  v.u += 0x7fff + ((v.u >> 16) & 1);
+  return (bf16) (v.u >> 16);
+}
+
+
+
+/**
+ * =====> FUNCTIONS <=====
+ */
+
+/**
+ * @brief Cast a FP32 tensor to BF16, two elements per 32-bit store. Set up the arguments by using a "struct cast_32tbf16_args" structure. Use pi_cl_team_fork(NUM_CORES, cast_fp32_tensor_to_bf16, &args) to parallelize.
+ * @param (void *) (struct cast_32tbf16_args cast_args)
+ */
+void cast_fp32_tensor_to_bf16 (void * cast_32tbf16_args);
+
+/**
+ * @brief Cast a BF16 tensor to FP32, two elements per 32-bit load. Set up the arguments by using a "struct cast_bf16t32_args" structure. Use pi_cl_team_fork(NUM_CORES, cast_bf16_tensor_to_fp32, &args) to parallelize.
+ * @param (void *) (struct cast_bf16t32_args cast_args)
+ */
+void cast_bf16_tensor_to_fp32 (void * cast_bf16t32_args);
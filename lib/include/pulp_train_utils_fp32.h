@@ -222,6 +222,7 @@ struct pad_args {
  * @param Rpad right padding
  * @param Upad upper padding
  * @param Dpad lower padding
+ * @param row_idx for sparse updates (mm_sparse_rows): indices of the N rows of A to be multiplied
  */
 struct matMul_args {
   float * __restrict__ A;
@@ -244,6 +245,7 @@ struct matMul_args {
   int Rpad;
   int Upad;
   int Dpad;
+  int * row_idx;
 };
 
 /**
@@ -352,6 +354,22 @@ struct scalar_mul_args{
   int dim;
 };
 
+/**
+ * @brief Arguments for the per-channel bias kernels
+ * @param data tensor of C channels of HW elements each (CHW layout, or HWC if HWC is set)
+ * @param bias vector of C elements
+ * @param C number of channels
+ * @param HW number of elements of a channel
+ * @param HWC layout of data (0: CHW, 1: HWC)
+*/
+struct bias_args{
+  float* data;
+  float* bias;
+  int C;
+  int HW;
+  int HWC;
+};
+
 
 /**
  * =====> FUNCTIONS <=====
@@ -422,6 +440,12 @@ void pad_tensor (void * pad_args);
  */
 void mm_manager (void * void_args);
 
+/**
+ * @brief Selects the transposed-A matmul (C=At*B or C=At*Bt) closest to the matmul_type of mm_manager(): the naive, Nx1, 1xN and NxN unroll families map to mm_trans_A, mm_trans_A_unroll_4x1, mm_trans_A_unroll_1x4 and mm_trans_A_unroll_2x2 (or their "_M" versions). Use pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &args) to parallelize.
+ * @param (void *) (struct mm_manager_args void_args)
+ */
+void mm_manager_trans_A (void * void_args);
+
 /**
  * @brief Calculates the exponential value of each element in the input vector/matrix.
  * @param (void *) (struct softmax_args void_args)
@@ -458,6 +482,34 @@ void pulp_div_fp32_cl(void* void_args);
  */
 void pulp_scalar_mul_fp32_cl(void* void_args);
 
+/**
+ * @brief Per-channel bias, added to the output of a layer after its matmul: data[c] += bias[c] on every element of channel c. Parallelizes on the channels
+ * @param (void *)  (struct bias_args void_args)
+ */
+void pulp_bias_add_fp32_cl(void* void_args);
+
+/**
+brief Gradient of a per-channel bias: bias[c] = sum of the elements of channel c of data (the output gradient)
+ * @param (void *)  (struct bias_args void_args)
+ */
+void pulp_bias_grad_fp32_cl(void* void_args);
+
+/**
+ * @brief Xorshift pseudo-random generator (to be called on a single core)
+ * @param state state of the generator, updated at each call (must not be 0)
+ * @return next pseudo-random number
+ */
+unsigned int xorshift32(unsigned int * state);
+
+/**
+ * @brief Converts a row mask into the list of selected rows (for sparse weight updates)
+ * @param mask array of size flags, non-zero for the selected rows
+ * @param size number of rows
+ * @param rows output array with the indices of the selected rows, in ascending order
+ * @return number of selected rows
+ */
+int sparse_rows_from_mask(int * mask, int size, int * rows);
+
 static inline float
 fasterexp (float p);
 
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_fp32.h"
+#include "pulp_act_fp32.h"
+#include "pulp_train_utils_bf16.h"
+#include "pulp_act_bf16.h"
+
+
+void pulp_relu_bf16_fw_cl( void * act_args_bf16 )
+{
+  pi_cl_team_fork(NUM_CORES, relu_core_fw_bf16, act_args_bf16);
+}
+
+void pulp_relu_bf16_bw_cl( void * act_args_bf16 )
+{
+  pi_cl_team_fork(NUM_CORES, relu_core_bw_bf16, act_args_bf16);
+}
+
+void pulp_sigmoid_bf16_fw_cl( void * act_args_bf16 )
+{
+  pi_cl_team_fork(NUM_CORES, sigmoid_core_fw_bf16, act_args_bf16);
+}
+
+void pulp_sigmoid_bf16_bw_cl( void * act_args_bf16 )
+{
+  pi_cl_team_fork(NUM_CORES, sigmoid_core_bw_bf16, act_args_bf16);
+}
+
+
+
+void relu_core_fw_bf16( void * act_args_bf16 )
+{
+  struct act_args_bf16 * args = (struct act_args_bf16 *) act_args_bf16;
+  int dim = args->input->dim;
+  bf16 * inData = args->input->data;
+  bf16 * outData = args->output->data;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  // Sign bit test, no conversion needed (-0 and negative NaNs give 0)
+  for (int i=start; i<stop; i++) {
+    outData[i] = (inData[i] & 0x8000) ? 0 : inData[i];
+  }
+}
+
+void relu_core_bw_bf16( void * act_args_bf16 )
+{
+  struct act_args_bf16 * args = (struct act_args_bf16 *) act_args_bf16;
+  int dim = args->input->dim;
+  bf16 * inData = args->input->data;
+  bf16 * inDiff = args->input->diff;
+  bf16 * outDiff = args->output->diff;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  for (int i=start; i<stop; i++) {
+    inDiff[i] = ((inData[i] & 0x8000) || (inData[i] == 0)) ? 0 : outDiff[i];
+  }
+}
+
+void sigmoid_core_fw_bf16( void * act_args_bf16 )
+{
+  struct act_args_bf16 * args = (struct act_args_bf16 *) act_args_bf16;
+  int dim = args->input->dim;
+  bf16 * inData = args->input->data;
+  bf16 * outData = args->output->data;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  for (int i=start; i<stop; i++) {
+    outData[i] = fp32_to_bf16(act_sigmoid(bf16_to_fp32(inData[i])));
+  }
+}
+
+void sigmoid_core_bw_bf16( void * act_args_bf16 )
+{
+  struct act_args_bf16 * args = (struct act_args_bf16 *) act_args_bf16;
+  int dim = args->input->dim;
+  bf16 * inDiff = args->input->diff;
+  bf16 * outData = args->output->data;
+  bf16 * outDiff = args->output->diff;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  for (int i=start; i<stop; i++) {
+    float y = bf16_to_fp32(outData[i]);
+    inDiff[i] = fp32_to_bf16(bf16_to_fp32(outDiff[i]) * y * (1.0f - y));
+  }
+}
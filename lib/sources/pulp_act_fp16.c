@@ -124,4 +124,398 @@ void pulp_softmax_fp16_bw_cl( void * act_args_fp16 )
   for(int j=0; j<dim; j++){
       inDiff[j] += (outData)[j] * (outDiff)[j]; // Gradient of pre-softmax head buffer: (L x L)
   }
-}
\ No newline at end of file
+}
+
+
+void tanh_prll_fp16(void * args)
+{
+  struct tanh_args_fp16 * args_tanh = (struct tanh_args_fp16 *) args;
+
+  const int blockSize=(args_tanh->dim+NUM_CORES-1)/NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start + blockSize > args_tanh->dim ? args_tanh->dim : start+blockSize;
+
+  for(int i=start;i<stop;i++){
+    args_tanh->output[i]=act_tanh_fp16(args_tanh->input[i]);
+  }
+}
+
+
+
+/**
+ * Parallel SIMD activation functions
+ */
+
+void pulp_sigmoid_fp16_fw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, sigmoid_core_fw_fp16, act_args_fp16);
+}
+
+void pulp_sigmoid_fp16_bw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, sigmoid_core_bw_fp16, act_args_fp16);
+}
+
+void pulp_tanh_fp16_fw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, tanh_core_fw_fp16, act_args_fp16);
+}
+
+void pulp_tanh_fp16_bw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, tanh_core_bw_fp16, act_args_fp16);
+}
+
+void pulp_gelu_fp16_fw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, gelu_core_fw_fp16, act_args_fp16);
+}
+
+void pulp_gelu_fp16_bw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, gelu_core_bw_fp16, act_args_fp16);
+}
+
+void pulp_silu_fp16_fw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, silu_core_fw_fp16, act_args_fp16);
+}
+
+void pulp_silu_fp16_bw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, silu_core_bw_fp16, act_args_fp16);
+}
+
+void pulp_leakyrelu_fp16_fw_cl( void * leakyrelu_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, leakyrelu_core_fw_fp16, leakyrelu_args_fp16);
+}
+
+void pulp_leakyrelu_fp16_bw_cl( void * leakyrelu_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, leakyrelu_core_bw_fp16, leakyrelu_args_fp16);
+}
+
+void pulp_relu6_fp16_fw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, relu6_core_fw_fp16, act_args_fp16);
+}
+
+void pulp_relu6_fp16_bw_cl( void * act_args_fp16 )
+{
+  pi_cl_team_fork(NUM_CORES, relu6_core_bw_fp16, act_args_fp16);
+}
+
+
+
+// GELU (tanh approximation) constants
+#define GELU_K0 0.7978845608f   // sqrt(2/pi)
+#define GELU_K1 0.044715f
+#define GELU_K3 0.134145f       // 3*GELU_K1
+#define GELU_CLIP 8.0f          // tanh is already +-1 in fp16 there, while x^2 overflows above 256
+
+// Clipped input of the cubic term
+static inline v2f16 gelu_clip_v2f16 (v2f16 x)
+{
+  v2f16 c;
+  c[0] = (x[0] > (fp16) GELU_CLIP) ? (fp16) GELU_CLIP : ((x[0] < (fp16) -GELU_CLIP) ? (fp16) -GELU_CLIP : x[0]);
+  c[1] = (x[1] > (fp16) GELU_CLIP) ? (fp16) GELU_CLIP : ((x[1] < (fp16) -GELU_CLIP) ? (fp16) -GELU_CLIP : x[1]);
+  return c;
+}
+
+static inline v2f16 gelu_fw_v2f16 (v2f16 x)
+{
+  v2f16 half = (v2f16) {0.5f, 0.5f};
+  v2f16 one  = (v2f16) {1.0f, 1.0f};
+  v2f16 k0   = (v2f16) {GELU_K0, GELU_K0};
+  v2f16 k1   = (v2f16) {GELU_K1, GELU_K1};
+  v2f16 c = gelu_clip_v2f16(x);
+  v2f16 t = act_tanh_v2f16(k0 * (c + k1 * c * c * c));
+  return half * x * (one + t);
+}
+
+// Computed on the clipped input: beyond the clipping points the derivative is exactly 1 or 0
+static inline v2f16 gelu_bw_v2f16 (v2f16 x)
+{
+  v2f16 half = (v2f16) {0.5f, 0.5f};
+  v2f16 one  = (v2f16) {1.0f, 1.0f};
+  v2f16 k0   = (v2f16) {GELU_K0, GELU_K0};
+  v2f16 k1   = (v2f16) {GELU_K1, GELU_K1};
+  v2f16 k3   = (v2f16) {GELU_K3, GELU_K3};
+  v2f16 c = gelu_clip_v2f16(x);
+  v2f16 c2 = c * c;
+  v2f16 t = act_tanh_v2f16(k0 * (c + k1 * c2 * c));
+  return half * (one + t) + half * c * (one - t * t) * k0 * (one + k3 * c2);
+}
+
+static inline v2f16 silu_bw_v2f16 (v2f16 x)
+{
+  v2f16 one = (v2f16) {1.0f, 1.0f};
+  v2f16 s = act_sigmoid_v2f16(x);
+  return s * (one + x * (one - s));
+}
+
+// Scalar leftovers are computed on a zero-padded vector
+static inline v2f16 load_left_v2f16 (fp16 x)
+{
+  return (v2f16) {x, 0.0f};
+}
+
+
+
+void sigmoid_core_fw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * outData = args->output->data;
+
+  // Even block size to keep the SIMD accesses aligned
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    *((v2f16 *) &outData[i]) = act_sigmoid_v2f16(x);
+  }
+  if (i < stop) outData[i] = act_sigmoid_fp16(inData[i]);
+}
+
+void sigmoid_core_bw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inDiff = args->input->diff;
+  fp16 * outData = args->output->data;
+  fp16 * outDiff = args->output->diff;
+  v2f16 one = (v2f16) {1.0f, 1.0f};
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 y = *((v2f16 *) &outData[i]);
+    v2f16 g = *((v2f16 *) &outDiff[i]);
+    *((v2f16 *) &inDiff[i]) = g * y * (one - y);
+  }
+  if (i < stop) inDiff[i] = outDiff[i] * outData[i] * ((fp16) 1.0f - outData[i]);
+}
+
+void tanh_core_fw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * outData = args->output->data;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    *((v2f16 *) &outData[i]) = act_tanh_v2f16(x);
+  }
+  if (i < stop) outData[i] = act_tanh_fp16(inData[i]);
+}
+
+void tanh_core_bw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inDiff = args->input->diff;
+  fp16 * outData = args->output->data;
+  fp16 * outDiff = args->output->diff;
+  v2f16 one = (v2f16) {1.0f, 1.0f};
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 y = *((v2f16 *) &outData[i]);
+    v2f16 g = *((v2f16 *) &outDiff[i]);
+    *((v2f16 *) &inDiff[i]) = g * (one - y * y);
+  }
+  if (i < stop) inDiff[i] = outDiff[i] * ((fp16) 1.0f - outData[i] * outData[i]);
+}
+
+void gelu_core_fw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * outData = args->output->data;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    *((v2f16 *) &outData[i]) = gelu_fw_v2f16(x);
+  }
+  if (i < stop) outData[i] = gelu_fw_v2f16(load_left_v2f16(inData[i]))[0];
+}
+
+void gelu_core_bw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * inDiff = args->input->diff;
+  fp16 * outDiff = args->output->diff;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    v2f16 g = *((v2f16 *) &outDiff[i]);
+    *((v2f16 *) &inDiff[i]) = g * gelu_bw_v2f16(x);
+  }
+  if (i < stop) inDiff[i] = outDiff[i] * gelu_bw_v2f16(load_left_v2f16(inData[i]))[0];
+}
+
+void silu_core_fw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * outData = args->output->data;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    *((v2f16 *) &outData[i]) = x * act_sigmoid_v2f16(x);
+  }
+  if (i < stop) outData[i] = inData[i] * act_sigmoid_fp16(inData[i]);
+}
+
+void silu_core_bw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * inDiff = args->input->diff;
+  fp16 * outDiff = args->output->diff;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    v2f16 g = *((v2f16 *) &outDiff[i]);
+    *((v2f16 *) &inDiff[i]) = g * silu_bw_v2f16(x);
+  }
+  if (i < stop) inDiff[i] = outDiff[i] * silu_bw_v2f16(load_left_v2f16(inData[i]))[0];
+}
+
+void leakyrelu_core_fw_fp16( void * leakyrelu_args_fp16 )
+{
+  struct leakyrelu_args_fp16 * args = (struct leakyrelu_args_fp16 *) leakyrelu_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * outData = args->output->data;
+  fp16 slope = args->negative_slope;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    v2f16 s = x * (v2f16) {slope, slope};
+    x[0] = x[0] > 0 ? x[0] : s[0];
+    x[1] = x[1] > 0 ? x[1] : s[1];
+    *((v2f16 *) &outData[i]) = x;
+  }
+  if (i < stop) outData[i] = inData[i] > 0 ? inData[i] : slope * inData[i];
+}
+
+void leakyrelu_core_bw_fp16( void * leakyrelu_args_fp16 )
+{
+  struct leakyrelu_args_fp16 * args = (struct leakyrelu_args_fp16 *) leakyrelu_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * inDiff = args->input->diff;
+  fp16 * outDiff = args->output->diff;
+  fp16 slope = args->negative_slope;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    v2f16 g = *((v2f16 *) &outDiff[i]);
+    v2f16 s = g * (v2f16) {slope, slope};
+    g[0] = x[0] > 0 ? g[0] : s[0];
+    g[1] = x[1] > 0 ? g[1] : s[1];
+    *((v2f16 *) &inDiff[i]) = g;
+  }
+  if (i < stop) inDiff[i] = inData[i] > 0 ? outDiff[i] : slope * outDiff[i];
+}
+
+void relu6_core_fw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * outData = args->output->data;
+  const fp16 six = 6.0f;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    x[0] = x[0] > 0 ? (x[0] < six ? x[0] : six) : 0;
+    x[1] = x[1] > 0 ? (x[1] < six ? x[1] : six) : 0;
+    *((v2f16 *) &outData[i]) = x;
+  }
+  if (i < stop) outData[i] = inData[i] > 0 ? (inData[i] < six ? inData[i] : six) : 0;
+}
+
+void relu6_core_bw_fp16( void * act_args_fp16 )
+{
+  struct act_args_fp16 * args = (struct act_args_fp16 *) act_args_fp16;
+  int dim = args->input->dim;
+  fp16 * inData = args->input->data;
+  fp16 * inDiff = args->input->diff;
+  fp16 * outDiff = args->output->diff;
+  const fp16 six = 6.0f;
+
+  const int blockSize = (((dim+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    v2f16 x = *((v2f16 *) &inData[i]);
+    v2f16 g = *((v2f16 *) &outDiff[i]);
+    g[0] = (x[0] > 0 && x[0] < six) ? g[0] : 0;
+    g[1] = (x[1] > 0 && x[1] < six) ? g[1] : 0;
+    *((v2f16 *) &inDiff[i]) = g;
+  }
+  if (i < stop) inDiff[i] = (inData[i] > 0 && inData[i] < six) ? outDiff[i] : 0;
+}
@@ -261,26 +261,360 @@ void tanh_prll(void * args){
   }
 }
 
-static inline float
-fastexp (float p)
+
+
+/**
+ * Parallel activation functions
+ */
+
+void pulp_sigmoid_fp32_fw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, sigmoid_core_fw_fp32, act_args);
+}
+
+void pulp_sigmoid_fp32_bw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, sigmoid_core_bw_fp32, act_args);
+}
+
+void pulp_tanh_fp32_fw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, tanh_core_fw_fp32, act_args);
+}
+
+void pulp_tanh_fp32_bw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, tanh_core_bw_fp32, act_args);
+}
+
+void pulp_gelu_fp32_fw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, gelu_core_fw_fp32, act_args);
+}
+
+void pulp_gelu_fp32_bw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, gelu_core_bw_fp32, act_args);
+}
+
+void pulp_silu_fp32_fw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, silu_core_fw_fp32, act_args);
+}
+
+void pulp_silu_fp32_bw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, silu_core_bw_fp32, act_args);
+}
+
+void pulp_leakyrelu_fp32_fw_cl( void * leakyrelu_args )
+{
+  pi_cl_team_fork(NUM_CORES, leakyrelu_core_fw_fp32, leakyrelu_args);
+}
+
+void pulp_leakyrelu_fp32_bw_cl( void * leakyrelu_args )
+{
+  pi_cl_team_fork(NUM_CORES, leakyrelu_core_bw_fp32, leakyrelu_args);
+}
+
+void pulp_relu6_fp32_fw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, relu6_core_fw_fp32, act_args);
+}
+
+void pulp_relu6_fp32_bw_cl( void * act_args )
+{
+  pi_cl_team_fork(NUM_CORES, relu6_core_bw_fp32, act_args);
+}
+
+
+
+// GELU (tanh approximation) constants
+#define GELU_K0 0.7978845608f   // sqrt(2/pi)
+#define GELU_K1 0.044715f
+
+static inline float gelu_fw (float x)
+{
+  float t = act_tanh(GELU_K0 * (x + GELU_K1 * x * x * x));
+  return 0.5f * x * (1.0f + t);
+}
+
+static inline float gelu_bw (float x)
+{
+  float x2 = x * x;
+  float t = act_tanh(GELU_K0 * (x + GELU_K1 * x2 * x));
+  return 0.5f * (1.0f + t) + 0.5f * x * (1.0f - t * t) * GELU_K0 * (1.0f + 3.0f * GELU_K1 * x2);
+}
+
+static inline float silu_bw (float x)
 {
-  return fastpow2 (1.442695040f * p);
+  float s = act_sigmoid(x);
+  return s * (1.0f + x * (1.0f - s));
+}
+
+
+
+void sigmoid_core_fw_fp32( void * act_args )
+{
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * outData = args->output->data;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    outData[i]   = act_sigmoid(a);
+    outData[i+1] = act_sigmoid(b);
+  }
+  if (i < stop) outData[i] = act_sigmoid(inData[i]);
 }
 
-static inline float
-fasttanh (float p)
+void sigmoid_core_bw_fp32( void * act_args )
 {
-  return -1.0f + 2.0f / (1.0f + fastexp (-2.0f * p));
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inDiff = args->input->diff;
+  float * outData = args->output->data;
+  float * outDiff = args->output->diff;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float ya = outData[i];
+    float yb = outData[i+1];
+    inDiff[i]   = outDiff[i]   * ya * (1.0f - ya);
+    inDiff[i+1] = outDiff[i+1] * yb * (1.0f - yb);
+  }
+  if (i < stop) inDiff[i] = outDiff[i] * outData[i] * (1.0f - outData[i]);
 }
 
-static inline float
-fastpow2 (float p)
+void tanh_core_fw_fp32( void * act_args )
 {
-  float offset = (p < 0) ? 1.0f : 0.0f;
-  float clipp = (p < -126) ? -126.0f : p;
-  int w = clipp;
-  float z = clipp - w + offset;
-  union { uint32_t i; float f; } v = { (uint32_t) ( (1 << 23) * (clipp + 121.2740575f + 27.7280233f / (4.84252568f - z) - 1.49012907f * z) ) };
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * outData = args->output->data;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    outData[i]   = act_tanh(a);
+    outData[i+1] = act_tanh(b);
+  }
+  if (i < stop) outData[i] = act_tanh(inData[i]);
+}
 
-  return v.f;
-}
\ No newline at end of file
+void tanh_core_bw_fp32( void * act_args )
+{
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inDiff = args->input->diff;
+  float * outData = args->output->data;
+  float * outDiff = args->output->diff;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float ya = outData[i];
+    float yb = outData[i+1];
+    inDiff[i]   = outDiff[i]   * (1.0f - ya * ya);
+    inDiff[i+1] = outDiff[i+1] * (1.0f - yb * yb);
+  }
+  if (i < stop) inDiff[i] = outDiff[i] * (1.0f - outData[i] * outData[i]);
+}
+
+void gelu_core_fw_fp32( void * act_args )
+{
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * outData = args->output->data;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    outData[i]   = gelu_fw(a);
+    outData[i+1] = gelu_fw(b);
+  }
+  if (i < stop) outData[i] = gelu_fw(inData[i]);
+}
+
+void gelu_core_bw_fp32( void * act_args )
+{
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * inDiff = args->input->diff;
+  float * outDiff = args->output->diff;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    inDiff[i]   = outDiff[i]   * gelu_bw(a);
+    inDiff[i+1] = outDiff[i+1] * gelu_bw(b);
+  }
+  if (i < stop) inDiff[i] = outDiff[i] * gelu_bw(inData[i]);
+}
+
+void silu_core_fw_fp32( void * act_args )
+{
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * outData = args->output->data;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    outData[i]   = a * act_sigmoid(a);
+    outData[i+1] = b * act_sigmoid(b);
+  }
+  if (i < stop) outData[i] = inData[i] * act_sigmoid(inData[i]);
+}
+
+void silu_core_bw_fp32( void * act_args )
+{
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * inDiff = args->input->diff;
+  float * outDiff = args->output->diff;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    inDiff[i]   = outDiff[i]   * silu_bw(a);
+    inDiff[i+1] = outDiff[i+1] * silu_bw(b);
+  }
+  if (i < stop) inDiff[i] = outDiff[i] * silu_bw(inData[i]);
+}
+
+void leakyrelu_core_fw_fp32( void * leakyrelu_args )
+{
+  struct leakyrelu_args * args = (struct leakyrelu_args *) leakyrelu_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * outData = args->output->data;
+  float slope = args->negative_slope;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    outData[i]   = a > 0 ? a : slope * a;
+    outData[i+1] = b > 0 ? b : slope * b;
+  }
+  if (i < stop) outData[i] = inData[i] > 0 ? inData[i] : slope * inData[i];
+}
+
+void leakyrelu_core_bw_fp32( void * leakyrelu_args )
+{
+  struct leakyrelu_args * args = (struct leakyrelu_args *) leakyrelu_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * inDiff = args->input->diff;
+  float * outDiff = args->output->diff;
+  float slope = args->negative_slope;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float ga = outDiff[i];
+    float gb = outDiff[i+1];
+    inDiff[i]   = inData[i]   > 0 ? ga : slope * ga;
+    inDiff[i+1] = inData[i+1] > 0 ? gb : slope * gb;
+  }
+  if (i < stop) inDiff[i] = inData[i] > 0 ? outDiff[i] : slope * outDiff[i];
+}
+
+void relu6_core_fw_fp32( void * act_args )
+{
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * outData = args->output->data;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    a = a > 0 ? a : 0;
+    b = b > 0 ? b : 0;
+    outData[i]   = a < 6.0f ? a : 6.0f;
+    outData[i+1] = b < 6.0f ? b : 6.0f;
+  }
+  if (i < stop) {
+    float a = inData[i] > 0 ? inData[i] : 0;
+    outData[i] = a < 6.0f ? a : 6.0f;
+  }
+}
+
+void relu6_core_bw_fp32( void * act_args )
+{
+  struct act_args * args = (struct act_args *) act_args;
+  int dim = args->input->dim;
+  float * inData = args->input->data;
+  float * inDiff = args->input->diff;
+  float * outDiff = args->output->diff;
+
+  const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    float a = inData[i];
+    float b = inData[i+1];
+    inDiff[i]   = (a > 0 && a < 6.0f) ? outDiff[i]   : 0;
+    inDiff[i+1] = (b > 0 && b < 6.0f) ? outDiff[i+1] : 0;
+  }
+  if (i < stop) inDiff[i] = (inData[i] > 0 && inData[i] < 6.0f) ? outDiff[i] : 0;
+}
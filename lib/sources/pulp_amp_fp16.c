@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_fp32.h"
+#include "pulp_train_utils_fp16.h"
+#include "pulp_amp_fp16.h"
+
+// Exponent field of an fp16: all ones for Inf and NaN
+#define FP16_EXP_MASK   0x7c00
+
+
+void pulp_amp_init( struct amp_args * args )
+{
+  args->good_steps = 0;
+  args->steps = 0;
+  args->skipped = 0;
+}
+
+void pulp_amp_scale_grad( struct amp_args * args, float * grad, fp16 * scaled, int size )
+{
+  struct amp_kernel_args kernel_args;
+  kernel_args.source = grad;
+  kernel_args.grad = scaled;
+  kernel_args.factor = args->scale;
+  kernel_args.size = size;
+  pi_cl_team_fork(NUM_CORES, pulp_amp_cast_scaled_fp16, &kernel_args);
+}
+
+int pulp_amp_check_overflow( struct amp_args * args, struct amp_param * params, int num_params )
+{
+  struct amp_kernel_args kernel_args;
+  kernel_args.flags = args->flags;
+
+  for (int p=0; p<num_params; p++) {
+    kernel_args.grad = params[p].weights->diff;
+    kernel_args.size = params[p].weights->dim;
+    pi_cl_team_fork(NUM_CORES, pulp_amp_check_fp16, &kernel_args);
+
+    for (int i=0; i<NUM_CORES; i++)
+      if (args->flags[i]) return 1;
+  }
+  return 0;
+}
+
+int pulp_amp_update( struct amp_args * args, struct amp_param * params, int num_params, float learning_rate )
+{
+  args->steps++;
+
+  if (pulp_amp_check_overflow(args, params, num_params)) {
+    // The gradients are lost: retry the next steps with a smaller scale
+    args->skipped++;
+    args->good_steps = 0;
+    args->scale *= args->backoff_factor;
+    if (args->scale < args->min_scale) args->scale = args->min_scale;
+    #ifdef DEBUG
+    printf("[pulp_amp_update]: Gradient overflow, loss scale reduced to %f\n", args->scale);
+    #endif
+    return 0;
+  }
+
+  struct amp_kernel_args kernel_args;
+  kernel_args.factor = learning_rate / args->scale;
+
+  for (int p=0; p<num_params; p++) {
+    kernel_args.master = params[p].master->data;
+    kernel_args.weights = params[p].weights->data;
+    kernel_args.grad = params[p].weights->diff;
+    kernel_args.size = params[p].master->dim;
+    pi_cl_team_fork(NUM_CORES, pulp_amp_update_fp16, &kernel_args);
+  }
+
+  if (++args->good_steps == args->growth_interval) {
+    args->good_steps = 0;
+    args->scale *= args->growth_factor;
+    if (args->scale > args->max_scale) args->scale = args->max_scale;
+  }
+  return 1;
+}
+
+void pulp_amp_report( struct amp_args * args )
+{
+  int perc = args->steps > 0 ? (100 * args->skipped) / args->steps : 0;
+  printf("Mixed precision: loss scale %f, %d of %d steps skipped on overflow (%d%%)\n", args->scale, args->skipped, args->steps, perc);
+}
+
+
+
+// MIXED-PRECISION KERNELS
+
+void pulp_amp_cast_scaled_fp16( void * void_args )
+{
+  struct amp_kernel_args * args = (struct amp_kernel_args *) void_args;
+  float * source = args->source;
+  fp16 * dest = args->grad;
+  float factor = args->factor;
+  int size = args->size;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  for (int i=start; i<stop; i++)
+    dest[i] = (fp16) (factor * source[i]);
+}
+
+void pulp_amp_check_fp16( void * void_args )
+{
+  struct amp_kernel_args * args = (struct amp_kernel_args *) void_args;
+  uint16_t * grad = (uint16_t *) args->grad;
+  int size = args->size;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  // Integer test on the exponent field, no fp16 compare needed
+  int found = 0;
+  for (int i=start; i<stop; i++) {
+    if ((grad[i] & FP16_EXP_MASK) == FP16_EXP_MASK) {
+      found = 1;
+      break;
+    }
+  }
+  args->flags[pi_core_id()] = found;
+}
+
+void pulp_amp_update_fp16( void * void_args )
+{
+  struct amp_kernel_args * args = (struct amp_kernel_args *) void_args;
+  float * master = args->master;
+  fp16 * weights = args->weights;
+  fp16 * grad = args->grad;
+  float factor = args->factor;
+  int size = args->size;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  for (int i=start; i<stop; i++) {
+    float w = master[i] - factor * (float) grad[i];
+    master[i] = w;
+    weights[i] = (fp16) w;
+  }
+}
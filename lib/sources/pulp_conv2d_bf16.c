@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_bf16.h"
+#include "pulp_matmul_bf16.h"
+#include "pulp_conv2d_bf16.h"
+
+static inline void conv2d_bf16_setup( struct Conv2D_args_bf16 * C2D_args, struct matMul_args_bf16 * matMul_args )
+{
+  matMul_args->H = C2D_args->input->H;
+  matMul_args->W = C2D_args->input->W;
+  matMul_args->pCin = C2D_args->input->C;
+  matMul_args->pCout = C2D_args->output->C;
+  matMul_args->pH = C2D_args->coeff->H;
+  matMul_args->pW = C2D_args->coeff->W;
+  matMul_args->stride_h = C2D_args->stride_h;
+  matMul_args->stride_w = C2D_args->stride_w;
+  matMul_args->Lpad = C2D_args->Lpad;
+  matMul_args->Rpad = C2D_args->Rpad;
+  matMul_args->Upad = C2D_args->Upad;
+  matMul_args->Dpad = C2D_args->Dpad;
+}
+
+
+void pulp_conv2d_bf16_fw_cl( void * Conv2D_args_bf16 )
+{
+  struct Conv2D_args_bf16 * C2D_args = (struct Conv2D_args_bf16 *) Conv2D_args_bf16;
+  struct matMul_args_bf16 matMul_args;
+
+  conv2d_bf16_setup(C2D_args, &matMul_args);
+  matMul_args.A = C2D_args->input->data;
+  matMul_args.B = C2D_args->coeff->data;
+  matMul_args.C = C2D_args->output->data;
+
+  pi_cl_team_fork(NUM_CORES, naive_conv2d_fw_kernel_CHW_bf16, &matMul_args);
+}
+
+
+void pulp_conv2d_bf16_bw_cl( void * Conv2D_args_bf16 )
+{
+  struct Conv2D_args_bf16 * C2D_args = (struct Conv2D_args_bf16 *) Conv2D_args_bf16;
+  int skip_in_grad = C2D_args->skip_in_grad;
+
+  pulp_conv2d_bf16_bw_param_grads_cl(Conv2D_args_bf16); 
+  if (skip_in_grad == 0)
+  {
+    pulp_conv2d_bf16_bw_input_grads_cl(Conv2D_args_bf16); 
+  }
+}
+
+
+void pulp_conv2d_bf16_bw_param_grads_cl( void * Conv2D_args_bf16 )
+{
+  struct Conv2D_args_bf16 * C2D_args = (struct Conv2D_args_bf16 *) Conv2D_args_bf16;
+  struct matMul_args_bf16 matMul_args;
+
+  conv2d_bf16_setup(C2D_args, &matMul_args);
+  matMul_args.A = C2D_args->input->data;
+  matMul_args.B = C2D_args->coeff->diff;
+  matMul_args.C = C2D_args->output->diff;
+
+  pi_cl_team_fork(NUM_CORES, naive_conv2d_param_grad_kernel_CHW_bf16, &matMul_args);
+}
+
+
+void pulp_conv2d_bf16_bw_input_grads_cl( void * Conv2D_args_bf16 )
+{
+  struct Conv2D_args_bf16 * C2D_args = (struct Conv2D_args_bf16 *) Conv2D_args_bf16;
+  struct matMul_args_bf16 matMul_args;
+
+  conv2d_bf16_setup(C2D_args, &matMul_args);
+  matMul_args.A = C2D_args->input->diff;
+  matMul_args.B = C2D_args->coeff->data;
+  matMul_args.C = C2D_args->output->diff;
+
+  pi_cl_team_fork(NUM_CORES, naive_conv2d_in_grad_kernel_CHW_bf16, &matMul_args);
+}
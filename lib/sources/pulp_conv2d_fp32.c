@@ -100,6 +100,42 @@ void pulp_conv2d_fp32_fw_cl( void * Conv2D_args )
         man_args.matmul_type = opt_matmul_type; //MATMUL_TYPE;
         pi_cl_team_fork(NUM_CORES, mm_manager, &man_args);
         #endif
+
+        // Bias added after the matmul (one per output channel, i.e. per row)
+        if (C2D_args->bias != NULL) {
+          struct bias_args b_args;
+          b_args.data = outData;
+          b_args.bias = C2D_args->bias->data;
+          b_args.C = C_out;
+          b_args.HW = matMul_args.M;
+          b_args.HWC = 0;
+          pi_cl_team_fork(NUM_CORES, pulp_bias_add_fp32_cl, &b_args);
+        }
+
+        // Low-rank adapter: out += A*(B*im2col), reusing the im2col buffer
+        if (C2D_args->lora_A != NULL) {
+          int r = C2D_args->lora_rank;
+          int HW = matMul_args.M;
+          float * lora_act = C2D_args->lora_buffer;
+
+          matMul_args.A = C2D_args->lora_B->data;
+          matMul_args.B = i2c_buffer;
+          matMul_args.C = lora_act;
+          matMul_args.N = r;
+          matMul_args.K = pW*pH*C_in;
+          matMul_args.M = HW;
+          matMul_args.trans_B = 1;
+          pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
+
+          matMul_args.A = C2D_args->lora_A->data;
+          matMul_args.B = lora_act;
+          matMul_args.C = outData;
+          matMul_args.N = C_out;
+          matMul_args.K = r;
+          matMul_args.M = HW;
+          matMul_args.trans_B = 0;
+          pi_cl_team_fork(NUM_CORES, mm_add, &matMul_args);
+        }
       }
 
     /**
@@ -141,6 +177,21 @@ void pulp_conv2d_fp32_fw_cl( void * Conv2D_args )
       man_args.matmul_type = opt_matmul_type; //MATMUL_TYPE;
       pi_cl_team_fork(NUM_CORES, mm_manager, &man_args);
       #endif     
+
+      // Bias added after the matmul (one per output channel, i.e. per column)
+      if (C2D_args->bias != NULL) {
+        struct bias_args b_args;
+        b_args.data = outData;
+        b_args.bias = C2D_args->bias->data;
+        b_args.C = C_out;
+        b_args.HW = matMul_args.N;
+        b_args.HWC = 1;
+        pi_cl_team_fork(NUM_CORES, pulp_bias_add_fp32_cl, &b_args);
+      }
+
+      if (C2D_args->lora_A != NULL) {
+        printf("[pulp_conv2d_fp32_fw_cl:] Low-rank adapter not implemented for HWC layout!\n");
+      }
     }
     else {
       printf("[pulp_conv2d_fp32_fw_cl:] Invalid data layout format (HWC or CHW)!\n");
@@ -152,6 +203,10 @@ void pulp_conv2d_fp32_fw_cl( void * Conv2D_args )
    */
   else if (USE_IM2COL == 0) {
 
+    if (C2D_args->bias != NULL || C2D_args->lora_A != NULL) {
+      printf("[pulp_conv2d_fp32_fw_cl:] Bias and low-rank adapter not implemented for the naive kernel!\n");
+    }
+
     /**
      * USE CHW DATA LAYOUT
      */
@@ -249,6 +304,20 @@ void pulp_conv2d_fp32_bw_param_grads_cl( void * Conv2D_args )
     int USE_IM2COL = C2D_args->USE_IM2COL;
     int USE_DMA = C2D_args->USE_DMA_IM2COL;
     int opt_matmul_type = C2D_args->opt_matmul_type_wg;
+
+  // Bias gradient
+  if (C2D_args->bias != NULL) {
+    struct bias_args b_args;
+    b_args.data = outDiff;
+    b_args.bias = C2D_args->bias->diff;
+    b_args.C = C_out;
+    b_args.HW = H_out*W_out;
+    b_args.HWC = HWC_layout;
+    pi_cl_team_fork(NUM_CORES, pulp_bias_grad_fp32_cl, &b_args);
+  }
+
+  // Frozen weights and no adapter (bias-only training): no im2col, no matmul
+  if (C2D_args->skip_wgt_grad && C2D_args->lora_A == NULL) return;
     
   /**
    * USE OPTIMIZED ALGORITHM
@@ -283,22 +352,72 @@ void pulp_conv2d_fp32_bw_param_grads_cl( void * Conv2D_args )
       matMul_args.M = pW*pH*C_in; 
       matMul_args.trans_B = 0;
 
-      #ifndef OPTIMIZE
-      pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
-      #else
-      struct mm_manager_args man_args;
-      man_args.mm_args = &matMul_args;
-      man_args.layer_type = LAYER_CONV2D;
-      man_args.step_type = STEP_WGT_GRAD;
-      man_args.matmul_type = opt_matmul_type; //MATMUL_TYPE;
-      pi_cl_team_fork(NUM_CORES, mm_manager, &man_args);
-      #endif
+      // Weight gradient (skipped for frozen weights)
+      if (C2D_args->skip_wgt_grad == 0) {
+        // Sparse update: gradient of the selected output channels only, in compact form
+        if (C2D_args->update_rows != NULL) {
+          matMul_args.N = C2D_args->num_update_rows;
+          matMul_args.row_idx = C2D_args->update_rows;
+          pi_cl_team_fork(NUM_CORES, mm_sparse_rows, &matMul_args);
+        }
+        else {
+          #ifndef OPTIMIZE
+          pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
+          #else
+          struct mm_manager_args man_args;
+          man_args.mm_args = &matMul_args;
+          man_args.layer_type = LAYER_CONV2D;
+          man_args.step_type = STEP_WGT_GRAD;
+          man_args.matmul_type = opt_matmul_type; //MATMUL_TYPE;
+          pi_cl_team_fork(NUM_CORES, mm_manager, &man_args);
+          #endif
+        }
+      }
+
+      // Adapter gradients: dA = dy*(B*im2col)^T, dB = (A^T*dy)*im2col
+      if (C2D_args->lora_A != NULL) {
+        int r = C2D_args->lora_rank;
+        float * lora_act = C2D_args->lora_buffer;
+        float * lora_grad = C2D_args->lora_buffer + r*H_out*W_out;
+
+        matMul_args.A = outDiff;
+        matMul_args.B = lora_act;
+        matMul_args.C = C2D_args->lora_A->diff;
+        matMul_args.N = C_out;
+        matMul_args.K = H_out*W_out;
+        matMul_args.M = r;
+        matMul_args.trans_B = 1;
+        pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
+
+        matMul_args.A = C2D_args->lora_A->data;
+        matMul_args.B = outDiff;
+        matMul_args.C = lora_grad;
+        matMul_args.N = r;
+        matMul_args.K = C_out;
+        matMul_args.M = H_out*W_out;
+        matMul_args.trans_B = 0;
+        pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args);
+
+        matMul_args.A = lora_grad;
+        matMul_args.B = i2c_buffer;
+        matMul_args.C = C2D_args->lora_B->diff;
+        matMul_args.N = r;
+        matMul_args.K = H_out*W_out;
+        matMul_args.M = pW*pH*C_in;
+        matMul_args.trans_B = 0;
+        pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
+      }
     }
   
     /**
      * USE HWC DATA LAYOUT
      */
     else if (HWC_layout == 1) {
+      if (C2D_args->lora_A != NULL) {
+        printf("[pulp_conv2d_fp32_bw_param_grads_cl:] Low-rank adapter not implemented for HWC layout!\n");
+        return;
+      }
+
       im2col_args.input = C2D_args->input;
       im2col_args.c = C2D_args->coeff;
       im2col_args.output = C2D_args->output;
@@ -330,16 +449,24 @@ void pulp_conv2d_fp32_bw_param_grads_cl( void * Conv2D_args )
       matMul_args.M = pW*pH*C_in; 
       matMul_args.trans_B = 1;
 
-      #ifndef OPTIMIZE
-      pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
-      #else
-      struct mm_manager_args man_args;
-      man_args.mm_args = &matMul_args;
-      man_args.layer_type = LAYER_CONV2D;
-      man_args.step_type = STEP_WGT_GRAD;
-      man_args.matmul_type = opt_matmul_type; //MATMUL_TYPE;
-      pi_cl_team_fork(NUM_CORES, mm_manager, &man_args);
-      #endif     
+      // Sparse update: gradient of the selected output channels only, in compact form
+      if (C2D_args->update_rows != NULL) {
+        matMul_args.N = C2D_args->num_update_rows;
+        matMul_args.row_idx = C2D_args->update_rows;
+        pi_cl_team_fork(NUM_CORES, mm_sparse_rows, &matMul_args);
+      }
+      else {
+        #ifndef OPTIMIZE
+        pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
+        #else
+        struct mm_manager_args man_args;
+        man_args.mm_args = &matMul_args;
+        man_args.layer_type = LAYER_CONV2D;
+        man_args.step_type = STEP_WGT_GRAD;
+        man_args.matmul_type = opt_matmul_type; //MATMUL_TYPE;
+        pi_cl_team_fork(NUM_CORES, mm_manager, &man_args);
+        #endif
+      }     
     }
     else {
       printf("[pulp_conv2d_fp32_bw_param_grads_cl:] Invalid data layout format (HWC or CHW)!\n");
@@ -351,6 +478,11 @@ void pulp_conv2d_fp32_bw_param_grads_cl( void * Conv2D_args )
    */
   else if (USE_IM2COL == 0) {
 
+    if (C2D_args->update_rows != NULL || C2D_args->lora_A != NULL) {
+      printf("[pulp_conv2d_fp32_bw_param_grads_cl:] Sparse update and low-rank adapter not implemented for the naive kernel!\n");
+      return;
+    }
+
     /**
      * USE CHW DATA LAYOUT
      */
@@ -433,6 +565,29 @@ void pulp_conv2d_fp32_bw_input_grads_cl( void * Conv2D_args )
   int USE_DMA = C2D_args->USE_DMA_IM2COL;
   int opt_matmul_type = C2D_args->opt_matmul_type_ig;
 
+  // Low-rank adapter: the input gradient is propagated through the merged weights W + A*B
+  if (C2D_args->lora_A != NULL) {
+    int r = C2D_args->lora_rank;
+    float * merged = C2D_args->lora_buffer + 2*r*H_out*W_out;
+
+    struct copy_args cpy_args;
+    cpy_args.from = coeffData;
+    cpy_args.to = merged;
+    cpy_args.size = C_out*C_in*pH*pW;
+    pi_cl_team_fork(NUM_CORES, copy, &cpy_args);
+
+    matMul_args.A = C2D_args->lora_A->data;
+    matMul_args.B = C2D_args->lora_B->data;
+    matMul_args.C = merged;
+    matMul_args.N = C_out;
+    matMul_args.K = r;
+    matMul_args.M = C_in*pH*pW;
+    matMul_args.trans_B = 0;
+    pi_cl_team_fork(NUM_CORES, mm_add, &matMul_args);
+
+    coeffData = merged;
+  }
+
   /**
    * USE OPTIMIZED ALGORITHM
    */
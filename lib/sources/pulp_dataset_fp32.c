@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_fp32.h"
+#include "pulp_dataset_fp32.h"
+#ifdef DATASET_HOSTFS
+#include "bsp/fs/hostfs.h"
+#endif
+
+
+// Starts the DMA transfers of the sample at position "cursor" into the free half of the L1 buffer
+static inline void dataset_load( struct dataset_args * args )
+{
+  int sample = args->index[args->cursor];
+  float * dest = args->l1_buffer + args->slot * (args->input_size + args->label_size);
+
+  args->dma_input.dir = PI_CL_DMA_DIR_EXT2LOC;
+  args->dma_input.merge = 0;
+  args->dma_input.size = 4 * args->input_size;
+  args->dma_input.id = 0;
+  args->dma_input.ext = (uint32_t) (args->inputs + sample * args->input_size);
+  args->dma_input.loc = (uint32_t) dest;
+  pi_cl_dma_memcpy(&args->dma_input);
+
+  args->dma_label.dir = PI_CL_DMA_DIR_EXT2LOC;
+  args->dma_label.merge = 0;
+  args->dma_label.size = 4 * args->label_size;
+  args->dma_label.id = 0;
+  args->dma_label.ext = (uint32_t) (args->labels + sample * args->label_size);
+  args->dma_label.loc = (uint32_t) (dest + args->input_size);
+  pi_cl_dma_memcpy(&args->dma_label);
+
+  args->cursor++;
+}
+
+
+
+void pulp_dataset_shuffle( struct dataset_args * args )
+{
+  int * index = args->index;
+
+  for (int i=args->num_samples-1; i>0; i--) {
+    int j = xorshift32(&args->seed) % (i+1);
+    int temp = index[i];
+    index[i] = index[j];
+    index[j] = temp;
+  }
+}
+
+void pulp_dataset_init( struct dataset_args * args )
+{
+  for (int i=0; i<args->num_samples; i++) args->index[i] = i;
+  if (args->shuffle) pulp_dataset_shuffle(args);
+
+  args->cursor = 0;
+  args->slot = 0;
+  args->epoch = 0;
+  dataset_load(args);
+}
+
+int pulp_dataset_next( struct dataset_args * args )
+{
+  pi_cl_dma_wait(&args->dma_input);
+  pi_cl_dma_wait(&args->dma_label);
+
+  // Expose the loaded sample
+  float * ready = args->l1_buffer + args->slot * (args->input_size + args->label_size);
+  int sample = args->index[args->cursor-1];
+  args->input->data = ready;
+  args->label = ready + args->input_size;
+
+  // The exposed sample is already in L1, so the index table can be reshuffled
+  if (args->cursor == args->num_samples) {
+    args->cursor = 0;
+    args->epoch++;
+    if (args->shuffle) pulp_dataset_shuffle(args);
+  }
+
+  // Load the next sample in the other half while this one is used
+  args->slot ^= 1;
+  dataset_load(args);
+
+  return sample;
+}
+
+void pulp_dataset_finish( struct dataset_args * args )
+{
+  pi_cl_dma_wait(&args->dma_input);
+  pi_cl_dma_wait(&args->dma_label);
+}
+
+
+
+#ifdef DATASET_HOSTFS
+int pulp_dataset_load_file( const char * path, float * buffer, int size )
+{
+  struct pi_hostfs_conf conf;
+  struct pi_device fs;
+
+  pi_hostfs_conf_init(&conf);
+  pi_open_from_conf(&fs, &conf);
+  if (pi_fs_mount(&fs)) {
+    printf("[pulp_dataset_load_file]: Unable to mount the host file system!!\n");
+    return -1;
+  }
+
+  pi_fs_file_t * file = pi_fs_open(&fs, path, PI_FS_FLAGS_READ);
+  if (file == NULL) {
+    printf("[pulp_dataset_load_file]: Unable to open %s!!\n", path);
+    pi_fs_unmount(&fs);
+    return -1;
+  }
+
+  int read = pi_fs_read(file, buffer, size);
+  pi_fs_close(file);
+  pi_fs_unmount(&fs);
+
+  if (read != size) {
+    printf("[pulp_dataset_load_file]: Read %d bytes of %d from %s!!\n", read, size, path);
+    return -1;
+  }
+  return 0;
+}
+#endif
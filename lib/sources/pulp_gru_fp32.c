@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2023 University of Bologna
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license.  See the LICENSE file for details.
+ */
+
+
+#include "pulp_gru_fp32.h"
+#include "pulp_matmul_fp32.h"
+#include "pulp_train_utils_fp32.h"
+#include "pulp_act_fp32.h"
+
+
+//FORWARD
+void pulp_gru_fp32_fw_cl(void * Gru_args)
+{
+    struct Gru_args *gru_args = (struct Gru_args *) Gru_args;
+
+    pi_cl_team_fork(NUM_CORES, pulp_gru_fp32_fw_kernel, gru_args);
+
+    #ifdef DEBUG
+    int N = gru_args->input->H;
+    int M = gru_args->output->W;
+    printf("\nGRU OutData: %d %d\n", N, M);
+    for (int j=0; j<N*M; j++){
+        if(!(j%(M))) printf("\n");
+        printf("%4.2e ", gru_args->output->data[j]);
+    }
+    printf("\n");
+    #endif
+}
+
+
+
+//BACKWARD
+void pulp_gru_fp32_bw_cl(void * Gru_args)
+{
+    struct Gru_args *gru_args = (struct Gru_args *) Gru_args;
+
+    pi_cl_team_fork(NUM_CORES, pulp_gru_fp32_bw_kernel, gru_args);
+
+    #ifdef DEBUG
+    int N = gru_args->input->H;
+    int M = gru_args->output->W;
+    printf("\nGRU gate gradients: %d %d\n", N, 3*M);
+    for (int j=0; j<N*3*M; j++){
+        if(!(j%(3*M))) printf("\n");
+        printf("%4.2e ", gru_args->grad_buffer[j]);
+    }
+    printf("\n");
+    #endif
+}
+
+
+
+
+/**
+ * PARALLEL KERNELS
+ */
+
+void pulp_gru_fp32_fw_kernel(void * Gru_args)
+{
+    struct Gru_args *gru_args = (struct Gru_args *) Gru_args;
+    float *coeffDataWx = gru_args->coeff_x->data;
+    float *coeffDataWs = gru_args->coeff_s->data;
+    float *inputData = gru_args->input->data;
+    float *stateData = gru_args->state->data;
+    float *outData = gru_args->output->data;
+    float *gates = gru_args->gate_buffer;
+    float *hn = gru_args->hn_buffer;
+
+    int N = gru_args->input->H; // Sequence length
+    int K = gru_args->input->W; // Input element size
+    int M = gru_args->output->W; // Hidden size
+    int G = 3*M;
+
+    // Input projection of the whole sequence (gates = X*Wx)
+    struct matMul_args matMul_args;
+    matMul_args.A = inputData;
+    matMul_args.B = coeffDataWx;
+    matMul_args.C = gates;
+    matMul_args.N = N;
+    matMul_args.K = K;
+    matMul_args.M = G;
+    matMul_args.trans_B = 0;
+
+    mm(&matMul_args);
+    pi_cl_team_barrier();
+
+    // Parallelize over the hidden units
+    const int blockSize = (M+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > M ? M : start+blockSize;
+
+    for (int t=0; t<N; t++) {
+        float *g_t = gates + t*G;
+        float *h_prev = stateData + t*M;
+
+        for (int j=start; j<stop; j++) {
+            float acc_r = g_t[j];
+            float acc_z = g_t[M+j];
+            float acc_n = 0;
+            for (int m=0; m<M; m++) {
+                float h = h_prev[m];
+                float *w = coeffDataWs + m*G;
+                acc_r += h * w[j];
+                acc_z += h * w[M+j];
+                acc_n += h * w[2*M+j];
+            }
+            float r_g = act_sigmoid(acc_r);
+            float z_g = act_sigmoid(acc_z);
+            float n_g = act_tanh(g_t[2*M+j] + r_g * acc_n);
+            float h = (1-z_g) * n_g + z_g * h_prev[j];
+
+            // Keep the activated gates for the backward step
+            g_t[j] = r_g;
+            g_t[M+j] = z_g;
+            g_t[2*M+j] = n_g;
+            hn[t*M+j] = acc_n;
+            outData[t*M+j] = h;
+            if (t < N-1)    stateData[(t+1)*M+j] = h;
+        }
+
+        pi_cl_team_barrier();
+    }
+}
+
+
+
+void pulp_gru_fp32_bw_kernel(void * Gru_args)
+{
+    struct Gru_args *gru_args = (struct Gru_args *) Gru_args;
+    float *coeffDataWx = gru_args->coeff_x->data;
+    float *coeffDataWs = gru_args->coeff_s->data;
+    float *coeffDiffWx = gru_args->coeff_x->diff;
+    float *coeffDiffWs = gru_args->coeff_s->diff;
+    float *inputData = gru_args->input->data;
+    float *inputDiff = gru_args->input->diff;
+    float *stateData = gru_args->state->data;
+    float *stateDiff = gru_args->state->diff;
+    float *outDiff = gru_args->output->diff;
+    float *gates = gru_args->gate_buffer;
+    float *hn = gru_args->hn_buffer;
+    float *grad = gru_args->grad_buffer;
+    int window = gru_args->bptt_window;
+
+    int N = gru_args->input->H; // Sequence length
+    int K = gru_args->input->W; // Input element size
+    int M = gru_args->output->W; // Hidden size
+    int G = 3*M;
+
+    // Parallelize over the hidden units
+    const int blockSize = (M+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > M ? M : start+blockSize;
+
+    /**
+     * grad holds the gradients seen by the state projection (r, z and r*dn for the candidate gate),
+     * hn is overwritten with the pre-activation gradient of the candidate gate, seen by the input projection.
+     * stateDiff[t] temporarily holds dh_t until the gradient of h_(t-1) replaces it.
+     */
+    for (int t=N-1; t>=0; t--) {
+        float *g_t = gates + t*G;
+        float *d_t = grad + t*G;
+        // The recurrent gradient is cut at the truncated-BPTT window boundaries
+        int recur = (t < N-1) && ((window <= 0) || ((t+1) % window != 0));
+
+        for (int j=start; j<stop; j++) {
+            float dh = outDiff[t*M+j];
+            if (t < N-1) {
+                // Gradient of h_t through timestep t+1
+                float *ws_row = coeffDataWs + j*G;
+                float *d_next = grad + (t+1)*G;
+                float rec = gates[(t+1)*G+M+j] * stateDiff[(t+1)*M+j];
+                for (int m=0; m<G; m++)     rec += d_next[m] * ws_row[m];
+                stateDiff[(t+1)*M+j] = rec;
+                if (recur)  dh += rec;
+            }
+
+            float r_g = g_t[j];
+            float z_g = g_t[M+j];
+            float n_g = g_t[2*M+j];
+
+            float dn = dh * (1-z_g) * (1-n_g*n_g);
+            float dz = dh * (stateData[t*M+j] - n_g) * z_g * (1-z_g);
+            float dr = dn * hn[t*M+j] * r_g * (1-r_g);
+
+            d_t[j] = dr;
+            d_t[M+j] = dz;
+            d_t[2*M+j] = dn * r_g;
+            hn[t*M+j] = dn;
+            stateDiff[t*M+j] = dh;
+        }
+
+        pi_cl_team_barrier();
+    }
+
+    // Gradient of the initial hidden state
+    for (int j=start; j<stop; j++) {
+        float *ws_row = coeffDataWs + j*G;
+        float rec = gates[M+j] * stateDiff[j];
+        for (int m=0; m<G; m++)     rec += grad[m] * ws_row[m];
+        stateDiff[j] = rec;
+    }
+
+    // Gradient of the State Weights (dWs = St*dG)
+    struct matMul_args matMul_args2;
+    matMul_args2.A = stateData;
+    matMul_args2.B = grad;
+    matMul_args2.C = coeffDiffWs;
+    matMul_args2.N = M;
+    matMul_args2.K = N;
+    matMul_args2.M = G;
+    matMul_args2.trans_B = 0;
+
+    mm_trans_A(&matMul_args2);
+    pi_cl_team_barrier();
+
+    // The input projection sees the candidate gradient without the reset gate
+    for (int t=0; t<N; t++) {
+        for (int j=start; j<stop; j++)  grad[t*G+2*M+j] = hn[t*M+j];
+    }
+    pi_cl_team_barrier();
+
+    // Gradient of the Input Weights (dWx = Xt*dG)
+    struct matMul_args matMul_args1;
+    matMul_args1.A = inputData;
+    matMul_args1.B = grad;
+    matMul_args1.C = coeffDiffWx;
+    matMul_args1.N = K;
+    matMul_args1.K = N;
+    matMul_args1.M = G;
+    matMul_args1.trans_B = 0;
+
+    mm_trans_A(&matMul_args1);
+
+    // Gradient of the Input (dX = dG*Wxt)
+    struct matMul_args matMul_args3;
+    matMul_args3.A = grad;
+    matMul_args3.B = coeffDataWx;
+    matMul_args3.C = inputDiff;
+    matMul_args3.N = N;
+    matMul_args3.K = G;
+    matMul_args3.M = K;
+    matMul_args3.trans_B = 1;
+
+    mm(&matMul_args3);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_bf16.h"
+#include "pulp_matmul_bf16.h"
+#include "pulp_linear_bf16.h"
+
+void pulp_linear_bf16_fw_cl( void * Linear_args_bf16 )
+{
+  struct Linear_args_bf16 * FC_args = (struct Linear_args_bf16 *) Linear_args_bf16;
+
+  struct matMul_args_bf16 matMul_args;
+
+  matMul_args.A = FC_args->coeff->data;
+  matMul_args.B = FC_args->input->data;
+  matMul_args.C = FC_args->output->data;
+  matMul_args.N = FC_args->output->dim;
+  matMul_args.K = FC_args->input->dim;
+  matMul_args.M = 1;
+  matMul_args.trans_B = 0;
+
+  pi_cl_team_fork(NUM_CORES, mm_bf16, &matMul_args);
+}
+
+
+void pulp_linear_bf16_bw_cl( void * Linear_args_bf16 )
+{
+  struct Linear_args_bf16 * FC_args = (struct Linear_args_bf16 *) Linear_args_bf16;
+  int skip_in_grad = FC_args->skip_in_grad;
+
+  pulp_linear_bf16_bw_param_grads_cl(Linear_args_bf16);
+  if (skip_in_grad == 0) 
+  {
+    pulp_linear_bf16_bw_input_grads_cl(Linear_args_bf16); 
+  }
+}
+
+
+void pulp_linear_bf16_bw_param_grads_cl( void * Linear_args_bf16 )
+{
+  struct Linear_args_bf16 * FC_args = (struct Linear_args_bf16 *) Linear_args_bf16;
+
+  struct matMul_args_bf16 matMul_args;
+
+  matMul_args.A = FC_args->output->diff;
+  matMul_args.B = FC_args->input->data;
+  matMul_args.C = FC_args->coeff->diff;
+  matMul_args.N = FC_args->output->dim;
+  matMul_args.K = 1;
+  matMul_args.M = FC_args->input->dim;
+  matMul_args.trans_B = 0;
+
+  pi_cl_team_fork(NUM_CORES, mm_bf16, &matMul_args);
+}
+
+
+void pulp_linear_bf16_bw_input_grads_cl( void * Linear_args_bf16 )
+{
+  struct Linear_args_bf16 * FC_args = (struct Linear_args_bf16 *) Linear_args_bf16;
+
+  struct matMul_args_bf16 matMul_args;
+
+  matMul_args.A = FC_args->output->diff;
+  matMul_args.B = FC_args->coeff->data;
+  matMul_args.C = FC_args->input->diff;
+  matMul_args.N = 1;
+  matMul_args.K = FC_args->output->dim;
+  matMul_args.M = FC_args->input->dim;
+  matMul_args.trans_B = 0;
+
+  pi_cl_team_fork(NUM_CORES, mm_M_bf16, &matMul_args);
+}
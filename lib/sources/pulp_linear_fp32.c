@@ -55,6 +55,39 @@ void pulp_linear_fp32_fw_cl( void * Linear_args )
   pi_cl_team_fork(NUM_CORES, mm_manager, &man_args);
   #endif
 
+  // Bias added after the matmul (one per output)
+  if (FC_args->bias != NULL) {
+    struct bias_args b_args;
+    b_args.data = outData;
+    b_args.bias = FC_args->bias->data;
+    b_args.C = Co;
+    b_args.HW = 1;
+    b_args.HWC = 0;
+    pi_cl_team_fork(NUM_CORES, pulp_bias_add_fp32_cl, &b_args);
+  }
+
+  // Low-rank adapter: out += A*(B*x), accumulated on the output
+  if (FC_args->lora_A != NULL) {
+    int r = FC_args->lora_rank;
+    float * lora_act = FC_args->lora_buffer;
+
+    matMul_args.A = FC_args->lora_B->data;
+    matMul_args.B = inputData;
+    matMul_args.C = lora_act;
+    matMul_args.N = r;
+    matMul_args.K = Ci;
+    matMul_args.M = 1;
+    matMul_args.trans_B = 0;
+    pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
+
+    matMul_args.A = FC_args->lora_A->data;
+    matMul_args.B = lora_act;
+    matMul_args.C = outData;
+    matMul_args.N = Co;
+    matMul_args.K = r;
+    matMul_args.M = 1;
+    pi_cl_team_fork(NUM_CORES, mm_add, &matMul_args);
+  }
 }
 
 
@@ -88,6 +121,52 @@ void pulp_linear_fp32_bw_param_grads_cl( void * Linear_args )
 
   struct matMul_args matMul_args;
 
+  // Bias gradient
+  if (FC_args->bias != NULL) {
+    struct bias_args b_args;
+    b_args.data = outDiff;
+    b_args.bias = FC_args->bias->diff;
+    b_args.C = Co;
+    b_args.HW = 1;
+    b_args.HWC = 0;
+    pi_cl_team_fork(NUM_CORES, pulp_bias_grad_fp32_cl, &b_args);
+  }
+
+  // Adapter gradients: dA = dy*(B*x)^T, dB = (A^T*dy)*x^T
+  if (FC_args->lora_A != NULL) {
+    int r = FC_args->lora_rank;
+    float * lora_act = FC_args->lora_buffer;
+    float * lora_grad = FC_args->lora_buffer + r;
+
+    matMul_args.A = outDiff;
+    matMul_args.B = lora_act;
+    matMul_args.C = FC_args->lora_A->diff;
+    matMul_args.N = Co;
+    matMul_args.K = 1;
+    matMul_args.M = r;
+    matMul_args.trans_B = 0;
+    pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
+
+    matMul_args.A = FC_args->lora_A->data;
+    matMul_args.B = outDiff;
+    matMul_args.C = lora_grad;
+    matMul_args.N = r;
+    matMul_args.K = Co;
+    matMul_args.M = 1;
+    pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args);
+
+    matMul_args.A = lora_grad;
+    matMul_args.B = inData;
+    matMul_args.C = FC_args->lora_B->diff;
+    matMul_args.N = r;
+    matMul_args.K = 1;
+    matMul_args.M = Ci;
+    pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
+  }
+
+  // Frozen weights: no weight gradient
+  if (FC_args->skip_wgt_grad) return;
+
   matMul_args.A = outDiff;
   matMul_args.B = inData;
   matMul_args.C = coeffDiff;
@@ -103,6 +182,14 @@ void pulp_linear_fp32_bw_param_grads_cl( void * Linear_args )
   */
   matMul_args.trans_B = 0;
 
+  // Sparse update: gradient of the selected output neurons only, in compact form
+  if (FC_args->update_rows != NULL) {
+    matMul_args.N = FC_args->num_update_rows;
+    matMul_args.row_idx = FC_args->update_rows;
+    pi_cl_team_fork(NUM_CORES, mm_sparse_rows, &matMul_args);
+    return;
+  }
+
   #ifndef OPTIMIZE
   pi_cl_team_fork(NUM_CORES, mm, &matMul_args);
   #else
@@ -160,4 +247,27 @@ void pulp_linear_fp32_bw_input_grads_cl( void * Linear_args )
   pi_cl_team_fork(NUM_CORES, mm_manager, &man_args);
   #endif
 
+  // Adapter contribution: dx += B^T*(A^T*dy)
+  if (FC_args->lora_A != NULL) {
+    int r = FC_args->lora_rank;
+    float * lora_grad = FC_args->lora_buffer + r;
+
+    matMul_args.A = FC_args->lora_A->data;
+    matMul_args.B = outDiff;
+    matMul_args.C = lora_grad;
+    matMul_args.N = r;
+    matMul_args.K = Co;
+    matMul_args.M = 1;
+    matMul_args.trans_B = 0;
+    pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args);
+
+    matMul_args.A = lora_grad;
+    matMul_args.B = FC_args->lora_B->data;
+    matMul_args.C = inDiff;
+    matMul_args.N = 1;
+    matMul_args.K = r;
+    matMul_args.M = Ci;
+    pi_cl_team_fork(NUM_CORES, mm_add, &matMul_args);
+  }
+
 }
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_bf16.h"
+#include "pulp_losses_bf16.h"
+#include <math.h>
+
+
+void pulp_CrossEntropyLoss_bf16 ( void * loss_args_bf16 )
+{
+  struct loss_args_bf16 * args = (struct loss_args_bf16 *) loss_args_bf16;
+  bf16 * outData = args->output->data;
+  bf16 * outDiff = args->output->diff;
+  bf16 * target = args->target;
+  int size = args->output->dim;
+
+  float loss = 0.0f;
+  for(int i=0; i<size; i++){
+    float o = bf16_to_fp32(outData[i]);
+    float t = bf16_to_fp32(target[i]);
+    loss += -t*logf(o);
+    outDiff[i] = fp32_to_bf16(o - t);
+  }
+
+  #ifdef DEBUG
+  printf("\nLoss: %+.4f\n", loss);
+  #endif
+
+  *args->wr_loss = loss;
+}
+
+
+void pulp_MSELoss_bf16 ( void * loss_args_bf16 )
+{
+  struct loss_args_bf16 * args = (struct loss_args_bf16 *) loss_args_bf16;
+  bf16 * outData = args->output->data;
+  bf16 * outDiff = args->output->diff;
+  bf16 * target = args->target;
+  int size = args->output->dim;
+
+  const float meanval = 1.0f / size;
+  const float gradval = 2.0f * meanval;
+
+  float loss = 0.0f;
+  for(int i=0; i<size; i++){
+    float diff = bf16_to_fp32(outData[i]) - bf16_to_fp32(target[i]);
+    loss += meanval * diff * diff;
+    outDiff[i] = fp32_to_bf16(gradval * diff);
+  }
+
+  #ifdef DEBUG
+  printf("\nLoss: %+.4f\n", loss);
+  #endif
+
+  *args->wr_loss = loss;
+}
@@ -113,3 +113,217 @@ void pulp_MSELoss_fp16 ( void * loss_args_fp16 )
   }
 
 }
+
+
+
+/**
+ * Parallel loss functions
+ */
+
+// Deterministic pairwise (tree) reduction of the partial results of the cores
+static inline float tree_sum_fp16 (float * partials)
+{
+  for (int stride=1; stride<NUM_CORES; stride=stride*2)
+    for (int i=0; i+stride<NUM_CORES; i=i+2*stride)
+      partials[i] += partials[i+stride];
+  return partials[0];
+}
+
+
+void pulp_MSELoss_fp16_kernel ( void * loss_parallel_args_fp16 )
+{
+  struct loss_parallel_args_fp16 * args = (struct loss_parallel_args_fp16 *) loss_parallel_args_fp16;
+  fp16 * outData = args->output->data;
+  fp16 * outDiff = args->output->diff;
+  fp16 * target = args->target;
+  int size = args->output->dim;
+
+  const float meanval = 1.0f / size;
+  const float gradval = 2.0f * meanval;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  float loss = 0.0f;
+  for (int i=start; i<stop; i++) {
+    float diff = (float) outData[i] - (float) target[i];
+    loss += diff * diff;
+    outDiff[i] = (fp16) (gradval * diff);
+  }
+
+  args->partial_loss[pi_core_id()] = loss;
+}
+
+
+void pulp_MSELoss_fp16_cl ( void * loss_args_fp16 )
+{
+  struct loss_args_fp16 * args = (struct loss_args_fp16 *) loss_args_fp16;
+  float partial_loss[NUM_CORES] = {0.0f};
+
+  struct loss_parallel_args_fp16 par_args;
+  par_args.output = args->output;
+  par_args.target = args->target;
+  par_args.partial_loss = partial_loss;
+
+  pi_cl_team_fork(NUM_CORES, pulp_MSELoss_fp16_kernel, &par_args);
+
+  float loss = tree_sum_fp16(partial_loss) / args->output->dim;
+
+  #ifdef DEBUG_LOSS
+  printf("loss:%f \n\n",loss);
+  #endif
+
+  *(args->wr_loss) = (fp16) loss;
+}
+
+
+void pulp_CrossEntropyLoss_fp16_kernel ( void * loss_parallel_args_fp16 )
+{
+  struct loss_parallel_args_fp16 * args = (struct loss_parallel_args_fp16 *) loss_parallel_args_fp16;
+  fp16 * outData = args->output->data;
+  fp16 * outDiff = args->output->diff;
+  fp16 * target = args->target;
+  int size = args->output->dim;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  float loss = 0.0f;
+  for (int i=start; i<stop; i++) {
+    float t = (float) target[i];
+    float o = (float) outData[i];
+    // Skip log(0) for null label entries (0*log(0) = 0)
+    if (t != 0.0f) loss -= t * logf(o);
+    outDiff[i] = (fp16) (o - t);
+  }
+
+  args->partial_loss[pi_core_id()] = loss;
+}
+
+
+void pulp_CrossEntropyLoss_fp16_cl ( void * loss_args_fp16 )
+{
+  struct loss_args_fp16 * args = (struct loss_args_fp16 *) loss_args_fp16;
+  float partial_loss[NUM_CORES] = {0.0f};
+
+  struct loss_parallel_args_fp16 par_args;
+  par_args.output = args->output;
+  par_args.target = args->target;
+  par_args.partial_loss = partial_loss;
+
+  pi_cl_team_fork(NUM_CORES, pulp_CrossEntropyLoss_fp16_kernel, &par_args);
+
+  float loss = tree_sum_fp16(partial_loss);
+
+  #ifdef DEBUG_LOSS
+  printf("loss:%f \n\n",loss);
+  #endif
+
+  *(args->wr_loss) = (fp16) loss;
+}
+
+
+void pulp_SoftmaxCrossEntropy_stats_fp16_kernel ( void * loss_parallel_args_fp16 )
+{
+  struct loss_parallel_args_fp16 * args = (struct loss_parallel_args_fp16 *) loss_parallel_args_fp16;
+  fp16 * logits = args->output->data;
+  fp16 * target = args->target;
+  int size = args->output->dim;
+  int core_id = pi_core_id();
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = core_id*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  // Online softmax statistics: the exponential sum is rescaled each time a new maximum is found
+  float max = -340282346638528859811704183484516925440.0f;
+  float sum = 0.0f;
+  float t_logit = 0.0f;
+  float t_sum = 0.0f;
+  for (int i=start; i<stop; i++) {
+    float x = (float) logits[i];
+    float t = (float) target[i];
+    if (x > max) {
+      sum = sum * expf(max - x) + 1.0f;
+      max = x;
+    }
+    else {
+      sum += expf(x - max);
+    }
+    t_logit += t * x;
+    t_sum += t;
+  }
+
+  args->partial_max[core_id] = max;
+  args->partial_sum[core_id] = sum;
+  args->partial_loss[core_id] = t_logit;
+  args->partial_target_sum[core_id] = t_sum;
+}
+
+
+void pulp_SoftmaxCrossEntropy_grad_fp16_kernel ( void * loss_parallel_args_fp16 )
+{
+  struct loss_parallel_args_fp16 * args = (struct loss_parallel_args_fp16 *) loss_parallel_args_fp16;
+  fp16 * logits = args->output->data;
+  fp16 * outDiff = args->output->diff;
+  fp16 * target = args->target;
+  int size = args->output->dim;
+  float max = args->max;
+  float scale = args->scale;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  // dL/dx = softmax(x) * sum(target) - target
+  for (int i=start; i<stop; i++) {
+    outDiff[i] = (fp16) (expf((float) logits[i] - max) * scale - (float) target[i]);
+  }
+}
+
+
+void pulp_SoftmaxCrossEntropyLoss_fp16_cl ( void * loss_args_fp16 )
+{
+  struct loss_args_fp16 * args = (struct loss_args_fp16 *) loss_args_fp16;
+  float partial_loss[NUM_CORES] = {0.0f};
+  float partial_max[NUM_CORES] = {0.0f};
+  float partial_sum[NUM_CORES] = {0.0f};
+  float partial_target_sum[NUM_CORES] = {0.0f};
+
+  struct loss_parallel_args_fp16 par_args;
+  par_args.output = args->output;
+  par_args.target = args->target;
+  par_args.partial_loss = partial_loss;
+  par_args.partial_max = partial_max;
+  par_args.partial_sum = partial_sum;
+  par_args.partial_target_sum = partial_target_sum;
+
+  pi_cl_team_fork(NUM_CORES, pulp_SoftmaxCrossEntropy_stats_fp16_kernel, &par_args);
+
+  // Merge the local statistics on the global maximum
+  float max = partial_max[0];
+  for (int i=1; i<NUM_CORES; i++)
+    if (partial_max[i] > max) max = partial_max[i];
+  for (int i=0; i<NUM_CORES; i++)
+    partial_sum[i] = partial_sum[i] * expf(partial_max[i] - max);
+
+  float sum = tree_sum_fp16(partial_sum);
+  float t_logit = tree_sum_fp16(partial_loss);
+  float t_sum = tree_sum_fp16(partial_target_sum);
+
+  // loss = sum(target * (logsumexp(x) - x))
+  float loss = t_sum * (max + logf(sum)) - t_logit;
+
+  #ifdef DEBUG_LOSS
+  printf("loss:%f \n\n",loss);
+  #endif
+
+  *(args->wr_loss) = (fp16) loss;
+
+  par_args.max = max;
+  par_args.scale = t_sum / sum;
+
+  pi_cl_team_fork(NUM_CORES, pulp_SoftmaxCrossEntropy_grad_fp16_kernel, &par_args);
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2023 University of Bologna
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license.  See the LICENSE file for details.
+ */
+
+
+#include "pulp_train_utils_fp16.h"
+#include "pulp_matmul_fp16.h"
+#include "pulp_act_fp16.h"
+#include "pulp_lstm_fp16.h"
+
+
+//FORWARD
+void pulp_lstm_fp16_fw_cl(void * Lstm_args_fp16)
+{
+    struct Lstm_args_fp16 *lstm_args = (struct Lstm_args_fp16 *) Lstm_args_fp16;
+
+    pi_cl_team_fork(NUM_CORES, pulp_lstm_fp16_fw_kernel, lstm_args);
+
+    #ifdef DEBUG
+    int N = lstm_args->input->H;
+    int M = lstm_args->output->W;
+    printf("\nLSTM OutData: %d %d\n", N, M);
+    for (int j=0; j<N*M; j++){
+        if(!(j%(M))) printf("\n");
+        printf("%4.2e ", lstm_args->output->data[j]);
+    }
+    printf("\n");
+    #endif
+}
+
+
+
+//BACKWARD
+void pulp_lstm_fp16_bw_cl(void * Lstm_args_fp16)
+{
+    struct Lstm_args_fp16 *lstm_args = (struct Lstm_args_fp16 *) Lstm_args_fp16;
+
+    pi_cl_team_fork(NUM_CORES, pulp_lstm_fp16_bw_kernel, lstm_args);
+
+    #ifdef DEBUG
+    int N = lstm_args->input->H;
+    int M = lstm_args->output->W;
+    printf("\nLSTM gate gradients: %d %d\n", N, 4*M);
+    for (int j=0; j<N*4*M; j++){
+        if(!(j%(4*M))) printf("\n");
+        printf("%4.2e ", lstm_args->grad_buffer[j]);
+    }
+    printf("\n");
+    #endif
+}
+
+
+
+
+/**
+ * PARALLEL KERNELS
+ */
+
+void pulp_lstm_fp16_fw_kernel(void * Lstm_args_fp16)
+{
+    struct Lstm_args_fp16 *lstm_args = (struct Lstm_args_fp16 *) Lstm_args_fp16;
+    fp16 *coeffDataWx = lstm_args->coeff_x->data;
+    fp16 *coeffDataWs = lstm_args->coeff_s->data;
+    fp16 *inputData = lstm_args->input->data;
+    fp16 *stateData = lstm_args->state->data;
+    fp16 *cellData = lstm_args->cell->data;
+    fp16 *outData = lstm_args->output->data;
+    fp16 *gates = lstm_args->gate_buffer;
+
+    int N = lstm_args->input->H; // Sequence length
+    int K = lstm_args->input->W; // Input element size
+    int M = lstm_args->output->W; // Hidden size
+    int G = 4*M;
+
+    // Input projection of the whole sequence (gates = X*Wx)
+    struct matMul_args_fp16 matMul_args;
+    matMul_args.A = inputData;
+    matMul_args.B = coeffDataWx;
+    matMul_args.C = gates;
+    matMul_args.N = N;
+    matMul_args.K = K;
+    matMul_args.M = G;
+    matMul_args.trans_B = 0;
+
+    mm_fp16(&matMul_args);
+    pi_cl_team_barrier();
+
+    // Parallelize over the hidden units
+    const int blockSize = (M+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > M ? M : start+blockSize;
+
+    for (int t=0; t<N; t++) {
+        fp16 *g_t = gates + t*G;
+        fp16 *h_prev = stateData + t*M;
+        fp16 *c_prev = cellData + t*M;
+
+        for (int j=start; j<stop; j++) {
+            fp16 acc_i = g_t[j];
+            fp16 acc_f = g_t[M+j];
+            fp16 acc_g = g_t[2*M+j];
+            fp16 acc_o = g_t[3*M+j];
+            for (int m=0; m<M; m++) {
+                fp16 h = h_prev[m];
+                fp16 *w = coeffDataWs + m*G;
+                acc_i += h * w[j];
+                acc_f += h * w[M+j];
+                acc_g += h * w[2*M+j];
+                acc_o += h * w[3*M+j];
+            }
+            fp16 i_g = act_sigmoid_fp16(acc_i);
+            fp16 f_g = act_sigmoid_fp16(acc_f);
+            fp16 g_g = act_tanh_fp16(acc_g);
+            fp16 o_g = act_sigmoid_fp16(acc_o);
+
+            fp16 c = f_g * c_prev[j] + i_g * g_g;
+            fp16 h = o_g * act_tanh_fp16(c);
+
+            // Keep the activated gates for the backward step
+            g_t[j] = i_g;
+            g_t[M+j] = f_g;
+            g_t[2*M+j] = g_g;
+            g_t[3*M+j] = o_g;
+            cellData[(t+1)*M+j] = c;
+            outData[t*M+j] = h;
+            if (t < N-1)    stateData[(t+1)*M+j] = h;
+        }
+
+        pi_cl_team_barrier();
+    }
+}
+
+
+
+void pulp_lstm_fp16_bw_kernel(void * Lstm_args_fp16)
+{
+    struct Lstm_args_fp16 *lstm_args = (struct Lstm_args_fp16 *) Lstm_args_fp16;
+    fp16 *coeffDataWx = lstm_args->coeff_x->data;
+    fp16 *coeffDataWs = lstm_args->coeff_s->data;
+    fp16 *coeffDiffWx = lstm_args->coeff_x->diff;
+    fp16 *coeffDiffWs = lstm_args->coeff_s->diff;
+    fp16 *inputData = lstm_args->input->data;
+    fp16 *inputDiff = lstm_args->input->diff;
+    fp16 *stateData = lstm_args->state->data;
+    fp16 *stateDiff = lstm_args->state->diff;
+    fp16 *cellData = lstm_args->cell->data;
+    fp16 *cellDiff = lstm_args->cell->diff;
+    fp16 *outDiff = lstm_args->output->diff;
+    fp16 *gates = lstm_args->gate_buffer;
+    fp16 *grad = lstm_args->grad_buffer;
+    int window = lstm_args->bptt_window;
+
+    int N = lstm_args->input->H; // Sequence length
+    int K = lstm_args->input->W; // Input element size
+    int M = lstm_args->output->W; // Hidden size
+    int G = 4*M;
+
+    // Parallelize over the hidden units
+    const int blockSize = (M+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > M ? M : start+blockSize;
+
+    for (int t=N-1; t>=0; t--) {
+        fp16 *g_t = gates + t*G;
+        fp16 *d_t = grad + t*G;
+        // The recurrent gradient is cut at the truncated-BPTT window boundaries
+        int recur = (t < N-1) && ((window <= 0) || ((t+1) % window != 0));
+
+        for (int j=start; j<stop; j++) {
+            fp16 dh = outDiff[t*M+j];
+            fp16 dc = 0;
+            if (t < N-1) {
+                // Gradient of h_t through the gates of timestep t+1
+                fp16 *ws_row = coeffDataWs + j*G;
+                fp16 *d_next = grad + (t+1)*G;
+                fp16 rec = 0;
+                for (int m=0; m<G; m++)     rec += d_next[m] * ws_row[m];
+                stateDiff[(t+1)*M+j] = rec;
+                if (recur) {
+                    dh += rec;
+                    dc = cellDiff[(t+2)*M+j] * gates[(t+1)*G+M+j];
+                }
+            }
+
+            fp16 i_g = g_t[j];
+            fp16 f_g = g_t[M+j];
+            fp16 g_g = g_t[2*M+j];
+            fp16 o_g = g_t[3*M+j];
+            fp16 tc = act_tanh_fp16(cellData[(t+1)*M+j]);
+
+            dc += dh * o_g * (1-tc*tc);
+            cellDiff[(t+1)*M+j] = dc;
+
+            d_t[j] = dc * g_g * i_g * (1-i_g);
+            d_t[M+j] = dc * cellData[t*M+j] * f_g * (1-f_g);
+            d_t[2*M+j] = dc * i_g * (1-g_g*g_g);
+            d_t[3*M+j] = dh * tc * o_g * (1-o_g);
+        }
+
+        pi_cl_team_barrier();
+    }
+
+    // Gradients of the initial hidden and cell states
+    for (int j=start; j<stop; j++) {
+        fp16 *ws_row = coeffDataWs + j*G;
+        fp16 rec = 0;
+        for (int m=0; m<G; m++)     rec += grad[m] * ws_row[m];
+        stateDiff[j] = rec;
+        cellDiff[j] = cellDiff[M+j] * gates[M+j];
+    }
+
+    // Gradient of the Input Weights (dWx = Xt*dG)
+    struct matMul_args_fp16 matMul_args1;
+    matMul_args1.A = inputData;
+    matMul_args1.B = grad;
+    matMul_args1.C = coeffDiffWx;
+    matMul_args1.N = K;
+    matMul_args1.K = N;
+    matMul_args1.M = G;
+    matMul_args1.trans_B = 0;
+
+    mm_trans_A_fp16(&matMul_args1);
+
+    // Gradient of the State Weights (dWs = St*dG)
+    struct matMul_args_fp16 matMul_args2;
+    matMul_args2.A = stateData;
+    matMul_args2.B = grad;
+    matMul_args2.C = coeffDiffWs;
+    matMul_args2.N = M;
+    matMul_args2.K = N;
+    matMul_args2.M = G;
+    matMul_args2.trans_B = 0;
+
+    mm_trans_A_fp16(&matMul_args2);
+
+    // Gradient of the Input (dX = dG*Wxt)
+    struct matMul_args_fp16 matMul_args3;
+    matMul_args3.A = grad;
+    matMul_args3.B = coeffDataWx;
+    matMul_args3.C = inputDiff;
+    matMul_args3.N = N;
+    matMul_args3.K = G;
+    matMul_args3.M = K;
+    matMul_args3.trans_B = 1;
+
+    mm_fp16(&matMul_args3);
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_bf16.h"
+#include "pulp_matmul_bf16.h"
+
+
+// Row i of A times column j of B (row j if transposed), unrolled by 2
+static inline float dot_bf16 (bf16 * A_row, bf16 * B, uint32_t j, uint32_t M, uint32_t K, uint32_t transp)
+{
+  float temp0 = 0;
+  float temp1 = 0;
+  uint32_t k = 0;
+
+  if (transp == 0) {
+    for (; k+1<K; k+=2) {
+      temp0 += bf16_to_fp32(A_row[k])   * bf16_to_fp32(B[j+k*M]);
+      temp1 += bf16_to_fp32(A_row[k+1]) * bf16_to_fp32(B[j+(k+1)*M]);
+    }
+    if (k < K) temp0 += bf16_to_fp32(A_row[k]) * bf16_to_fp32(B[j+k*M]);
+  }
+  else {
+    bf16 * B_row = B + j*K;
+    for (; k+1<K; k+=2) {
+      temp0 += bf16_to_fp32(A_row[k])   * bf16_to_fp32(B_row[k]);
+      temp1 += bf16_to_fp32(A_row[k+1]) * bf16_to_fp32(B_row[k+1]);
+    }
+    if (k < K) temp0 += bf16_to_fp32(A_row[k]) * bf16_to_fp32(B_row[k]);
+  }
+  return temp0 + temp1;
+}
+
+
+void mm_bf16 (void * void_args)
+{
+  struct matMul_args_bf16* args = (struct matMul_args_bf16 *)void_args;
+  bf16 * __restrict__ A = args->A;
+  bf16 * __restrict__ B = args->B;
+  bf16 * __restrict__ C = args->C;
+
+  const uint32_t N = args->N;
+  const uint32_t M = args->M;
+  const uint32_t K = args->K;
+  const uint32_t transp = args->trans_B;
+
+  const uint32_t blockSize = (N+NUM_CORES-1) / NUM_CORES;
+  const uint32_t start = pi_core_id()*blockSize;
+  const uint32_t stop = start+blockSize > N ? N : start+blockSize;
+
+  for (uint32_t i=start; i<stop; i++) {
+    for (uint32_t j=0; j<M; j++) {
+      C[i*M+j] = fp32_to_bf16(dot_bf16(A+i*K, B, j, M, K, transp));
+    }
+  }
+}
+
+
+void mm_M_bf16 (void * void_args)
+{
+  struct matMul_args_bf16* args = (struct matMul_args_bf16 *)void_args;
+  bf16 * __restrict__ A = args->A;
+  bf16 * __restrict__ B = args->B;
+  bf16 * __restrict__ C = args->C;
+
+  const uint32_t N = args->N;
+  const uint32_t M = args->M;
+  const uint32_t K = args->K;
+  const uint32_t transp = args->trans_B;
+
+  const uint32_t blockSize = (M+NUM_CORES-1) / NUM_CORES;
+  const uint32_t start = pi_core_id()*blockSize;
+  const uint32_t stop = start+blockSize > M ? M : start+blockSize;
+
+  for (uint32_t i=0; i<N; i++) {
+    for (uint32_t j=start; j<stop; j++) {
+      C[i*M+j] = fp32_to_bf16(dot_bf16(A+i*K, B, j, M, K, transp));
+    }
+  }
+}
+
+
+
+void naive_conv2d_fw_kernel_CHW_bf16 (void * matMul_args)
+{
+  struct matMul_args_bf16* args = (struct matMul_args_bf16 *)matMul_args;
+  bf16 * __restrict__ inData = args->A;
+  bf16 * __restrict__ coeffData = args->B;
+  bf16 * __restrict__ outData = args->C;
+
+  const int H_in = args->H;
+  const int W_in = args->W;
+  const int pW = args->pW;
+  const int pH = args->pH;
+  const int C_in = args->pCin;
+  const int C_out = args->pCout;
+
+  const int h_str = args->stride_h;
+  const int w_str = args->stride_w;
+  const int Lpad = args->Lpad;
+  const int Upad = args->Upad;
+
+  const int H_out = (H_in - pH + Upad + args->Dpad)/h_str + 1;
+  const int W_out = (W_in - pW + Lpad + args->Rpad)/w_str + 1;
+
+  const int blockSize = (C_out+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > C_out ? C_out : start+blockSize;
+
+  for (int co=start; co<stop; co++) {
+    for (int ho=0; ho<H_out; ho++) {
+      for (int wo=0; wo<W_out; wo++) {
+        float temp = 0;
+        for (int ci=0; ci<C_in; ci++) {
+          for (int hk=0; hk<pH; hk++) {
+            int hi = h_str*ho + hk - Upad;
+            // Zero padding
+            if (hi < 0 || hi >= H_in) continue;
+            for (int wk=0; wk<pW; wk++) {
+              int wi = w_str*wo + wk - Lpad;
+              if (wi < 0 || wi >= W_in) continue;
+              temp += bf16_to_fp32(inData[wi+hi*W_in+ci*H_in*W_in]) * bf16_to_fp32(coeffData[wk+hk*pW+ci*pH*pW+co*C_in*pH*pW]);
+            }
+          }
+        }
+        outData[wo+ho*W_out+co*H_out*W_out] = fp32_to_bf16(temp);
+      }
+    }
+  }
+}
+
+
+void naive_conv2d_param_grad_kernel_CHW_bf16 (void * matMul_args)
+{
+  struct matMul_args_bf16* args = (struct matMul_args_bf16 *)matMul_args;
+  bf16 * __restrict__ inData = args->A;
+  bf16 * __restrict__ coeffDiff = args->B;
+  bf16 * __restrict__ outDiff = args->C;
+
+  const int H_in = args->H;
+  const int W_in = args->W;
+  const int pW = args->pW;
+  const int pH = args->pH;
+  const int C_in = args->pCin;
+  const int C_out = args->pCout;
+
+  const int h_str = args->stride_h;
+  const int w_str = args->stride_w;
+  const int Lpad = args->Lpad;
+  const int Upad = args->Upad;
+
+  const int H_out = (H_in - pH + Upad + args->Dpad)/h_str + 1;
+  const int W_out = (W_in - pW + Lpad + args->Rpad)/w_str + 1;
+
+  const int blockSize = (C_out+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > C_out ? C_out : start+blockSize;
+
+  for (int co=start; co<stop; co++) {
+    for (int ci=0; ci<C_in; ci++) {
+      for (int hk=0; hk<pH; hk++) {
+        for (int wk=0; wk<pW; wk++) {
+          float temp = 0;
+          for (int ho=0; ho<H_out; ho++) {
+            int hi = h_str*ho + hk - Upad;
+            if (hi < 0 || hi >= H_in) continue;
+            for (int wo=0; wo<W_out; wo++) {
+              int wi = w_str*wo + wk - Lpad;
+              if (wi < 0 || wi >= W_in) continue;
+              temp += bf16_to_fp32(outDiff[wo+ho*W_out+co*H_out*W_out]) * bf16_to_fp32(inData[wi+hi*W_in+ci*H_in*W_in]);
+            }
+          }
+          coeffDiff[wk+hk*pW+ci*pH*pW+co*C_in*pH*pW] = fp32_to_bf16(temp);
+        }
+      }
+    }
+  }
+}
+
+
+void naive_conv2d_in_grad_kernel_CHW_bf16 (void * matMul_args)
+{
+  struct matMul_args_bf16* args = (struct matMul_args_bf16 *)matMul_args;
+  bf16 * __restrict__ inDiff = args->A;
+  bf16 * __restrict__ coeffData = args->B;
+  bf16 * __restrict__ outDiff = args->C;
+
+  const int H_in = args->H;
+  const int W_in = args->W;
+  const int pW = args->pW;
+  const int pH = args->pH;
+  const int C_in = args->pCin;
+  const int C_out = args->pCout;
+
+  const int h_str = args->stride_h;
+  const int w_str = args->stride_w;
+  const int Lpad = args->Lpad;
+  const int Upad = args->Upad;
+
+  const int H_out = (H_in - pH + Upad + args->Dpad)/h_str + 1;
+  const int W_out = (W_in - pW + Lpad + args->Rpad)/w_str + 1;
+
+  const int blockSize = (C_in+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > C_in ? C_in : start+blockSize;
+
+  // Input pixel (hi, wi) is seen by kernel element (hk, wk) of output pixel (ho, wo) if hi+Upad = h_str*ho+hk (same on w)
+  for (int ci=start; ci<stop; ci++) {
+    for (int hi=0; hi<H_in; hi++) {
+      for (int wi=0; wi<W_in; wi++) {
+        float temp = 0;
+        for (int hk=0; hk<pH; hk++) {
+          int h = hi + Upad - hk;
+          if (h < 0 || h % h_str != 0 || h/h_str >= H_out) continue;
+          int ho = h / h_str;
+          for (int wk=0; wk<pW; wk++) {
+            int w = wi + Lpad - wk;
+            if (w < 0 || w % w_str != 0 || w/w_str >= W_out) continue;
+            int wo = w / w_str;
+            for (int co=0; co<C_out; co++) {
+              temp += bf16_to_fp32(coeffData[wk+hk*pW+ci*pH*pW+co*C_in*pH*pW]) * bf16_to_fp32(outDiff[wo+ho*W_out+co*H_out*W_out]);
+            }
+          }
+        }
+        inDiff[wi+hi*W_in+ci*H_in*W_in] = fp32_to_bf16(temp);
+      }
+    }
+  }
+}
@@ -176,6 +176,40 @@ void mm_M_fp16(void * void_args) {
 
 
 
+// Naive matmul with transposed A and parallelism on N
+void mm_trans_A_fp16(void * void_args) {
+
+  struct matMul_args_fp16* args = (struct matMul_args_fp16 *)void_args;
+  fp16 * __restrict__ A = args->A;
+  fp16 * __restrict__ B = args->B;
+  fp16 * __restrict__ C = args->C;
+
+  const uint32_t N = args->N;
+  const uint32_t M = args->M;
+  const uint32_t K = args->K;
+
+  // Strides of B along K and M
+  const uint32_t B_k = args->trans_B ? 1 : M;
+  const uint32_t B_j = args->trans_B ? K : 1;
+
+  const uint32_t blockSize = (N+NUM_CORES-1) / NUM_CORES;
+  const uint32_t start = pi_core_id()*blockSize;
+  const uint32_t stop = start+blockSize > N ? N : start+blockSize;
+
+  for (uint32_t i=start; i < stop; i++) 
+  {
+    for (uint32_t j = 0; j < M; j++) 
+    {
+      fp16 temp = 0;
+      for (uint32_t k = 0; k < K; k++) 
+      {
+            temp += A[k*N+i] * B[k*B_k+j*B_j];
+      } 
+      C[i*M+j] = temp;
+    } 
+  } 
+}
+
 // Naive forward kernel for DepthWise Convolution
 void dw_kernel_forward_fp16(void * kernel_DW_args_fp16) {
 
@@ -506,6 +540,31 @@ void naive_conv2d_in_grad_kernel_CHW_fp16 (void * matMul_args_fp16)
  * Optimized versions
  */
 
+// Dot product of a row of A with column j of B (row j if B is transposed) on fp16 pairs, for the leftovers of the SIMD matmuls
+static inline fp16 __attribute__((always_inline)) dot_fp16_SIMD (fp16 * A_row, fp16 * B, uint32_t j, uint32_t M, uint32_t K, uint32_t transp)
+{
+  uint32_t K_loop = (K & 0xfffffffe);
+  v2f16 temp = (v2f16) {0, 0};
+
+  // Contiguous column: transposed B, or B with a single column
+  if (transp || M == 1) 
+  {
+    fp16 * B_col = transp ? &B[j*K] : &B[j];
+    for (uint32_t k = 0; k < K_loop; k+=2)
+      temp += *((v2f16 *) &A_row[k]) * *((v2f16 *) &B_col[k]);
+  }
+  else 
+  {
+    for (uint32_t k = 0; k < K_loop; k+=2)
+      temp += *((v2f16 *) &A_row[k]) * (v2f16) {B[k*M+j], B[(k+1)*M+j]};
+  }
+
+  fp16 res = temp[0] + temp[1];
+  // Leftover on K
+  if (K & 1) res += A_row[K-1] * (transp ? B[j*K+(K-1)] : B[(K-1)*M+j]);
+  return res;
+}
+
 void __attribute__((noinline)) mm_fp16_SIMD_2x4 (void * void_args) 
 {
 
@@ -527,9 +586,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_2x4 (void * void_args)
   uint32_t M_loop = (M & 0xfffffffe);
   uint32_t K_loop = (K & 0xfffffffe);
 
-  if      (M < 2) mm_fp16(args);
-  else if (K < 2) mm_fp16(args);
-  else {
+  // Small M and K are covered by the leftovers, no naive fallback
   // =====> B NOT TRANSPOSED <=====
   if (transp == 0) 
   {
@@ -575,10 +632,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_2x4 (void * void_args)
       // Leftover on M
       if(M & 1) {
         for (uint32_t i = start; i < stop; i++) {
-          fp16 val = 0;
-          for (uint32_t k = 0; k < K; k++) {
-            val += A[i*K+k]*B[k*M+(M-1)];
-          }
+          fp16 val = dot_fp16_SIMD(&A[i*K], B, M-1, M, K, 0);
           C[i*M+(M-1)] = val;
         }
       }
@@ -657,14 +711,10 @@ void __attribute__((noinline)) mm_fp16_SIMD_2x4 (void * void_args)
     // Leftover on N
     if(M & 1) {
       for (uint32_t i = start; i < stop; i++) {
-        fp16 val = 0;
-        for (uint32_t k = 0; k < K; k++) {
-          val += A[i*K+k]*B[(M-1)*K+k];
-        }
+        fp16 val = dot_fp16_SIMD(&A[i*K], B, M-1, M, K, 1);
       C[i*M+(M-1)] = val;
       }
     }
-    }
   }
 
 }
@@ -707,7 +757,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_4x8 (void * void_args)
     if (transp == 0) 
     {
     #if NUM_CORES > 1
-      const uint32_t blockSize = (N_loop+NUM_CORES-1) / NUM_CORES;
+      const uint32_t blockSize = (((N_loop+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;   // Whole blocks of 2 rows
       const uint32_t start = core_id*blockSize;
       const uint32_t stop = start+blockSize < N_loop? start+blockSize: N_loop;
 
@@ -781,11 +831,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_4x8 (void * void_args)
           {
             for (uint32_t j=(M-(M & 0x00000003)); j<M; j++)
             {
-              fp16 left_temp = 0;
-              for (uint32_t k=0; k<K; k++)
-              {
-                left_temp += A[ii*K+k] * B[k*M+j];
-              }
+              fp16 left_temp = dot_fp16_SIMD(&A[ii*K], B, j, M, K, 0);
               C[ii*M+j] = left_temp;
             }
           }
@@ -800,11 +846,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_4x8 (void * void_args)
 
         for (uint32_t j=j_start; j<j_stop; j++)
         {
-          fp16 temp_left = 0;
-          for (uint32_t k=0; k<K; k++)
-          {
-            temp_left += A[(N-1)*K+k] * B[j+k*M];
-          }
+          fp16 temp_left = dot_fp16_SIMD(&A[(N-1)*K], B, j, M, K, 0);
           C[(N-1)*M+j] = temp_left;
         }
       }
@@ -814,7 +856,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_4x8 (void * void_args)
     else
     {
     #if NUM_CORES > 1
-      const uint32_t blockSize = (N_loop+NUM_CORES-1) / NUM_CORES;
+      const uint32_t blockSize = (((N_loop+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;   // Whole blocks of 2 rows
       const uint32_t start = pi_core_id()*blockSize;
       const uint32_t stop = start+blockSize < N_loop? start+blockSize: N_loop;
 
@@ -921,11 +963,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_4x8 (void * void_args)
           {
             for (uint32_t j=(M-(M & 0x00000003)); j<M; j++)
             {
-              fp16 left_temp = 0;
-              for (uint32_t k=0; k<K; k++)
-              {
-                left_temp += A[ii*K+k] * B[j*K+k];
-              }
+              fp16 left_temp = dot_fp16_SIMD(&A[ii*K], B, j, M, K, 1);
               C[ii*M+j] = left_temp;
             }
           }
@@ -941,11 +979,7 @@ void __attribute__((noinline)) mm_fp16_SIMD_4x8 (void * void_args)
         for (uint32_t j=j_start; j<j_stop; j++)
         //for (uint32_t j=0; j<M; j++)
         {
-          fp16 temp_left = 0;
-          for (uint32_t k=0; k<K; k++)
-          {
-            temp_left += A[(N-1)*K+k] * B[j*K+k];
-          }
+          fp16 temp_left = dot_fp16_SIMD(&A[(N-1)*K], B, j, M, K, 1);
           C[(N-1)*M+j] = temp_left;
         }
       }
@@ -994,14 +1028,12 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_2x4 (void * void_args)
   uint32_t M_left = M - M_par;
   uint32_t core_id = pi_core_id();
 
-  if      (M_par < 2) mm_fp16(args);
-  else if (K < 2)     mm_fp16(args);
-  else {
+  // Small M and K are covered by the leftovers, no naive fallback
   // =====> B NOT TRANSPOSED <=====
   if (transp == 0) 
   {
     #if NUM_CORES > 1
-    const uint32_t blockSize = (M_par+NUM_CORES-1) / NUM_CORES;
+    const uint32_t blockSize = (((M_par+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;   // Whole blocks of 2 columns
     const uint32_t start = core_id*blockSize;
     const uint32_t stop = start+blockSize < M_par? start+blockSize: M_par;
 
@@ -1049,11 +1081,7 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_2x4 (void * void_args)
 
       for (uint32_t i = i_start; i < i_stop; i++) 
       {
-        fp16 val = 0;
-        for (uint32_t k = 0; k < K; k++) 
-        {
-          val += A[i*K+k]*B[k*M+(M-1)];
-        }
+        fp16 val = dot_fp16_SIMD(&A[i*K], B, M-1, M, K, 0);
         C[i*M+(M-1)] = val;
       }
     }
@@ -1063,7 +1091,7 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_2x4 (void * void_args)
   else 
   {
     #if NUM_CORES > 1
-    const uint32_t blockSize = (M_par+NUM_CORES-1) / NUM_CORES;
+    const uint32_t blockSize = (((M_par+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;   // Whole blocks of 2 columns
     const uint32_t start = core_id*blockSize;
     const uint32_t stop = start+blockSize < M_par? start+blockSize: M_par;
 
@@ -1136,16 +1164,11 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_2x4 (void * void_args)
       
       for (uint32_t i = i_start; i < i_stop; i++) 
       {
-        fp16 val = 0;
-        for (uint32_t k = 0; k < K; k++) 
-        {
-          val += A[i*K+k]*B[(M-1)*K+k];
-        }
+        fp16 val = dot_fp16_SIMD(&A[i*K], B, M-1, M, K, 1);
       C[i*M+(M-1)] = val;
       }
     }
   }
-  }
 }
 
 
@@ -1187,7 +1210,7 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_4x8 (void * void_args)
   if (transp == 0) 
   {
     #if NUM_CORES > 1
-      const uint32_t blockSize = (M_par+NUM_CORES-1) / NUM_CORES;
+      const uint32_t blockSize = (((M_par+NUM_CORES-1) / NUM_CORES) + 3) & 0xfffffffc;   // Whole blocks of 4 columns
       const uint32_t start = core_id*blockSize;
       const uint32_t stop = start+blockSize < M_par? start+blockSize: M_par;
 
@@ -1259,11 +1282,7 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_4x8 (void * void_args)
         {
           for (uint32_t jj=j; jj<j+4; jj++)
           {
-            float left_temp = 0;
-            for (uint32_t k=0; k<K; k++)
-            {
-              left_temp += A[(N-1)*K+k] * B[jj+k*M];
-            }
+            fp16 left_temp = dot_fp16_SIMD(&A[(N-1)*K], B, jj, M, K, 0);
             C[(N-1)*M+jj] = left_temp;
           }
         }
@@ -1279,11 +1298,7 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_4x8 (void * void_args)
         {
           for (uint32_t j=M-M_left; j<M; j++)
           {
-            float left_temp = 0;
-            for (uint32_t k=0; k<K; k++)
-            {
-              left_temp += A[i*K+k] * B[j+k*M];
-            }
+            fp16 left_temp = dot_fp16_SIMD(&A[i*K], B, j, M, K, 0);
             C[i*M+j] = left_temp;
           }
         }
@@ -1294,7 +1309,7 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_4x8 (void * void_args)
   else 
   {
   #if NUM_CORES > 1
-    const uint32_t blockSize = (M_par+NUM_CORES-1) / NUM_CORES;
+    const uint32_t blockSize = (((M_par+NUM_CORES-1) / NUM_CORES) + 3) & 0xfffffffc;   // Whole blocks of 4 columns
     const uint32_t start = core_id*blockSize;
     const uint32_t stop = start+blockSize < M_par? start+blockSize: M_par;
 
@@ -1398,11 +1413,7 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_4x8 (void * void_args)
         {
           for (uint32_t jj=j; jj<j+4; jj++)
           {
-            float left_temp = 0;
-            for (uint32_t k=0; k<K; k++)
-            {
-              left_temp += A[(N-1)*K+k] * B[jj*K+k];
-            }
+            fp16 left_temp = dot_fp16_SIMD(&A[(N-1)*K], B, jj, M, K, 1);
             C[(N-1)*M+jj] = left_temp;
           }
         }
@@ -1418,11 +1429,7 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_4x8 (void * void_args)
         {
           for (uint32_t j=M-M_left; j<M; j++)
           {
-            float left_temp = 0;
-            for (uint32_t k=0; k<K; k++)
-            {
-              left_temp += A[i*K+k] * B[j*K+k];
-            }
+            fp16 left_temp = dot_fp16_SIMD(&A[i*K], B, j, M, K, 1);
             C[i*M+j] = left_temp;
           }
         }
@@ -1430,3 +1437,194 @@ void __attribute__((noinline)) mm_M_fp16_SIMD_4x8 (void * void_args)
     }
   }
 }
+
+
+
+/**
+ * FP32 accumulation
+ */
+
+// Dot product of row i of A and column j of B, accumulated in fp32
+static inline float __attribute__((always_inline)) dot_fp16_fp32acc (struct matMul_args_fp16 * args, uint32_t i, uint32_t j)
+{
+  fp16 * __restrict__ A = args->A;
+  fp16 * __restrict__ B = args->B;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+
+  float temp = 0;
+  if (args->trans_B == 0)   for (uint32_t k=0; k<K; k++)  temp += (float) A[i*K+k] * (float) B[k*M+j];
+  else                      for (uint32_t k=0; k<K; k++)  temp += (float) A[i*K+k] * (float) B[j*K+k];
+  return temp;
+}
+
+// Computes rows [i_start, i_stop) and columns [j_start, j_stop) of C in 2x2 blocks, loading fp16 pairs and accumulating in fp32
+static inline void __attribute__((always_inline)) mm_fp16_fp32acc_tile (struct matMul_args_fp16 * args, 
+  uint32_t i_start, uint32_t i_stop, uint32_t j_start, uint32_t j_stop, int out_fp32)
+{
+  fp16 * __restrict__ A = args->A; 
+  fp16 * __restrict__ B = args->B; 
+  fp16 * __restrict__ C = args->C; 
+  float * C32 = (float *) args->C;
+  uint32_t M = args->M; 
+  uint32_t K = args->K;  
+  uint32_t transp = args->trans_B;
+
+  if (i_start >= i_stop || j_start >= j_stop) return;
+
+  uint32_t K_loop = (K & 0xfffffffe);
+  uint32_t i_loop = i_start + ((i_stop-i_start) & 0xfffffffe);
+  uint32_t j_loop = j_start + ((j_stop-j_start) & 0xfffffffe);
+
+  v2f16 Av0, Av1, Bv0, Bv1;
+
+  for (uint32_t i=i_start; i<i_loop; i+=2) 
+  {
+    fp16 * a0 = &A[i*K];
+    fp16 * a1 = a0 + K;
+
+    for (uint32_t j=j_start; j<j_loop; j+=2) 
+    {
+      float c00 = 0, c01 = 0, c10 = 0, c11 = 0;
+
+      // =====> B NOT TRANSPOSED <=====
+      if (transp == 0) 
+      {
+        for (uint32_t k=0; k<K_loop; k+=2) 
+        {
+          Av0 = *((v2f16 *) &a0[k]);
+          Av1 = *((v2f16 *) &a1[k]);
+          Bv0 = *((v2f16 *) &B[k*M+j]);
+          Bv1 = *((v2f16 *) &B[(k+1)*M+j]);
+          c00 += (float) Av0[0] * (float) Bv0[0] + (float) Av0[1] * (float) Bv1[0];
+          c01 += (float) Av0[0] * (float) Bv0[1] + (float) Av0[1] * (float) Bv1[1];
+          c10 += (float) Av1[0] * (float) Bv0[0] + (float) Av1[1] * (float) Bv1[0];
+          c11 += (float) Av1[0] * (float) Bv0[1] + (float) Av1[1] * (float) Bv1[1];
+        }
+        // Leftover on K
+        if (K & 1) 
+        {
+          Bv0 = *((v2f16 *) &B[(K-1)*M+j]);
+          c00 += (float) a0[K-1] * (float) Bv0[0];
+          c01 += (float) a0[K-1] * (float) Bv0[1];
+          c10 += (float) a1[K-1] * (float) Bv0[0];
+          c11 += (float) a1[K-1] * (float) Bv0[1];
+        }
+      }
+
+      // =====> B IS TRANSPOSED <=====
+      else 
+      {
+        fp16 * b0 = &B[j*K];
+        fp16 * b1 = b0 + K;
+        for (uint32_t k=0; k<K_loop; k+=2) 
+        {
+          Av0 = *((v2f16 *) &a0[k]);
+          Av1 = *((v2f16 *) &a1[k]);
+          Bv0 = *((v2f16 *) &b0[k]);
+          Bv1 = *((v2f16 *) &b1[k]);
+          c00 += (float) Av0[0] * (float) Bv0[0] + (float) Av0[1] * (float) Bv0[1];
+          c01 += (float) Av0[0] * (float) Bv1[0] + (float) Av0[1] * (float) Bv1[1];
+          c10 += (float) Av1[0] * (float) Bv0[0] + (float) Av1[1] * (float) Bv0[1];
+          c11 += (float) Av1[0] * (float) Bv1[0] + (float) Av1[1] * (float) Bv1[1];
+        }
+        // Leftover on K
+        if (K & 1) 
+        {
+          c00 += (float) a0[K-1] * (float) b0[K-1];
+          c01 += (float) a0[K-1] * (float) b1[K-1];
+          c10 += (float) a1[K-1] * (float) b0[K-1];
+          c11 += (float) a1[K-1] * (float) b1[K-1];
+        }
+      }
+
+      if (out_fp32) 
+      {
+        C32[i*M+j] = c00;       C32[i*M+j+1] = c01;
+        C32[(i+1)*M+j] = c10;   C32[(i+1)*M+j+1] = c11;
+      }
+      else 
+      {
+        C[i*M+j] = (fp16) c00;       C[i*M+j+1] = (fp16) c01;
+        C[(i+1)*M+j] = (fp16) c10;   C[(i+1)*M+j+1] = (fp16) c11;
+      }
+    }
+
+    // Leftover on M
+    if (j_loop < j_stop) 
+    {
+      float c0 = dot_fp16_fp32acc(args, i, j_loop);
+      float c1 = dot_fp16_fp32acc(args, i+1, j_loop);
+      if (out_fp32)   { C32[i*M+j_loop] = c0;         C32[(i+1)*M+j_loop] = c1; }
+      else            { C[i*M+j_loop] = (fp16) c0;    C[(i+1)*M+j_loop] = (fp16) c1; }
+    }
+  }
+
+  // Leftover on N
+  if (i_loop < i_stop) 
+  {
+    for (uint32_t j=j_start; j<j_stop; j++) 
+    {
+      float c = dot_fp16_fp32acc(args, i_loop, j);
+      if (out_fp32)   C32[i_loop*M+j] = c;
+      else            C[i_loop*M+j] = (fp16) c;
+    }
+  }
+}
+
+
+void __attribute__((noinline)) mm_fp16_SIMD_2x2_fp32acc (void * void_args)
+{
+  struct matMul_args_fp16 * args = (struct matMul_args_fp16 *) void_args;
+  uint32_t N = args->N;  
+  uint32_t M = args->M; 
+
+  const uint32_t blockSize = (N+NUM_CORES-1) / NUM_CORES;
+  const uint32_t start = pi_core_id()*blockSize;
+  const uint32_t stop = start+blockSize > N ? N : start+blockSize;
+
+  mm_fp16_fp32acc_tile(args, start, stop, 0, M, 0);
+}
+
+
+void __attribute__((noinline)) mm_M_fp16_SIMD_2x2_fp32acc (void * void_args)
+{
+  struct matMul_args_fp16 * args = (struct matMul_args_fp16 *) void_args;
+  uint32_t N = args->N;  
+  uint32_t M = args->M; 
+
+  // Even blocks, to keep the fp16 pairs of B aligned
+  const uint32_t blockSize = (((M+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const uint32_t start = pi_core_id()*blockSize;
+  const uint32_t stop = start+blockSize > M ? M : start+blockSize;
+
+  mm_fp16_fp32acc_tile(args, 0, N, start, stop, 0);
+}
+
+
+void __attribute__((noinline)) mm_fp16_SIMD_2x2_fp32out (void * void_args)
+{
+  struct matMul_args_fp16 * args = (struct matMul_args_fp16 *) void_args;
+  uint32_t N = args->N;  
+  uint32_t M = args->M; 
+
+  const uint32_t blockSize = (N+NUM_CORES-1) / NUM_CORES;
+  const uint32_t start = pi_core_id()*blockSize;
+  const uint32_t stop = start+blockSize > N ? N : start+blockSize;
+
+  mm_fp16_fp32acc_tile(args, start, stop, 0, M, 1);
+}
+
+
+void __attribute__((noinline)) mm_M_fp16_SIMD_2x2_fp32out (void * void_args)
+{
+  struct matMul_args_fp16 * args = (struct matMul_args_fp16 *) void_args;
+  uint32_t N = args->N;  
+  uint32_t M = args->M; 
+
+  const uint32_t blockSize = (((M+NUM_CORES-1) / NUM_CORES) + 1) & 0xfffffffe;
+  const uint32_t start = pi_core_id()*blockSize;
+  const uint32_t stop = start+blockSize > M ? M : start+blockSize;
+
+  mm_fp16_fp32acc_tile(args, 0, N, start, stop, 1);
+}
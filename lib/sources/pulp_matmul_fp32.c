@@ -2423,9 +2423,9 @@ void mm_M_u2 (void * matMul_args) {
   {
     for (uint32_t i = 0; i < N; i++) 
     {
-      float temp = 0;
       for (uint32_t j = start; j < stop; j++) 
       {
+        float temp = 0;
         for (uint32_t k = 0; k < (K & 0xfffffffe); k=k+2) 
         {
               temp += A[i*K+k]   * B[k+j*K];
@@ -4045,3 +4045,324 @@ void mm_M_unroll_4x4 (void * matMul_args)
     }
   }
 }
+
+
+
+
+
+/**
+ * TRANSPOSED-A VERSIONS
+ * A is stored as K*N and read by columns, B is read as K*M (or as M*K if trans_B is set).
+ * Every kernel computes a block of rows [i_start, i_stop) and columns [j_start, j_stop) of C;
+ * the public functions only select the block owned by each core.
+ */
+
+static inline void mm_trans_A_block(
+  float * __restrict__ A, float * __restrict__ B, float * __restrict__ C,
+  uint32_t N, uint32_t M, uint32_t K, uint32_t B_k, uint32_t B_j,
+  uint32_t i_start, uint32_t i_stop, uint32_t j_start, uint32_t j_stop)
+{
+  for (uint32_t i=i_start; i<i_stop; i++)
+  {
+    for (uint32_t j=j_start; j<j_stop; j++)
+    {
+      float temp = 0;
+      for (uint32_t k=0; k<K; k++)
+      {
+        temp += A[k*N+i] * B[k*B_k+j*B_j];
+      }
+      C[i*M+j] = temp;
+    }
+  }
+}
+
+static inline void mm_trans_A_block_1x4(
+  float * __restrict__ A, float * __restrict__ B, float * __restrict__ C,
+  uint32_t N, uint32_t M, uint32_t K, uint32_t B_k, uint32_t B_j,
+  uint32_t i_start, uint32_t i_stop, uint32_t j_start, uint32_t j_stop)
+{
+  uint32_t j_par = j_start + ((j_stop-j_start) & 0xfffffffc);
+
+  for (uint32_t i=i_start; i<i_stop; i++)
+  {
+    for (uint32_t j=j_start; j<j_par; j=j+4)
+    {
+      float temp0 = 0;
+      float temp1 = 0;
+      float temp2 = 0;
+      float temp3 = 0;
+
+      for (uint32_t k=0; k<K; k++)
+      {
+        float Ash = A[k*N+i];
+        float * Bp = B + k*B_k + j*B_j;
+        temp0 += Ash * Bp[0];
+        temp1 += Ash * Bp[B_j];
+        temp2 += Ash * Bp[2*B_j];
+        temp3 += Ash * Bp[3*B_j];
+      }
+      C[i*M+j]    = temp0;
+      C[i*M+j+1]  = temp1;
+      C[i*M+j+2]  = temp2;
+      C[i*M+j+3]  = temp3;
+    }
+  }
+  // Leftover on M
+  mm_trans_A_block(A, B, C, N, M, K, B_k, B_j, i_start, i_stop, j_par, j_stop);
+}
+
+static inline void mm_trans_A_block_4x1(
+  float * __restrict__ A, float * __restrict__ B, float * __restrict__ C,
+  uint32_t N, uint32_t M, uint32_t K, uint32_t B_k, uint32_t B_j,
+  uint32_t i_start, uint32_t i_stop, uint32_t j_start, uint32_t j_stop)
+{
+  uint32_t i_par = i_start + ((i_stop-i_start) & 0xfffffffc);
+
+  for (uint32_t i=i_start; i<i_par; i=i+4)
+  {
+    for (uint32_t j=j_start; j<j_stop; j++)
+    {
+      float temp0 = 0;
+      float temp1 = 0;
+      float temp2 = 0;
+      float temp3 = 0;
+
+      for (uint32_t k=0; k<K; k++)
+      {
+        // Rows of C are adjacent elements of a column of A
+        float * Ap = A + k*N + i;
+        float Bsh = B[k*B_k+j*B_j];
+        temp0 += Ap[0] * Bsh;
+        temp1 += Ap[1] * Bsh;
+        temp2 += Ap[2] * Bsh;
+        temp3 += Ap[3] * Bsh;
+      }
+      C[i*M+j]      = temp0;
+      C[(i+1)*M+j]  = temp1;
+      C[(i+2)*M+j]  = temp2;
+      C[(i+3)*M+j]  = temp3;
+    }
+  }
+  // Leftover on N
+  mm_trans_A_block(A, B, C, N, M, K, B_k, B_j, i_par, i_stop, j_start, j_stop);
+}
+
+static inline void mm_trans_A_block_2x2(
+  float * __restrict__ A, float * __restrict__ B, float * __restrict__ C,
+  uint32_t N, uint32_t M, uint32_t K, uint32_t B_k, uint32_t B_j,
+  uint32_t i_start, uint32_t i_stop, uint32_t j_start, uint32_t j_stop)
+{
+  uint32_t i_par = i_start + ((i_stop-i_start) & 0xfffffffe);
+  uint32_t j_par = j_start + ((j_stop-j_start) & 0xfffffffe);
+
+  for (uint32_t i=i_start; i<i_par; i=i+2)
+  {
+    for (uint32_t j=j_start; j<j_par; j=j+2)
+    {
+      float temp0 = 0;
+      float temp1 = 0;
+      float temp2 = 0;
+      float temp3 = 0;
+
+      for (uint32_t k=0; k<K; k++)
+      {
+        float A0 = A[k*N+i];
+        float A1 = A[k*N+i+1];
+        float B0 = B[k*B_k+j*B_j];
+        float B1 = B[k*B_k+(j+1)*B_j];
+        temp0 += A0 * B0;
+        temp1 += A0 * B1;
+        temp2 += A1 * B0;
+        temp3 += A1 * B1;
+      }
+      C[i*M+j]        = temp0;
+      C[i*M+j+1]      = temp1;
+      C[(i+1)*M+j]    = temp2;
+      C[(i+1)*M+j+1]  = temp3;
+    }
+  }
+  // Leftovers on M and N
+  mm_trans_A_block(A, B, C, N, M, K, B_k, B_j, i_start, i_par, j_par, j_stop);
+  mm_trans_A_block(A, B, C, N, M, K, B_k, B_j, i_par, i_stop, j_start, j_stop);
+}
+
+
+
+void mm_trans_A (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (N+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > N ? N : start+blockSize;
+
+  if (start < stop) mm_trans_A_block(args->A, args->B, args->C, N, M, K, B_k, B_j, start, stop, 0, M);
+}
+
+void mm_trans_A_unroll_1x4 (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (N+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > N ? N : start+blockSize;
+
+  if (start < stop) mm_trans_A_block_1x4(args->A, args->B, args->C, N, M, K, B_k, B_j, start, stop, 0, M);
+}
+
+void mm_trans_A_unroll_4x1 (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (N+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > N ? N : start+blockSize;
+
+  if (start < stop) mm_trans_A_block_4x1(args->A, args->B, args->C, N, M, K, B_k, B_j, start, stop, 0, M);
+}
+
+void mm_trans_A_unroll_2x2 (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (N+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > N ? N : start+blockSize;
+
+  if (start < stop) mm_trans_A_block_2x2(args->A, args->B, args->C, N, M, K, B_k, B_j, start, stop, 0, M);
+}
+
+void mm_M_trans_A (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (M+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > M ? M : start+blockSize;
+
+  if (start < stop) mm_trans_A_block(args->A, args->B, args->C, N, M, K, B_k, B_j, 0, N, start, stop);
+}
+
+void mm_M_trans_A_unroll_1x4 (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (M+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > M ? M : start+blockSize;
+
+  if (start < stop) mm_trans_A_block_1x4(args->A, args->B, args->C, N, M, K, B_k, B_j, 0, N, start, stop);
+}
+
+void mm_M_trans_A_unroll_4x1 (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (M+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > M ? M : start+blockSize;
+
+  if (start < stop) mm_trans_A_block_4x1(args->A, args->B, args->C, N, M, K, B_k, B_j, 0, N, start, stop);
+}
+
+void mm_M_trans_A_unroll_2x2 (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (M+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > M ? M : start+blockSize;
+
+  if (start < stop) mm_trans_A_block_2x2(args->A, args->B, args->C, N, M, K, B_k, B_j, 0, N, start, stop);
+}
+
+
+
+void mm_sparse_rows (void * matMul_args)
+{
+  struct matMul_args* args = (struct matMul_args *)matMul_args;
+  float * __restrict__ A = args->A;
+  float * __restrict__ B = args->B;
+  float * __restrict__ C = args->C;
+  int * rows = args->row_idx;
+  uint32_t N = args->N;
+  uint32_t M = args->M;
+  uint32_t K = args->K;
+  uint32_t B_k = args->trans_B ? 1 : M;
+  uint32_t B_j = args->trans_B ? K : 1;
+
+  uint32_t blockSize = (M+NUM_CORES-1) / NUM_CORES;
+  uint32_t start = pi_core_id()*blockSize;
+  uint32_t stop = start+blockSize > M ? M : start+blockSize;
+
+  uint32_t i = 0;
+  for (; i+1 < N; i+=2) 
+  {
+    float * A0 = A + rows[i]*K;
+    float * A1 = A + rows[i+1]*K;
+    for (uint32_t j=start; j<stop; j++) 
+    {
+      float temp0 = 0;
+      float temp1 = 0;
+      for (uint32_t k=0; k<K; k++) 
+      {
+        float b = B[k*B_k + j*B_j];
+        temp0 += A0[k] * b;
+        temp1 += A1[k] * b;
+      }
+      C[i*M+j]      = temp0;
+      C[(i+1)*M+j]  = temp1;
+    }
+  }
+  // Leftover row
+  if (i < N) 
+  {
+    float * A0 = A + rows[i]*K;
+    for (uint32_t j=start; j<stop; j++) 
+    {
+      float temp0 = 0;
+      for (uint32_t k=0; k<K; k++)  temp0 += A0[k] * B[k*B_k + j*B_j];
+      C[i*M+j] = temp0;
+    }
+  }
+}
@@ -13,105 +13,288 @@
 #include "pulp_matmul_fp16.h"
 #include "pulp_train_utils_fp16.h"
 #include "pulp_act_fp16.h"
+#include "pulp_train_utils_fp32.h"
+#include "pulp_act_fp32.h"
 #include <math.h>
 
 
-//FORWARD
-void pulp_mhsa_fp16_fw_cl(void* Mhsa_args){
-    struct Mhsa_args_fp16 *mhsa_args = (struct Mhsa_args_fp16 *) Mhsa_args;
-    fp16 *coeffDataWin = mhsa_args->coeff_in->data; // Input Projection Weights
-    fp16 *coeffDataWout = mhsa_args->coeff_out->data; // Output Projection Weights
-    fp16 *attention_map = mhsa_args->attention_map->data; // Buffer saving the MHSA map before projection
-    fp16 *outData = mhsa_args->output->data;  
+
+// SHARED PROJECTIONS
+
+// Projection matmul, with the kernel selected by mm_manager_fp16 when OPTIMIZE is set
+static inline void mhsa_fp16_mm (struct matMul_args_fp16 * matMul_args, int opt_matmul_type)
+{
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES, mm_fp16, matMul_args);
+    #else
+    struct mm_manager_args_fp16 man_args;
+    man_args.mm_args = matMul_args;
+    man_args.layer_type = LAYER_LINEAR;
+    man_args.step_type = STEP_FW;
+    man_args.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args);
+    #endif
+}
+
+// Transposes an (N x M) matrix into (M x N). Copy of temporary buffer required because transpose is NOT inplace
+static inline void mhsa_fp16_transpose (fp16 * matrix, fp16 * temp, int N, int M)
+{
+    struct transp_args_fp16 transp_args;
+    transp_args.matrix = matrix;
+    transp_args.transp_matrix = temp;
+    transp_args.N = N;
+    transp_args.M = M;
+
+    pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args);
+
+    struct copy_args_fp16 copy_args;
+    copy_args.from = temp;
+    copy_args.to = matrix;
+    copy_args.size = N*M;
+
+    pi_cl_team_fork(NUM_CORES, copy_fp16, &copy_args);
+}
+
+// Projects the input sequence into Q, K, V, stored as a (3F x L) matrix to facilitate division in chunks for the multiple heads
+static void mhsa_fp16_input_projection_fw (struct Mhsa_args_fp16 * mhsa_args)
+{
     fp16 *inputData = mhsa_args->input->data;
-    fp16 *temp = mhsa_args->temp_buffer;
-    fp16 *head_buffer = mhsa_args->head_buffer->data;
-    fp16 *softmax_buffer = mhsa_args->softmax_buffer->data;
+    fp16 *coeffDataWin = mhsa_args->coeff_in->data;
     fp16 *qkv = mhsa_args->qkv->data;
-    fp16 *q = mhsa_args->qkv->data;
-    fp16 *k = mhsa_args->qkv->data;
-    fp16 *v = mhsa_args->qkv->data;
-    int n_heads = mhsa_args->n_heads;
-
-    int opt_matmul_type = mhsa_args->opt_matmul_type_fw;
 
     int L = mhsa_args->input->H; // Input/Output Sequence length
     int E = mhsa_args->input->W; // Input Sequence element size
     int F = mhsa_args->attention_map->W; // Hidden dimension of attention
 
-    #ifdef DEBUG
-    printf("\nPrinting the parameters: L-%d, E-%d, F-%d", L, E, F);
-    #endif
-
-    int H = F / n_heads; // Size of head chunks
-    fp16 scaling = 1/sqrt(H);
-
-    // Projecting input sequence into Q, K, V
-    struct matMul_args_fp16 matMul_args1;
-    matMul_args1.A = inputData;
-    matMul_args1.B = coeffDataWin; 
-    matMul_args1.C = qkv; // Q, K, V are saved contiguously, in the same matrix
-    matMul_args1.N = L;
-    matMul_args1.K = E;
-    matMul_args1.M = 3*F;
-    matMul_args1.trans_B = 0;
+    struct matMul_args_fp16 matMul_args;
+    matMul_args.A = inputData;
+    matMul_args.B = coeffDataWin; 
+    matMul_args.C = qkv; // Q, K, V are saved contiguously, in the same matrix
+    matMul_args.N = L;
+    matMul_args.K = E;
+    matMul_args.M = 3*F;
+    matMul_args.trans_B = 0;
 
     #ifdef DEBUG
     printf("\ninputData: %d %d\n", L, E);
     for (int j=0; j<L*E; j++){
         if(!(j%(E))) printf("\n");
-        printf("%.8f ", matMul_args1.A[j]);
+        printf("%.8f ", inputData[j]);
     }
     printf("\n");
 
     printf("\nWin: %d %d\n", E, 3*F);
     for (int j=0; j<E*3*F; j++){
         if(!(j%(3*F))) printf("\n");
-        printf("%.8f ",  matMul_args1.B[j]);
+        printf("%.8f ",  coeffDataWin[j]);
     }
     printf("\n");
     #endif
 
-    #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm_fp16, &matMul_args1);
-    #else
-    struct mm_manager_args_fp16 man_args1;
-    man_args1.mm_args = &matMul_args1;
-    man_args1.layer_type = LAYER_LINEAR;
-    man_args1.step_type = STEP_FW;
-    man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args1);
-    #endif
+    mhsa_fp16_mm(&matMul_args, mhsa_args->opt_matmul_type_fw);
 
     #ifdef DEBUG
     printf("\nQKV Data: %d %d\n", L, 3*F);
     for (int j=0; j<L*3*F; j++){
         if(!(j%(3*F))) printf("\n");
-        printf("%.8f ", matMul_args1.C[j]);
+        printf("%.8f ", qkv[j]);
+    }
+    printf("\n");
+    #endif
+
+    // Transpose Projections (L x 3F -> 3F x L)
+    mhsa_fp16_transpose(qkv, mhsa_args->temp_buffer, L, 3*F);
+}
+
+// Projects the (F x L) attention map into the (L x E) output sequence
+static void mhsa_fp16_output_projection_fw (struct Mhsa_args_fp16 * mhsa_args)
+{
+    fp16 *outData = mhsa_args->output->data;
+
+    int L = mhsa_args->input->H;
+    int E = mhsa_args->input->W;
+    int F = mhsa_args->attention_map->W;
+
+    struct matMul_args_fp16 matMul_args;
+    matMul_args.A = mhsa_args->coeff_out->data;
+    matMul_args.B = mhsa_args->attention_map->data;
+    matMul_args.C = outData;
+    matMul_args.N = E;
+    matMul_args.K = F;
+    matMul_args.M = L;
+    matMul_args.trans_B = 0;
+
+    mhsa_fp16_mm(&matMul_args, mhsa_args->opt_matmul_type_fw);
+
+    #ifdef DEBUG
+    printf("\nTransposed Output sequence Data: %d %d\n", E, L);
+    for (int j=0; j<L*E; j++){
+        if(!(j%(L))) printf("\n");
+        printf("%.8f ", outData[j]);
+    }
+    printf("\n");
+    #endif
+
+    // Transpose back to original dimension
+    mhsa_fp16_transpose(outData, mhsa_args->temp_buffer, E, L);
+    
+    #ifdef DEBUG
+    printf("\nOutput Data map Data: %d %d\n", E, L);
+    for (int j=0; j<L*E; j++){
+        if(!(j%(L))) printf("\n");
+        printf("%.8f ", outData[j]);
+    }
+    printf("\n");
+    #endif
+}
+
+// Gradients of the attention map (F x L) and of the Output Projection Weights (E x F)
+static void mhsa_fp16_output_projection_bw (struct Mhsa_args_fp16 * mhsa_args)
+{
+    fp16 *coeffDiffWout = mhsa_args->coeff_out->diff; // E x F
+    fp16 *attention_map = mhsa_args->attention_map->data; // F x L
+    fp16 *attention_map_diff = mhsa_args->attention_map->diff; // F x L
+    fp16 *outDiff = mhsa_args->output->diff; // L x E
+    fp16 *temp = mhsa_args->temp_buffer;
+    int opt_matmul_type = mhsa_args->opt_matmul_type_wg;
+
+    int L = mhsa_args->input->H;
+    int E = mhsa_args->input->W;
+    int F = mhsa_args->attention_map->W;
+
+    #ifdef DEBUG
+    printf("\noutData\n");
+    for(int i=0; i<L*E; i++){
+    if(!(i%E)) printf("\n");
+      printf("%4.2e  ",mhsa_args->output->data[i]);
+    }
+    printf("\n");
+
+    printf("\nLinear outDiff\n");
+    for(int i=0; i<L*E; i++){
+    if(!(i%E)) printf("\n");
+      printf("%4.2e  ",outDiff[i]);
     }
     printf("\n");
     #endif
 
-    // Transpose Projections (L x 3F -> 3F x L) to facilitate division in chunks for the multiple heads. Copy of temporary buffer required because transpose is NOT inplace
-    struct transp_args_fp16 transp_args1;
-    transp_args1.matrix = qkv;
-    transp_args1.transp_matrix = temp;
-    transp_args1.N = L;
-    transp_args1.M = 3*F;
+    // Attention Map
+    struct matMul_args_fp16 matMul_args1;
+    matMul_args1.A = outDiff; 
+    matMul_args1.B = mhsa_args->coeff_out->data; 
+    matMul_args1.C = attention_map_diff;
+    matMul_args1.N = L;
+    matMul_args1.K = E;
+    matMul_args1.M = F;
+    matMul_args1.trans_B = 0;
+
+    mhsa_fp16_mm(&matMul_args1, opt_matmul_type); // Gradient of attention map: (L x E)*(E x F) - > (L x F)
+    mhsa_fp16_transpose(attention_map_diff, temp, L, F); // Transposed gradient of attention map: (L x F) - > (F x L)
+
+    // Output Projection Weights
+    struct matMul_args_fp16 matMul_args2;
+    matMul_args2.A = attention_map; 
+    matMul_args2.B = outDiff; 
+    matMul_args2.C = coeffDiffWout;
+    matMul_args2.N = F;
+    matMul_args2.K = L;
+    matMul_args2.M = E;
+    matMul_args2.trans_B = 0;
+
+    #ifdef DEBUG
+    printf("\nTransposed Attention map\n");
+    for (int i=0; i<F*L; i++){
+        if(!(i%L)) printf("\n");
+        printf("%4.2e  ", attention_map[i]);
+    }
+    printf("\n");
+    #endif
 
-    pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args1);
+    mhsa_fp16_mm(&matMul_args2, opt_matmul_type); // Output weight gradient: (F x L)*(L x E) - > (F x E)
+    mhsa_fp16_transpose(coeffDiffWout, temp, F, E); // Transposed output weight gradient: (F x E) - > (E x F)
 
-    struct copy_args_fp16 copy_args1;
-    copy_args1.from = temp;
-    copy_args1.to = qkv;
-    copy_args1.size = L*3*F;
+    #ifdef DEBUG
+    printf("\nLinear coeffDiffWout");
+    for (int i=0; i<E*F; i++){
+      if(!(i%F)) printf("\n");
+      printf("%4.2e (i=%d)", coeffDiffWout[i], i);
+    }
+    printf("\n");
+    #endif
+}
+
+// Gradients of the Input Projection Weights (E x 3F) and of the input sequence (L x E), from the (3F x L) Q, K, V gradients
+static void mhsa_fp16_input_projection_bw (struct Mhsa_args_fp16 * mhsa_args)
+{
+    fp16 *coeffDiffWin = mhsa_args->coeff_in->diff; // E x 3F
+    fp16 *qkv_diff = mhsa_args->qkv->diff; // 3F x L
+    fp16 *inDiff = mhsa_args->input->diff; // L x E
+    fp16 *temp = mhsa_args->temp_buffer;
+    int opt_matmul_type = mhsa_args->opt_matmul_type_wg;
 
-    pi_cl_team_fork(NUM_CORES, copy_fp16, &copy_args1);
+    int L = mhsa_args->input->H;
+    int E = mhsa_args->input->W;
+    int F = mhsa_args->attention_map->W;
+
+    // Input Projection Weights
+    struct matMul_args_fp16 matMul_args1;
+    matMul_args1.A = qkv_diff; 
+    matMul_args1.B = mhsa_args->input->data; 
+    matMul_args1.C = coeffDiffWin;
+    matMul_args1.N = 3*F;
+    matMul_args1.K = L;
+    matMul_args1.M = E;
+    matMul_args1.trans_B = 0;
+
+    mhsa_fp16_mm(&matMul_args1, opt_matmul_type); // Input weight gradient: (3F x L)*(L x E) - > (3F x E)
+    mhsa_fp16_transpose(coeffDiffWin, temp, 3*F, E); // Transpose input weight gradient: (3F x E) - > (E x 3F)
+
+    // Input Gradients
+    struct matMul_args_fp16 matMul_args2;
+    matMul_args2.A = mhsa_args->coeff_in->data; 
+    matMul_args2.B = qkv_diff; 
+    matMul_args2.C = inDiff;
+    matMul_args2.N = E;
+    matMul_args2.K = 3*F;
+    matMul_args2.M = L;
+    matMul_args2.trans_B = 0;
+
+    mhsa_fp16_mm(&matMul_args2, opt_matmul_type); // Input gradients: (E x 3F)*(3F x L) - > (E x L)
+    mhsa_fp16_transpose(inDiff, temp, E, L); // Input gradients transpose: (E x L) - > (L x E)
+}
+
+
+
+
+//FORWARD
+void pulp_mhsa_fp16_fw_cl(void* Mhsa_args){
+    struct Mhsa_args_fp16 *mhsa_args = (struct Mhsa_args_fp16 *) Mhsa_args;
+    fp16 *attention_map = mhsa_args->attention_map->data; // Buffer saving the MHSA map before projection
+    fp16 *temp = mhsa_args->temp_buffer;
+    fp16 *head_buffer = mhsa_args->head_buffer->data;
+    fp16 *softmax_buffer = mhsa_args->softmax_buffer->data;
+    fp16 *qkv = mhsa_args->qkv->data;
+    int n_heads = mhsa_args->n_heads;
+
+    int opt_matmul_type = mhsa_args->opt_matmul_type_fw;
+
+    int L = mhsa_args->input->H; // Input/Output Sequence length
+    int F = mhsa_args->attention_map->W; // Hidden dimension of attention
+
+    #ifdef DEBUG
+    printf("\nPrinting the parameters: L-%d, E-%d, F-%d", L, mhsa_args->input->W, F);
+    #endif
+
+    int H = F / n_heads; // Size of head chunks
+    fp16 scaling = 1/sqrt(H);
+
+    // Projecting input sequence into Q, K, V (3F x L)
+    mhsa_fp16_input_projection_fw(mhsa_args);
 
     // Separate Q, K and V entry points in the QKV matrix
-    q = qkv;
-    k = qkv + L*F;
-    v = qkv + L*2*F;
+    fp16 *q = qkv;
+    fp16 *k = qkv + L*F;
+    fp16 *v = qkv + L*2*F;
 
     // Cycle on the different heads
     for(int i = 0; i < n_heads; i++){
@@ -136,17 +319,7 @@ void pulp_mhsa_fp16_fw_cl(void* Mhsa_args){
         matMul_args2.M = L;
         matMul_args2.trans_B = 0;
 
-        #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES,  mm_fp16, &matMul_args2);
-        #else
-        struct mm_manager_args_fp16 man_args2;
-        man_args2.mm_args = &matMul_args2;
-        man_args2.layer_type = LAYER_LINEAR;
-        man_args2.step_type = STEP_FW;
-        man_args2.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args2);
-        #endif
-
+        mhsa_fp16_mm(&matMul_args2, opt_matmul_type);
 
         struct scalar_mul_args_fp16 s_m_args;
         s_m_args.input = current_head_buffer;
@@ -155,11 +328,8 @@ void pulp_mhsa_fp16_fw_cl(void* Mhsa_args){
 
         pi_cl_team_fork(NUM_CORES,  pulp_scalar_mul_fp16_cl, &s_m_args);
 
-        /*
-        for(int j = 0; j < (L*L); j++)
-            current_head_buffer[j] = current_head_buffer[j]*scaling;
-        */
-        struct act_args_fp16 softmax_arg;
+        // Softmax of every query (column) over the keys (rows)
+        struct mhsa_softmax_args_fp16 softmax_arg;
         struct blob_fp16 input;
         struct blob_fp16 output;
         input.data = current_head_buffer;
@@ -167,10 +337,9 @@ void pulp_mhsa_fp16_fw_cl(void* Mhsa_args){
         output.data = current_softmax_buffer;
         softmax_arg.input = &input;
         softmax_arg.output = &output;
+        softmax_arg.L = L;
 
-        pulp_softmax_fp16_fw_cl(&softmax_arg);
-
-        //pi_cl_team_fork(1, pulp_softmax_fp16_fw_cl, &softmax_arg); //TODO: actually parallelize this function
+        pi_cl_team_fork(NUM_CORES, mhsa_softmax_fp16_fw_kernel, &softmax_arg);
 
         // Multiply softmax result with the i-th head's V chunk
         struct matMul_args_fp16 matMul_args3;
@@ -182,72 +351,11 @@ void pulp_mhsa_fp16_fw_cl(void* Mhsa_args){
         matMul_args3.M = L;
         matMul_args3.trans_B = 0;
 
-        #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES,  mm_fp16, &matMul_args3);
-        #else
-        struct mm_manager_args_fp16 man_args3;
-        man_args3.mm_args = &matMul_args3;
-        man_args3.layer_type = LAYER_LINEAR;
-        man_args3.step_type = STEP_FW;
-        man_args3.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args3);
-        #endif
+        mhsa_fp16_mm(&matMul_args3, opt_matmul_type);
     }
 
     // Final attention map projection
-    struct matMul_args_fp16 matMul_args4;
-    matMul_args4.A = coeffDataWout;
-    matMul_args4.B = attention_map;
-    matMul_args4.C = outData;
-    matMul_args4.N = E;
-    matMul_args4.K = F;
-    matMul_args4.M = L;
-    matMul_args4.trans_B = 0;
-
-    #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm_fp16, &matMul_args4);
-    #else
-    struct mm_manager_args_fp16 man_args4;
-    man_args4.mm_args = &matMul_args4;
-    man_args4.layer_type = LAYER_LINEAR;
-    man_args4.step_type = STEP_FW;
-    man_args4.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args4);
-    #endif
-
-    #ifdef DEBUG
-    printf("\nTransposed Output sequence Data: %d %d\n", E, L);
-    for (int j=0; j<L*E; j++){
-        if(!(j%(L))) printf("\n");
-        printf("%.8f ", matMul_args4.C[j]);
-    }
-    printf("\n");
-    #endif
-
-    // Transpose back to original dimension
-    struct transp_args_fp16 transp_args3;
-    transp_args3.matrix = outData;
-    transp_args3.transp_matrix = temp;
-    transp_args3.N = E;
-    transp_args3.M = L;
-
-    pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args3);
-
-    struct copy_args_fp16 copy_args2;
-    copy_args2.from = temp;
-    copy_args2.to = outData;
-    copy_args2.size = L*E;
-
-    pi_cl_team_fork(NUM_CORES, copy_fp16, &copy_args2);
-    
-    #ifdef DEBUG
-    printf("\nOutput Data map Data: %d %d\n", E, L);
-    for (int j=0; j<L*E; j++){
-        if(!(j%(L))) printf("\n");
-        printf("%.8f ", outData[j]);
-    }
-    printf("\n");
-    #endif
+    mhsa_fp16_output_projection_fw(mhsa_args);
 }
 
 
@@ -258,26 +366,16 @@ void pulp_mhsa_fp16_fw_cl(void* Mhsa_args){
 void pulp_mhsa_fp16_bw_cl(void * Mhsa_args) {
     struct Mhsa_args_fp16 *mhsa_args = (struct Mhsa_args_fp16 *) Mhsa_args;
 
-    fp16 *coeffDataWin = mhsa_args->coeff_in->data; // E x 3F
-    fp16 *coeffDataWout = mhsa_args->coeff_out->data; // E x F
-    fp16 *inData = mhsa_args->input->data; // L x E
-    fp16 *temp = mhsa_args->temp_buffer; // Temporary buffer to save transposed matrices // TODO: THIS HAS TO BE DYNAMIC (calculate the max capacity required)
+    fp16 *temp = mhsa_args->temp_buffer; // Temporary buffer to save transposed matrices, max(L*F, 3F*E, L*E) elements
     fp16 *grad = mhsa_args->grad; // L x L
-    fp16 *outData = mhsa_args->output->data; // L x E
-    fp16 *attention_map = mhsa_args->attention_map->data; // F x L
-    fp16 *diff_attention_map = mhsa_args->attention_map->diff; // F x L
-    fp16 *coeffDiffWin = mhsa_args->coeff_in->diff; // E x 3F
-    fp16 *coeffDiffWout = mhsa_args->coeff_out->diff; // E x F
-    fp16 *head_buffer = mhsa_args->head_buffer->data; // L x L
     fp16 *softmax_buffer = mhsa_args->softmax_buffer->data;
 
-    int total_dim = mhsa_args->output->dim;
     int L = mhsa_args->input->H; // Input sequence length
-    int E = mhsa_args->input->W; // Input sequence element size
     int F = mhsa_args->attention_map->W; // Attention block hidden size
     int n_heads = mhsa_args->n_heads; // Number of heads of the mhsa
     int H = F / n_heads;
     int opt_matmul_type = mhsa_args->opt_matmul_type_wg;
+    fp16 scaling = 1/sqrt(H);
 
     fp16 *q = mhsa_args->qkv->data; // 3F x L
     fp16 *k = mhsa_args->qkv->data + F*L;
@@ -287,139 +385,11 @@ void pulp_mhsa_fp16_bw_cl(void * Mhsa_args) {
     fp16 *k_diff = mhsa_args->qkv->diff + F*L;
     fp16 *v_diff = mhsa_args->qkv->diff + 2*F*L;
 
-
-    fp16 *outDiff = mhsa_args->output->diff; // L x E
-    fp16 *inDiff = mhsa_args->input->diff; // L x E
     fp16 *attention_map_diff = mhsa_args->attention_map->diff; // F x L
     fp16 *head_buffer_diff = mhsa_args->head_buffer->diff; // L x L
 
-    
-    
-    #ifdef DEBUG
-    printf("\noutData\n");
-    for(int i=0; i<total_dim; i++){
-    if(!(i%E)) printf("\n");
-      printf("%4.2e  ",outData[i]);
-    }
-    printf("\n");
-
-    printf("\nLinear outDiff\n");
-    for(int i=0; i<total_dim; i++){
-    if(!(i%E)) printf("\n");
-      printf("%4.2e  ",outDiff[i]);
-    }
-    printf("\n");
-    #endif
-
-
     // Calculate gradient for Output Weights and Attention Map
-
-    // Attention Map
-
-    // matmul setup 1
-    struct matMul_args_fp16 matMul_args1;
-    matMul_args1.A = outDiff; 
-    matMul_args1.B = coeffDataWout; 
-    matMul_args1.C = attention_map_diff;
-    matMul_args1.N = L;
-    matMul_args1.K = E;
-    matMul_args1.M = F;
-    matMul_args1.trans_B = 0;
-
-    #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm_fp16, &matMul_args1); // Gradient of attention map: (L x E)*(E x F) - > (L x F)
-    #else
-    struct mm_manager_args_fp16 man_args1;
-    man_args1.mm_args = &matMul_args1;
-    man_args1.layer_type = LAYER_LINEAR;
-    man_args1.step_type = STEP_FW;
-    man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args1);
-    #endif
-
-    //Transpose map gradients (copy required because transpose can't be done inplace)
-    struct transp_args_fp16 transp_args1;
-    transp_args1.matrix = attention_map_diff;
-    transp_args1.transp_matrix = temp;
-    transp_args1.N = L;
-    transp_args1.M = F;
-
-    pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args1);
-
-    struct copy_args_fp16 copy_args1;
-    copy_args1.from = temp;
-    copy_args1.to = attention_map_diff;
-    copy_args1.size = F*L;
-
-    pi_cl_team_fork(NUM_CORES, copy_fp16, &copy_args1); // Transposed gradient of attention map: (L x F) - > (F x L)
-
-    // Output Projection Weights
-
-
-    // matmul setup 2
-    struct matMul_args_fp16 matMul_args2;
-    matMul_args2.A = attention_map; 
-    matMul_args2.B = outDiff; 
-    matMul_args2.C = coeffDiffWout;
-    matMul_args2.N = F;
-    matMul_args2.K = L;
-    matMul_args2.M = E;
-    matMul_args2.trans_B = 0;
-
-
-    #ifdef DEBUG
-    printf("\ngrad\n");
-    for (int i=0; i<total_dim; i++){
-        if(!(i%E)) printf("\n");
-        printf("%4.2e  ", outDiff[i]);
-    }
-    printf("\n");
-
-    printf("\nTransposed Attention map\n");
-    for (int i=0; i<F*L; i++){
-        if(!(i%L)) printf("\n");
-        printf("%4.2e  ", attention_map[i]);
-    }
-    printf("\n");
-    #endif
-
-    #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm_fp16, &matMul_args2); // Output weight gradient: (F x L)*(L x E) - > (F x E)
-    #else
-    struct mm_manager_args_fp16 man_args2;
-    man_args2.mm_args = &matMul_args2;
-    man_args2.layer_type = LAYER_LINEAR;
-    man_args2.step_type = STEP_FW;
-    man_args2.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args2);
-    #endif
-
-
-    // Transpose Linear Output Weight gradients
-    struct transp_args_fp16 transp_args9;
-    transp_args9.matrix = coeffDiffWout;
-    transp_args9.transp_matrix = temp;
-    transp_args9.N = F;
-    transp_args9.M = E;
-
-    pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args9);
-
-    struct copy_args_fp16 copy_args9;
-    copy_args9.from = temp;
-    copy_args9.to = coeffDiffWout;
-    copy_args9.size = E*F;
-
-    pi_cl_team_fork(NUM_CORES, copy_fp16, &copy_args9); // Transposed output weight gradient: (F x E) - > (E x F)
-
-
-    #ifdef DEBUG
-    printf("\nLinear coeffDiffWout");
-    for (int i=0; i<E*F; i++){
-      if(!(i%F)) printf("\n");
-      printf("%4.2e (i=%d)", coeffDiffWout[i], i);
-    }
-    printf("\n");
-    #endif
+    mhsa_fp16_output_projection_bw(mhsa_args);
 
     // Cycle on the heads
     for(int i=0; i<n_heads; i++){
@@ -433,89 +403,60 @@ void pulp_mhsa_fp16_bw_cl(void * Mhsa_args) {
         matMul_args3.N = H;
         matMul_args3.K = L;
         matMul_args3.M = L;
-        matMul_args3.trans_B = 0;
+        matMul_args3.trans_B = 1;
 
-        #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES,  mm_fp16, &matMul_args3); // i-th head Value gradient: (H x L)*(L x L) - > (H x L)
-        #else
-        struct mm_manager_args_fp16 man_args3;
-        man_args3.mm_args = &matMul_args3;
-        man_args3.layer_type = LAYER_LINEAR;
-        man_args3.step_type = STEP_FW;
-        man_args3.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args3);
-        #endif
+        mhsa_fp16_mm(&matMul_args3, opt_matmul_type); // i-th head Value gradient: (H x L)*(L x L)^T - > (H x L)
 
 
         // I-th head Buffer Gradient
 
-        // Transpose output gradients
+        // Transpose i-th head's V chunk
         struct transp_args_fp16 transp_args3;
-        transp_args3.matrix = attention_map_diff + i*L*H;
+        transp_args3.matrix = v + i*L*H;
         transp_args3.transp_matrix = temp;
         transp_args3.N = H;
         transp_args3.M = L;
 
-        pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args3); // Transpose i-th head attention map gradient: (H x L) - > (L x H) 
+        pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args3); // Transpose i-th head Values: (H x L) - > (L x H) 
 
 
         // matmul setup 4
         struct matMul_args_fp16 matMul_args4;
         matMul_args4.A = temp; 
-        matMul_args4.B = v + i*L*H; 
+        matMul_args4.B = attention_map_diff + i*L*H; 
         matMul_args4.C = head_buffer_diff + i*L*L;
         matMul_args4.N = L;
         matMul_args4.K = H;
         matMul_args4.M = L;
         matMul_args4.trans_B = 0;
 
-        #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES, mm_fp16, &matMul_args4); // i-th head Buffer gradient: (L x H)*(H x L) - > (L x L)
-        #else
-        struct mm_manager_args_fp16 man_args4;
-        man_args4.mm_args = &matMul_args4;
-        man_args4.layer_type = LAYER_LINEAR;
-        man_args4.step_type = STEP_FW;
-        man_args4.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args4);
-        #endif
+        mhsa_fp16_mm(&matMul_args4, opt_matmul_type); // i-th head Buffer gradient: (L x H)*(H x L) - > (L x L)
 
 
-        struct act_args_fp16 softmax_arg;
+        // Back propagation of i-th head Buffer gradient through the softmax of every query and the scaling
+        struct mhsa_softmax_args_fp16 softmax_arg;
         struct blob_fp16 input;
         struct blob_fp16 output;
         input.diff = grad;
         input.dim = L*L;
         output.data = softmax_buffer + i*L*L;
         output.diff = head_buffer_diff + i*L*L;
-        output.dim = i;
+        output.dim = L*L;
         softmax_arg.input = &input;
         softmax_arg.output = &output;
-        // Back propagation of i-th head Buffer gradient through the softmax operation
+        softmax_arg.L = L;
 
-        
-        pi_cl_team_fork(1, pulp_softmax_fp16_bw_cl, &softmax_arg);
+        pi_cl_team_fork(NUM_CORES, mhsa_softmax_fp16_bw_kernel, &softmax_arg);
 
+        struct scalar_mul_args_fp16 s_m_args;
+        s_m_args.input = grad;
+        s_m_args.scalar = scaling;
+        s_m_args.dim = L*L;
 
+        pi_cl_team_fork(NUM_CORES,  pulp_scalar_mul_fp16_cl, &s_m_args);
 
 
         // I-th head Query Gradient
-        
-        // Transpose softmax gradients
-        struct transp_args_fp16 transp_args4;
-        transp_args4.matrix = grad;
-        transp_args4.transp_matrix = temp;
-        transp_args4.N = L;
-        transp_args4.M = L;
-
-        pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args4); 
-
-        struct copy_args_fp16 copy_args3;
-        copy_args3.from = temp;
-        copy_args3.to = grad;
-        copy_args3.size = L*L;
-
-        pi_cl_team_fork(NUM_CORES, copy_fp16, &copy_args3); // Still (L x L). Unsure if it is needed.
 
         // matmul setup 5
         struct matMul_args_fp16 matMul_args5;
@@ -527,16 +468,7 @@ void pulp_mhsa_fp16_bw_cl(void * Mhsa_args) {
         matMul_args5.M = L;
         matMul_args5.trans_B = 0;
 
-        #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES, mm_fp16, &matMul_args5); // i-th head Query gradient: (H x L)*(L x L) - > (H x L)
-        #else
-        struct mm_manager_args_fp16 man_args5;
-        man_args5.mm_args = &matMul_args5;
-        man_args5.layer_type = LAYER_LINEAR;
-        man_args5.step_type = STEP_FW;
-        man_args5.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args5);
-        #endif
+        mhsa_fp16_mm(&matMul_args5, opt_matmul_type); // i-th head Query gradient: (H x L)*(L x L) - > (H x L)
 
 
         // I-th head Key Gradients
@@ -549,104 +481,291 @@ void pulp_mhsa_fp16_bw_cl(void * Mhsa_args) {
         matMul_args6.N = H;
         matMul_args6.K = L;
         matMul_args6.M = L;
-        matMul_args6.trans_B = 0;
-
-        #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES, mm_fp16, &matMul_args6); // i-th head Key gradient: (H x L)*(L x L) - > (H x L)
-        #else
-        struct mm_manager_args_fp16 man_args6;
-        man_args6.mm_args = &matMul_args6;
-        man_args6.layer_type = LAYER_LINEAR;
-        man_args6.step_type = STEP_FW;
-        man_args6.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args6);
-        #endif
+        matMul_args6.trans_B = 1;
+
+        mhsa_fp16_mm(&matMul_args6, opt_matmul_type); // i-th head Key gradient: (H x L)*(L x L)^T - > (H x L)
     }
 
     // Input projection Gradients
-    
-    // matmul setup 7
-    struct matMul_args_fp16 matMul_args7;
-    matMul_args7.A = q_diff; 
-    matMul_args7.B = inData; 
-    matMul_args7.C = coeffDiffWin;
-    matMul_args7.N = 3*F;
-    matMul_args7.K = L;
-    matMul_args7.M = E;
-    matMul_args7.trans_B = 0;
+    mhsa_fp16_input_projection_bw(mhsa_args);
+}
 
-    #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES, mm_fp16, &matMul_args7); // Input weight gradient: (3F x L)*(L x E) - > (3F x E)
-    #else
-    struct mm_manager_args_fp16 man_args7;
-    man_args7.mm_args = &matMul_args7;
-    man_args7.layer_type = LAYER_LINEAR;
-    man_args7.step_type = STEP_FW;
-    man_args7.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args7);
-    #endif
 
-    // Transpose input weight gradients
-    struct transp_args_fp16 transp_args5;
-    transp_args5.matrix = coeffDiffWin;
-    transp_args5.transp_matrix = temp;
-    transp_args5.N = 3*F;
-    transp_args5.M = E;
 
-    pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args5); 
 
-    struct copy_args_fp16 copy_args4;
-    copy_args4.from = temp;
-    copy_args4.to = coeffDiffWin;
-    copy_args4.size = E*3*F;
+//FORWARD (HEAD-PARALLEL)
+void pulp_mhsa_heads_fp16_fw_cl(void* Mhsa_args){
+    struct Mhsa_args_fp16 *mhsa_args = (struct Mhsa_args_fp16 *) Mhsa_args;
+    fp16 *qkv = mhsa_args->qkv->data;
+    int n_heads = mhsa_args->n_heads;
+
+    int L = mhsa_args->input->H; // Input/Output Sequence length
+    int F = mhsa_args->attention_map->W; // Hidden dimension of attention
+    int H = F / n_heads; // Size of head chunks
+
+    // Projecting input sequence into Q, K, V (3F x L)
+    mhsa_fp16_input_projection_fw(mhsa_args);
+
+    // Attention of all the heads in a single fork: every core owns a block of (head, query) pairs
+    struct mhsa_heads_args_fp16 heads_args;
+    heads_args.q = qkv;
+    heads_args.k = qkv + L*F;
+    heads_args.v = qkv + L*2*F;
+    heads_args.head_buffer = mhsa_args->head_buffer->data;
+    heads_args.softmax_buffer = mhsa_args->softmax_buffer->data;
+    heads_args.output = mhsa_args->attention_map->data;
+    heads_args.scaling = 1/sqrt(H);
+    heads_args.L = L;
+    heads_args.H = H;
+    heads_args.n_heads = n_heads;
 
-    pi_cl_team_fork(NUM_CORES, copy_fp16, &copy_args4); // Transpose input weight gradient: (3F x E) - > (E x 3F)
+    pi_cl_team_fork(NUM_CORES, mhsa_heads_fp16_fw_kernel, &heads_args);
 
+    // Final attention map projection
+    mhsa_fp16_output_projection_fw(mhsa_args);
+}
 
 
 
-    // Input Gradients
 
-    // matmul setup 8
-    struct matMul_args_fp16 matMul_args8;
-    matMul_args8.A = coeffDataWin; 
-    matMul_args8.B = q_diff; 
-    matMul_args8.C = inDiff;
-    matMul_args8.N = E;
-    matMul_args8.K = 3*F;
-    matMul_args8.M = L;
-    matMul_args8.trans_B = 0;
+//BACKWARD (HEAD-PARALLEL)
+void pulp_mhsa_heads_fp16_bw_cl(void * Mhsa_args) {
+    struct Mhsa_args_fp16 *mhsa_args = (struct Mhsa_args_fp16 *) Mhsa_args;
 
-    #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES, mm_fp16, &matMul_args8); // Input gradients: (E x 3F)*(3F x L) - > (E x L)
-    #else
-    struct mm_manager_args_fp16 man_args8;
-    man_args8.mm_args = &matMul_args8;
-    man_args8.layer_type = LAYER_LINEAR;
-    man_args8.step_type = STEP_FW;
-    man_args8.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager_fp16, &man_args8);
-    #endif
+    int L = mhsa_args->input->H; // Input sequence length
+    int F = mhsa_args->attention_map->W; // Attention block hidden size
+    int n_heads = mhsa_args->n_heads; // Number of heads of the mhsa
+    int H = F / n_heads;
 
-    // Transpose input weight gradients
-    struct transp_args_fp16 transp_args6;
-    transp_args6.matrix = inDiff;
-    transp_args6.transp_matrix = temp;
-    transp_args6.N = E;
-    transp_args6.M = L;
+    // Calculate gradient for Output Weights and Attention Map
+    mhsa_fp16_output_projection_bw(mhsa_args);
+
+    // Q, K, V gradients of all the heads: every core owns a block of (head, query) pairs, then a block of (head, key) pairs
+    struct mhsa_heads_args_fp16 heads_args;
+    heads_args.q = mhsa_args->qkv->data;
+    heads_args.k = mhsa_args->qkv->data + F*L;
+    heads_args.v = mhsa_args->qkv->data + 2*F*L;
+    heads_args.softmax_buffer = mhsa_args->softmax_buffer->data;
+    heads_args.grad = mhsa_args->head_buffer->diff;
+    heads_args.q_diff = mhsa_args->qkv->diff;
+    heads_args.k_diff = mhsa_args->qkv->diff + F*L;
+    heads_args.v_diff = mhsa_args->qkv->diff + 2*F*L;
+    heads_args.output_diff = mhsa_args->attention_map->diff;
+    heads_args.scaling = 1/sqrt(H);
+    heads_args.L = L;
+    heads_args.H = H;
+    heads_args.n_heads = n_heads;
+
+    pi_cl_team_fork(NUM_CORES, mhsa_heads_fp16_bw_q_kernel, &heads_args);
+    pi_cl_team_fork(NUM_CORES, mhsa_heads_fp16_bw_kv_kernel, &heads_args);
 
-    pi_cl_team_fork(NUM_CORES, transpose_fp16, &transp_args6); 
+    // Input projection Gradients
+    mhsa_fp16_input_projection_bw(mhsa_args);
+}
 
-    struct copy_args_fp16 copy_args5;
-    copy_args5.from = temp;
-    copy_args5.to = inDiff;
-    copy_args5.size = L*E;
 
-    pi_cl_team_fork(NUM_CORES, copy_fp16, &copy_args5); // Input gradients transpose: (E x L) - > (L x E)
 
 
+// HEAD-PARALLEL ATTENTION KERNELS
+
+void mhsa_heads_fp16_fw_kernel(void * mhsa_heads_args_fp16)
+{
+    struct mhsa_heads_args_fp16 * args = (struct mhsa_heads_args_fp16 *) mhsa_heads_args_fp16;
+    int L = args->L;
+    int H = args->H;
+    fp16 scaling = args->scaling;
+    float minfloat = -340282346638528859811704183484516925440.0f;
+
+    // Parallelize over all the (head, query) pairs: whole heads when n_heads is a multiple of NUM_CORES, head x query blocks otherwise
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int l = idx % L;
+        fp16 * q = args->q + h*H*L + l;
+        fp16 * k = args->k + h*H*L;
+        fp16 * v = args->v + h*H*L;
+        fp16 * scores = args->head_buffer + h*L*L + l;
+        fp16 * probs = args->softmax_buffer + h*L*L + l;
+        fp16 * o = args->output + h*H*L + l;
+
+        // Column l of K^T * Q
+        float max = minfloat;
+        for (int j=0; j<L; j++) {
+            fp16 s = 0;
+            for (int d=0; d<H; d++) s += k[d*L+j] * q[d*L];
+            s *= scaling;
+            scores[j*L] = s;
+            if ((float) s > max) max = (float) s;
+        }
+
+        // Softmax over the keys (exponentials and sum in fp32)
+        float sum = 0.0f;
+        for (int j=0; j<L; j++) {
+            float p = act_exp((float) scores[j*L] - max);
+            probs[j*L] = (fp16) p;
+            sum += p;
+        }
+        fp16 inv_sum = (fp16) (1.0f / sum);
+        for (int j=0; j<L; j++) probs[j*L] *= inv_sum;
+
+        // Column l of V * softmax
+        for (int d=0; d<H; d++) {
+            fp16 acc = 0;
+            fp16 * v_row = v + d*L;
+            for (int j=0; j<L; j++) acc += v_row[j] * probs[j*L];
+            o[d*L] = acc;
+        }
+    }
 }
-  
 
 
+void mhsa_heads_fp16_bw_q_kernel(void * mhsa_heads_args_fp16)
+{
+    struct mhsa_heads_args_fp16 * args = (struct mhsa_heads_args_fp16 *) mhsa_heads_args_fp16;
+    int L = args->L;
+    int H = args->H;
+    fp16 scaling = args->scaling;
+
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int l = idx % L;
+        fp16 * k = args->k + h*H*L;
+        fp16 * v = args->v + h*H*L;
+        fp16 * probs = args->softmax_buffer + h*L*L + l;
+        fp16 * grad = args->grad + h*L*L + l;
+        fp16 * o_diff = args->output_diff + h*H*L + l;
+        fp16 * q_diff = args->q_diff + h*H*L + l;
+
+        // Column l of the softmax output gradient (V^T * dO) and its dot product with the softmax output
+        float delta = 0.0f;
+        for (int j=0; j<L; j++) {
+            fp16 dp = 0;
+            for (int d=0; d<H; d++) dp += v[d*L+j] * o_diff[d*L];
+            grad[j*L] = dp;
+            delta += (float) (dp * probs[j*L]);
+        }
+
+        // Back propagation through the softmax and the scaling
+        fp16 delta_h = (fp16) delta;
+        for (int j=0; j<L; j++) {
+            grad[j*L] = probs[j*L] * (grad[j*L] - delta_h) * scaling;
+        }
+
+        // Column l of the Query gradient
+        for (int d=0; d<H; d++) {
+            fp16 acc = 0;
+            fp16 * k_row = k + d*L;
+            for (int j=0; j<L; j++) acc += k_row[j] * grad[j*L];
+            q_diff[d*L] = acc;
+        }
+    }
+}
+
+
+void mhsa_heads_fp16_bw_kv_kernel(void * mhsa_heads_args_fp16)
+{
+    struct mhsa_heads_args_fp16 * args = (struct mhsa_heads_args_fp16 *) mhsa_heads_args_fp16;
+    int L = args->L;
+    int H = args->H;
+
+    // Parallelize over all the (head, key) pairs: rows of the score gradients are contiguous
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int j = idx % L;
+        fp16 * q = args->q + h*H*L;
+        fp16 * probs = args->softmax_buffer + h*L*L + j*L;
+        fp16 * grad = args->grad + h*L*L + j*L;
+        fp16 * o_diff = args->output_diff + h*H*L;
+        fp16 * k_diff = args->k_diff + h*H*L + j;
+        fp16 * v_diff = args->v_diff + h*H*L + j;
+
+        for (int d=0; d<H; d++) {
+            fp16 acc_k = 0;
+            fp16 acc_v = 0;
+            fp16 * q_row = q + d*L;
+            fp16 * o_diff_row = o_diff + d*L;
+            for (int l=0; l<L; l++) {
+                acc_k += grad[l] * q_row[l];
+                acc_v += probs[l] * o_diff_row[l];
+            }
+            k_diff[d*L] = acc_k;
+            v_diff[d*L] = acc_v;
+        }
+    }
+}
+
+
+
+
+//SOFTMAX KERNELS
+void mhsa_softmax_fp16_fw_kernel(void * mhsa_softmax_args_fp16)
+{
+    struct mhsa_softmax_args_fp16 * args = (struct mhsa_softmax_args_fp16 *) mhsa_softmax_args_fp16;
+    fp16 * inData = args->input->data;
+    fp16 * outData = args->output->data;
+    int L = args->L;
 
+    // Parallelize over the queries (columns)
+    const int blockSize = (L+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > L ? L : start+blockSize;
+
+    for (int l=start; l<stop; l++) {
+        fp16 * scores = inData + l;
+        fp16 * probs = outData + l;
+
+        // Exponentials and sum in fp32, as in mhsa_heads_fp16_fw_kernel()
+        float max = (float) scores[0];
+        for (int j=1; j<L; j++) if ((float) scores[j*L] > max) max = (float) scores[j*L];
+
+        float sum = 0.0f;
+        for (int j=0; j<L; j++) {
+            float p = act_exp((float) scores[j*L] - max);
+            probs[j*L] = (fp16) p;
+            sum += p;
+        }
+
+        fp16 inv_sum = (fp16) (1.0f / sum);
+        for (int j=0; j<L; j++) probs[j*L] *= inv_sum;
+    }
+}
+
+
+void mhsa_softmax_fp16_bw_kernel(void * mhsa_softmax_args_fp16)
+{
+    struct mhsa_softmax_args_fp16 * args = (struct mhsa_softmax_args_fp16 *) mhsa_softmax_args_fp16;
+    fp16 * inDiff = args->input->diff;
+    fp16 * outData = args->output->data;
+    fp16 * outDiff = args->output->diff;
+    int L = args->L;
+
+    const int blockSize = (L+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > L ? L : start+blockSize;
+
+    for (int l=start; l<stop; l++) {
+        fp16 * probs = outData + l;
+        fp16 * probs_diff = outDiff + l;
+        fp16 * scores_diff = inDiff + l;
+
+        // dS = P * (dP - sum(P * dP)) over the keys of the query, dot product accumulated in fp32
+        float dot = 0.0f;
+        for (int j=0; j<L; j++) dot += (float) (probs[j*L] * probs_diff[j*L]);
+        fp16 dot_h = (fp16) dot;
+        for (int j=0; j<L; j++) scores_diff[j*L] = probs[j*L] * (probs_diff[j*L] - dot_h);
+    }
+}
@@ -24,7 +24,6 @@ void pulp_mhsa_fp32_fw_cl(void* Mhsa_args){
     float *attention_map = mhsa_args->attention_map->data; // Buffer saving the MHSA map before projection
     float *outData = mhsa_args->output->data;  
     float *inputData = mhsa_args->input->data;
-    float *temp = mhsa_args->temp_buffer;
     float *head_buffer = mhsa_args->head_buffer->data;
     float *softmax_buffer = mhsa_args->softmax_buffer->data;
     float *qkv = mhsa_args->qkv->data;
@@ -46,68 +45,52 @@ void pulp_mhsa_fp32_fw_cl(void* Mhsa_args){
     int H = F / n_heads; // Size of head chunks
     float scaling = 1/sqrt(H);
 
-    // Projecting input sequence into Q, K, V
+    // Projecting input sequence into Q, K, V, directly in the (3F x L) layout that divides them in chunks for the multiple heads
     struct matMul_args matMul_args1;
-    matMul_args1.A = inputData;
-    matMul_args1.B = coeffDataWin; 
+    matMul_args1.A = coeffDataWin;
+    matMul_args1.B = inputData; 
     matMul_args1.C = qkv; // Q, K, V are saved contiguously, in the same matrix
-    matMul_args1.N = L;
+    matMul_args1.N = 3*F;
     matMul_args1.K = E;
-    matMul_args1.M = 3*F;
-    matMul_args1.trans_B = 0;
+    matMul_args1.M = L;
+    matMul_args1.trans_B = 1;
 
     #ifdef DEBUG
     printf("\ninputData: %d %d\n", L, E);
     for (int j=0; j<L*E; j++){
         if(!(j%(E))) printf("\n");
-        printf("%.8f ", matMul_args1.A[j]);
+        printf("%.8f ", inputData[j]);
     }
     printf("\n");
 
     printf("\nWin: %d %d\n", E, 3*F);
     for (int j=0; j<E*3*F; j++){
         if(!(j%(3*F))) printf("\n");
-        printf("%.8f ",  matMul_args1.B[j]);
+        printf("%.8f ",  coeffDataWin[j]);
     }
     printf("\n");
     #endif
 
     #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm, &matMul_args1);
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args1);
     #else
     struct mm_manager_args man_args1;
     man_args1.mm_args = &matMul_args1;
     man_args1.layer_type = LAYER_LINEAR;
     man_args1.step_type = STEP_FW;
     man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager, &man_args1);
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args1);
     #endif
 
     #ifdef DEBUG
-    printf("\nQKV Data: %d %d\n", L, 3*F);
+    printf("\nQKV Data: %d %d\n", 3*F, L);
     for (int j=0; j<L*3*F; j++){
-        if(!(j%(3*F))) printf("\n");
+        if(!(j%(L))) printf("\n");
         printf("%.8f ", matMul_args1.C[j]);
     }
     printf("\n");
     #endif
 
-    // Transpose Projections (L x 3F -> 3F x L) to facilitate division in chunks for the multiple heads. Copy of temporary buffer required because transpose is NOT inplace
-    struct transp_args transp_args1;
-    transp_args1.matrix = qkv;
-    transp_args1.transp_matrix = temp;
-    transp_args1.N = L;
-    transp_args1.M = 3*F;
-
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args1);
-
-    struct copy_args copy_args1;
-    copy_args1.from = temp;
-    copy_args1.to = qkv;
-    copy_args1.size = L*3*F;
-
-    pi_cl_team_fork(NUM_CORES, copy, &copy_args1);
-
     // Separate Q, K and V entry points in the QKV matrix
     q = qkv;
     k = qkv + L*F;
@@ -117,18 +100,9 @@ void pulp_mhsa_fp32_fw_cl(void* Mhsa_args){
     for(int i = 0; i < n_heads; i++){
         float* current_head_buffer = head_buffer + i*L*L;
         float* current_softmax_buffer = softmax_buffer + i*L*L;
-        // Transpose i-th head's K chunk
-        struct transp_args transp_args2;
-        transp_args2.matrix = k + L*i*H;
-        transp_args2.transp_matrix = temp;
-        transp_args2.N = H;
-        transp_args2.M = L;
-
-        pi_cl_team_fork(NUM_CORES, transpose, &transp_args2);
-
-        // Multiply it with the i-th head's Q chunk
+        // Multiply the i-th head's K chunk, read as transposed, with the i-th head's Q chunk
         struct matMul_args matMul_args2;
-        matMul_args2.A = temp;
+        matMul_args2.A = k + L*i*H;
         matMul_args2.B = q + L*i*H;
         matMul_args2.C = current_head_buffer;
         matMul_args2.N = L;
@@ -137,14 +111,14 @@ void pulp_mhsa_fp32_fw_cl(void* Mhsa_args){
         matMul_args2.trans_B = 0;
 
         #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES,  mm, &matMul_args2);
+        pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args2);
         #else
         struct mm_manager_args man_args2;
         man_args2.mm_args = &matMul_args2;
         man_args2.layer_type = LAYER_LINEAR;
         man_args2.step_type = STEP_FW;
         man_args2.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager, &man_args2);
+        pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args2);
         #endif
 
 
@@ -165,7 +139,8 @@ void pulp_mhsa_fp32_fw_cl(void* Mhsa_args){
         #endif
 
         
-        struct act_args softmax_arg;
+        // Softmax of every query (column) over the keys
+        struct softmax_args softmax_arg;
         struct blob input;
         struct blob output;
         input.data = current_head_buffer;
@@ -173,8 +148,9 @@ void pulp_mhsa_fp32_fw_cl(void* Mhsa_args){
         output.data = current_softmax_buffer;
         softmax_arg.input = &input;
         softmax_arg.output = &output;
+        softmax_arg.L = L;
 
-        pulp_softmax_fp32_fw_cl(&softmax_arg);
+        pi_cl_team_fork(NUM_CORES, mhsa_softmax_fp32_fw_kernel, &softmax_arg);
 
         // Multiply softmax result with the i-th head's V chunk
         struct matMul_args matMul_args3;
@@ -212,56 +188,31 @@ void pulp_mhsa_fp32_fw_cl(void* Mhsa_args){
     printf("\n");
     #endif
 
-    // Final attention map projection
+    // Final attention map projection, directly in the (L x E) output layout
     struct matMul_args matMul_args4;
-    matMul_args4.A = coeffDataWout;
-    matMul_args4.B = attention_map;
+    matMul_args4.A = attention_map;
+    matMul_args4.B = coeffDataWout;
     matMul_args4.C = outData;
-    matMul_args4.N = E;
+    matMul_args4.N = L;
     matMul_args4.K = F;
-    matMul_args4.M = L;
-    matMul_args4.trans_B = 0;
+    matMul_args4.M = E;
+    matMul_args4.trans_B = 1;
 
     #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm, &matMul_args4);
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args4);
     #else
     struct mm_manager_args man_args4;
     man_args4.mm_args = &matMul_args4;
     man_args4.layer_type = LAYER_LINEAR;
     man_args4.step_type = STEP_FW;
     man_args4.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager, &man_args4);
-    #endif
-
-    #ifdef DEBUG
-    printf("\nTransposed Output sequence Data: %d %d\n", E, L);
-    for (int j=0; j<L*E; j++){
-        if(!(j%(L))) printf("\n");
-        printf("%.8f ", matMul_args4.C[j]);
-    }
-    printf("\n");
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args4);
     #endif
 
-    // Transpose back to original dimension
-    struct transp_args transp_args3;
-    transp_args3.matrix = outData;
-    transp_args3.transp_matrix = temp;
-    transp_args3.N = E;
-    transp_args3.M = L;
-
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args3);
-
-    struct copy_args copy_args2;
-    copy_args2.from = temp;
-    copy_args2.to = outData;
-    copy_args2.size = L*E;
-
-    pi_cl_team_fork(NUM_CORES, copy, &copy_args2);
-    
     #ifdef DEBUG
-    printf("\nOutput Data map Data: %d %d\n", E, L);
+    printf("\nOutput Data map Data: %d %d\n", L, E);
     for (int j=0; j<L*E; j++){
-        if(!(j%(L))) printf("\n");
+        if(!(j%(E))) printf("\n");
         printf("%.8f ", outData[j]);
     }
     printf("\n");
@@ -277,7 +228,6 @@ void pulp_mhsa_fp32_fw_cl_2(void* Mhsa_args){
     float *attention_map = mhsa_args->attention_map->data; // Buffer saving the MHSA map before projection
     float *outData = mhsa_args->output->data;  
     float *inputData = mhsa_args->input->data;
-    float *temp = mhsa_args->temp_buffer;
     float *head_buffer = mhsa_args->head_buffer->data;
     float *softmax_buffer = mhsa_args->softmax_buffer->data;
     float *qkv = mhsa_args->qkv->data;
@@ -302,68 +252,52 @@ void pulp_mhsa_fp32_fw_cl_2(void* Mhsa_args){
     float scaling = 1/sqrt(H);
 
 
-    // Projecting input sequence into Q, K, V
+    // Projecting input sequence into Q, K, V, directly in the (3F x L) layout that divides them in chunks for the multiple heads
     struct matMul_args matMul_args1;
-    matMul_args1.A = inputData;
-    matMul_args1.B = coeffDataWin; 
+    matMul_args1.A = coeffDataWin;
+    matMul_args1.B = inputData; 
     matMul_args1.C = qkv; // Q, K, V are saved contiguously, in the same matrix
-    matMul_args1.N = L;
+    matMul_args1.N = 3*F;
     matMul_args1.K = E;
-    matMul_args1.M = 3*F;
-    matMul_args1.trans_B = 0;
+    matMul_args1.M = L;
+    matMul_args1.trans_B = 1;
 
     #ifdef DEBUG
     printf("\ninputData: %d %d\n", L, E);
     for (int j=0; j<L*E; j++){
         if(!(j%(E))) printf("\n");
-        printf("%.8f ", matMul_args1.A[j]);
+        printf("%.8f ", inputData[j]);
     }
     printf("\n");
 
     printf("\nWin: %d %d\n", E, 3*F);
     for (int j=0; j<E*3*F; j++){
         if(!(j%(3*F))) printf("\n");
-        printf("%.8f ",  matMul_args1.B[j]);
+        printf("%.8f ",  coeffDataWin[j]);
     }
     printf("\n");
     #endif
 
     #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm, &matMul_args1);
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args1);
     #else
     struct mm_manager_args man_args1;
     man_args1.mm_args = &matMul_args1;
     man_args1.layer_type = LAYER_LINEAR;
     man_args1.step_type = STEP_FW;
     man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager, &man_args1);
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args1);
     #endif
 
     #ifdef DEBUG
-    printf("\nQKV Data: %d %d\n", L, 3*F);
+    printf("\nQKV Data: %d %d\n", 3*F, L);
     for (int j=0; j<L*3*F; j++){
-        if(!(j%(3*F))) printf("\n");
+        if(!(j%(L))) printf("\n");
         printf("%.8f ", matMul_args1.C[j]);
     }
     printf("\n");
     #endif
 
-    // Transpose Projections (L x 3F -> 3F x L) to facilitate division in chunks for the multiple heads. Copy of temporary buffer required because transpose is NOT inplace
-    struct transp_args transp_args1;
-    transp_args1.matrix = qkv;
-    transp_args1.transp_matrix = temp;
-    transp_args1.N = L;
-    transp_args1.M = 3*F;
-
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args1);
-
-    struct copy_args copy_args1;
-    copy_args1.from = temp;
-    copy_args1.to = qkv;
-    copy_args1.size = L*3*F;
-
-    pi_cl_team_fork(NUM_CORES, copy, &copy_args1);
-
     // Separate Q, K and V entry points in the QKV matrix
     q = qkv;
     k = qkv + L*F;
@@ -372,18 +306,9 @@ void pulp_mhsa_fp32_fw_cl_2(void* Mhsa_args){
     // Cycle on the different heads
     for(int i = 0; i < n_heads; i++){
         float* current_head_buffer = head_buffer + i*L*L;
-        // Transpose i-th head's K chunk
-        struct transp_args transp_args2;
-        transp_args2.matrix = k + L*i*H;
-        transp_args2.transp_matrix = temp;
-        transp_args2.N = H;
-        transp_args2.M = L;
-
-        pi_cl_team_fork(NUM_CORES, transpose, &transp_args2);
-
-        // Multiply it with the i-th head's Q chunk
+        // Multiply the i-th head's K chunk, read as transposed, with the i-th head's Q chunk
         struct matMul_args matMul_args2;
-        matMul_args2.A = temp;
+        matMul_args2.A = k + L*i*H;
         matMul_args2.B = q + L*i*H;
         matMul_args2.C = current_head_buffer;
         matMul_args2.N = L;
@@ -392,14 +317,14 @@ void pulp_mhsa_fp32_fw_cl_2(void* Mhsa_args){
         matMul_args2.trans_B = 0;
 
         #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES,  mm, &matMul_args2);
+        pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args2);
         #else
         struct mm_manager_args man_args2;
         man_args2.mm_args = &matMul_args2;
         man_args2.layer_type = LAYER_LINEAR;
         man_args2.step_type = STEP_FW;
         man_args2.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager, &man_args2);
+        pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args2);
         #endif
 
 
@@ -498,56 +423,326 @@ void pulp_mhsa_fp32_fw_cl_2(void* Mhsa_args){
         #endif
     }
 
-    // Final attention map projection
+    // Final attention map projection, directly in the (L x E) output layout
     struct matMul_args matMul_args4;
-    matMul_args4.A = coeffDataWout;
-    matMul_args4.B = attention_map;
+    matMul_args4.A = attention_map;
+    matMul_args4.B = coeffDataWout;
     matMul_args4.C = outData;
-    matMul_args4.N = E;
+    matMul_args4.N = L;
     matMul_args4.K = F;
-    matMul_args4.M = L;
-    matMul_args4.trans_B = 0;
+    matMul_args4.M = E;
+    matMul_args4.trans_B = 1;
 
     #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm, &matMul_args4);
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args4);
     #else
     struct mm_manager_args man_args4;
     man_args4.mm_args = &matMul_args4;
     man_args4.layer_type = LAYER_LINEAR;
     man_args4.step_type = STEP_FW;
     man_args4.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager, &man_args4);
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args4);
     #endif
 
     #ifdef DEBUG
-    printf("\nTransposed Output sequence Data: %d %d\n", E, L);
+    printf("\nOutput Data map Data: %d %d\n", L, E);
     for (int j=0; j<L*E; j++){
-        if(!(j%(L))) printf("\n");
-        printf("%.8f ", matMul_args4.C[j]);
+        if(!(j%(E))) printf("\n");
+        printf("%.8f ", outData[j]);
     }
     printf("\n");
     #endif
+}
 
-    // Transpose back to original dimension
-    struct transp_args transp_args3;
-    transp_args3.matrix = outData;
-    transp_args3.transp_matrix = temp;
-    transp_args3.N = E;
-    transp_args3.M = L;
 
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args3);
 
-    struct copy_args copy_args2;
-    copy_args2.from = temp;
-    copy_args2.to = outData;
-    copy_args2.size = L*E;
+//FORWARD (TILED ATTENTION)
+void pulp_mhsa_flash_fp32_fw_cl(void* Mhsa_args){
+    struct Mhsa_args *mhsa_args = (struct Mhsa_args *) Mhsa_args;
+    float *coeffDataWin = mhsa_args->coeff_in->data; // Input Projection Weights
+    float *coeffDataWout = mhsa_args->coeff_out->data; // Output Projection Weights
+    float *attention_map = mhsa_args->attention_map->data; // Buffer saving the MHSA map before projection
+    float *outData = mhsa_args->output->data;  
+    float *inputData = mhsa_args->input->data;
+    float *qkv = mhsa_args->qkv->data;
+    float *lse = mhsa_args->lse;
+    int n_heads = mhsa_args->n_heads;
+
+    int opt_matmul_type = mhsa_args->opt_matmul_type_fw;
+
+    int L = mhsa_args->input->H; // Input/Output Sequence length
+    int E = mhsa_args->input->W; // Input Sequence element size
+    int F = mhsa_args->attention_map->W; // Hidden dimension of attention
+
+    #ifdef DEBUG
+    printf("\nPrinting the parameters: L-%d, E-%d, F-%d", L, E, F);
+    #endif
+
+    int H = F / n_heads; // Size of head chunks
+    float scaling = 1/sqrt(H);
+
+    // Projecting input sequence into Q, K, V, directly in the (3F x L) layout that divides them in chunks for the multiple heads
+    struct matMul_args matMul_args1;
+    matMul_args1.A = coeffDataWin;
+    matMul_args1.B = inputData; 
+    matMul_args1.C = qkv; // Q, K, V are saved contiguously, in the same matrix
+    matMul_args1.N = 3*F;
+    matMul_args1.K = E;
+    matMul_args1.M = L;
+    matMul_args1.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args1);
+    #else
+    struct mm_manager_args man_args1;
+    man_args1.mm_args = &matMul_args1;
+    man_args1.layer_type = LAYER_LINEAR;
+    man_args1.step_type = STEP_FW;
+    man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args1);
+    #endif
+
+    // Tiled attention on all the heads: (F x L) attention map, no L x L buffer
+    struct flash_attn_args flash_args;
+    flash_args.q = qkv;
+    flash_args.k = qkv + L*F;
+    flash_args.v = qkv + L*2*F;
+    flash_args.output = attention_map;
+    flash_args.lse = lse;
+    flash_args.scaling = scaling;
+    flash_args.L = L;
+    flash_args.H = H;
+    flash_args.n_heads = n_heads;
+
+    pi_cl_team_fork(NUM_CORES, mhsa_flash_fp32_fw_kernel, &flash_args);
+
+    #ifdef DEBUG
+    printf("\nAttention map Data: %d %d\n", F, L);
+    for (int j=0; j<F*L; j++){
+        if(!(j%(L))) printf("\n");
+        printf("%.8f ", attention_map[j]);
+    }
+    printf("\n");
+    #endif
+
+    // Final attention map projection, directly in the (L x E) output layout
+    struct matMul_args matMul_args4;
+    matMul_args4.A = attention_map;
+    matMul_args4.B = coeffDataWout;
+    matMul_args4.C = outData;
+    matMul_args4.N = L;
+    matMul_args4.K = F;
+    matMul_args4.M = E;
+    matMul_args4.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args4);
+    #else
+    struct mm_manager_args man_args4;
+    man_args4.mm_args = &matMul_args4;
+    man_args4.layer_type = LAYER_LINEAR;
+    man_args4.step_type = STEP_FW;
+    man_args4.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args4);
+    #endif
 
-    pi_cl_team_fork(NUM_CORES, copy, &copy_args2);
-    
     #ifdef DEBUG
-    printf("\nOutput Data map Data: %d %d\n", E, L);
+    printf("\nOutput Data map Data: %d %d\n", L, E);
     for (int j=0; j<L*E; j++){
+        if(!(j%(E))) printf("\n");
+        printf("%.8f ", outData[j]);
+    }
+    printf("\n");
+    #endif
+}
+
+
+
+
+
+//FORWARD (HEAD-PARALLEL)
+void pulp_mhsa_heads_fp32_fw_cl(void* Mhsa_args){
+    struct Mhsa_args *mhsa_args = (struct Mhsa_args *) Mhsa_args;
+    float *coeffDataWin = mhsa_args->coeff_in->data; // Input Projection Weights
+    float *coeffDataWout = mhsa_args->coeff_out->data; // Output Projection Weights
+    float *attention_map = mhsa_args->attention_map->data; // Buffer saving the MHSA map before projection
+    float *outData = mhsa_args->output->data;  
+    float *inputData = mhsa_args->input->data;
+    float *qkv = mhsa_args->qkv->data;
+    float *head_buffer = mhsa_args->head_buffer->data;
+    float *softmax_buffer = mhsa_args->softmax_buffer->data;
+    int n_heads = mhsa_args->n_heads;
+
+    int opt_matmul_type = mhsa_args->opt_matmul_type_fw;
+
+    int L = mhsa_args->input->H; // Input/Output Sequence length
+    int E = mhsa_args->input->W; // Input Sequence element size
+    int F = mhsa_args->attention_map->W; // Hidden dimension of attention
+
+    #ifdef DEBUG
+    printf("\nPrinting the parameters: L-%d, E-%d, F-%d", L, E, F);
+    #endif
+
+    int H = F / n_heads; // Size of head chunks
+    float scaling = 1/sqrt(H);
+
+    // Projecting input sequence into Q, K, V, directly in the (3F x L) layout that divides them in chunks for the multiple heads
+    struct matMul_args matMul_args1;
+    matMul_args1.A = coeffDataWin;
+    matMul_args1.B = inputData; 
+    matMul_args1.C = qkv; // Q, K, V are saved contiguously, in the same matrix
+    matMul_args1.N = 3*F;
+    matMul_args1.K = E;
+    matMul_args1.M = L;
+    matMul_args1.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args1);
+    #else
+    struct mm_manager_args man_args1;
+    man_args1.mm_args = &matMul_args1;
+    man_args1.layer_type = LAYER_LINEAR;
+    man_args1.step_type = STEP_FW;
+    man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args1);
+    #endif
+
+    // Attention of all the heads in a single fork: every core owns a block of (head, query) pairs
+    struct mhsa_heads_args heads_args;
+    heads_args.q = qkv;
+    heads_args.k = qkv + L*F;
+    heads_args.v = qkv + L*2*F;
+    heads_args.head_buffer = head_buffer;
+    heads_args.softmax_buffer = softmax_buffer;
+    heads_args.output = attention_map;
+    heads_args.scaling = scaling;
+    heads_args.L = L;
+    heads_args.H = H;
+    heads_args.n_heads = n_heads;
+
+    pi_cl_team_fork(NUM_CORES, mhsa_heads_fp32_fw_kernel, &heads_args);
+
+    #ifdef DEBUG
+    printf("\nAttention map Data: %d %d\n", F, L);
+    for (int j=0; j<F*L; j++){
         if(!(j%(L))) printf("\n");
+        printf("%.8f ", attention_map[j]);
+    }
+    printf("\n");
+    #endif
+
+    // Final attention map projection, directly in the (L x E) output layout
+    struct matMul_args matMul_args4;
+    matMul_args4.A = attention_map;
+    matMul_args4.B = coeffDataWout;
+    matMul_args4.C = outData;
+    matMul_args4.N = L;
+    matMul_args4.K = F;
+    matMul_args4.M = E;
+    matMul_args4.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args4);
+    #else
+    struct mm_manager_args man_args4;
+    man_args4.mm_args = &matMul_args4;
+    man_args4.layer_type = LAYER_LINEAR;
+    man_args4.step_type = STEP_FW;
+    man_args4.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args4);
+    #endif
+
+    #ifdef DEBUG
+    printf("\nOutput Data map Data: %d %d\n", L, E);
+    for (int j=0; j<L*E; j++){
+        if(!(j%(E))) printf("\n");
+        printf("%.8f ", outData[j]);
+    }
+    printf("\n");
+    #endif
+}
+
+
+
+
+
+//FORWARD (INCREMENTAL DECODING)
+void pulp_mhsa_fp32_fw_incremental_cl(void* Mhsa_args){
+    struct Mhsa_args *mhsa_args = (struct Mhsa_args *) Mhsa_args;
+    float *coeffDataWin = mhsa_args->coeff_in->data; // Input Projection Weights
+    float *coeffDataWout = mhsa_args->coeff_out->data; // Output Projection Weights
+    float *attention_map = mhsa_args->attention_map->data; // F
+    float *outData = mhsa_args->output->data; // E
+    float *inputData = mhsa_args->input->data; // E
+    float *qkv = mhsa_args->qkv->data; // 3F
+    struct mhsa_kv_cache *cache = mhsa_args->kv_cache;
+    int n_heads = mhsa_args->n_heads;
+
+    int opt_matmul_type = mhsa_args->opt_matmul_type_fw;
+
+    int E = mhsa_args->input->W; // Input Sequence element size
+    int F = mhsa_args->attention_map->W; // Hidden dimension of attention
+    int H = F / n_heads; // Size of head chunks
+    int L_max = cache->L_max;
+
+    // Projecting the new token into q, k, v: (3F x E)*(E x 1) - > (3F x 1)
+    struct matMul_args matMul_args1;
+    matMul_args1.A = coeffDataWin;
+    matMul_args1.B = inputData; 
+    matMul_args1.C = qkv;
+    matMul_args1.N = 3*F;
+    matMul_args1.K = E;
+    matMul_args1.M = 1;
+    matMul_args1.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args1);
+    #else
+    struct mm_manager_args man_args1;
+    man_args1.mm_args = &matMul_args1;
+    man_args1.layer_type = LAYER_LINEAR;
+    man_args1.step_type = STEP_FW;
+    man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args1);
+    #endif
+
+    // Append k and v to the ring buffer, overwriting the oldest token when full
+    int slot = cache->next;
+    for (int f=0; f<F; f++) {
+        cache->k[f*L_max+slot] = qkv[F+f];
+        cache->v[f*L_max+slot] = qkv[2*F+f];
+    }
+    cache->next = (slot+1 == L_max) ? 0 : slot+1;
+    if (cache->length < L_max) cache->length++;
+
+    // Attention of the new query over the cached tokens
+    struct mhsa_decode_args decode_args;
+    decode_args.q = qkv;
+    decode_args.cache = cache;
+    decode_args.output = attention_map;
+    decode_args.scaling = 1/sqrt(H);
+    decode_args.H = H;
+    decode_args.n_heads = n_heads;
+
+    pi_cl_team_fork(NUM_CORES, mhsa_decode_fp32_scores_kernel, &decode_args);
+    pi_cl_team_fork(NUM_CORES, mhsa_decode_fp32_softmax_kernel, &decode_args);
+    pi_cl_team_fork(NUM_CORES, mhsa_decode_fp32_av_kernel, &decode_args);
+
+    // Output projection of the single row: (1 x F)*(F x E) - > (1 x E)
+    struct matMul_args matMul_args4;
+    matMul_args4.A = attention_map;
+    matMul_args4.B = coeffDataWout;
+    matMul_args4.C = outData;
+    matMul_args4.N = 1;
+    matMul_args4.K = F;
+    matMul_args4.M = E;
+    matMul_args4.trans_B = 1;
+
+    pi_cl_team_fork(NUM_CORES,  mm_M, &matMul_args4);
+
+    #ifdef DEBUG
+    printf("\nOutput token (cache length %d): %d\n", cache->length, E);
+    for (int j=0; j<E; j++){
         printf("%.8f ", outData[j]);
     }
     printf("\n");
@@ -565,7 +760,6 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
     float *coeffDataWin = mhsa_args->coeff_in->data; // E x 3F
     float *coeffDataWout = mhsa_args->coeff_out->data; // E x F
     float *inData = mhsa_args->input->data; // L x E
-    float *temp = mhsa_args->temp_buffer; // Temporary buffer to save transposed matrices // TODO: THIS HAS TO BE DYNAMIC (calculate the max capacity required)
     float *grad = mhsa_args->grad; // L x L
     float *outData = mhsa_args->output->data; // L x E
     float *attention_map = mhsa_args->attention_map->data; // F x L
@@ -581,6 +775,7 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
     int F = mhsa_args->attention_map->W; // Attention block hidden size
     int n_heads = mhsa_args->n_heads; // Number of heads of the mhsa
     int H = F / n_heads;
+    float scaling = 1/sqrt(H);
     int opt_matmul_type = mhsa_args->opt_matmul_type_wg;
 
     float *q = mhsa_args->qkv->data; // 3F x L
@@ -622,53 +817,37 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
 
     // matmul setup 1
     struct matMul_args matMul_args1;
-    matMul_args1.A = outDiff; 
-    matMul_args1.B = coeffDataWout; 
+    matMul_args1.A = coeffDataWout; 
+    matMul_args1.B = outDiff; 
     matMul_args1.C = attention_map_diff;
-    matMul_args1.N = L;
+    matMul_args1.N = F;
     matMul_args1.K = E;
-    matMul_args1.M = F;
-    matMul_args1.trans_B = 0;
+    matMul_args1.M = L;
+    matMul_args1.trans_B = 1;
 
     #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm, &matMul_args1); // Gradient of attention map: (L x E)*(E x F) - > (L x F)
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args1); // Gradient of attention map: (F x E)*(E x L) - > (F x L)
     #else
     struct mm_manager_args man_args1;
     man_args1.mm_args = &matMul_args1;
     man_args1.layer_type = LAYER_LINEAR;
     man_args1.step_type = STEP_FW;
     man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager, &man_args1);
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args1);
     #endif
 
-    //Transpose map gradients (copy required because transpose can't be done inplace)
-    struct transp_args transp_args1;
-    transp_args1.matrix = attention_map_diff;
-    transp_args1.transp_matrix = temp;
-    transp_args1.N = L;
-    transp_args1.M = F;
-
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args1);
-
-    struct copy_args copy_args1;
-    copy_args1.from = temp;
-    copy_args1.to = attention_map_diff;
-    copy_args1.size = F*L;
-
-    pi_cl_team_fork(NUM_CORES, copy, &copy_args1); // Transposed gradient of attention map: (L x F) - > (F x L)
-
     // Output Projection Weights
 
 
     // matmul setup 2
     struct matMul_args matMul_args2;
-    matMul_args2.A = attention_map; 
-    matMul_args2.B = outDiff; 
+    matMul_args2.A = outDiff; 
+    matMul_args2.B = attention_map; 
     matMul_args2.C = coeffDiffWout;
-    matMul_args2.N = F;
+    matMul_args2.N = E;
     matMul_args2.K = L;
-    matMul_args2.M = E;
-    matMul_args2.trans_B = 0;
+    matMul_args2.M = F;
+    matMul_args2.trans_B = 1;
 
 
     #ifdef DEBUG
@@ -688,33 +867,17 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
     #endif
 
     #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES,  mm, &matMul_args2); // Output weight gradient: (F x L)*(L x E) - > (F x E)
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args2); // Output weight gradient: (E x L)*(L x F) - > (E x F)
     #else
     struct mm_manager_args man_args2;
     man_args2.mm_args = &matMul_args2;
     man_args2.layer_type = LAYER_LINEAR;
     man_args2.step_type = STEP_FW;
     man_args2.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager, &man_args2);
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args2);
     #endif
 
 
-    // Transpose Linear Output Weight gradients
-    struct transp_args transp_args9;
-    transp_args9.matrix = coeffDiffWout;
-    transp_args9.transp_matrix = temp;
-    transp_args9.N = F;
-    transp_args9.M = E;
-
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args9);
-
-    struct copy_args copy_args9;
-    copy_args9.from = temp;
-    copy_args9.to = coeffDiffWout;
-    copy_args9.size = E*F;
-
-    pi_cl_team_fork(NUM_CORES, copy, &copy_args9); // Transposed output weight gradient: (F x E) - > (E x F)
-
 
     #ifdef DEBUG
     printf("\nLinear coeffDiffWout");
@@ -737,10 +900,10 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
         matMul_args3.N = H;
         matMul_args3.K = L;
         matMul_args3.M = L;
-        matMul_args3.trans_B = 0;
+        matMul_args3.trans_B = 1;
 
         #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES,  mm, &matMul_args3); // i-th head Value gradient: (H x L)*(L x L) - > (H x L)
+        pi_cl_team_fork(NUM_CORES,  mm, &matMul_args3); // i-th head Value gradient: (H x L)*(L x L)^T - > (H x L)
         #else
         struct mm_manager_args man_args3;
         man_args3.mm_args = &matMul_args3;
@@ -753,20 +916,10 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
 
         // I-th head Buffer Gradient
 
-        // Transpose output gradients
-        struct transp_args transp_args3;
-        transp_args3.matrix = attention_map_diff + i*L*H;
-        transp_args3.transp_matrix = temp;
-        transp_args3.N = H;
-        transp_args3.M = L;
-
-        pi_cl_team_fork(NUM_CORES, transpose, &transp_args3); // Transpose i-th head attention map gradient: (H x L) - > (L x H) 
-
-
-        // matmul setup 4
+        // matmul setup 4 (i-th head Values read as transposed: (H x L) - > (L x H))
         struct matMul_args matMul_args4;
-        matMul_args4.A = temp; 
-        matMul_args4.B = v + i*L*H; 
+        matMul_args4.A = v + i*L*H; 
+        matMul_args4.B = attention_map_diff + i*L*H; 
         matMul_args4.C = head_buffer_diff + i*L*L;
         matMul_args4.N = L;
         matMul_args4.K = H;
@@ -774,52 +927,40 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
         matMul_args4.trans_B = 0;
 
         #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES, mm, &matMul_args4); // i-th head Buffer gradient: (L x H)*(H x L) - > (L x L)
+        pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args4); // i-th head Buffer gradient: (L x H)*(H x L) - > (L x L)
         #else
         struct mm_manager_args man_args4;
         man_args4.mm_args = &matMul_args4;
         man_args4.layer_type = LAYER_LINEAR;
         man_args4.step_type = STEP_FW;
         man_args4.matmul_type = opt_matmul_type; //MATMUL_TYPE
-        pi_cl_team_fork(NUM_CORES, mm_manager, &man_args4);
+        pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args4);
         #endif
 
 
-        struct act_args softmax_arg;
+        struct softmax_args softmax_arg;
         struct blob input;
         struct blob output;
         input.diff = grad;
         input.dim = L*L;
         output.data = softmax_buffer + i*L*L;
         output.diff = head_buffer_diff + i*L*L;
-        output.dim = i;
         softmax_arg.input = &input;
         softmax_arg.output = &output;
-        // Back propagation of i-th head Buffer gradient through the softmax operation
-
-        
-        pi_cl_team_fork(1, pulp_softmax_fp32_bw_cl, &softmax_arg);
+        softmax_arg.L = L;
+        // Back propagation of i-th head Buffer gradient through the softmax of every query
+        pi_cl_team_fork(NUM_CORES, mhsa_softmax_fp32_bw_kernel, &softmax_arg);
 
+        // Scores were scaled before the softmax
+        struct scalar_mul_args s_m_args;
+        s_m_args.input = grad;
+        s_m_args.scalar = scaling;
+        s_m_args.dim = L*L;
 
+        pi_cl_team_fork(NUM_CORES,  pulp_scalar_mul_fp32_cl, &s_m_args);
 
 
         // I-th head Query Gradient
-        
-        // Transpose softmax gradients
-        struct transp_args transp_args4;
-        transp_args4.matrix = grad;
-        transp_args4.transp_matrix = temp;
-        transp_args4.N = L;
-        transp_args4.M = L;
-
-        pi_cl_team_fork(NUM_CORES, transpose, &transp_args4); 
-
-        struct copy_args copy_args3;
-        copy_args3.from = temp;
-        copy_args3.to = grad;
-        copy_args3.size = L*L;
-
-        pi_cl_team_fork(NUM_CORES, copy, &copy_args3); // Still (L x L). Unsure if it is needed.
 
         // matmul setup 5
         struct matMul_args matMul_args5;
@@ -853,10 +994,10 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
         matMul_args6.N = H;
         matMul_args6.K = L;
         matMul_args6.M = L;
-        matMul_args6.trans_B = 0;
+        matMul_args6.trans_B = 1;
 
         #ifndef OPTIMIZE
-        pi_cl_team_fork(NUM_CORES, mm, &matMul_args6); // i-th head Key gradient: (H x L)*(L x L) - > (H x L)
+        pi_cl_team_fork(NUM_CORES, mm, &matMul_args6); // i-th head Key gradient: (H x L)*(L x L)^T - > (H x L)
         #else
         struct mm_manager_args man_args6;
         man_args6.mm_args = &matMul_args6;
@@ -871,86 +1012,821 @@ void pulp_mhsa_fp32_bw_cl(void * Mhsa_args) {
     
     // matmul setup 7
     struct matMul_args matMul_args7;
-    matMul_args7.A = q_diff; 
-    matMul_args7.B = inData; 
+    matMul_args7.A = inData; 
+    matMul_args7.B = q_diff; 
     matMul_args7.C = coeffDiffWin;
-    matMul_args7.N = 3*F;
+    matMul_args7.N = E;
     matMul_args7.K = L;
-    matMul_args7.M = E;
-    matMul_args7.trans_B = 0;
+    matMul_args7.M = 3*F;
+    matMul_args7.trans_B = 1;
 
     #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES, mm, &matMul_args7); // Input weight gradient: (3F x L)*(L x E) - > (3F x E)
+    pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args7); // Input weight gradient: (E x L)*(L x 3F) - > (E x 3F)
     #else
     struct mm_manager_args man_args7;
     man_args7.mm_args = &matMul_args7;
     man_args7.layer_type = LAYER_LINEAR;
     man_args7.step_type = STEP_FW;
     man_args7.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager, &man_args7);
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args7);
+    #endif
+
+
+
+
+    // Input Gradients
+
+    // matmul setup 8
+    struct matMul_args matMul_args8;
+    matMul_args8.A = q_diff; 
+    matMul_args8.B = coeffDataWin; 
+    matMul_args8.C = inDiff;
+    matMul_args8.N = L;
+    matMul_args8.K = 3*F;
+    matMul_args8.M = E;
+    matMul_args8.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args8); // Input gradients: (L x 3F)*(3F x E) - > (L x E)
+    #else
+    struct mm_manager_args man_args8;
+    man_args8.mm_args = &matMul_args8;
+    man_args8.layer_type = LAYER_LINEAR;
+    man_args8.step_type = STEP_FW;
+    man_args8.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args8);
     #endif
 
-    // Transpose input weight gradients
-    struct transp_args transp_args5;
-    transp_args5.matrix = coeffDiffWin;
-    transp_args5.transp_matrix = temp;
-    transp_args5.N = 3*F;
-    transp_args5.M = E;
 
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args5); 
+}
+  
+
+
+
+
+//BACKWARD (TILED ATTENTION)
+void pulp_mhsa_flash_fp32_bw_cl(void * Mhsa_args) {
+    struct Mhsa_args *mhsa_args = (struct Mhsa_args *) Mhsa_args;
+
+    float *coeffDataWin = mhsa_args->coeff_in->data; // E x 3F
+    float *coeffDataWout = mhsa_args->coeff_out->data; // E x F
+    float *inData = mhsa_args->input->data; // L x E
+    float *attention_map = mhsa_args->attention_map->data; // F x L
+    float *coeffDiffWin = mhsa_args->coeff_in->diff; // E x 3F
+    float *coeffDiffWout = mhsa_args->coeff_out->diff; // E x F
+
+    int L = mhsa_args->input->H; // Input sequence length
+    int E = mhsa_args->input->W; // Input sequence element size
+    int F = mhsa_args->attention_map->W; // Attention block hidden size
+    int n_heads = mhsa_args->n_heads; // Number of heads of the mhsa
+    int H = F / n_heads;
+    int opt_matmul_type = mhsa_args->opt_matmul_type_wg;
+
+    float *q = mhsa_args->qkv->data; // 3F x L
+    float *q_diff = mhsa_args->qkv->diff; // 3F x L
+
+    float *outDiff = mhsa_args->output->diff; // L x E
+    float *inDiff = mhsa_args->input->diff; // L x E
+    float *attention_map_diff = mhsa_args->attention_map->diff; // F x L
+
+    // Attention Map gradient
+    struct matMul_args matMul_args1;
+    matMul_args1.A = coeffDataWout; 
+    matMul_args1.B = outDiff; 
+    matMul_args1.C = attention_map_diff;
+    matMul_args1.N = F;
+    matMul_args1.K = E;
+    matMul_args1.M = L;
+    matMul_args1.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args1); // Gradient of attention map: (F x E)*(E x L) - > (F x L)
+    #else
+    struct mm_manager_args man_args1;
+    man_args1.mm_args = &matMul_args1;
+    man_args1.layer_type = LAYER_LINEAR;
+    man_args1.step_type = STEP_FW;
+    man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args1);
+    #endif
 
-    struct copy_args copy_args4;
-    copy_args4.from = temp;
-    copy_args4.to = coeffDiffWin;
-    copy_args4.size = E*3*F;
+    // Output Projection Weights
+    struct matMul_args matMul_args2;
+    matMul_args2.A = outDiff; 
+    matMul_args2.B = attention_map; 
+    matMul_args2.C = coeffDiffWout;
+    matMul_args2.N = E;
+    matMul_args2.K = L;
+    matMul_args2.M = F;
+    matMul_args2.trans_B = 1;
 
-    pi_cl_team_fork(NUM_CORES, copy, &copy_args4); // Transpose input weight gradient: (3F x E) - > (E x 3F)
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args2); // Output weight gradient: (E x L)*(L x F) - > (E x F)
+    #else
+    struct mm_manager_args man_args2;
+    man_args2.mm_args = &matMul_args2;
+    man_args2.layer_type = LAYER_LINEAR;
+    man_args2.step_type = STEP_FW;
+    man_args2.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args2);
+    #endif
 
+    // Q, K, V gradients of all the heads, recomputing the attention probabilities block by block
+    struct flash_attn_args flash_args;
+    flash_args.q = q;
+    flash_args.k = q + L*F;
+    flash_args.v = q + L*2*F;
+    flash_args.output = attention_map;
+    flash_args.q_diff = q_diff;
+    flash_args.k_diff = q_diff + L*F;
+    flash_args.v_diff = q_diff + L*2*F;
+    flash_args.output_diff = attention_map_diff;
+    flash_args.lse = mhsa_args->lse;
+    flash_args.delta = mhsa_args->delta;
+    flash_args.scaling = 1/sqrt(H);
+    flash_args.L = L;
+    flash_args.H = H;
+    flash_args.n_heads = n_heads;
+
+    pi_cl_team_fork(NUM_CORES, mhsa_flash_fp32_bw_delta_kernel, &flash_args);
+    pi_cl_team_fork(NUM_CORES, mhsa_flash_fp32_bw_kv_kernel, &flash_args);
+    pi_cl_team_fork(NUM_CORES, mhsa_flash_fp32_bw_q_kernel, &flash_args);
 
+    // Input projection Gradients
+    struct matMul_args matMul_args7;
+    matMul_args7.A = inData; 
+    matMul_args7.B = q_diff; 
+    matMul_args7.C = coeffDiffWin;
+    matMul_args7.N = E;
+    matMul_args7.K = L;
+    matMul_args7.M = 3*F;
+    matMul_args7.trans_B = 1;
 
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args7); // Input weight gradient: (E x L)*(L x 3F) - > (E x 3F)
+    #else
+    struct mm_manager_args man_args7;
+    man_args7.mm_args = &matMul_args7;
+    man_args7.layer_type = LAYER_LINEAR;
+    man_args7.step_type = STEP_FW;
+    man_args7.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args7);
+    #endif
 
     // Input Gradients
+    struct matMul_args matMul_args8;
+    matMul_args8.A = q_diff; 
+    matMul_args8.B = coeffDataWin; 
+    matMul_args8.C = inDiff;
+    matMul_args8.N = L;
+    matMul_args8.K = 3*F;
+    matMul_args8.M = E;
+    matMul_args8.trans_B = 1;
 
-    // matmul setup 8
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args8); // Input gradients: (L x 3F)*(3F x E) - > (L x E)
+    #else
+    struct mm_manager_args man_args8;
+    man_args8.mm_args = &matMul_args8;
+    man_args8.layer_type = LAYER_LINEAR;
+    man_args8.step_type = STEP_FW;
+    man_args8.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args8);
+    #endif
+}
+
+
+
+
+//BACKWARD (HEAD-PARALLEL)
+void pulp_mhsa_heads_fp32_bw_cl(void * Mhsa_args) {
+    struct Mhsa_args *mhsa_args = (struct Mhsa_args *) Mhsa_args;
+
+    float *coeffDataWin = mhsa_args->coeff_in->data; // E x 3F
+    float *coeffDataWout = mhsa_args->coeff_out->data; // E x F
+    float *inData = mhsa_args->input->data; // L x E
+    float *attention_map = mhsa_args->attention_map->data; // F x L
+    float *coeffDiffWin = mhsa_args->coeff_in->diff; // E x 3F
+    float *coeffDiffWout = mhsa_args->coeff_out->diff; // E x F
+
+    int L = mhsa_args->input->H; // Input sequence length
+    int E = mhsa_args->input->W; // Input sequence element size
+    int F = mhsa_args->attention_map->W; // Attention block hidden size
+    int n_heads = mhsa_args->n_heads; // Number of heads of the mhsa
+    int H = F / n_heads;
+    int opt_matmul_type = mhsa_args->opt_matmul_type_wg;
+
+    float *q = mhsa_args->qkv->data; // 3F x L
+    float *q_diff = mhsa_args->qkv->diff; // 3F x L
+
+    float *outDiff = mhsa_args->output->diff; // L x E
+    float *inDiff = mhsa_args->input->diff; // L x E
+    float *attention_map_diff = mhsa_args->attention_map->diff; // F x L
+
+    // Attention Map gradient
+    struct matMul_args matMul_args1;
+    matMul_args1.A = coeffDataWout; 
+    matMul_args1.B = outDiff; 
+    matMul_args1.C = attention_map_diff;
+    matMul_args1.N = F;
+    matMul_args1.K = E;
+    matMul_args1.M = L;
+    matMul_args1.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args1); // Gradient of attention map: (F x E)*(E x L) - > (F x L)
+    #else
+    struct mm_manager_args man_args1;
+    man_args1.mm_args = &matMul_args1;
+    man_args1.layer_type = LAYER_LINEAR;
+    man_args1.step_type = STEP_FW;
+    man_args1.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args1);
+    #endif
+
+    // Output Projection Weights
+    struct matMul_args matMul_args2;
+    matMul_args2.A = outDiff; 
+    matMul_args2.B = attention_map; 
+    matMul_args2.C = coeffDiffWout;
+    matMul_args2.N = E;
+    matMul_args2.K = L;
+    matMul_args2.M = F;
+    matMul_args2.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES,  mm_trans_A, &matMul_args2); // Output weight gradient: (E x L)*(L x F) - > (E x F)
+    #else
+    struct mm_manager_args man_args2;
+    man_args2.mm_args = &matMul_args2;
+    man_args2.layer_type = LAYER_LINEAR;
+    man_args2.step_type = STEP_FW;
+    man_args2.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args2);
+    #endif
+
+    // Q, K, V gradients of all the heads: every core owns a block of (head, query) pairs, then a block of (head, key) pairs
+    struct mhsa_heads_args heads_args;
+    heads_args.q = q;
+    heads_args.k = q + L*F;
+    heads_args.v = q + L*2*F;
+    heads_args.softmax_buffer = mhsa_args->softmax_buffer->data;
+    heads_args.grad = mhsa_args->head_buffer->diff;
+    heads_args.q_diff = q_diff;
+    heads_args.k_diff = q_diff + L*F;
+    heads_args.v_diff = q_diff + L*2*F;
+    heads_args.output_diff = attention_map_diff;
+    heads_args.scaling = 1/sqrt(H);
+    heads_args.L = L;
+    heads_args.H = H;
+    heads_args.n_heads = n_heads;
+
+    pi_cl_team_fork(NUM_CORES, mhsa_heads_fp32_bw_q_kernel, &heads_args);
+    pi_cl_team_fork(NUM_CORES, mhsa_heads_fp32_bw_kv_kernel, &heads_args);
+
+    // Input projection Gradients
+    struct matMul_args matMul_args7;
+    matMul_args7.A = inData; 
+    matMul_args7.B = q_diff; 
+    matMul_args7.C = coeffDiffWin;
+    matMul_args7.N = E;
+    matMul_args7.K = L;
+    matMul_args7.M = 3*F;
+    matMul_args7.trans_B = 1;
+
+    #ifndef OPTIMIZE
+    pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args7); // Input weight gradient: (E x L)*(L x 3F) - > (E x 3F)
+    #else
+    struct mm_manager_args man_args7;
+    man_args7.mm_args = &matMul_args7;
+    man_args7.layer_type = LAYER_LINEAR;
+    man_args7.step_type = STEP_FW;
+    man_args7.matmul_type = opt_matmul_type; //MATMUL_TYPE
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args7);
+    #endif
+
+    // Input Gradients
     struct matMul_args matMul_args8;
-    matMul_args8.A = coeffDataWin; 
-    matMul_args8.B = q_diff; 
+    matMul_args8.A = q_diff; 
+    matMul_args8.B = coeffDataWin; 
     matMul_args8.C = inDiff;
-    matMul_args8.N = E;
+    matMul_args8.N = L;
     matMul_args8.K = 3*F;
-    matMul_args8.M = L;
-    matMul_args8.trans_B = 0;
+    matMul_args8.M = E;
+    matMul_args8.trans_B = 1;
 
     #ifndef OPTIMIZE
-    pi_cl_team_fork(NUM_CORES, mm, &matMul_args8); // Input gradients: (E x 3F)*(3F x L) - > (E x L)
+    pi_cl_team_fork(NUM_CORES, mm_trans_A, &matMul_args8); // Input gradients: (L x 3F)*(3F x E) - > (L x E)
     #else
     struct mm_manager_args man_args8;
     man_args8.mm_args = &matMul_args8;
     man_args8.layer_type = LAYER_LINEAR;
     man_args8.step_type = STEP_FW;
     man_args8.matmul_type = opt_matmul_type; //MATMUL_TYPE
-    pi_cl_team_fork(NUM_CORES, mm_manager, &man_args8);
+    pi_cl_team_fork(NUM_CORES, mm_manager_trans_A, &man_args8);
     #endif
+}
+
+
+
 
-    // Transpose input weight gradients
-    struct transp_args transp_args6;
-    transp_args6.matrix = inDiff;
-    transp_args6.transp_matrix = temp;
-    transp_args6.N = E;
-    transp_args6.M = L;
+// TILED ATTENTION KERNELS
+
+void mhsa_flash_fp32_fw_kernel(void * flash_attn_args)
+{
+    struct flash_attn_args * args = (struct flash_attn_args *) flash_attn_args;
+    int L = args->L;
+    int H = args->H;
+    float scaling = args->scaling;
+    float minfloat = -340282346638528859811704183484516925440.0f;
+
+    float scores[MHSA_FLASH_TILE];
+
+    // Parallelize over all the (head, query) pairs
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int l = idx % L;
+        float * q = args->q + h*H*L + l;
+        float * k = args->k + h*H*L;
+        float * v = args->v + h*H*L;
+        float * o = args->output + h*H*L + l;
+
+        float max = minfloat;
+        float sum = 0.0f;
+        for (int d=0; d<H; d++) o[d*L] = 0.0f;
+
+        // Stream the keys and values in blocks, rescaling the partial results when the running max changes
+        for (int j0=0; j0<L; j0+=MHSA_FLASH_TILE) {
+            int tile = L-j0 < MHSA_FLASH_TILE ? L-j0 : MHSA_FLASH_TILE;
+
+            float tile_max = max;
+            for (int t=0; t<tile; t++) {
+                float s = 0.0f;
+                for (int d=0; d<H; d++) s += q[d*L] * k[d*L+j0+t];
+                s *= scaling;
+                scores[t] = s;
+                if (s > tile_max) tile_max = s;
+            }
+
+            if (tile_max > max) {
+                float corr = act_exp(max - tile_max);
+                sum *= corr;
+                for (int d=0; d<H; d++) o[d*L] *= corr;
+                max = tile_max;
+            }
+
+            for (int t=0; t<tile; t++) {
+                float p = act_exp(scores[t] - max);
+                scores[t] = p;
+                sum += p;
+            }
+
+            for (int d=0; d<H; d++) {
+                float acc = 0.0f;
+                float * v_row = v + d*L + j0;
+                for (int t=0; t<tile; t++) acc += scores[t] * v_row[t];
+                o[d*L] += acc;
+            }
+        }
+
+        float inv_sum = 1.0f / sum;
+        for (int d=0; d<H; d++) o[d*L] *= inv_sum;
+        args->lse[idx] = max + logf(sum);
+    }
+}
 
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args6); 
 
-    struct copy_args copy_args5;
-    copy_args5.from = temp;
-    copy_args5.to = inDiff;
-    copy_args5.size = L*E;
+void mhsa_flash_fp32_bw_delta_kernel(void * flash_attn_args)
+{
+    struct flash_attn_args * args = (struct flash_attn_args *) flash_attn_args;
+    int L = args->L;
+    int H = args->H;
 
-    pi_cl_team_fork(NUM_CORES, copy, &copy_args5); // Input gradients transpose: (E x L) - > (L x E)
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
 
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int l = idx % L;
+        float * o = args->output + h*H*L + l;
+        float * o_diff = args->output_diff + h*H*L + l;
 
+        float acc = 0.0f;
+        for (int d=0; d<H; d++) acc += o[d*L] * o_diff[d*L];
+        args->delta[idx] = acc;
+    }
 }
-  
 
 
+void mhsa_flash_fp32_bw_kv_kernel(void * flash_attn_args)
+{
+    struct flash_attn_args * args = (struct flash_attn_args *) flash_attn_args;
+    int L = args->L;
+    int H = args->H;
+    float scaling = args->scaling;
+
+    float probs[MHSA_FLASH_TILE];
+    float dscores[MHSA_FLASH_TILE];
+
+    // Parallelize over all the (head, key) pairs: each core owns whole columns of dK and dV
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int j = idx % L;
+        float * q = args->q + h*H*L;
+        float * k = args->k + h*H*L + j;
+        float * v = args->v + h*H*L + j;
+        float * o_diff = args->output_diff + h*H*L;
+        float * k_diff = args->k_diff + h*H*L + j;
+        float * v_diff = args->v_diff + h*H*L + j;
+        float * lse = args->lse + h*L;
+        float * delta = args->delta + h*L;
+
+        for (int d=0; d<H; d++) {
+            k_diff[d*L] = 0.0f;
+            v_diff[d*L] = 0.0f;
+        }
+
+        for (int l0=0; l0<L; l0+=MHSA_FLASH_TILE) {
+            int tile = L-l0 < MHSA_FLASH_TILE ? L-l0 : MHSA_FLASH_TILE;
+
+            // Recompute the probabilities and the score gradients of this block of queries
+            for (int t=0; t<tile; t++) {
+                float s = 0.0f;
+                float dp = 0.0f;
+                for (int d=0; d<H; d++) {
+                    s += q[d*L+l0+t] * k[d*L];
+                    dp += o_diff[d*L+l0+t] * v[d*L];
+                }
+                float p = act_exp(s*scaling - lse[l0+t]);
+                probs[t] = p;
+                dscores[t] = p * (dp - delta[l0+t]) * scaling;
+            }
+
+            for (int d=0; d<H; d++) {
+                float acc_k = 0.0f;
+                float acc_v = 0.0f;
+                float * q_row = q + d*L + l0;
+                float * o_diff_row = o_diff + d*L + l0;
+                for (int t=0; t<tile; t++) {
+                    acc_k += dscores[t] * q_row[t];
+                    acc_v += probs[t] * o_diff_row[t];
+                }
+                k_diff[d*L] += acc_k;
+                v_diff[d*L] += acc_v;
+            }
+        }
+    }
+}
+
+
+void mhsa_flash_fp32_bw_q_kernel(void * flash_attn_args)
+{
+    struct flash_attn_args * args = (struct flash_attn_args *) flash_attn_args;
+    int L = args->L;
+    int H = args->H;
+    float scaling = args->scaling;
+
+    float dscores[MHSA_FLASH_TILE];
+
+    // Parallelize over all the (head, query) pairs: each core owns whole columns of dQ
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int l = idx % L;
+        float * q = args->q + h*H*L + l;
+        float * k = args->k + h*H*L;
+        float * v = args->v + h*H*L;
+        float * o_diff = args->output_diff + h*H*L + l;
+        float * q_diff = args->q_diff + h*H*L + l;
+        float lse = args->lse[idx];
+        float delta = args->delta[idx];
+
+        for (int d=0; d<H; d++) q_diff[d*L] = 0.0f;
+
+        for (int j0=0; j0<L; j0+=MHSA_FLASH_TILE) {
+            int tile = L-j0 < MHSA_FLASH_TILE ? L-j0 : MHSA_FLASH_TILE;
+
+            for (int t=0; t<tile; t++) {
+                float s = 0.0f;
+                float dp = 0.0f;
+                for (int d=0; d<H; d++) {
+                    s += q[d*L] * k[d*L+j0+t];
+                    dp += o_diff[d*L] * v[d*L+j0+t];
+                }
+                float p = act_exp(s*scaling - lse);
+                dscores[t] = p * (dp - delta) * scaling;
+            }
+
+            for (int d=0; d<H; d++) {
+                float acc = 0.0f;
+                float * k_row = k + d*L + j0;
+                for (int t=0; t<tile; t++) acc += dscores[t] * k_row[t];
+                q_diff[d*L] += acc;
+            }
+        }
+    }
+}
+
+
+
+
+// HEAD-PARALLEL ATTENTION KERNELS
+
+void mhsa_heads_fp32_fw_kernel(void * mhsa_heads_args)
+{
+    struct mhsa_heads_args * args = (struct mhsa_heads_args *) mhsa_heads_args;
+    int L = args->L;
+    int H = args->H;
+    float scaling = args->scaling;
+    float minfloat = -340282346638528859811704183484516925440.0f;
+
+    // Parallelize over all the (head, query) pairs: whole heads when n_heads is a multiple of NUM_CORES, head x query blocks otherwise
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int l = idx % L;
+        float * q = args->q + h*H*L + l;
+        float * k = args->k + h*H*L;
+        float * v = args->v + h*H*L;
+        float * scores = args->head_buffer + h*L*L + l;
+        float * probs = args->softmax_buffer + h*L*L + l;
+        float * o = args->output + h*H*L + l;
+
+        // Column l of K^T * Q
+        float max = minfloat;
+        for (int j=0; j<L; j++) {
+            float s = 0.0f;
+            for (int d=0; d<H; d++) s += k[d*L+j] * q[d*L];
+            s *= scaling;
+            scores[j*L] = s;
+            if (s > max) max = s;
+        }
+
+        // Softmax over the keys
+        float sum = 0.0f;
+        for (int j=0; j<L; j++) {
+            float p = act_exp(scores[j*L] - max);
+            probs[j*L] = p;
+            sum += p;
+        }
+        float inv_sum = 1.0f / sum;
+        for (int j=0; j<L; j++) probs[j*L] *= inv_sum;
+
+        // Column l of V * softmax
+        for (int d=0; d<H; d++) {
+            float acc = 0.0f;
+            float * v_row = v + d*L;
+            for (int j=0; j<L; j++) acc += v_row[j] * probs[j*L];
+            o[d*L] = acc;
+        }
+    }
+}
 
+
+void mhsa_heads_fp32_bw_q_kernel(void * mhsa_heads_args)
+{
+    struct mhsa_heads_args * args = (struct mhsa_heads_args *) mhsa_heads_args;
+    int L = args->L;
+    int H = args->H;
+    float scaling = args->scaling;
+
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int l = idx % L;
+        float * k = args->k + h*H*L;
+        float * v = args->v + h*H*L;
+        float * probs = args->softmax_buffer + h*L*L + l;
+        float * grad = args->grad + h*L*L + l;
+        float * o_diff = args->output_diff + h*H*L + l;
+        float * q_diff = args->q_diff + h*H*L + l;
+
+        // Column l of the softmax output gradient (V^T * dO) and its dot product with the softmax output
+        float delta = 0.0f;
+        for (int j=0; j<L; j++) {
+            float dp = 0.0f;
+            for (int d=0; d<H; d++) dp += v[d*L+j] * o_diff[d*L];
+            grad[j*L] = dp;
+            delta += dp * probs[j*L];
+        }
+
+        // Back propagation through the softmax and the scaling
+        for (int j=0; j<L; j++) {
+            grad[j*L] = probs[j*L] * (grad[j*L] - delta) * scaling;
+        }
+
+        // Column l of the Query gradient
+        for (int d=0; d<H; d++) {
+            float acc = 0.0f;
+            float * k_row = k + d*L;
+            for (int j=0; j<L; j++) acc += k_row[j] * grad[j*L];
+            q_diff[d*L] = acc;
+        }
+    }
+}
+
+
+void mhsa_heads_fp32_bw_kv_kernel(void * mhsa_heads_args)
+{
+    struct mhsa_heads_args * args = (struct mhsa_heads_args *) mhsa_heads_args;
+    int L = args->L;
+    int H = args->H;
+
+    // Parallelize over all the (head, key) pairs: rows of the score gradients are contiguous
+    const int dim = args->n_heads*L;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / L;
+        int j = idx % L;
+        float * q = args->q + h*H*L;
+        float * probs = args->softmax_buffer + h*L*L + j*L;
+        float * grad = args->grad + h*L*L + j*L;
+        float * o_diff = args->output_diff + h*H*L;
+        float * k_diff = args->k_diff + h*H*L + j;
+        float * v_diff = args->v_diff + h*H*L + j;
+
+        for (int d=0; d<H; d++) {
+            float acc_k = 0.0f;
+            float acc_v = 0.0f;
+            float * q_row = q + d*L;
+            float * o_diff_row = o_diff + d*L;
+            for (int l=0; l<L; l++) {
+                acc_k += grad[l] * q_row[l];
+                acc_v += probs[l] * o_diff_row[l];
+            }
+            k_diff[d*L] = acc_k;
+            v_diff[d*L] = acc_v;
+        }
+    }
+}
+
+
+
+
+// INCREMENTAL DECODING KERNELS
+
+void mhsa_decode_fp32_scores_kernel(void * mhsa_decode_args)
+{
+    struct mhsa_decode_args * args = (struct mhsa_decode_args *) mhsa_decode_args;
+    struct mhsa_kv_cache * cache = args->cache;
+    int H = args->H;
+    int L_max = cache->L_max;
+    int length = cache->length;
+    float scaling = args->scaling;
+
+    const int dim = args->n_heads*length;
+    const int blockSize = (dim+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > dim ? dim : start+blockSize;
+
+    for (int idx=start; idx<stop; idx++) {
+        int h = idx / length;
+        int j = idx % length;
+        float * q = args->q + h*H;
+        float * k = cache->k + h*H*L_max + j;
+
+        float s = 0.0f;
+        for (int d=0; d<H; d++) s += q[d] * k[d*L_max];
+        cache->scores[h*L_max+j] = s * scaling;
+    }
+}
+
+
+void mhsa_decode_fp32_softmax_kernel(void * mhsa_decode_args)
+{
+    struct mhsa_decode_args * args = (struct mhsa_decode_args *) mhsa_decode_args;
+    struct mhsa_kv_cache * cache = args->cache;
+    int L_max = cache->L_max;
+    int length = cache->length;
+
+    const int blockSize = (args->n_heads+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > args->n_heads ? args->n_heads : start+blockSize;
+
+    for (int h=start; h<stop; h++) {
+        float * scores = cache->scores + h*L_max;
+
+        float max = scores[0];
+        for (int j=1; j<length; j++) if (scores[j] > max) max = scores[j];
+
+        float sum = 0.0f;
+        for (int j=0; j<length; j++) {
+            scores[j] = act_exp(scores[j] - max);
+            sum += scores[j];
+        }
+
+        float inv_sum = 1.0f / sum;
+        for (int j=0; j<length; j++) scores[j] *= inv_sum;
+    }
+}
+
+
+void mhsa_decode_fp32_av_kernel(void * mhsa_decode_args)
+{
+    struct mhsa_decode_args * args = (struct mhsa_decode_args *) mhsa_decode_args;
+    struct mhsa_kv_cache * cache = args->cache;
+    int H = args->H;
+    int F = H*args->n_heads;
+    int L_max = cache->L_max;
+    int length = cache->length;
+
+    const int blockSize = (F+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > F ? F : start+blockSize;
+
+    for (int f=start; f<stop; f++) {
+        float * probs = cache->scores + (f/H)*L_max;
+        float * v = cache->v + f*L_max;
+
+        float acc = 0.0f;
+        for (int j=0; j<length; j++) acc += probs[j] * v[j];
+        args->output[f] = acc;
+    }
+}
+
+
+
+
+//SOFTMAX KERNELS
+void mhsa_softmax_fp32_fw_kernel(void * softmax_args)
+{
+    struct softmax_args * args = (struct softmax_args *) softmax_args;
+    float * inData = args->input->data;
+    float * outData = args->output->data;
+    int L = args->L;
+
+    // Parallelize over the queries (columns)
+    const int blockSize = (L+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > L ? L : start+blockSize;
+
+    for (int l=start; l<stop; l++) {
+        float * scores = inData + l;
+        float * probs = outData + l;
+
+        float max = scores[0];
+        for (int j=1; j<L; j++) if (scores[j*L] > max) max = scores[j*L];
+
+        float sum = 0.0f;
+        for (int j=0; j<L; j++) {
+            float p = act_exp(scores[j*L] - max);
+            probs[j*L] = p;
+            sum += p;
+        }
+
+        float inv_sum = 1.0f / sum;
+        for (int j=0; j<L; j++) probs[j*L] *= inv_sum;
+    }
+}
+
+
+void mhsa_softmax_fp32_bw_kernel(void * softmax_args)
+{
+    struct softmax_args * args = (struct softmax_args *) softmax_args;
+    float * inDiff = args->input->diff;
+    float * outData = args->output->data;
+    float * outDiff = args->output->diff;
+    int L = args->L;
+
+    const int blockSize = (L+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > L ? L : start+blockSize;
+
+    for (int l=start; l<stop; l++) {
+        float * probs = outData + l;
+        float * probs_diff = outDiff + l;
+        float * scores_diff = inDiff + l;
+
+        // dS = P * (dP - sum(P * dP)) over the keys of the query
+        float dot = 0.0f;
+        for (int j=0; j<L; j++) dot += probs[j*L] * probs_diff[j*L];
+        for (int j=0; j<L; j++) scores_diff[j*L] = probs[j*L] * (probs_diff[j*L] - dot);
+    }
+}
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_fp32.h"
+#include "pulp_optimizers_fp32.h"
+#include "pulp_net_fp32.h"
+
+
+// GRADIENT CHECKPOINTING
+
+static inline int is_checkpoint( struct net_args * args, int layer )
+{
+  return (layer == 0) || (args->checkpoint == NULL) || args->checkpoint[layer];
+}
+
+int pulp_net_checkpoint_cost( struct net_args * args, int * memory, int * arena_size )
+{
+  struct net_layer * layers = args->layers;
+  int N = args->num_layers;
+
+  int stored = 0;
+  int max_segment = 0;
+  int segment = 0;
+  int segment_cost = 0;
+  int recompute = 0;
+
+  for (int i=1; i<N; i++) {
+    int size = layers[i].input->dim;
+    if (is_checkpoint(args, i)) {
+      stored += size;
+      segment = 0;
+      recompute += segment_cost;
+      segment_cost = 0;
+    }
+    else {
+      // Input of layer i is refilled by the forward of layer i-1
+      segment_cost += layers[i-1].fw_cost > 0 ? layers[i-1].fw_cost : layers[i-1].output->dim;
+      segment += size;
+      if (segment > max_segment) max_segment = segment;
+    }
+  }
+  // The last segment is still in the arena after the forward, it is not recomputed
+
+  if (memory != NULL)       *memory = stored + max_segment;
+  if (arena_size != NULL)   *arena_size = max_segment;
+  return recompute;
+}
+
+int pulp_net_checkpoint_plan( struct net_args * args, int budget )
+{
+  int N = args->num_layers;
+  int * checkpoint = args->checkpoint;
+
+  if (N > CHECKPOINT_MAX_LAYERS) {
+    printf("[pulp_net_checkpoint_plan]: Too many layers (max %d)!!\n", CHECKPOINT_MAX_LAYERS);
+    for (int i=0; i<N; i++) checkpoint[i] = 1;
+    return -1;
+  }
+
+  // Exhaustive search over the checkpoint sets (bit i-1 of the mask marks layer i)
+  int best_mask = -1, best_cost = 0, best_mem = 0;
+  int min_mask = 0, min_mem = 0;
+  for (int mask=0; mask<(1<<(N-1)); mask++) {
+    checkpoint[0] = 1;
+    for (int i=1; i<N; i++) checkpoint[i] = (mask >> (i-1)) & 1;
+
+    int mem = 0;
+    int cost = pulp_net_checkpoint_cost(args, &mem, NULL);
+
+    if (mask == 0 || mem < min_mem) { min_mem = mem; min_mask = mask; }
+    if (mem <= budget && (best_mask < 0 || cost < best_cost || (cost == best_cost && mem < best_mem))) {
+      best_mask = mask; best_cost = cost; best_mem = mem;
+    }
+  }
+
+  int mask = best_mask >= 0 ? best_mask : min_mask;
+  checkpoint[0] = 1;
+  for (int i=1; i<N; i++) checkpoint[i] = (mask >> (i-1)) & 1;
+
+  #ifdef DEBUG
+  printf("[pulp_net_checkpoint_plan]: budget=%d, memory=%d, recompute=%d, checkpoints:", budget, best_mask >= 0 ? best_mem : min_mem, best_cost);
+  for (int i=0; i<N; i++) if (checkpoint[i]) printf(" %d", i);
+  printf("\n");
+  #endif
+
+  if (best_mask < 0) {
+    printf("[pulp_net_checkpoint_plan]: No checkpoint set fits the budget (min memory %d)!!\n", min_mem);
+    return -1;
+  }
+  return best_cost;
+}
+
+void pulp_net_checkpoint_bind( struct net_args * args )
+{
+  struct net_layer * layers = args->layers;
+  int N = args->num_layers;
+  int offset = 0;
+
+  for (int i=1; i<N; i++) {
+    if (is_checkpoint(args, i)) {
+      offset = 0;
+    }
+    else {
+      layers[i].input->data = args->arena + offset;
+      layers[i-1].output->data = args->arena + offset;
+      offset += layers[i].input->dim;
+    }
+  }
+}
+
+
+
+// ACTIVATION OFFLOAD
+
+// Activation k is offloaded if a later activation reuses its slot of the window
+static inline int is_offloaded( struct net_args * args, int k )
+{
+  return (k >= 1) && (k + OFFLOAD_WINDOW <= args->num_layers - 1);
+}
+
+// Offloaded activations are a prefix (1, 2, ..) of the intermediate ones, stored back to back in L2
+static inline float * l2_activation( struct net_args * args, int k )
+{
+  float * ptr = args->l2_buffer;
+  for (int j=1; j<k; j++) ptr += args->layers[j].input->dim;
+  return ptr;
+}
+
+// Transfers of OFFLOAD_DMA_CHUNK bytes, merged on the counter of the first one so that a single wait covers them
+static inline void offload_dma( struct net_args * args, int k, int dir, pi_cl_dma_copy_t * cmd )
+{
+  uint32_t ext = (uint32_t) l2_activation(args, k);
+  uint32_t loc = (uint32_t) args->layers[k].input->data;
+  uint32_t size = 4 * args->layers[k].input->dim;
+
+  cmd->dir = dir;
+  cmd->id = 0;
+  for (uint32_t offset=0; offset<size; offset+=OFFLOAD_DMA_CHUNK) {
+    cmd->merge = (offset > 0);
+    cmd->size = size-offset > OFFLOAD_DMA_CHUNK ? OFFLOAD_DMA_CHUNK : size-offset;
+    cmd->ext = ext + offset;
+    cmd->loc = loc + offset;
+    pi_cl_dma_memcpy(cmd);
+  }
+}
+
+void pulp_net_offload_size( struct net_args * args, int * window_size, int * l2_size )
+{
+  struct net_layer * layers = args->layers;
+  int max_dim = 0, l2_dim = 0;
+
+  for (int k=1; k<args->num_layers; k++) {
+    int size = layers[k].input->dim;
+    if (size > max_dim)         max_dim = size;
+    if (is_offloaded(args, k))  l2_dim += size;
+  }
+
+  if (window_size != NULL)  *window_size = OFFLOAD_WINDOW * max_dim;
+  if (l2_size != NULL)      *l2_size = l2_dim;
+}
+
+void pulp_net_offload_bind( struct net_args * args )
+{
+  struct net_layer * layers = args->layers;
+  int max_dim = 0;
+
+  for (int k=1; k<args->num_layers; k++) 
+    if (layers[k].input->dim > max_dim) max_dim = layers[k].input->dim;
+
+  for (int k=1; k<args->num_layers; k++) {
+    float * slot = args->arena + (k % OFFLOAD_WINDOW) * max_dim;
+    layers[k].input->data = slot;
+    layers[k-1].output->data = slot;
+  }
+}
+
+
+
+// FROZEN LAYERS
+
+int pulp_net_lowest_trainable( struct net_args * args )
+{
+  for (int k=0; k<args->num_layers; k++)
+    if (args->layers[k].coeff != NULL && args->layers[k].trainable) return k;
+  return args->num_layers;
+}
+
+// Backward of layer k: weight gradient only if trainable, input gradient only above the lowest trainable layer
+static inline void layer_bw( struct net_layer * layer, int k, int lowest )
+{
+  int param_grad = (layer->coeff != NULL) && layer->trainable;
+  int input_grad = (k > lowest);
+
+  if (layer->bw_param != NULL || layer->bw_input != NULL) {
+    if (param_grad && layer->bw_param != NULL)  layer->bw_param(layer->args);
+    if (input_grad && layer->bw_input != NULL)  layer->bw_input(layer->args);
+  }
+  else if (param_grad || input_grad) {
+    layer->bw(layer->args);
+  }
+}
+
+
+
+// TRAINING FUNCTIONS
+
+void pulp_net_fp32_fw( struct net_args * args )
+{
+  struct net_layer * layers = args->layers;
+  int N = args->num_layers;
+
+  if (args->offload) {
+    pi_cl_dma_copy_t dma[OFFLOAD_WINDOW];
+    int pending[OFFLOAD_WINDOW] = {0};
+
+    for (int k=0; k<N; k++) {
+      // The output slot of layer k has to be flushed to L2 before being overwritten
+      int out_slot = (k+1) % OFFLOAD_WINDOW;
+      if (pending[out_slot]) { pi_cl_dma_wait(&dma[out_slot]); pending[out_slot] = 0; }
+
+      layers[k].fw(layers[k].args);
+
+      // The input of layer k has been consumed, park it in L2 while the next layers run
+      if (is_offloaded(args, k)) {
+        offload_dma(args, k, PI_CL_DMA_DIR_LOC2EXT, &dma[k % OFFLOAD_WINDOW]);
+        pending[k % OFFLOAD_WINDOW] = 1;
+      }
+    }
+
+    for (int s=0; s<OFFLOAD_WINDOW; s++)
+      if (pending[s]) pi_cl_dma_wait(&dma[s]);
+    return;
+  }
+
+  for (int i=0; i<N; i++)
+    layers[i].fw(layers[i].args);
+}
+
+void pulp_net_fp32_bw( struct net_args * args )
+{
+  struct net_layer * layers = args->layers;
+  int stop = args->num_layers;
+  int lowest = pulp_net_lowest_trainable(args);
+
+  if (args->offload) {
+    pi_cl_dma_copy_t dma;
+    int pending = 0;
+
+    for (int k=stop-1; k>=lowest; k--) {
+      // Input of layer k has been prefetched during the backward of layer k+1
+      if (pending) { pi_cl_dma_wait(&dma); pending = 0; }
+
+      // Prefetch the input of layer k-1 in the slot of the (no longer needed) input of layer k+2
+      if (k-1 >= lowest && is_offloaded(args, k-1)) {
+        offload_dma(args, k-1, PI_CL_DMA_DIR_EXT2LOC, &dma);
+        pending = 1;
+      }
+
+      layer_bw(&layers[k], k, lowest);
+    }
+    return;
+  }
+
+  // Segments are processed from the last one, down to the lowest trainable layer
+  while (stop > lowest) {
+    int start = stop - 1;
+    while (!is_checkpoint(args, start)) start--;
+
+    // Refill the arena with the activations of the segment (the last one is still there after the forward)
+    if (stop < args->num_layers)
+      for (int i=start; i<stop-1; i++)
+        layers[i].fw(layers[i].args);
+
+    for (int i=stop-1; i>=start && i>=lowest; i--)
+      layer_bw(&layers[i], i, lowest);
+
+    stop = start;
+  }
+}
+
+void pulp_net_fp32_update( struct net_args * args, float learning_rate )
+{
+  struct optim_args opt_args;
+  opt_args.learning_rate = learning_rate;
+
+  for (int k=0; k<args->num_layers; k++) {
+    struct net_layer * layer = &args->layers[k];
+    if (layer->coeff != NULL && layer->trainable) {
+      // Weights, unless only the bias and/or the adapter are trained
+      opt_args.weights = layer->coeff;
+      if (!layer->skip_wgt_grad && layer->update_rows != NULL) {
+        // One row of weights per output channel
+        opt_args.update_rows = layer->update_rows;
+        opt_args.num_update_rows = layer->num_update_rows;
+        opt_args.row_size = layer->coeff->dim / layer->output->C;
+        pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_fp32_sparse, &opt_args);
+      }
+      else if (!layer->skip_wgt_grad) {
+        pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_fp32, &opt_args);
+      }
+
+      if (layer->bias != NULL) {
+        opt_args.weights = layer->bias;
+        pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_fp32, &opt_args);
+      }
+      if (layer->lora_A != NULL) {
+        opt_args.weights = layer->lora_A;
+        pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_fp32, &opt_args);
+        opt_args.weights = layer->lora_B;
+        pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_fp32, &opt_args);
+      }
+    }
+  }
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_bf16.h"
+#include "pulp_optimizers_bf16.h"
+
+
+void pulp_gradient_descent_bf16 (void * optim_args_bf16)
+{
+  struct optim_args_bf16 * args = (struct optim_args_bf16 *) optim_args_bf16;
+  bf16 * __restrict__ weights = args->weights->data;
+  bf16 * __restrict__ weight_grad = args->weights->diff;
+  float * __restrict__ master = args->master;
+  const int wgt_size = args->weights->dim;
+  const float lr = args->learning_rate;
+
+  int blockSize = (wgt_size+NUM_CORES-1) / NUM_CORES;
+  int start = pi_core_id()*blockSize;
+  int stop = start+blockSize > wgt_size ? wgt_size : start+blockSize;
+
+  if (master != NULL) {
+    for (int i=start; i<stop; i++) {
+      float w = master[i] - lr * bf16_to_fp32(weight_grad[i]);
+      master[i] = w;
+      weights[i] = fp32_to_bf16(w);
+    }
+  }
+  else {
+    for (int i=start; i<stop; i++) {
+      weights[i] = fp32_to_bf16(bf16_to_fp32(weights[i]) - lr * bf16_to_fp32(weight_grad[i]));
+    }
+  }
+}
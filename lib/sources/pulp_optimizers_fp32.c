@@ -54,3 +54,27 @@ void pulp_gradient_descent_fp32 (void * optim_args)
     printf("\n\n");
     #endif
 }
+
+
+void pulp_gradient_descent_fp32_sparse (void * optim_args) 
+{
+    struct optim_args * args = (struct optim_args *) optim_args;
+    float * __restrict__ weights = args->weights->data; 
+    float * __restrict__ weight_grad = args->weights->diff;
+    int * rows = args->update_rows;
+    const int row_size = args->row_size;
+    const int grad_size = args->num_update_rows * row_size; 
+    float lr = args->learning_rate;
+
+    int blockSize = (grad_size+NUM_CORES-1) / NUM_CORES;
+    int start = pi_core_id()*blockSize;
+    int stop = start+blockSize > grad_size ? grad_size : start+blockSize;
+
+    int r = start / row_size;
+    int j = start - r*row_size;
+    for (int i=start; i<stop; i++) 
+    {   
+        weights[rows[r]*row_size + j] -= lr * weight_grad[i];
+        if (++j == row_size) { j = 0; r++; }
+    }    
+}
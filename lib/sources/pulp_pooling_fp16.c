@@ -35,33 +35,43 @@ void pulp_avgpool_fp16_fw_cl(void * pool_args_fp16) {
   uint16_t Wker = args->Wker;
   uint16_t Hstr = args->Hstride;
   uint16_t Wstr = args->Wstride;
+  int Lpad = args->Lpad;
+  int Upad = args->Upad;
+  int HWC = args->HWC;
 
   // Internal variables
-  uint32_t Hact = (H-Hker+Hstr)/Hstr; //H / Hker;
-  uint32_t Wact = (W-Wker+Hstr)/Wstr; //W / Wker;
+  uint32_t Hact = (H+Upad+args->Dpad-Hker+Hstr)/Hstr;
+  uint32_t Wact = (W+Lpad+args->Rpad-Wker+Wstr)/Wstr;
   if (Hact!=Ho || Wact!=Wo)   {printf("\n[pulp_avgpool_fp16_fw_cl] Invalid pooling kernel size or output size!\n"); return;}
-  int HW = H*W;
-  int HWk = Hker*Wker;
-  int HWo = Ho*Wo;
+  fp16 HWk = Hker*Wker;
 
-  const int blockSize = (C+NUM_CORES-1) / NUM_CORES;
+  // Strides of channels, rows and columns (CHW or HWC)
+  int in_c = HWC ? 1 : H*W;     int in_h = HWC ? W*C : W;     int in_w = HWC ? C : 1;
+  int out_c = HWC ? 1 : Ho*Wo;  int out_h = HWC ? Wo*C : Wo;  int out_w = HWC ? C : 1;
+
+  // Parallelize over the output rows of all the channels
+  const int blockSize = (C*Ho+NUM_CORES-1) / NUM_CORES;
   const int start = pi_core_id()*blockSize;
-  const int stop = start+blockSize > C ? C : start+blockSize;
+  const int stop = start+blockSize > C*Ho ? C*Ho : start+blockSize;
 
-  for (int k=start; k<stop; k++) {
-    for (int ha=0; ha<Hact; ha++) {
-      for (int wa=0; wa<Wact; wa++) {
-        fp16 avgpool = 0;
-        for (int hk=0; hk<Hker; hk++) {
-          for (int wk=0; wk<Wker; wk++) {
-            uint32_t  in_idx = wk + wa*Wstr + (hk + ha*Hstr)*W + k*HW;
-            avgpool += inData[in_idx];
-          }
+  for (int row=start; row<stop; row++) {
+    int k = row / Ho;
+    int ha = row % Ho;
+    // Window rows inside the input (the padding counts as zeros)
+    int h0 = ha*Hstr - Upad;
+    int hk_start = h0 < 0 ? -h0 : 0;
+    int hk_stop = h0+Hker > H ? H-h0 : Hker;
+    for (int wa=0; wa<Wact; wa++) {
+      int w0 = wa*Wstr - Lpad;
+      int wk_start = w0 < 0 ? -w0 : 0;
+      int wk_stop = w0+Wker > W ? W-w0 : Wker;
+      fp16 avgpool = 0;
+      for (int hk=hk_start; hk<hk_stop; hk++) {
+        for (int wk=wk_start; wk<wk_stop; wk++) {
+          avgpool += inData[(w0+wk)*in_w + (h0+hk)*in_h + k*in_c];
         }
-        avgpool = avgpool / HWk;
-        uint32_t out_idx = wa + ha*Wo + k*HWo;
-        outData[out_idx] = avgpool;
       }
+      outData[wa*out_w + ha*out_h + k*out_c] = avgpool / HWk;
     }
   }
 }
@@ -80,38 +90,43 @@ void pulp_avgpool_fp16_bw_cl(void * pool_args_fp16){
   uint16_t Wker = args->Wker;
   uint16_t Hstr = args->Hstride;
   uint16_t Wstr = args->Wstride;
+  int Lpad = args->Lpad;
+  int Upad = args->Upad;
+  int HWC = args->HWC;
 
   // Internal variables
-  uint32_t Hact = (H-Hker+Hstr)/Hstr; //H / Hker;
-  uint32_t Wact = (W-Wker+Hstr)/Wstr; //W / Wker;
+  uint32_t Hact = (H+Upad+args->Dpad-Hker+Hstr)/Hstr;
+  uint32_t Wact = (W+Lpad+args->Rpad-Wker+Wstr)/Wstr;
   if (Hact!=Ho || Wact!=Wo)   {printf("\n[pulp_avgpool_fp16_bw_cl] Invalid pooling kernel size or output size!\n"); return;}
-  int HW = H*W;
-  int HWk = Hker*Wker;
-  int HWo = Ho*Wo;
+  fp16 HWk = Hker*Wker;
 
-  const int blockSize = (C+NUM_CORES-1) / NUM_CORES;
-  const int start = pi_core_id()*blockSize;
-  const int stop = start+blockSize > C ? C : start+blockSize;
+  // Strides of channels, rows and columns (CHW or HWC)
+  int in_c = HWC ? 1 : H*W;     int in_h = HWC ? W*C : W;     int in_w = HWC ? C : 1;
+  int out_c = HWC ? 1 : Ho*Wo;  int out_h = HWC ? Wo*C : Wo;  int out_w = HWC ? C : 1;
 
-  // Initialize gradient
-  for (int k=start; k<stop; k++) {
-    for (int hw=0; hw<HW; hw++) {
-      inDiff[k*HW+hw] = 0;
-    }
-  }
+  // Parallelize over the input rows of all the channels, gathering from the windows that cover each input
+  const int blockSize = (C*H+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > C*H ? C*H : start+blockSize;
 
-  // Compute input gradient
-  for (int k=start; k<stop; k++) {
-    for (int ho=0; ho<Ho; ho++) {
-      for (int wo=0; wo<Wo; wo++) {
-        for (int hact=0; hact<Hker; hact++) {
-          for (int wact=0; wact<Wker; wact++) {
-            int in_idx = (wact+wo*Wstr) + (hact+ho*Hstr)*W + k*HW;
-            int out_idx = wo + ho*Wo + k*HWo;
-            inDiff[in_idx] += outDiff[out_idx] / HWk;
-          }
+  for (int row=start; row<stop; row++) {
+    int k = row / H;
+    int h = row % H;
+    // Output rows whose window contains h
+    int hp = h + Upad;
+    int ho_start = hp-Hker+1 <= 0 ? 0 : (hp-Hker+Hstr)/Hstr;
+    int ho_stop = hp/Hstr+1 > Ho ? Ho : hp/Hstr+1;
+    for (int w=0; w<W; w++) {
+      int wp = w + Lpad;
+      int wo_start = wp-Wker+1 <= 0 ? 0 : (wp-Wker+Wstr)/Wstr;
+      int wo_stop = wp/Wstr+1 > Wo ? Wo : wp/Wstr+1;
+      fp16 grad = 0;
+      for (int ho=ho_start; ho<ho_stop; ho++) {
+        for (int wo=wo_start; wo<wo_stop; wo++) {
+          grad += outDiff[wo*out_w + ho*out_h + k*out_c];
         }
       }
+      inDiff[w*in_w + h*in_h + k*in_c] = grad / HWk;
     }
   }
 }
@@ -125,6 +140,7 @@ void pulp_maxpool_fp16_fw_cl(void * pool_args_fp16) {
   struct pool_args_fp16 * args = (struct pool_args_fp16 *) pool_args_fp16;
   fp16 * inData = args->input->data;
   fp16 * outData = args->output->data;
+  uint8_t * argmax = args->argmax;
   uint16_t W = args->input->W;
   uint16_t H = args->input->H;
   uint16_t C = args->input->C;
@@ -134,33 +150,48 @@ void pulp_maxpool_fp16_fw_cl(void * pool_args_fp16) {
   uint16_t Wker = args->Wker;
   uint16_t Hstr = args->Hstride;
   uint16_t Wstr = args->Wstride;
+  int Lpad = args->Lpad;
+  int Upad = args->Upad;
+  int HWC = args->HWC;
 
   // Internal variables
-  uint32_t Hact = (H-Hker+Hstr)/Hstr; //H / Hker;
-  uint32_t Wact = (W-Wker+Hstr)/Wstr; //W / Wker;
+  uint32_t Hact = (H+Upad+args->Dpad-Hker+Hstr)/Hstr;
+  uint32_t Wact = (W+Lpad+args->Rpad-Wker+Wstr)/Wstr;
   if (Hact!=Ho || Wact!=Wo)   {printf("\n[pulp_maxpool_fp16_fw_cl] Invalid pooling kernel size or output size!\n"); return;}
-  int HW = H*W;
-  int HWk = Hker*Wker;
-  int HWo = Ho*Wo;
+  if (argmax != NULL && Hker*Wker > 256)   {printf("\n[pulp_maxpool_fp16_fw_cl] Pooling window too large for uint8_t argmax!\n"); return;}
 
-  const int blockSize = (C+NUM_CORES-1) / NUM_CORES;
+  // Strides of channels, rows and columns (CHW or HWC)
+  int in_c = HWC ? 1 : H*W;     int in_h = HWC ? W*C : W;     int in_w = HWC ? C : 1;
+  int out_c = HWC ? 1 : Ho*Wo;  int out_h = HWC ? Wo*C : Wo;  int out_w = HWC ? C : 1;
+
+  // Parallelize over the output rows of all the channels
+  const int blockSize = (C*Ho+NUM_CORES-1) / NUM_CORES;
   const int start = pi_core_id()*blockSize;
-  const int stop = start+blockSize > C ? C : start+blockSize;
+  const int stop = start+blockSize > C*Ho ? C*Ho : start+blockSize;
 
-  for (int k=start; k<stop; k++) {
-    for (int ha=0; ha<Hact; ha++) {
-      for (int wa=0; wa<Wact; wa++) {
-        fp16 maxpool = inData[wa*Wstr + ha*Hstr*W + k*HW];
-        for (int hk=0; hk<Hker; hk++) {
-          for (int wk=0; wk<Wker; wk++) {
-            uint32_t  in_idx = wk + wa*Wstr + (hk + ha*Hstr)*W + k*HW;
-            fp16 newData = inData[in_idx];
-            if (newData > maxpool)  {maxpool = newData;}
-          }
+  for (int row=start; row<stop; row++) {
+    int k = row / Ho;
+    int ha = row % Ho;
+    // Window rows inside the input (the padding is ignored)
+    int h0 = ha*Hstr - Upad;
+    int hk_start = h0 < 0 ? -h0 : 0;
+    int hk_stop = h0+Hker > H ? H-h0 : Hker;
+    for (int wa=0; wa<Wact; wa++) {
+      int w0 = wa*Wstr - Lpad;
+      int wk_start = w0 < 0 ? -w0 : 0;
+      int wk_stop = w0+Wker > W ? W-w0 : Wker;
+      int win_idx = w0*in_w + h0*in_h + k*in_c;
+      fp16 maxpool = inData[win_idx + wk_start*in_w + hk_start*in_h];
+      uint8_t maxidx = wk_start + hk_start*Wker;
+      for (int hk=hk_start; hk<hk_stop; hk++) {
+        for (int wk=wk_start; wk<wk_stop; wk++) {
+          fp16 newData = inData[win_idx + wk*in_w + hk*in_h];
+          if (newData > maxpool)  {maxpool = newData; maxidx = wk + hk*Wker;}
         }
-        uint32_t out_idx = wa + ha*Wo + k*HWo;
-        outData[out_idx] = maxpool;
       }
+      uint32_t out_idx = wa*out_w + ha*out_h + k*out_c;
+      outData[out_idx] = maxpool;
+      if (argmax != NULL)   argmax[out_idx] = maxidx;
     }
   }
 }
@@ -171,6 +202,7 @@ void pulp_maxpool_fp16_bw_cl(void * pool_args_fp16){
   fp16 * inData = args->input->data;
   fp16 * inDiff = args->input->diff;
   fp16 * outDiff = args->output->diff;
+  uint8_t * argmax = args->argmax;
   uint16_t W = args->input->W;
   uint16_t H = args->input->H;
   uint16_t C = args->input->C;
@@ -180,59 +212,170 @@ void pulp_maxpool_fp16_bw_cl(void * pool_args_fp16){
   uint16_t Wker = args->Wker;
   uint16_t Hstr = args->Hstride;
   uint16_t Wstr = args->Wstride;
+  int Lpad = args->Lpad;
+  int Upad = args->Upad;
+  int HWC = args->HWC;
 
   // Internal variables
-  uint32_t Hact = (H-Hker+Hstr)/Hstr;
-  uint32_t Wact = (W-Wker+Hstr)/Wstr;
+  uint32_t Hact = (H+Upad+args->Dpad-Hker+Hstr)/Hstr;
+  uint32_t Wact = (W+Lpad+args->Rpad-Wker+Wstr)/Wstr;
   if (Hact!=Ho || Wact!=Wo)   {printf("\n[pulp_maxpool_fp16_bw_cl] Invalid pooling kernel size or output size!\n"); return;}
-  int HW = H*W;
-  int HWk = Hker*Wker;
-  int HWo = Ho*Wo;
 
+  // Strides of channels, rows and columns (CHW or HWC)
+  int in_c = HWC ? 1 : H*W;     int in_h = HWC ? W*C : W;     int in_w = HWC ? C : 1;
+  int out_c = HWC ? 1 : Ho*Wo;  int out_h = HWC ? Wo*C : Wo;  int out_w = HWC ? C : 1;
+
+  // Stored indices: parallelize over the input rows of all the channels, gathering from the windows that selected each input
+  if (argmax != NULL) {
+    const int blockSize = (C*H+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > C*H ? C*H : start+blockSize;
+
+    for (int row=start; row<stop; row++) {
+      int k = row / H;
+      int h = row % H;
+      // Output rows whose window contains h
+      int hp = h + Upad;
+      int ho_start = hp-Hker+1 <= 0 ? 0 : (hp-Hker+Hstr)/Hstr;
+      int ho_stop = hp/Hstr+1 > Ho ? Ho : hp/Hstr+1;
+      for (int w=0; w<W; w++) {
+        int wp = w + Lpad;
+        int wo_start = wp-Wker+1 <= 0 ? 0 : (wp-Wker+Wstr)/Wstr;
+        int wo_stop = wp/Wstr+1 > Wo ? Wo : wp/Wstr+1;
+        fp16 grad = 0;
+        for (int ho=ho_start; ho<ho_stop; ho++) {
+          for (int wo=wo_start; wo<wo_stop; wo++) {
+            uint32_t out_idx = wo*out_w + ho*out_h + k*out_c;
+            if (argmax[out_idx] == (wp-wo*Wstr) + (hp-ho*Hstr)*Wker)  grad += outDiff[out_idx];
+          }
+        }
+        inDiff[w*in_w + h*in_h + k*in_c] = grad;
+      }
+    }
+    return;
+  }
+
+  // Search the maximum again: parallelize over the channels, so that overlapping windows do not race
   const int blockSize = (C+NUM_CORES-1) / NUM_CORES;
   const int start = pi_core_id()*blockSize;
   const int stop = start+blockSize > C ? C : start+blockSize;
 
-  // Initialize gradient and mask
+  // Initialize gradient
   for (int k=start; k<stop; k++) {
-    for (int hw=0; hw<HW; hw++) {
-      inDiff[k*HW+hw] = 0;
+    for (int h=0; h<H; h++) {
+      for (int w=0; w<W; w++) {
+        inDiff[w*in_w + h*in_h + k*in_c] = 0;
+      }
     }
   }
 
-  // Mask for the update
-  uint8_t maxmask[HWk];
-  uint32_t maxidx = 0;
-
   // Compute input gradient
   for (int k=start; k<stop; k++) {
     for (int ho=0; ho<Ho; ho++) {
+      int h0 = ho*Hstr - Upad;
+      int hk_start = h0 < 0 ? -h0 : 0;
+      int hk_stop = h0+Hker > H ? H-h0 : Hker;
       for (int wo=0; wo<Wo; wo++) {
-        // Create local mask
-        fp16 max = inData[wo*Wstr + ho*Hstr*W + k*HW];
-        maxidx = 0;
-        // Find maximum location and set mask
-        for (int hact=0; hact<Hker; hact++) {
-          for (int wact=0; wact<Wker; wact++) {
-            maxmask[wact+hact*Wker] = 0;
-            uint32_t  in_idx = wact + wo*Wstr + (hact + ho*Hstr)*W + k*HW;
-            fp16 newData = inData[in_idx];
+        int w0 = wo*Wstr - Lpad;
+        int wk_start = w0 < 0 ? -w0 : 0;
+        int wk_stop = w0+Wker > W ? W-w0 : Wker;
+        int win_idx = w0*in_w + h0*in_h + k*in_c;
+        // Find maximum location
+        uint32_t maxidx = win_idx + wk_start*in_w + hk_start*in_h;
+        fp16 max = inData[maxidx];
+        for (int hact=hk_start; hact<hk_stop; hact++) {
+          for (int wact=wk_start; wact<wk_stop; wact++) {
+            fp16 newData = inData[win_idx + wact*in_w + hact*in_h];
             if (newData > max)  {
               max = newData;
-              maxidx = wact + hact*Wker;
+              maxidx = win_idx + wact*in_w + hact*in_h;
             }          
           }
-        }        
-        maxmask[maxidx] = 1;
-        // Update gradients
-        for (int hact=0; hact<Hker; hact++) {
-          for (int wact=0; wact<Wker; wact++) {
-            int in_idx = (wact+wo*Wstr) + (hact+ho*Hstr)*W + k*HW;
-            int out_idx = wo + ho*Wo + k*HWo;
-            inDiff[in_idx] += maxmask[wact+hact*Wker]*outDiff[out_idx];
-          }
         }
+        // Update gradient
+        inDiff[maxidx] += outDiff[wo*out_w + ho*out_h + k*out_c];
       }
     }
   }
-}
\ No newline at end of file
+}
+
+
+
+
+
+void pulp_global_avgpool_fp16_fw_cl(void * pool_args_fp16) {
+
+  struct pool_args_fp16 * args = (struct pool_args_fp16 *) pool_args_fp16;
+  fp16 * inData = args->input->data;
+  fp16 * outData = args->output->data;
+  int W = args->input->W;
+  int H = args->input->H;
+  int C = args->input->C;
+  int HWC = args->HWC;
+
+  int HW = H*W;
+  fp16 scale = (fp16) (1.0f / HW);
+  // Strides of channels and spatial positions (CHW or HWC)
+  int in_c = HWC ? 1 : HW;
+  int in_p = HWC ? C : 1;
+
+  if (C >= NUM_CORES) {
+    // Parallelize over the channels
+    const int blockSize = (C+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > C ? C : start+blockSize;
+
+    for (int k=start; k<stop; k++) {
+      fp16 sum = 0;
+      for (int p=0; p<HW; p++)  sum += inData[p*in_p + k*in_c];
+      outData[k] = sum * scale;
+    }
+  }
+  else {
+    // Too few channels: parallelize over the spatial positions and reduce the partial sums
+    const int blockSize = (HW+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > HW ? HW : start+blockSize;
+
+    fp16 partial[C];
+    for (int k=0; k<C; k++)   partial[k] = 0;
+    for (int p=start; p<stop; p++) {
+      for (int k=0; k<C; k++)   partial[k] += inData[p*in_p + k*in_c];
+    }
+
+    if (pi_core_id() == 0) {
+      for (int k=0; k<C; k++)   outData[k] = 0;
+    }
+    pi_cl_team_barrier();
+
+    pi_cl_team_critical_enter();
+    for (int k=0; k<C; k++)   outData[k] += partial[k] * scale;
+    pi_cl_team_critical_exit();
+  }
+}
+
+void pulp_global_avgpool_fp16_bw_cl(void * pool_args_fp16) {
+
+  struct pool_args_fp16 * args = (struct pool_args_fp16 *) pool_args_fp16;
+  fp16 * inDiff = args->input->diff;
+  fp16 * outDiff = args->output->diff;
+  int W = args->input->W;
+  int H = args->input->H;
+  int C = args->input->C;
+  int HWC = args->HWC;
+
+  int HW = H*W;
+  fp16 scale = (fp16) (1.0f / HW);
+
+  // Parallelize over the whole input
+  const int blockSize = (C*HW+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > C*HW ? C*HW : start+blockSize;
+
+  if (HWC) {
+    for (int i=start; i<stop; i++)  inDiff[i] = outDiff[i%C] * scale;
+  }
+  else {
+    for (int i=start; i<stop; i++)  inDiff[i] = outDiff[i/HW] * scale;
+  }
+}
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_fp32.h"
+#include "pulp_replay_fp32.h"
+
+#define REPLAY_READ   1
+#define REPLAY_WRITE  2
+
+
+static inline int record_bytes( struct replay_args * args )
+{
+  return REPLAY_RECORD_BYTES(args->act_size, args->label_size, args->format);
+}
+
+static inline int packed_bytes( struct replay_args * args )
+{
+  return record_bytes(args) - 4 - 4*args->label_size;
+}
+
+static inline void replay_dma( struct replay_args * args, pi_cl_dma_copy_t * cmd, int dir, int record, uint8_t * stage )
+{
+  cmd->dir = dir;
+  cmd->merge = 0;
+  cmd->size = record_bytes(args);
+  cmd->id = 0;
+  cmd->ext = (uint32_t) (args->storage + record * record_bytes(args));
+  cmd->loc = (uint32_t) stage;
+  pi_cl_dma_memcpy(cmd);
+}
+
+// Starts loading a random record in the free staging record
+static inline void replay_load( struct replay_args * args )
+{
+  // A record being stored could be the one to be read
+  if (args->pending & REPLAY_WRITE) { pi_cl_dma_wait(&args->dma_write); args->pending &= ~REPLAY_WRITE; }
+
+  args->next_record = xorshift32(&args->seed) % args->count;
+  replay_dma(args, &args->dma_read, PI_CL_DMA_DIR_EXT2LOC, args->next_record, args->l1_buffer + args->slot * record_bytes(args));
+  args->pending |= REPLAY_READ;
+}
+
+// Returns the record to be overwritten by a new sample, -1 to discard it
+static int replay_select( struct replay_args * args, int class )
+{
+  args->seen++;
+
+  if (args->policy == REPLAY_RESERVOIR) {
+    if (args->count < args->capacity) return args->count++;
+    int j = xorshift32(&args->seed) % args->seen;
+    return j < args->capacity ? j : -1;
+  }
+
+  // Class-balanced: the largest class gives up a random record
+  int * stored = args->class_count;
+  int * seen = args->class_count + args->num_classes;
+  seen[class]++;
+
+  if (args->count < args->capacity) {
+    args->classes[args->count] = class;
+    stored[class]++;
+    return args->count++;
+  }
+
+  int largest = 0;
+  for (int c=1; c<args->num_classes; c++)
+    if (stored[c] > stored[largest]) largest = c;
+
+  int victim = largest;
+  if (stored[class] >= stored[largest]) {
+    // The class already has its share: reservoir sampling among its own samples
+    if ((int) (xorshift32(&args->seed) % seen[class]) >= stored[class]) return -1;
+    victim = class;
+  }
+
+  int k = xorshift32(&args->seed) % stored[victim];
+  for (int r=0; r<args->capacity; r++) {
+    if (args->classes[r] == victim && k-- == 0) {
+      stored[victim]--;
+      stored[class]++;
+      args->classes[r] = class;
+      return r;
+    }
+  }
+  return -1;
+}
+
+
+
+void pulp_replay_init( struct replay_args * args )
+{
+  args->count = 0;
+  args->seen = 0;
+  args->slot = 0;
+  args->pending = 0;
+  args->next_record = -1;
+  if (args->policy == REPLAY_CLASS_BALANCED)
+    for (int c=0; c<2*args->num_classes; c++) args->class_count[c] = 0;
+}
+
+int pulp_replay_add( struct replay_args * args, float * activation, float * label, int class )
+{
+  int record = replay_select(args, class);
+  if (record < 0) return -1;
+
+  // The staging record for insertions is free once the previous store is done
+  uint8_t * stage = args->l1_buffer + 2 * record_bytes(args);
+  if (args->pending & REPLAY_WRITE) { pi_cl_dma_wait(&args->dma_write); args->pending &= ~REPLAY_WRITE; }
+  // Do not overwrite a record while it is being read
+  if (args->pending & REPLAY_READ) { pi_cl_dma_wait(&args->dma_read); args->pending &= ~REPLAY_READ; }
+
+  struct replay_pack_args pack_args;
+  pack_args.data = activation;
+  pack_args.packed = stage;
+  pack_args.partial = args->partial;
+  pack_args.size = args->act_size;
+  pack_args.scale = 1.0f;
+
+  if (args->format == REPLAY_INT8) {
+    pi_cl_team_fork(NUM_CORES, pulp_replay_absmax, &pack_args);
+    float max = 0;
+    for (int i=0; i<NUM_CORES; i++) if (args->partial[i] > max) max = args->partial[i];
+    pack_args.scale = max > 0 ? max / 127.0f : 1.0f;
+    pi_cl_team_fork(NUM_CORES, pulp_replay_pack_int8, &pack_args);
+  }
+  else {
+    pi_cl_team_fork(NUM_CORES, pulp_replay_pack_fp16, &pack_args);
+  }
+
+  float * tail = (float *) (stage + packed_bytes(args));
+  tail[0] = pack_args.scale;
+  for (int i=0; i<args->label_size; i++) tail[1+i] = label[i];
+
+  replay_dma(args, &args->dma_write, PI_CL_DMA_DIR_LOC2EXT, record, stage);
+  args->pending |= REPLAY_WRITE;
+
+  return record;
+}
+
+int pulp_replay_next( struct replay_args * args )
+{
+  if (args->count == 0) {
+    printf("[pulp_replay_next]: Replay buffer is empty!!\n");
+    return -1;
+  }
+
+  if (args->next_record < 0) replay_load(args);
+  if (args->pending & REPLAY_READ) { pi_cl_dma_wait(&args->dma_read); args->pending &= ~REPLAY_READ; }
+
+  uint8_t * stage = args->l1_buffer + args->slot * record_bytes(args);
+  int record = args->next_record;
+
+  // Load the next replayed sample while this one is used
+  args->slot ^= 1;
+  replay_load(args);
+
+  float * tail = (float *) (stage + packed_bytes(args));
+  args->label = tail + 1;
+
+  struct replay_pack_args pack_args;
+  pack_args.data = args->output->data;
+  pack_args.packed = stage;
+  pack_args.scale = tail[0];
+  pack_args.partial = args->partial;
+  pack_args.size = args->act_size;
+
+  if (args->format == REPLAY_INT8)
+    pi_cl_team_fork(NUM_CORES, pulp_replay_unpack_int8, &pack_args);
+  else
+    pi_cl_team_fork(NUM_CORES, pulp_replay_unpack_fp16, &pack_args);
+
+  return record;
+}
+
+
+
+// COMPRESSION KERNELS
+
+void pulp_replay_pack_fp16( void * void_args )
+{
+  struct replay_pack_args * args = (struct replay_pack_args *) void_args;
+  float * data = args->data;
+  fp16 * packed = (fp16 *) args->packed;
+  int size = args->size;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  for (int i=start; i<stop; i++)
+    packed[i] = (fp16) data[i];
+}
+
+void pulp_replay_unpack_fp16( void * void_args )
+{
+  struct replay_pack_args * args = (struct replay_pack_args *) void_args;
+  float * data = args->data;
+  fp16 * packed = (fp16 *) args->packed;
+  int size = args->size;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  for (int i=start; i<stop; i++)
+    data[i] = (float) packed[i];
+}
+
+void pulp_replay_absmax( void * void_args )
+{
+  struct replay_pack_args * args = (struct replay_pack_args *) void_args;
+  float * data = args->data;
+  int size = args->size;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  float max = 0;
+  for (int i=start; i<stop; i++) {
+    float val = data[i] > 0 ? data[i] : -data[i];
+    if (val > max) max = val;
+  }
+  args->partial[pi_core_id()] = max;
+}
+
+void pulp_replay_pack_int8( void * void_args )
+{
+  struct replay_pack_args * args = (struct replay_pack_args *) void_args;
+  float * data = args->data;
+  int8_t * packed = (int8_t *) args->packed;
+  float inv_scale = 1.0f / args->scale;
+  int size = args->size;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  for (int i=start; i<stop; i++) {
+    float val = data[i] * inv_scale;
+    int q = (int) (val >= 0 ? val + 0.5f : val - 0.5f);
+    if (q > 127)  q = 127;
+    if (q < -127) q = -127;
+    packed[i] = (int8_t) q;
+  }
+}
+
+void pulp_replay_unpack_int8( void * void_args )
+{
+  struct replay_pack_args * args = (struct replay_pack_args *) void_args;
+  float * data = args->data;
+  int8_t * packed = (int8_t *) args->packed;
+  float scale = args->scale;
+  int size = args->size;
+
+  const int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+  const int start = pi_core_id()*blockSize;
+  const int stop = start+blockSize > size ? size : start+blockSize;
+
+  for (int i=start; i<stop; i++)
+    data[i] = scale * (float) packed[i];
+}
@@ -28,21 +28,21 @@
 void pulp_sumnode_fp32_fw( void * SkipConn_args )
 {
     struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
-    struct blob act0 = args->activation0;
-    struct blob act1 = args->activation1;
-    struct blob out = args->activation2;
+    struct blob * act0 = args->activation0;
+    struct blob * act1 = args->activation1;
+    struct blob * out = args->activation2;
 
-    if (act0.dim != act1.dim || act1.dim != out.dim) {
+    if (act0->dim != act1->dim || act1->dim != out->dim) {
         printf("[pulp_sumnode_fp32_fw]: Sizes of input and output activations not matching!!"); return;
     }
 
-    struct vect_sum_args args;
-    args.op_1 = act0.data;
-    args.op_2 = act1.data;
-    args.dest = out.data;
-    args.size = out.dim;
+    struct vect_sum_args sum_args;
+    sum_args.op_1 = act0->data;
+    sum_args.op_2 = act1->data;
+    sum_args.dest = out->data;
+    sum_args.size = out->dim;
 
-    pi_cl_team_fork(NUM_CORES, vect_sum, &args);
+    pi_cl_team_fork(NUM_CORES, vect_sum, &sum_args);
 }
 
 
@@ -50,21 +50,48 @@ void pulp_sumnode_fp32_fw( void * SkipConn_args )
 void pulp_residualconn_fp32_fw( void * SkipConn_args )
 {
     struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
-    struct blob act0 = args->activation0;
-    struct blob act1 = args->activation1;
-    struct blob out = args->activation2;
+    struct blob * act0 = args->activation0;
+    struct blob * act1 = args->activation1;
+    struct blob * out = args->activation2;
 
-    if (act0.dim != act1.dim || act1.dim != out.dim) {
+    if (act0->dim != act1->dim || act1->dim != out->dim) {
         printf("[pulp_residualconn_fp32_fw]: Sizes of input and output activations not matching!!"); return;
     }
 
-    struct vect_sum_args args;
-    args.op_1 = act0.data;
-    args.op_2 = act1.data;
-    args.dest = out.data;
-    args.size = out.dim;
+    struct vect_sum_args sum_args;
+    sum_args.op_1 = act0->data;
+    sum_args.op_2 = act1->data;
+    sum_args.dest = out->data;
+    sum_args.size = out->dim;
 
-    pi_cl_team_fork(NUM_CORES, vect_sum, &args);
+    pi_cl_team_fork(NUM_CORES, vect_sum, &sum_args);
+}
+
+
+
+
+void pulp_residualconn_relu_fp32_fw( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+
+    if (args->activation0->dim != args->activation1->dim || args->activation1->dim != args->activation2->dim) {
+        printf("[pulp_residualconn_relu_fp32_fw]: Sizes of input and output activations not matching!!"); return;
+    }
+
+    pi_cl_team_fork(NUM_CORES, residualconn_relu_fp32_fw_kernel, args);
+}
+
+
+
+void pulp_residualconn_scale_fp32_fw( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+
+    if (args->activation0->dim != args->activation1->dim || args->activation1->dim != args->activation2->dim) {
+        printf("[pulp_residualconn_scale_fp32_fw]: Sizes of input and output activations not matching!!"); return;
+    }
+
+    pi_cl_team_fork(NUM_CORES, residualconn_scale_fp32_fw_kernel, args);
 }
 
 
@@ -76,21 +103,22 @@ void pulp_residualconn_fp32_fw( void * SkipConn_args )
 void pulp_sumnode_fp32_bw( void * SkipConn_args )
 {
     struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
-    struct blob act0 = args->activation0;
-    struct blob act1 = args->activation1;
-    struct blob indiff = args->activation2;
+    struct blob * act0 = args->activation0;
+    struct blob * act1 = args->activation1;
+    struct blob * indiff = args->activation2;
     
-    if (act0.dim != act1.dim || act1.dim != indiff.dim) {
+    if (act0->dim != act1->dim || act1->dim != indiff->dim) {
         printf("[pulp_sumnode_fp32_bw]: Sizes of input and output gradients not matching!!"); return;
     }
 
-    struct vect_sum_args args;
-    args.op_1 = act0.diff;
-    args.op_2 = act1.diff;
-    args.dest = indiff.diff;
-    args.size = indiff.dim;
+    // Element-wise, so indiff can alias one of the two gradients (in-place accumulation)
+    struct vect_sum_args sum_args;
+    sum_args.op_1 = act0->diff;
+    sum_args.op_2 = act1->diff;
+    sum_args.dest = indiff->diff;
+    sum_args.size = indiff->dim;
 
-    pi_cl_team_fork(NUM_CORES, vect_sum, &args);
+    pi_cl_team_fork(NUM_CORES, vect_sum, &sum_args);
 }
 
 
@@ -98,20 +126,163 @@ void pulp_sumnode_fp32_bw( void * SkipConn_args )
 void pulp_residualconn_fp32_bw( void * SkipConn_args )
 {
     struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
-    struct blob act0 = args->activation0;
-    struct blob act1 = args->activation1;
-    struct blob outdiff = args->activation2;
+    struct blob * act0 = args->activation0;
+    struct blob * act1 = args->activation1;
+    struct blob * outdiff = args->activation2;
     
-    if (act0.dim != act1.dim || act1.dim != outdiff.dim) {
+    if (act0->dim != act1->dim || act1->dim != outdiff->dim) {
         printf("[pulp_residualconn_fp32_bw]: Sizes of input and output gradients not matching!!"); return;
     }
 
-    // Copy gradient into the input
-    struct copy_args cpy_args;
-    cpy_args.from = outdiff.diff;
-    cpy_args.to = act0.diff;
-    cpy_args.size = outdiff.dim;
-    pi_cl_team_fork(NUM_CORES, copy, &cpy_args);
-    cpy_args.to = act1.diff;
-    pi_cl_team_fork(NUM_CORES, copy, &cpy_args);
+    // Branches aliasing the output gradient do not need any copy
+    int copy0 = (act0->diff != outdiff->diff);
+    int copy1 = (act1->diff != outdiff->diff);
+
+    if (copy0 && copy1) {
+        // Dispatch the gradient to both branches with a single pass
+        pi_cl_team_fork(NUM_CORES, residualconn_fp32_bw_kernel, args);
+    }
+    else if (copy0 || copy1) {
+        struct copy_args cpy_args;
+        cpy_args.from = outdiff->diff;
+        cpy_args.to = copy0 ? act0->diff : act1->diff;
+        cpy_args.size = outdiff->dim;
+        pi_cl_team_fork(NUM_CORES, copy, &cpy_args);
+    }
+}
+
+
+
+
+void pulp_residualconn_relu_fp32_bw( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+
+    if (args->activation0->dim != args->activation1->dim || args->activation1->dim != args->activation2->dim) {
+        printf("[pulp_residualconn_relu_fp32_bw]: Sizes of input and output gradients not matching!!"); return;
+    }
+
+    pi_cl_team_fork(NUM_CORES, residualconn_relu_fp32_bw_kernel, args);
+}
+
+
+
+void pulp_residualconn_scale_fp32_bw( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+
+    if (args->activation0->dim != args->activation1->dim || args->activation1->dim != args->activation2->dim) {
+        printf("[pulp_residualconn_scale_fp32_bw]: Sizes of input and output gradients not matching!!"); return;
+    }
+
+    pi_cl_team_fork(NUM_CORES, residualconn_scale_fp32_bw_kernel, args);
+}
+
+
+
+
+
+// PARALLEL KERNELS
+
+void residualconn_fp32_bw_kernel( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+    float * grad0 = args->activation0->diff;
+    float * grad1 = args->activation1->diff;
+    float * outDiff = args->activation2->diff;
+    int size = args->activation2->dim;
+
+    int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+    int start = pi_core_id()*blockSize;
+    int stop = start+blockSize > size ? size : start+blockSize;
+
+    for (int i=start; i<stop; i++) {
+        float grad = outDiff[i];
+        grad0[i] = grad;
+        grad1[i] = grad;
+    }
+}
+
+
+
+void residualconn_relu_fp32_fw_kernel( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+    float * in0 = args->activation0->data;
+    float * in1 = args->activation1->data;
+    float * outData = args->activation2->data;
+    int size = args->activation2->dim;
+
+    int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+    int start = pi_core_id()*blockSize;
+    int stop = start+blockSize > size ? size : start+blockSize;
+
+    for (int i=start; i<stop; i++) {
+        float sum = in0[i] + in1[i];
+        outData[i] = sum > 0.0f ? sum : 0.0f;
+    }
+}
+
+
+
+void residualconn_relu_fp32_bw_kernel( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+    float * grad0 = args->activation0->diff;
+    float * grad1 = args->activation1->diff;
+    float * outData = args->activation2->data;
+    float * outDiff = args->activation2->diff;
+    int size = args->activation2->dim;
+
+    int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+    int start = pi_core_id()*blockSize;
+    int stop = start+blockSize > size ? size : start+blockSize;
+
+    for (int i=start; i<stop; i++) {
+        float grad = outData[i] > 0.0f ? outDiff[i] : 0.0f;
+        grad0[i] = grad;
+        grad1[i] = grad;
+    }
+}
+
+
+
+void residualconn_scale_fp32_fw_kernel( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+    float * in0 = args->activation0->data;
+    float * in1 = args->activation1->data;
+    float * outData = args->activation2->data;
+    float scale = args->scale;
+    int size = args->activation2->dim;
+
+    int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+    int start = pi_core_id()*blockSize;
+    int stop = start+blockSize > size ? size : start+blockSize;
+
+    for (int i=start; i<stop; i++) {
+        outData[i] = scale * in0[i] + in1[i];
+    }
+}
+
+
+
+void residualconn_scale_fp32_bw_kernel( void * SkipConn_args )
+{
+    struct SkipConn_args * args = (struct SkipConn_args *) SkipConn_args;
+    float * grad0 = args->activation0->diff;
+    float * grad1 = args->activation1->diff;
+    float * outDiff = args->activation2->diff;
+    float scale = args->scale;
+    int size = args->activation2->dim;
+
+    int blockSize = (size+NUM_CORES-1) / NUM_CORES;
+    int start = pi_core_id()*blockSize;
+    int stop = start+blockSize > size ? size : start+blockSize;
+
+    for (int i=start; i<stop; i++) {
+        float grad = outDiff[i];
+        grad0[i] = scale * grad;
+        grad1[i] = grad;
+    }
 }
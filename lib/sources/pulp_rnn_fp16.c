@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2023 University of Bologna
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license.  See the LICENSE file for details.
+ */
+
+
+#include "pulp_train_utils_fp16.h"
+#include "pulp_matmul_fp16.h"
+#include "pulp_act_fp16.h"
+#include "pulp_rnn_fp16.h"
+
+
+//FORWARD
+void pulp_rnn_fp16_fw_cl(void * Rnn_args_fp16)
+{
+    struct Rnn_args_fp16 *rnn_args = (struct Rnn_args_fp16 *) Rnn_args_fp16;
+
+    // Input projection and whole recurrence in a single fork, one barrier per timestep
+    pi_cl_team_fork(NUM_CORES, pulp_rnn_fp16_fw_kernel, rnn_args);
+
+    #ifdef DEBUG
+    int N = rnn_args->input->H;
+    int M = rnn_args->output->W;
+    printf("\nLinear OutData: %d %d\n", N, M);
+    for (int j=0; j<N*M; j++){
+        if(!(j%(M))) printf("\n");
+        printf("%4.2e ", rnn_args->output->data[j]);
+    }
+    printf("\n");
+    #endif
+}
+
+
+
+//BACKWARD
+void pulp_rnn_fp16_bw_cl(void * Rnn_args_fp16)
+{
+    struct Rnn_args_fp16 *rnn_args = (struct Rnn_args_fp16 *) Rnn_args_fp16;
+
+    // Timestep gradients and weight/input gradients in a single fork
+    pi_cl_team_fork(NUM_CORES, pulp_rnn_fp16_bw_kernel, rnn_args);
+
+    #ifdef DEBUG
+    int total_dim = rnn_args->output->dim;
+    int M = rnn_args->output->W;
+    printf("\ngrad \n");
+    for (int i=0; i<total_dim; i++){
+        if(!(i%M)) printf("\n");
+        printf("%4.2e  ", rnn_args->grad_buffer[i]);
+    }
+    printf("\n");
+    #endif
+}
+
+
+
+
+/**
+ * PARALLEL KERNELS
+ */
+
+// The SIMD matmul loads fp16 pairs from the rows of A, B and C, which are 4-byte aligned only for even K and M
+static inline void rnn_fp16_mm (struct matMul_args_fp16 * args)
+{
+    if ((args->K | args->M) & 1)    mm_fp16(args);
+    else                            mm_fp16_SIMD_2x4(args);
+}
+
+void pulp_rnn_fp16_fw_kernel(void * Rnn_args_fp16)
+{
+    struct Rnn_args_fp16 *rnn_args = (struct Rnn_args_fp16 *) Rnn_args_fp16;
+    fp16 *coeffDataWx = rnn_args->coeff_x->data; // Input Weights
+    fp16 *coeffDataWs = rnn_args->coeff_s->data; // State Weights
+    fp16 *outData = rnn_args->output->data;  
+    fp16 *inputData = rnn_args->input->data;
+    fp16 *stateData = rnn_args->state->data;
+
+    int N = rnn_args->input->H; // Input/Output Sequence length
+    int K = rnn_args->input->W; // Input Sequence element length
+    int M = rnn_args->output->W; // Output Sequence element length
+
+    // Input projection of the whole sequence (out = X*Wx)
+    struct matMul_args_fp16 matMul_args;
+    matMul_args.A = inputData;
+    matMul_args.B = coeffDataWx;
+    matMul_args.C = outData;
+    matMul_args.N = N;
+    matMul_args.K = K;
+    matMul_args.M = M;
+    matMul_args.trans_B = 0;
+
+    rnn_fp16_mm(&matMul_args);
+    pi_cl_team_barrier();
+
+    // Parallelize over pairs of hidden units
+    const int blockSize = (((M+NUM_CORES-1) / NUM_CORES)+1) & 0xfffffffe;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > M ? M : start+blockSize;
+
+    for (int t=0; t<N; t++) {
+        fp16 *h_prev = stateData + t*M;
+        fp16 *h_t = outData + t*M;
+
+        int j = start;
+        // Pairs of hidden units are 4-byte aligned only if the rows have an even length
+        if (!(M & 1)) {
+            for (; j+1<stop; j+=2) {
+                v2f16 acc = *((v2f16 *) &h_t[j]);
+                for (int m=0; m<M; m++) {
+                    v2f16 h = (v2f16) {h_prev[m], h_prev[m]};
+                    acc += h * *((v2f16 *) &coeffDataWs[m*M+j]);
+                }
+                acc = act_tanh_v2f16(acc);
+                *((v2f16 *) &h_t[j]) = acc;
+                // Store the state of the next timestep for the backward step
+                if (t < N-1)    *((v2f16 *) &stateData[(t+1)*M+j]) = acc;
+            }
+        }
+        // Leftover hidden units (all of them when M is odd)
+        for (; j<stop; j++) {
+            fp16 acc = h_t[j];
+            for (int m=0; m<M; m++)     acc += h_prev[m] * coeffDataWs[m*M+j];
+            h_t[j] = act_tanh_fp16(acc);
+            if (t < N-1)    stateData[(t+1)*M+j] = h_t[j];
+        }
+
+        pi_cl_team_barrier();
+    }
+}
+
+
+
+void pulp_rnn_fp16_bw_kernel(void * Rnn_args_fp16)
+{
+    struct Rnn_args_fp16 *rnn_args = (struct Rnn_args_fp16 *) Rnn_args_fp16;
+
+    fp16 *coeffDataWx = rnn_args->coeff_x->data;
+    fp16 *coeffDataWs = rnn_args->coeff_s->data;
+    fp16 *inData = rnn_args->input->data;
+    fp16 *outData = rnn_args->output->data;
+    fp16 *coeffDiffWx = rnn_args->coeff_x->diff;
+    fp16 *coeffDiffWs = rnn_args->coeff_s->diff;
+    fp16 *outDiff = rnn_args->output->diff;  
+    fp16 *inDiff = rnn_args->input->diff;
+    fp16 *hiddState = rnn_args->state->data;
+    fp16 *grad = rnn_args->grad_buffer; // Buffer that saves the pre-activation gradients
+    int window = rnn_args->bptt_window;
+
+    int N = rnn_args->input->H; // Input sequence length
+    int K = rnn_args->input->W; // Input sequence element size
+    int M = rnn_args->output->W; // Output sequence element size
+
+    // Transposed gradients (M*N), followed by the transposed input or state (K*N or M*N)
+    fp16 *gradT = rnn_args->temp_buffer;
+    fp16 *opT = gradT + N*M;
+
+    // Parallelize over the hidden units
+    const int blockSize = (M+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > M ? M : start+blockSize;
+
+    // Pairs of the gradient and Ws rows are 4-byte aligned only if M is even
+    int M_loop = (M & 1) ? 0 : M;
+
+    for (int t=N-1; t>=0; t--) {
+        fp16 *g_next = grad + (t+1)*M;
+        // The recurrent gradient is cut at the truncated-BPTT window boundaries
+        int recur = (t < N-1) && ((window <= 0) || ((t+1) % window != 0));
+
+        for (int j=start; j<stop; j++) {
+            fp16 dh = outDiff[t*M+j];
+            if (recur) {
+                fp16 *ws_row = coeffDataWs + j*M;
+                v2f16 acc = (v2f16) {0, 0};
+                for (int m=0; m<M_loop; m+=2)   acc += *((v2f16 *) &g_next[m]) * *((v2f16 *) &ws_row[m]);
+                for (int m=M_loop; m<M; m++)    dh += g_next[m] * ws_row[m];
+                dh += acc[0] + acc[1];
+            }
+            fp16 h = outData[t*M+j];
+            grad[t*M+j] = (1-(h*h)) * dh;
+        }
+
+        pi_cl_team_barrier();
+    }
+
+    // Transpose the gradients and the input
+    struct transp_args_fp16 transp_args1;
+    transp_args1.matrix = grad;
+    transp_args1.transp_matrix = gradT;
+    transp_args1.N = N;
+    transp_args1.M = M;
+
+    transpose_fp16(&transp_args1);
+
+    struct transp_args_fp16 transp_args2;
+    transp_args2.matrix = inData;
+    transp_args2.transp_matrix = opT;
+    transp_args2.N = N;
+    transp_args2.M = K;
+
+    transpose_fp16(&transp_args2);
+    pi_cl_team_barrier();
+
+    // Gradient of the Input Weights (dWx = Xt*G)
+    struct matMul_args_fp16 matMul_args1;
+    matMul_args1.A = opT; 
+    matMul_args1.B = gradT; 
+    matMul_args1.C = coeffDiffWx;
+    matMul_args1.N = K;
+    matMul_args1.K = N;
+    matMul_args1.M = M;
+    matMul_args1.trans_B = 1;
+
+    rnn_fp16_mm(&matMul_args1);
+
+    // Gradient of the Input (dX = G*Wxt)
+    struct matMul_args_fp16 matMul_args3;
+    matMul_args3.A = grad;
+    matMul_args3.B = coeffDataWx;
+    matMul_args3.C = inDiff;
+    matMul_args3.N = N;
+    matMul_args3.K = M;
+    matMul_args3.M = K;
+    matMul_args3.trans_B = 1;
+
+    rnn_fp16_mm(&matMul_args3);
+    pi_cl_team_barrier();
+
+    // Transpose the state
+    struct transp_args_fp16 transp_args3;
+    transp_args3.matrix = hiddState;
+    transp_args3.transp_matrix = opT;
+    transp_args3.N = N;
+    transp_args3.M = M;
+
+    transpose_fp16(&transp_args3);
+    pi_cl_team_barrier();
+
+    // Gradient of the State Weights (dWs = St*G)
+    struct matMul_args_fp16 matMul_args2;
+    matMul_args2.A = opT; 
+    matMul_args2.B = gradT; 
+    matMul_args2.C = coeffDiffWs;
+    matMul_args2.N = M;
+    matMul_args2.K = N;
+    matMul_args2.M = M;
+    matMul_args2.trans_B = 1;
+
+    rnn_fp16_mm(&matMul_args2);
+}
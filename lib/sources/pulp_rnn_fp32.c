@@ -19,190 +19,190 @@
 void pulp_rnn_fp32_fw_cl(void* Rnn_args)
 {
     struct Rnn_args *rnn_args = (struct Rnn_args *) Rnn_args;
-    float *coeffDataWx = rnn_args->coeff_x->data; // Input Weights
-    float *coeffDataWs = rnn_args->coeff_s->data; // State Weights
-    float *outData = rnn_args->output->data;  
-    float *inputData = rnn_args->input->data;
-    float *stateData= rnn_args->state->data;
 
+    #ifdef DEBUG
     int N = rnn_args->input->H; // Input/Output Sequence length
     int K = rnn_args->input->W; // Input Sequence element length
     int M = rnn_args->output->W; // Output Sequence element length
 
-    //matmul setup 1
-    struct matMul_args matMul_args1;
-    matMul_args1.A = inputData;
-    matMul_args1.B = coeffDataWx; 
-    matMul_args1.C = outData;
-    matMul_args1.N = N;
-    matMul_args1.K = K;
-    matMul_args1.M = M;
-    matMul_args1.trans_B = 0;
-
-    #ifdef DEBUG
     printf("\ninputData: %d %d\n", N, K);
-    for (int j=0; j<K; j++){
-        printf("%4.2e ", matMul_args1.A[j]);
+    for (int j=0; j<N*K; j++){
+        if(!(j%(K))) printf("\n");
+        printf("%4.2e ", rnn_args->input->data[j]);
     }
     printf("\n");
 
-    printf("\nWx: %d %d\n", K, M);
-    for (int j=0; j<K*M; j++){
-        if(!(j%(M))) printf("\n");
-        printf("%4.2e ",  matMul_args1.B[j]);
+    printf("\ninitial state: %d\n", M);
+    for (int j=0; j<M; j++){
+        printf("%4.2e ", rnn_args->state->data[j]);
     }
     printf("\n");
     #endif
 
-    pi_cl_team_fork(NUM_CORES,  mm, &matMul_args1);
-
+    // Whole recurrence in a single fork, one barrier per timestep
+    pi_cl_team_fork(NUM_CORES, pulp_rnn_fp32_fw_kernel, rnn_args);
 
     #ifdef DEBUG
-    printf("\noutData: %d %d\n", N, M);
+    printf("\nLinear OutData: %d %d\n", N, M);
     for (int j=0; j<N*M; j++){
-        printf("%4.2e ", matMul_args1.C[j]);
+        if(!(j%(M))) printf("\n");
+        printf("%4.2e ", rnn_args->output->data[j]);
     }
     printf("\n");
     #endif
+}
 
 
-    //matmul setup 2
-    struct matMul_args matMul_args2;
-    matMul_args2.A = stateData;
-    matMul_args2.B = coeffDataWs;
-    matMul_args2.C = outData;
-    matMul_args2.N = N;
-    matMul_args2.K = M;
-    matMul_args2.M = M;
-    matMul_args2.trans_B = 0;
-
 
+//BACKWARD
+void pulp_rnn_fp32_bw_cl(void * Rnn_args) 
+{
+    struct Rnn_args *rnn_args = (struct Rnn_args *) Rnn_args;
 
     #ifdef DEBUG
-    printf("\nprev_state: %d %d\n", N, M);
-    for (int j=0; j<M; j++){
-        printf("%4.2e ", matMul_args2.A[j]);
+    int total_dim = rnn_args->output->dim;
+    int M = rnn_args->output->W; // Output sequence element size
+
+    printf("\nHIDDEN STATES\n");
+    for(int i=0; i<(total_dim); i++){
+    if(!(i%M)) printf("\n");
+      printf("%4.2e  ",rnn_args->state->data[i]);
     }
     printf("\n");
 
-    printf("\nWs: %d %d\n", M, M);
-    for (int j=0; j<M*M; j++){
-        if(!(j%(M))) printf("\n");
-        printf("%4.2e ",  matMul_args2.B[j]);
+    printf("\nLinear outDiff\n");
+    for(int i=0; i<total_dim; i++){
+    if(!(i%M)) printf("\n");
+      printf("%4.2e  ",rnn_args->output->diff[i]);
     }
     printf("\n");
     #endif
 
-
-    pi_cl_team_fork(NUM_CORES, mm_add, &matMul_args2);
-
+    // Timestep gradients and weight/input gradients in a single fork
+    pi_cl_team_fork(NUM_CORES, pulp_rnn_fp32_bw_kernel, rnn_args);
 
     #ifdef DEBUG
-    printf("\noutData: %d %d\n", N, M);
-    for (int j=0; j<N*M; j++){
-        printf("%4.2e ", matMul_args2.C[j]);
+    printf("\ngrad \n");
+    for (int i=0; i<total_dim; i++){
+        if(!(i%M)) printf("\n");
+        printf("%4.2e  ", rnn_args->grad_buffer[i]);
     }
     printf("\n");
     #endif
+}
 
-    struct tanh_args tanh_arg;  
-    tanh_arg.input = matMul_args2.C;
-    tanh_arg.dim = N*M;
-    tanh_arg.output = matMul_args2.C;
 
-    pi_cl_team_fork(NUM_CORES, tanh_prll, &tanh_arg);
 
 
-    #ifdef DEBUG
-    printf("\nLinear OutData: %d %d\n", N, M);
-    for (int j=0; j<N*M; j++){
-        printf("%4.2e ", matMul_args2.C[j]);
-    }
-    #endif
+/**
+ * PARALLEL KERNELS
+ */
 
-    /*
-    if(i != ((rnn_args->input->H)-1)){
-        for(int j=0; j<M; j++)
-            stateData[(i+1)*M+j]=matMul_args2.C[j];
-    }
-    else{
-        for(int j=0; j<M; j++)
-            stateData[j]=matMul_args2.C[j];
+void pulp_rnn_fp32_fw_kernel(void * Rnn_args)
+{
+    struct Rnn_args *rnn_args = (struct Rnn_args *) Rnn_args;
+    float *coeffDataWx = rnn_args->coeff_x->data; // Input Weights
+    float *coeffDataWs = rnn_args->coeff_s->data; // State Weights
+    float *outData = rnn_args->output->data;  
+    float *inputData = rnn_args->input->data;
+    float *stateData = rnn_args->state->data;
+
+    int N = rnn_args->input->H; // Input/Output Sequence length
+    int K = rnn_args->input->W; // Input Sequence element length
+    int M = rnn_args->output->W; // Output Sequence element length
+
+    // Parallelize over the hidden units
+    const int blockSize = (M+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > M ? M : start+blockSize;
+
+    for (int t=0; t<N; t++) {
+        float *x_t = inputData + t*K;
+        float *h_prev = stateData + t*M;
+        float *h_t = outData + t*M;
+
+        int j = start;
+        for (; j+1<stop; j+=2) {
+            float acc0 = 0;
+            float acc1 = 0;
+            for (int k=0; k<K; k++) {
+                float x = x_t[k];
+                acc0 += x * coeffDataWx[k*M+j];
+                acc1 += x * coeffDataWx[k*M+j+1];
+            }
+            for (int m=0; m<M; m++) {
+                float h = h_prev[m];
+                acc0 += h * coeffDataWs[m*M+j];
+                acc1 += h * coeffDataWs[m*M+j+1];
+            }
+            h_t[j]   = act_tanh(acc0);
+            h_t[j+1] = act_tanh(acc1);
+        }
+        // Leftover hidden unit
+        if (j < stop) {
+            float acc = 0;
+            for (int k=0; k<K; k++)     acc += x_t[k] * coeffDataWx[k*M+j];
+            for (int m=0; m<M; m++)     acc += h_prev[m] * coeffDataWs[m*M+j];
+            h_t[j] = act_tanh(acc);
+        }
+
+        // Store the state of the next timestep for the backward step
+        if (t < N-1) {
+            for (int jj=start; jj<stop; jj++)   stateData[(t+1)*M+jj] = h_t[jj];
+        }
+
+        pi_cl_team_barrier();
     }
-    */
 }
 
 
 
-//BACKWARD
-void pulp_rnn_fp32_bw_cl(void * Rnn_args) 
+void pulp_rnn_fp32_bw_kernel(void * Rnn_args)
 {
     struct Rnn_args *rnn_args = (struct Rnn_args *) Rnn_args;
 
     float *coeffDataWx = rnn_args->coeff_x->data;
     float *coeffDataWs = rnn_args->coeff_s->data;
     float *inData = rnn_args->input->data;
-    float *temp = rnn_args->temp_buffer; // Temporary buffer to save transposed matrices
     float *outData = rnn_args->output->data;
     float *coeffDiffWx = rnn_args->coeff_x->diff;
     float *coeffDiffWs = rnn_args->coeff_s->diff;
-
     float *outDiff = rnn_args->output->diff;  
-
     float *inDiff = rnn_args->input->diff;
     float *hiddState = rnn_args->state->data;
-    float *hiddStateDiff = rnn_args->state->diff;
-    float *grad = rnn_args->grad_buffer; // Buffer that saves output gradients for tanh
+    float *grad = rnn_args->grad_buffer; // Buffer that saves the pre-activation gradients
+    int window = rnn_args->bptt_window;
 
-    int total_dim = rnn_args->output->dim;
     int N = rnn_args->input->H; // Input sequence length
     int K = rnn_args->input->W; // Input sequence element size
     int M = rnn_args->output->W; // Output sequence element size
-    
 
+    // Parallelize over the hidden units
+    const int blockSize = (M+NUM_CORES-1) / NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start+blockSize > M ? M : start+blockSize;
 
-    #ifdef DEBUG
-    printf("\nHIDDEN STATES\n");
-    for(int i=0; i<(total_dim); i++){
-    if(!(i%M)) printf("\n");
-      printf("%4.2e  ",hiddState[i]);
-    }
-    printf("\n");
+    for (int t=N-1; t>=0; t--) {
+        float *g_next = grad + (t+1)*M;
+        // The recurrent gradient is cut at the truncated-BPTT window boundaries
+        int recur = (t < N-1) && ((window <= 0) || ((t+1) % window != 0));
 
-    printf("\noutData\n");
-    for(int i=0; i<total_dim; i++){
-    if(!(i%M)) printf("\n");
-      printf("%4.2e  ",outData[i]);
-    }
-    printf("\n");
+        for (int j=start; j<stop; j++) {
+            float dh = outDiff[t*M+j];
+            if (recur) {
+                float *ws_row = coeffDataWs + j*M;
+                for (int m=0; m<M; m++)     dh += g_next[m] * ws_row[m];
+            }
+            float h = outData[t*M+j];
+            grad[t*M+j] = (1-(h*h)) * dh;
+        }
 
-    printf("\nLinear outDiff\n");
-    for(int i=0; i<total_dim; i++){
-    if(!(i%M)) printf("\n");
-      printf("%4.2e  ",outDiff[i]);
+        pi_cl_team_barrier();
     }
-    printf("\n");
-    #endif
-
-    for(int i=0; i<total_dim; i++)
-        grad[i]=(1-(outData[i] * outData[i])) *  outDiff[i]; // Taylor series expansion for derivative(tanh)
-
-
-    // Calculate gradient for Input Weights
-
-    // Transpose Input
-    struct transp_args transp_args1;
-    transp_args1.matrix = inData;
-    transp_args1.transp_matrix = temp;
-    transp_args1.N = N;
-    transp_args1.M = K;
-
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args1);
 
-
-    // matmul setup 1
+    // Gradient of the Input Weights (dWx = Xt*G)
     struct matMul_args matMul_args1;
-    matMul_args1.A = temp; 
+    matMul_args1.A = inData; 
     matMul_args1.B = grad; 
     matMul_args1.C = coeffDiffWx;
     matMul_args1.N = K;
@@ -210,139 +210,29 @@ void pulp_rnn_fp32_bw_cl(void * Rnn_args)
     matMul_args1.M = M;
     matMul_args1.trans_B = 0;
 
+    mm_trans_A(&matMul_args1);
 
-    #ifdef DEBUG
-    printf("\ngrad \n");
-    for (int i=0; i<total_dim; i++){
-        if(!(i%M)) printf("\n");
-        printf("%4.2e  ", grad[i]);
-    }
-    printf("\n");
-
-    printf("\nTransposed input sequence\n");
-    for (int i=0; i<N*K; i++){
-        if(!(i%N)) printf("\n");
-        printf("%4.2e  ", matMul_args1.A[i]);
-    }
-    printf("\n");
-    #endif
-
-  
-    pi_cl_team_fork(NUM_CORES, mm_unroll_4x1, &matMul_args1);
-
-
-    #ifdef DEBUG
-    printf("\nLinear coeffDiffWx");
-    for (int i=0; i<K*M; i++){
-      if(!(i%M)) printf("\n");
-      printf("%4.2e (i=%d)", matMul_args1.C[i], i);
-    }
-    printf("\n");
-    #endif
-
-
-    // Calculate gradient for State Weights
-    // Transpose State
-    struct transp_args transp_args2;
-    transp_args2.matrix = hiddState;
-    transp_args2.transp_matrix = temp;
-    transp_args2.N = N;
-    transp_args2.M = M;
-
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args2); 
-
-
-    // matmul setup 2
+    // Gradient of the State Weights (dWs = St*G)
     struct matMul_args matMul_args2;
-    matMul_args2.A = temp; 
+    matMul_args2.A = hiddState; 
     matMul_args2.B = grad; 
     matMul_args2.C = coeffDiffWs;
     matMul_args2.N = M;
     matMul_args2.K = N;
     matMul_args2.M = M;
     matMul_args2.trans_B = 0;
-  
-    pi_cl_team_fork(NUM_CORES, mm_unroll_4x1, &matMul_args2);
-
-
-
-    #ifdef DEBUG
-    printf("\nLinear coeffDiffWs");
-    for (int i=0; i<M*M; i++){
-      if(!(i%M)) printf("\n");
-      printf("%4.2e (i=%d)", matMul_args2.C[i], i);
-    }
-    printf("\n");
-    #endif
-
-
-    #ifdef DEBUG
-    printf("\ngrad \n");
-    for (int i=0; i<total_dim; i++){
-        if(!(i%M)) printf("\n");
-        printf("%4.2e  ", matMul_args2.B[i]);
-    }
-    printf("\n");
-
-    printf("\nTransposed hidden state\n");
-    for (int i=0; i<total_dim; i++){
-        if(!(i%N)) printf("\n");
-        printf("%4.2e  ",matMul_args2.A[i]);
-    }
-    printf("\n");
-
-    #endif
-
-
-    // Calculate the Gradient of the Input
-    // Transpose Input Weights
-    struct transp_args transp_args3;
-    transp_args3.matrix = coeffDataWx;
-    transp_args3.transp_matrix = temp;
-    transp_args3.N = K;
-    transp_args3.M = M;
 
-    pi_cl_team_fork(NUM_CORES, transpose, &transp_args3); 
+    mm_trans_A(&matMul_args2);
 
-
-    // matmul setup 3
+    // Gradient of the Input (dX = G*Wxt)
     struct matMul_args matMul_args3;
     matMul_args3.A = grad;
-    matMul_args3.B = temp;
+    matMul_args3.B = coeffDataWx;
     matMul_args3.C = inDiff;
     matMul_args3.N = N;
     matMul_args3.K = M;
     matMul_args3.M = K;
-    matMul_args3.trans_B = 0;
-
-
-    pi_cl_team_fork(NUM_CORES, mm_M_unroll_4x1, &matMul_args3);
-
- 
-    #ifdef DEBUG
-    printf("\noutputDiff\n");
-    for (int i=0; i<total_dim; i++){
-        if(!(i%M)) printf("\n");
-        printf("%4.2e  ", matMul_args1.A[i]);
-    }
-    printf("\n");
+    matMul_args3.trans_B = 1;
 
-    printf("\nTransposed Wx\n");
-    for (int i=0; i<K*M; i++){
-        if(!(i%K)) printf("\n");
-        printf("%4.2e  ", matMul_args1.B[i]);
-    }
-    printf("\n");
-
-    printf("\nInput Gradients\n");
-    for (int i=0; i<N*K; i++){
-        if(!(i%K)) printf("\n");
-        printf("%4.2e  ", matMul_args1.C[i]);
-    }
-    printf("\n");
-    #endif
+    mm(&matMul_args3);
 }
-  
-
-
-
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_fp32.h"
+#include "pulp_selective_fp32.h"
+#include "math.h"
+
+
+// Fraction of the recent losses below loss (ties count half), 1 if there is no history
+static float loss_rank( struct selective_args * args, float loss )
+{
+  if (args->count == 0) return 1.0f;
+
+  float below = 0;
+  for (int i=0; i<args->count; i++) {
+    if (args->history[i] < loss)        below += 1.0f;
+    else if (args->history[i] == loss)  below += 0.5f;
+  }
+  return below / args->count;
+}
+
+
+
+void pulp_selective_init( struct selective_args * args )
+{
+  args->count = 0;
+  args->pos = 0;
+  args->seen = 0;
+  args->selected = 0;
+  args->bp_cycles = 0;
+}
+
+int pulp_selective_select( struct selective_args * args, float loss )
+{
+  int select = 1;
+
+  if (args->policy == SELECT_THRESHOLD) {
+    select = (loss >= args->threshold);
+  }
+  else if (args->policy == SELECT_PERCENTILE) {
+    select = (args->count == 0) || (loss_rank(args, loss) >= args->percentile);
+  }
+  else if (args->policy == SELECT_PROB) {
+    float prob = powf(loss_rank(args, loss), args->beta);
+    float draw = (float) (xorshift32(&args->seed) & 0xffff) / 65536.0f;
+    select = (draw < prob);
+  }
+  else {
+    printf("[pulp_selective_select]: Invalid selection policy!!\n");
+  }
+
+  if (args->policy != SELECT_THRESHOLD) {
+    args->history[args->pos] = loss;
+    args->pos = (args->pos + 1) % args->history_size;
+    if (args->count < args->history_size) args->count++;
+  }
+
+  args->seen++;
+  args->selected += select;
+
+  #ifdef DEBUG
+  printf("[pulp_selective_select]: loss=%f -> %s\n", loss, select ? "backprop" : "skip");
+  #endif
+
+  return select;
+}
+
+void pulp_selective_report( struct selective_args * args )
+{
+  int skipped = args->seen - args->selected;
+  unsigned long avg = args->selected > 0 ? args->bp_cycles / args->selected : 0;
+
+  printf("Selective backprop: %d of %d samples skipped (%d%%), ~%lu backward+update cycles saved (%lu per sample)\n", 
+    skipped, args->seen, args->seen > 0 ? 100*skipped/args->seen : 0, avg*skipped, avg);
+}
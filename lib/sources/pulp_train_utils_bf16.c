@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2021-2022 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_train_utils_bf16.h"
+
+
+void cast_fp32_tensor_to_bf16 (void * cast_32tbf16_args)
+{
+  struct cast_32tbf16_args args = *((struct cast_32tbf16_args *)cast_32tbf16_args);
+  // Even blocks, so that each core writes whole 32-bit words
+  int blockSize = (((args.size+NUM_CORES-1) / NUM_CORES) + 1) & ~1;
+  int start = pi_core_id()*blockSize;
+  int stop = start+blockSize > args.size ? args.size : start+blockSize;
+
+  uint32_t * dest = (uint32_t *) (args.destination + start);
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    *dest++ = (uint32_t) fp32_to_bf16(args.source[i]) | ((uint32_t) fp32_to_bf16(args.source[i+1]) << 16);
+  }
+  if (i < stop) {
+    args.destination[i] = fp32_to_bf16(args.source[i]);
+  }
+}
+
+void cast_bf16_tensor_to_fp32 (void * cast_bf16t32_args)
+{
+  struct cast_bf16t32_args args = *((struct cast_bf16t32_args *)cast_bf16t32_args);
+  int blockSize = (((args.size+NUM_CORES-1) / NUM_CORES) + 1) & ~1;
+  int start = pi_core_id()*blockSize;
+  int stop = start+blockSize > args.size ? args.size : start+blockSize;
+
+  // A bf16 is the upper half of an fp32: each 32-bit word gives two fp32 with a shift and a mask
+  uint32_t * src = (uint32_t *) (args.source + start);
+  uint32_t * dest = (uint32_t *) args.destination;
+  int i = start;
+  for (; i+1<stop; i+=2) {
+    uint32_t w = *src++;
+    dest[i]   = w << 16;
+    dest[i+1] = w & 0xffff0000;
+  }
+  if (i < stop) {
+    args.destination[i] = bf16_to_fp32(args.source[i]);
+  }
+}
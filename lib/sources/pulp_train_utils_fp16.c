@@ -410,6 +410,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -429,6 +432,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -448,6 +454,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -479,6 +488,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -498,6 +510,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -517,6 +532,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -548,6 +566,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -567,6 +588,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -586,6 +610,9 @@ void mm_manager_fp16 (void * void_args)
             // Parallelism on M
             else if (matmul_type == 4)     { mm_M_fp16_SIMD_2x4((void *) matMul_args);}
             else if (matmul_type == 5)     { mm_M_fp16_SIMD_4x8((void *) matMul_args);}
+            // FP32 accumulation
+            else if (matmul_type == 6)     { mm_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
+            else if (matmul_type == 7)     { mm_M_fp16_SIMD_2x2_fp32acc((void *) matMul_args);}
             else
             {
                 printf("\nWrong matmul selection!\n");
@@ -390,6 +390,68 @@ void pulp_scalar_mul_fp32_cl(void* void_args){
 }
 
 
+void pulp_bias_add_fp32_cl(void* void_args){
+    struct bias_args* args = (struct bias_args *) void_args;
+
+    float* data = args->data;
+    float* bias = args->bias;
+    int C = args->C;
+    int HW = args->HW;
+    // Stride between the elements of a channel, and between channels
+    int step = args->HWC ? C : 1;
+    int ch_step = args->HWC ? 1 : HW;
+
+    const int blockSize=(C+NUM_CORES-1)/NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start + blockSize > C ? C : start+blockSize;
+
+    for(int c=start; c<stop; c++){
+        float b = bias[c];
+        for(int i=0; i<HW; i++) data[c*ch_step + i*step] += b;
+    }
+}
+
+
+void pulp_bias_grad_fp32_cl(void* void_args){
+    struct bias_args* args = (struct bias_args *) void_args;
+
+    float* data = args->data;
+    float* bias = args->bias;
+    int C = args->C;
+    int HW = args->HW;
+    // Stride between the elements of a channel, and between channels
+    int step = args->HWC ? C : 1;
+    int ch_step = args->HWC ? 1 : HW;
+
+    const int blockSize=(C+NUM_CORES-1)/NUM_CORES;
+    const int start = pi_core_id()*blockSize;
+    const int stop = start + blockSize > C ? C : start+blockSize;
+
+    for(int c=start; c<stop; c++){
+        float sum = 0;
+        for(int i=0; i<HW; i++) sum += data[c*ch_step + i*step];
+        bias[c] = sum;
+    }
+}
+
+
+unsigned int xorshift32(unsigned int * state){
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+int sparse_rows_from_mask(int * mask, int size, int * rows){
+    int num = 0;
+    for (int i=0; i<size; i++)
+        if (mask[i]) rows[num++] = i;
+    return num;
+}
+
+
 
 /**
  * Choose the user-selected matmul for the chosen layer.
@@ -784,3 +846,32 @@ void mm_manager (void * void_args)
     }
 
 }
+
+
+void mm_manager_trans_A (void * void_args)
+{
+    struct mm_manager_args* args = (struct mm_manager_args *) void_args;
+    
+    struct matMul_args *matMul_args = args->mm_args;    
+    int matmul_type = args->matmul_type;
+
+    #ifdef DEBUG
+    printf("Running transposed-A matmul %d\n", matmul_type);
+    #endif
+
+    // Naive
+    if      (matmul_type == 0)                          { mm_trans_A((void *) matMul_args); }
+    else if (matmul_type == 1)                          { mm_M_trans_A((void *) matMul_args); }
+    // Parallelism on N
+    else if (matmul_type >= 2 && matmul_type <= 5)      { mm_trans_A_unroll_1x4((void *) matMul_args); }
+    else if (matmul_type >= 6 && matmul_type <= 8)      { mm_trans_A_unroll_4x1((void *) matMul_args); }
+    else if (matmul_type >= 9 && matmul_type <= 12)     { mm_trans_A_unroll_2x2((void *) matMul_args); }
+    // Parallelism on M
+    else if (matmul_type >= 13 && matmul_type <= 16)    { mm_M_trans_A_unroll_1x4((void *) matMul_args); }
+    else if (matmul_type >= 17 && matmul_type <= 19)    { mm_M_trans_A_unroll_4x1((void *) matMul_args); }
+    else if (matmul_type >= 20 && matmul_type <= 23)    { mm_M_trans_A_unroll_2x2((void *) matMul_args); }
+    else
+    {
+        printf("\nWrong matmul selection!\n");
+    }
+}
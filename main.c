@@ -18,7 +18,7 @@
 #include "net.h"
 
 /**
- *  Configures cluster, then calls net_step()
+ *  Configures cluster, then calls net_step() (or check_step() when a CHECK_* flag is set)
 **/
 
 int main (void) {
@@ -37,8 +37,21 @@ int main (void) {
       return -1;
   }
 
+  #ifdef DATASET_HOSTFS
+  printf("\nLoading dataset..\n");
+  if (load_dataset())
+  {
+      return -1;
+  }
+  #endif
+
+  #ifdef CHECKS
+  printf("\nLaunching library checks...\n");
+  pi_cluster_send_task_to_cl(&cluster_dev, pi_cluster_task(&cl_task, check_step, NULL));
+  #else
   printf("\nLaunching training procedure...\n");
   pi_cluster_send_task_to_cl(&cluster_dev, pi_cluster_task(&cl_task, net_step, NULL));
+  #endif
 
   printf("Exiting DNN Training.\n");
   pi_cluster_close(&cluster_dev);
@@ -32,29 +32,198 @@ PI_L1 struct Linear_args l2_args;
 PI_L1 float l0_ker[Tin_C_l0 * Tout_C_l0 * Tker_H_l0 * Tker_W_l0];
 PI_L1 float l2_ker[Tin_C_l2 * Tout_C_l2 * Tker_H_l2 * Tker_W_l2];
 
-// Define kernel grad tensors
-PI_L1 float l0_ker_diff[Tin_C_l0 * Tout_C_l0 * Tker_H_l0 * Tker_W_l0];
+// Sparse update of layer 0: number of output channels to be updated (the first ones)
+#ifndef UPDATE_CHANNELS_L0
+#define UPDATE_CHANNELS_L0 Tout_C_l0
+#endif
+#if UPDATE_CHANNELS_L0 < Tout_C_l0
+#define SPARSE_UPDATE_L0
+PI_L1 int l0_update_mask[Tout_C_l0];
+PI_L1 int l0_update_rows[Tout_C_l0];
+#endif
+
+// Define kernel grad tensors (only the updated channels)
+#ifndef AMP
+PI_L1 float l0_ker_diff[Tin_C_l0 * UPDATE_CHANNELS_L0 * Tker_H_l0 * Tker_W_l0];
 PI_L1 float l2_ker_diff[Tin_C_l2 * Tout_C_l2 * Tker_H_l2 * Tker_W_l2];
+#endif
 
 // Define I/O tensors
 PI_L1 float l0_in[Tin_C_l0 * Tin_H_l0 * Tin_W_l0];
+#if !defined(CHECKPOINTING) && !defined(AMP)
 PI_L1 float l1_in[Tin_C_l1 * Tin_H_l1 * Tin_W_l1];
 PI_L1 float l2_in[Tin_C_l2 * Tin_H_l2 * Tin_W_l2];
+#endif
 PI_L1 float l2_out[Tout_C_l2 * Tout_H_l2 * Tout_W_l2];
 
 // Define IM2COL buffer for all the convolutions
+#ifndef AMP
 PI_L1 float im2col_buffer[Tout_C_l0*Tker_H_l0*Tker_W_l0*Tin_H_l0*Tin_W_l0];
+#endif
 
 // Define transposition / block transposition buffer for all conv2d and PW layers
 PI_L1 float bt_buffer[1];
 // Define error propagation tensors
+#ifndef AMP
 PI_L1 float l1_in_diff[Tin_C_l1 * Tin_H_l1 * Tin_W_l1];
 PI_L1 float l2_in_diff[Tin_C_l2 * Tin_H_l2 * Tin_W_l2];
+#endif
 PI_L1 float l2_out_diff[Tout_C_l2 * Tout_H_l2 * Tout_W_l2];
 
 // Loss function configuration structure
 PI_L1 struct loss_args loss_args;
 
+#ifdef DATASET
+// Streaming dataset: samples in L2, double buffer in L1
+#ifndef DATASET_SHUFFLE
+#define DATASET_SHUFFLE 1
+#endif
+#define NUM_SAMPLES DATASET_SIZE
+PI_L1 struct dataset_args dataset;
+PI_L1 int dataset_index[DATASET_SIZE];
+PI_L1 float dataset_buffer[2*(IN_SIZE+OUT_SIZE)];
+#else
+#define NUM_SAMPLES 1
+#endif
+
+#ifdef REPLAY
+// Latent replay buffer for the trainable tail (layer 2)
+#ifndef REPLAY_CAPACITY
+#define REPLAY_CAPACITY 64
+#endif
+#ifndef REPLAY_FORMAT
+#define REPLAY_FORMAT REPLAY_FP16
+#endif
+#ifndef REPLAY_POLICY
+#define REPLAY_POLICY REPLAY_RESERVOIR
+#endif
+#ifndef REPLAY_PER_STEP
+#define REPLAY_PER_STEP 1
+#endif
+#define REPLAY_RECORD REPLAY_RECORD_BYTES(Tin_C_l2*Tin_H_l2*Tin_W_l2, Tout_C_l2*Tout_H_l2*Tout_W_l2, REPLAY_FORMAT)
+PI_L2 uint8_t replay_storage[REPLAY_CAPACITY*REPLAY_RECORD] __attribute__((aligned(4)));
+PI_L1 uint8_t replay_buffer[3*REPLAY_RECORD] __attribute__((aligned(4)));
+PI_L1 float replay_partial[NUM_CORES];
+PI_L1 int replay_classes[REPLAY_CAPACITY];
+PI_L1 int replay_class_count[2*Tout_C_l2*Tout_H_l2*Tout_W_l2];
+PI_L1 struct replay_args replay;
+#endif
+
+#ifdef SELECTIVE_BP
+// Selective backpropagation of the samples with a high loss
+#ifndef SELECTIVE_POLICY
+#define SELECTIVE_POLICY SELECT_PERCENTILE
+#endif
+#ifndef SELECTIVE_THRESHOLD
+#define SELECTIVE_THRESHOLD 0.01f
+#endif
+#ifndef SELECTIVE_PERCENTILE
+#define SELECTIVE_PERCENTILE 0.5f
+#endif
+#ifndef SELECTIVE_BETA
+#define SELECTIVE_BETA 2.0f
+#endif
+#ifndef SELECTIVE_HISTORY
+#define SELECTIVE_HISTORY 32
+#endif
+PI_L1 struct selective_args selective;
+PI_L1 float selective_history[SELECTIVE_HISTORY];
+#endif
+
+// Trainable layers (set to 0 to freeze the weights of a layer)
+#ifndef TRAINABLE_L0
+#define TRAINABLE_L0 1
+#endif
+#ifndef TRAINABLE_L2
+#define TRAINABLE_L2 1
+#endif
+
+// Parameter-efficient training of layer 2: frozen weights, trained bias (BIAS_ONLY_L2) or low-rank adapter (LORA_RANK_L2)
+#ifdef BIAS_ONLY_L2
+PI_L1 struct blob layer2_bias;
+PI_L1 float l2_bias[Tout_C_l2*Tout_H_l2*Tout_W_l2];
+PI_L1 float l2_bias_diff[Tout_C_l2*Tout_H_l2*Tout_W_l2];
+#endif
+#ifdef LORA_RANK_L2
+PI_L1 struct blob layer2_lora_A, layer2_lora_B;
+PI_L1 float l2_lora_A[Tout_C_l2*Tout_H_l2*Tout_W_l2*LORA_RANK_L2];
+PI_L1 float l2_lora_A_diff[Tout_C_l2*Tout_H_l2*Tout_W_l2*LORA_RANK_L2];
+PI_L1 float l2_lora_B[LORA_RANK_L2*Tin_C_l2*Tin_H_l2*Tin_W_l2];
+PI_L1 float l2_lora_B_diff[LORA_RANK_L2*Tin_C_l2*Tin_H_l2*Tin_W_l2];
+PI_L1 float l2_lora_buffer[2*LORA_RANK_L2];
+#endif
+#if defined(BIAS_ONLY_L2) || defined(LORA_RANK_L2)
+#define SKIP_WGT_GRAD_L2 1
+#else
+#define SKIP_WGT_GRAD_L2 0
+#endif
+
+#ifdef AMP
+// Mixed precision: fp16 copies of the network, the fp32 tensors above keep the master weights and the loss
+// (the fp32 activations and gradients between the layers and the im2col buffer are not allocated, their blobs only give the shapes)
+#if defined(CHECKPOINTING) || defined(SPARSE_UPDATE_L0) || SKIP_WGT_GRAD_L2 || defined(REPLAY)
+#error "AMP does not support checkpointing, sparse, bias-only and LoRA updates, and replay"
+#endif
+#ifndef AMP_INIT_SCALE
+#define AMP_INIT_SCALE 1024.0f
+#endif
+#ifndef AMP_GROWTH_INTERVAL
+#define AMP_GROWTH_INTERVAL 100
+#endif
+PI_L1 struct blob_fp16 layer0_in_fp16, layer0_wgt_fp16, layer0_out_fp16;
+PI_L1 struct blob_fp16 layer1_in_fp16, layer1_out_fp16;
+PI_L1 struct blob_fp16 layer2_in_fp16, layer2_wgt_fp16, layer2_out_fp16;
+PI_L1 struct Conv2D_args_fp16 l0_args_fp16;
+PI_L1 struct act_args_fp16 l1_args_fp16;
+PI_L1 struct Linear_args_fp16 l2_args_fp16;
+PI_L1 fp16 l0_ker_fp16[Tin_C_l0 * Tout_C_l0 * Tker_H_l0 * Tker_W_l0];
+PI_L1 fp16 l2_ker_fp16[Tin_C_l2 * Tout_C_l2 * Tker_H_l2 * Tker_W_l2];
+PI_L1 fp16 l0_ker_diff_fp16[Tin_C_l0 * Tout_C_l0 * Tker_H_l0 * Tker_W_l0];
+PI_L1 fp16 l2_ker_diff_fp16[Tin_C_l2 * Tout_C_l2 * Tker_H_l2 * Tker_W_l2];
+PI_L1 fp16 l0_in_fp16[Tin_C_l0 * Tin_H_l0 * Tin_W_l0];
+PI_L1 fp16 l1_in_fp16[Tin_C_l1 * Tin_H_l1 * Tin_W_l1];
+PI_L1 fp16 l2_in_fp16[Tin_C_l2 * Tin_H_l2 * Tin_W_l2];
+PI_L1 fp16 l2_out_fp16[Tout_C_l2 * Tout_H_l2 * Tout_W_l2];
+PI_L1 fp16 l1_in_diff_fp16[Tin_C_l1 * Tin_H_l1 * Tin_W_l1];
+PI_L1 fp16 l2_in_diff_fp16[Tin_C_l2 * Tin_H_l2 * Tin_W_l2];
+PI_L1 fp16 l2_out_diff_fp16[Tout_C_l2 * Tout_H_l2 * Tout_W_l2];
+PI_L1 fp16 im2col_buffer_fp16[Tout_C_l0*Tker_H_l0*Tker_W_l0*Tin_H_l0*Tin_W_l0];
+PI_L1 fp16 bt_buffer_fp16[1];
+PI_L1 struct amp_args amp;
+PI_L1 struct amp_param amp_params[2];
+PI_L1 int amp_num_params;
+PI_L1 int amp_flags[NUM_CORES];
+#endif
+
+// Layer-chain training (see pulp_net_fp32.h), used by checkpointing, frozen layers, sparse and parameter-efficient updates, mixed precision
+#if defined(CHECKPOINTING) || !TRAINABLE_L0 || !TRAINABLE_L2 || defined(SPARSE_UPDATE_L0) || SKIP_WGT_GRAD_L2 || defined(AMP)
+#define NET_CHAIN
+PI_L1 struct net_layer net_layers[3];
+PI_L1 struct net_args net_args;
+#endif
+
+#ifdef CHECKPOINTING
+// Checkpointed layers (bit i keeps the input of layer i), used if no CHECKPOINT_BUDGET is given
+#ifndef CHECKPOINT_MASK
+#define CHECKPOINT_MASK 0x5
+#endif
+// L1 pool of the intermediate activations: the checkpointed inputs, then the arena of the recomputed segments.
+// With CHECKPOINT_BUDGET, the plan keeps them within the budget; no plan needs more than all the activations
+#define CHECKPOINT_ALL_SIZE (Tin_C_l1*Tin_H_l1*Tin_W_l1 + Tin_C_l2*Tin_H_l2*Tin_W_l2)
+#ifndef CHECKPOINT_POOL_SIZE
+#if defined(CHECKPOINT_BUDGET) && (CHECKPOINT_BUDGET < CHECKPOINT_ALL_SIZE)
+#define CHECKPOINT_POOL_SIZE (CHECKPOINT_BUDGET)
+#else
+#define CHECKPOINT_POOL_SIZE (CHECKPOINT_ALL_SIZE)
+#endif
+#endif
+PI_L1 int checkpoint[3];
+PI_L1 float ckpt_pool[CHECKPOINT_POOL_SIZE];
+// The layer inputs are placed in the pool in DNN_init()
+#define l1_in (ckpt_pool)
+#define l2_in (ckpt_pool)
+#endif
+
 
 
 /**
@@ -78,39 +247,51 @@ void DNN_init()
   layer0_in.H = Tin_H_l0;
   layer0_in.W = Tin_W_l0;
   layer0_wgt.data = l0_ker;
+  #ifndef AMP
   layer0_wgt.diff = l0_ker_diff;
+  #endif
   layer0_wgt.dim = Tin_C_l0*Tout_C_l0*Tker_H_l0*Tker_W_l0;
   layer0_wgt.C = Tin_C_l0;
   layer0_wgt.H = Tker_H_l0;
   layer0_wgt.W = Tker_W_l0;
+  #ifndef AMP
   layer0_out.data = l1_in;
   layer0_out.diff = l1_in_diff;
+  #endif
   layer0_out.dim = Tin_C_l1*Tin_H_l1*Tin_W_l1;
   layer0_out.C = Tout_C_l0;
   layer0_out.H = Tout_H_l0;
   layer0_out.W = Tout_W_l0;
   // Layer 1
+  #ifndef AMP
   layer1_in.data = l1_in;
   layer1_in.diff = l1_in_diff;
+  #endif
   layer1_in.dim = Tin_C_l1*Tin_H_l1*Tin_W_l1;
   layer1_in.C = Tin_C_l1;
   layer1_in.H = Tin_H_l1;
   layer1_in.W = Tin_W_l1;
+  #ifndef AMP
   layer1_out.data = l2_in;
   layer1_out.diff = l2_in_diff;
+  #endif
   layer1_out.dim = Tin_C_l2*Tin_H_l2*Tin_W_l2;
   layer1_out.C = Tout_C_l1;
   layer1_out.H = Tout_H_l1;
   layer1_out.W = Tout_W_l1;
   // Layer 2
+  #ifndef AMP
   layer2_in.data = l2_in;
   layer2_in.diff = l2_in_diff;
+  #endif
   layer2_in.dim = Tin_C_l2*Tin_H_l2*Tin_W_l2;
   layer2_in.C = Tin_C_l2;
   layer2_in.H = Tin_H_l2;
   layer2_in.W = Tin_W_l2;
   layer2_wgt.data = l2_ker;
+  #ifndef AMP
   layer2_wgt.diff = l2_ker_diff;
+  #endif
   layer2_wgt.dim = Tin_C_l2*Tout_C_l2*Tker_H_l2*Tker_W_l2;
   layer2_wgt.C = Tin_C_l2;
   layer2_wgt.H = Tker_H_l2;
@@ -134,7 +315,9 @@ void DNN_init()
   l0_args.Dpad = 0;
   l0_args.stride_h = 1;
   l0_args.stride_w = 1;
+  #ifndef AMP
   l0_args.i2c_buffer = (float*) im2col_buffer;
+  #endif
   l0_args.bt_buffer = (float*) bt_buffer;
   l0_args.HWC = 0;
   l0_args.opt_matmul_type_fw = MATMUL_TYPE_FW_L0;
@@ -142,6 +325,17 @@ void DNN_init()
   l0_args.opt_matmul_type_ig = MATMUL_TYPE_IG_L0;
   l0_args.USE_IM2COL = 1;
   l0_args.USE_DMA_IM2COL = 0;
+  l0_args.update_rows = NULL;
+  l0_args.num_update_rows = 0;
+  l0_args.bias = NULL;
+  l0_args.skip_wgt_grad = 0;
+  l0_args.lora_A = NULL;
+  l0_args.lora_B = NULL;
+  #ifdef SPARSE_UPDATE_L0
+  for (int i=0; i<Tout_C_l0; i++)   l0_update_mask[i] = (i < UPDATE_CHANNELS_L0);
+  l0_args.update_rows = l0_update_rows;
+  l0_args.num_update_rows = sparse_rows_from_mask(l0_update_mask, Tout_C_l0, l0_update_rows);
+  #endif
   // Layer 1
   l1_args.input = &layer1_in;
   l1_args.output = &layer1_out;
@@ -153,20 +347,324 @@ void DNN_init()
   l2_args.opt_matmul_type_fw = MATMUL_TYPE_FW_L2;
   l2_args.opt_matmul_type_wg = MATMUL_TYPE_WG_L2;
   l2_args.opt_matmul_type_ig = MATMUL_TYPE_IG_L2;
+  l2_args.update_rows = NULL;
+  l2_args.num_update_rows = 0;
+  l2_args.bias = NULL;
+  l2_args.skip_wgt_grad = SKIP_WGT_GRAD_L2;
+  l2_args.lora_A = NULL;
+  l2_args.lora_B = NULL;
+  #ifdef BIAS_ONLY_L2
+  for (int i=0; i<Tout_C_l2*Tout_H_l2*Tout_W_l2; i++)   l2_bias[i] = 0.0f;
+  layer2_bias.data = l2_bias;
+  layer2_bias.diff = l2_bias_diff;
+  layer2_bias.dim = Tout_C_l2*Tout_H_l2*Tout_W_l2;
+  l2_args.bias = &layer2_bias;
+  #endif
+  #ifdef LORA_RANK_L2
+  // A starts from zero, so that the adapter does not change the pretrained layer
+  for (int i=0; i<Tout_C_l2*Tout_H_l2*Tout_W_l2*LORA_RANK_L2; i++)   l2_lora_A[i] = 0.0f;
+  for (int i=0; i<LORA_RANK_L2*Tin_C_l2*Tin_H_l2*Tin_W_l2; i++)      l2_lora_B[i] = 0.01f * (float) ((i*7) % 11 - 5);
+  layer2_lora_A.data = l2_lora_A;
+  layer2_lora_A.diff = l2_lora_A_diff;
+  layer2_lora_A.dim = Tout_C_l2*Tout_H_l2*Tout_W_l2*LORA_RANK_L2;
+  layer2_lora_B.data = l2_lora_B;
+  layer2_lora_B.diff = l2_lora_B_diff;
+  layer2_lora_B.dim = LORA_RANK_L2*Tin_C_l2*Tin_H_l2*Tin_W_l2;
+  l2_args.lora_A = &layer2_lora_A;
+  l2_args.lora_B = &layer2_lora_B;
+  l2_args.lora_rank = LORA_RANK_L2;
+  l2_args.lora_buffer = l2_lora_buffer;
+  #endif
+
+  #ifdef AMP
+  // fp16 copies of the tensors, same shapes as the fp32 ones
+  for(int i=0; i<Tin_C_l0*Tout_C_l0*Tker_H_l0*Tker_W_l0; i++)		l0_ker_fp16[i] = (fp16) l0_ker[i];
+  for(int i=0; i<Tin_C_l2*Tout_C_l2*Tker_H_l2*Tker_W_l2; i++)		l2_ker_fp16[i] = (fp16) l2_ker[i];
+  layer0_in_fp16.data = l0_in_fp16;
+  layer0_in_fp16.dim = layer0_in.dim;
+  layer0_in_fp16.C = layer0_in.C;
+  layer0_in_fp16.H = layer0_in.H;
+  layer0_in_fp16.W = layer0_in.W;
+  layer0_wgt_fp16.data = l0_ker_fp16;
+  layer0_wgt_fp16.diff = l0_ker_diff_fp16;
+  layer0_wgt_fp16.dim = layer0_wgt.dim;
+  layer0_wgt_fp16.C = layer0_wgt.C;
+  layer0_wgt_fp16.H = layer0_wgt.H;
+  layer0_wgt_fp16.W = layer0_wgt.W;
+  layer0_out_fp16.data = l1_in_fp16;
+  layer0_out_fp16.diff = l1_in_diff_fp16;
+  layer0_out_fp16.dim = layer0_out.dim;
+  layer0_out_fp16.C = layer0_out.C;
+  layer0_out_fp16.H = layer0_out.H;
+  layer0_out_fp16.W = layer0_out.W;
+  layer1_in_fp16.data = l1_in_fp16;
+  layer1_in_fp16.diff = l1_in_diff_fp16;
+  layer1_in_fp16.dim = layer1_in.dim;
+  layer1_in_fp16.C = layer1_in.C;
+  layer1_in_fp16.H = layer1_in.H;
+  layer1_in_fp16.W = layer1_in.W;
+  layer1_out_fp16.data = l2_in_fp16;
+  layer1_out_fp16.diff = l2_in_diff_fp16;
+  layer1_out_fp16.dim = layer1_out.dim;
+  layer1_out_fp16.C = layer1_out.C;
+  layer1_out_fp16.H = layer1_out.H;
+  layer1_out_fp16.W = layer1_out.W;
+  layer2_in_fp16.data = l2_in_fp16;
+  layer2_in_fp16.diff = l2_in_diff_fp16;
+  layer2_in_fp16.dim = layer2_in.dim;
+  layer2_in_fp16.C = layer2_in.C;
+  layer2_in_fp16.H = layer2_in.H;
+  layer2_in_fp16.W = layer2_in.W;
+  layer2_wgt_fp16.data = l2_ker_fp16;
+  layer2_wgt_fp16.diff = l2_ker_diff_fp16;
+  layer2_wgt_fp16.dim = layer2_wgt.dim;
+  layer2_wgt_fp16.C = layer2_wgt.C;
+  layer2_wgt_fp16.H = layer2_wgt.H;
+  layer2_wgt_fp16.W = layer2_wgt.W;
+  layer2_out_fp16.data = l2_out_fp16;
+  layer2_out_fp16.diff = l2_out_diff_fp16;
+  layer2_out_fp16.dim = layer2_out.dim;
+  layer2_out_fp16.C = layer2_out.C;
+  layer2_out_fp16.H = layer2_out.H;
+  layer2_out_fp16.W = layer2_out.W;
+
+  // Layer 0
+  l0_args_fp16.input = &layer0_in_fp16;
+  l0_args_fp16.coeff = &layer0_wgt_fp16;
+  l0_args_fp16.output = &layer0_out_fp16;
+  l0_args_fp16.skip_in_grad = 1;
+  l0_args_fp16.Lpad = 0;
+  l0_args_fp16.Rpad = 0;
+  l0_args_fp16.Upad = 0;
+  l0_args_fp16.Dpad = 0;
+  l0_args_fp16.stride_h = 1;
+  l0_args_fp16.stride_w = 1;
+  l0_args_fp16.i2c_buffer = im2col_buffer_fp16;
+  l0_args_fp16.bt_buffer = bt_buffer_fp16;
+  l0_args_fp16.HWC = 0;
+  l0_args_fp16.opt_matmul_type_fw = MATMUL_TYPE_FW_L0;
+  l0_args_fp16.opt_matmul_type_wg = MATMUL_TYPE_WG_L0;
+  l0_args_fp16.opt_matmul_type_ig = MATMUL_TYPE_IG_L0;
+  l0_args_fp16.USE_IM2COL = 1;
+  l0_args_fp16.USE_DMA_IM2COL = 0;
+  // Layer 1
+  l1_args_fp16.input = &layer1_in_fp16;
+  l1_args_fp16.output = &layer1_out_fp16;
+  // Layer 2
+  l2_args_fp16.input = &layer2_in_fp16;
+  l2_args_fp16.coeff = &layer2_wgt_fp16;
+  l2_args_fp16.output = &layer2_out_fp16;
+  l2_args_fp16.skip_in_grad = 0;
+  l2_args_fp16.opt_matmul_type_fw = MATMUL_TYPE_FW_L2;
+  l2_args_fp16.opt_matmul_type_wg = MATMUL_TYPE_WG_L2;
+  l2_args_fp16.opt_matmul_type_ig = MATMUL_TYPE_IG_L2;
+
+  // The optimizer updates the fp32 master weights of the trainable layers
+  amp_num_params = 0;
+  if (TRAINABLE_L0) {
+    amp_params[amp_num_params].master = &layer0_wgt;
+    amp_params[amp_num_params].weights = &layer0_wgt_fp16;
+    amp_num_params++;
+  }
+  if (TRAINABLE_L2) {
+    amp_params[amp_num_params].master = &layer2_wgt;
+    amp_params[amp_num_params].weights = &layer2_wgt_fp16;
+    amp_num_params++;
+  }
+  amp.scale = AMP_INIT_SCALE;
+  amp.growth_factor = 2.0f;
+  amp.backoff_factor = 0.5f;
+  amp.growth_interval = AMP_GROWTH_INTERVAL;
+  amp.min_scale = 1.0f;
+  amp.max_scale = 65536.0f;
+  amp.flags = amp_flags;
+  pulp_amp_init(&amp);
+  #endif
+
+  #ifdef REPLAY
+  // Configure the replay buffer on the input of layer 2
+  replay.storage = replay_storage;
+  replay.capacity = REPLAY_CAPACITY;
+  replay.act_size = Tin_C_l2*Tin_H_l2*Tin_W_l2;
+  replay.label_size = Tout_C_l2*Tout_H_l2*Tout_W_l2;
+  replay.format = REPLAY_FORMAT;
+  replay.policy = REPLAY_POLICY;
+  replay.num_classes = Tout_C_l2*Tout_H_l2*Tout_W_l2;
+  replay.classes = replay_classes;
+  replay.class_count = replay_class_count;
+  replay.l1_buffer = replay_buffer;
+  replay.partial = replay_partial;
+  replay.seed = 0x5678;
+  replay.output = &layer2_in;
+  pulp_replay_init(&replay);
+  #endif
+
+  #ifdef SELECTIVE_BP
+  selective.policy = SELECTIVE_POLICY;
+  selective.threshold = SELECTIVE_THRESHOLD;
+  selective.percentile = SELECTIVE_PERCENTILE;
+  selective.beta = SELECTIVE_BETA;
+  selective.history = selective_history;
+  selective.history_size = SELECTIVE_HISTORY;
+  selective.seed = 0x9abc;
+  pulp_selective_init(&selective);
+  #endif
+
+  #ifdef DATASET
+  // Configure the dataset and start loading the first sample
+  dataset.inputs = DATASET_SAMPLES;
+  dataset.labels = DATASET_SAMPLES + DATASET_SIZE*IN_SIZE;
+  dataset.num_samples = DATASET_SIZE;
+  dataset.input_size = IN_SIZE;
+  dataset.label_size = OUT_SIZE;
+  dataset.index = dataset_index;
+  dataset.l1_buffer = dataset_buffer;
+  dataset.shuffle = DATASET_SHUFFLE;
+  dataset.seed = 0x1234;
+  dataset.input = &layer0_in;
+  pulp_dataset_init(&dataset);
+  #endif
+
+  #ifdef NET_CHAIN
+  // Describe the network as a chain of layers
+  net_layers[0].fw = pulp_conv2d_fp32_fw_cl;
+  net_layers[0].bw = pulp_conv2d_fp32_bw_cl;
+  net_layers[0].bw_param = pulp_conv2d_fp32_bw_param_grads_cl;
+  net_layers[0].bw_input = pulp_conv2d_fp32_bw_input_grads_cl;
+  net_layers[0].args = &l0_args;
+  net_layers[0].input = &layer0_in;
+  net_layers[0].output = &layer0_out;
+  net_layers[0].coeff = &layer0_wgt;
+  net_layers[0].trainable = TRAINABLE_L0;
+  net_layers[0].fw_cost = Tout_C_l0*Tin_C_l0*Tker_H_l0*Tker_W_l0*Tout_H_l0*Tout_W_l0;
+  net_layers[0].update_rows = l0_args.update_rows;
+  net_layers[0].num_update_rows = l0_args.num_update_rows;
+  net_layers[0].bias = l0_args.bias;
+  net_layers[0].lora_A = l0_args.lora_A;
+  net_layers[0].lora_B = l0_args.lora_B;
+  net_layers[0].skip_wgt_grad = l0_args.skip_wgt_grad;
+  net_layers[1].fw = pulp_relu_fp32_fw_cl;
+  net_layers[1].bw = pulp_relu_fp32_bw_cl;
+  net_layers[1].bw_param = NULL;
+  net_layers[1].bw_input = NULL;
+  net_layers[1].args = &l1_args;
+  net_layers[1].input = &layer1_in;
+  net_layers[1].output = &layer1_out;
+  net_layers[1].coeff = NULL;
+  net_layers[1].trainable = 0;
+  net_layers[1].fw_cost = Tin_C_l1*Tin_H_l1*Tin_W_l1;
+  net_layers[1].update_rows = NULL;
+  net_layers[1].num_update_rows = 0;
+  net_layers[1].bias = NULL;
+  net_layers[1].lora_A = NULL;
+  net_layers[1].lora_B = NULL;
+  net_layers[1].skip_wgt_grad = 0;
+  net_layers[2].fw = pulp_linear_fp32_fw_cl;
+  net_layers[2].bw = pulp_linear_fp32_bw_cl;
+  net_layers[2].bw_param = pulp_linear_fp32_bw_param_grads_cl;
+  net_layers[2].bw_input = pulp_linear_fp32_bw_input_grads_cl;
+  net_layers[2].args = &l2_args;
+  net_layers[2].input = &layer2_in;
+  net_layers[2].output = &layer2_out;
+  net_layers[2].coeff = &layer2_wgt;
+  net_layers[2].trainable = TRAINABLE_L2;
+  net_layers[2].fw_cost = Tin_C_l2*Tout_C_l2;
+  net_layers[2].update_rows = NULL;
+  net_layers[2].num_update_rows = 0;
+  net_layers[2].bias = l2_args.bias;
+  net_layers[2].lora_A = l2_args.lora_A;
+  net_layers[2].lora_B = l2_args.lora_B;
+  net_layers[2].skip_wgt_grad = l2_args.skip_wgt_grad;
+
+  #ifdef AMP
+  // Same chain on the fp16 primitives (coeff keeps pointing to the fp32 master weights, which mark the trainable layers)
+  net_layers[0].fw = pulp_conv2d_fp16_fw_cl;
+  net_layers[0].bw = pulp_conv2d_fp16_bw_cl;
+  net_layers[0].bw_param = pulp_conv2d_fp16_bw_param_grads_cl;
+  net_layers[0].bw_input = pulp_conv2d_fp16_bw_input_grads_cl;
+  net_layers[0].args = &l0_args_fp16;
+  net_layers[1].fw = pulp_relu_fp16_fw_cl;
+  net_layers[1].bw = pulp_relu_fp16_bw_cl;
+  net_layers[1].args = &l1_args_fp16;
+  net_layers[2].fw = pulp_linear_fp16_fw_cl;
+  net_layers[2].bw = pulp_linear_fp16_bw_cl;
+  net_layers[2].bw_param = pulp_linear_fp16_bw_param_grads_cl;
+  net_layers[2].bw_input = pulp_linear_fp16_bw_input_grads_cl;
+  net_layers[2].args = &l2_args_fp16;
+  #endif
+
+  net_args.layers = net_layers;
+  net_args.num_layers = 3;
+  net_args.checkpoint = NULL;
+  net_args.arena = NULL;
+  net_args.offload = 0;
+  net_args.l2_buffer = NULL;
+  #endif
+
+  #ifdef CHECKPOINTING
+  net_args.checkpoint = checkpoint;
+
+  #ifdef CHECKPOINT_BUDGET
+  pulp_net_checkpoint_plan(&net_args, CHECKPOINT_BUDGET);
+  #else
+  for (int i=0; i<3; i++)   checkpoint[i] = (CHECKPOINT_MASK >> i) & 1;
+  #endif
+
+  int ckpt_memory = 0;
+  int ckpt_arena = 0;
+  int ckpt_recompute = pulp_net_checkpoint_cost(&net_args, &ckpt_memory, &ckpt_arena);
+  printf("Checkpointing: %d activation elements in L1, %d recomputed forward ops per step\n", ckpt_memory, ckpt_recompute);
+
+  // Checkpointed inputs at the start of the pool, the arena of the recomputed segments after them
+  float * ckpt_ptr = ckpt_pool;
+  for (int i=1; i<3; i++) {
+    if (checkpoint[i]) {
+      net_layers[i].input->data = ckpt_ptr;
+      net_layers[i-1].output->data = ckpt_ptr;
+      ckpt_ptr += net_layers[i].input->dim;
+    }
+  }
+  if ((ckpt_ptr - ckpt_pool) + ckpt_arena > CHECKPOINT_POOL_SIZE) printf("\n*** CHECKPOINT POOL TOO SMALL (%d needed) ***\n", (int) (ckpt_ptr - ckpt_pool) + ckpt_arena);
+  net_args.arena = ckpt_ptr;
+  pulp_net_checkpoint_bind(&net_args);
+  #endif
 }
 
 
 // Forward pass function
 void forward()
 {
+  #ifdef AMP
+  // fp16 input, the output is cast back to fp32 for the loss
+  struct cast_32t16_args cast_in;
+  cast_in.source = layer0_in.data;
+  cast_in.destination = l0_in_fp16;
+  cast_in.size = Tin_C_l0*Tin_H_l0*Tin_W_l0;
+  pi_cl_team_fork(NUM_CORES, cast_fp32_tensor_to_fp16, &cast_in);
+  pulp_net_fp32_fw(&net_args);
+  struct cast_16t32_args cast_out;
+  cast_out.source = l2_out_fp16;
+  cast_out.destination = l2_out;
+  cast_out.size = Tout_C_l2*Tout_H_l2*Tout_W_l2;
+  pi_cl_team_fork(NUM_CORES, cast_fp16_tensor_to_fp32, &cast_out);
+  #elif defined(NET_CHAIN)
+  pulp_net_fp32_fw(&net_args);
+  #else
   pulp_conv2d_fp32_fw_cl(&l0_args);
   pulp_relu_fp32_fw_cl(&l1_args);
   pulp_linear_fp32_fw_cl(&l2_args);
+  #endif
 }
 
 // Backward pass function
 void backward()
 {
+  #ifdef NET_CHAIN
+  // Segments are recomputed from their checkpoint, then back-propagated down to the lowest trainable layer
+  pulp_net_fp32_bw(&net_args);
+  return;
+  #endif
+
   /**
    * EXERCISE 3 - BACKWARD
   */
@@ -182,7 +680,11 @@ void backward()
 void compute_loss()
 {
   loss_args.output = &layer2_out;
+  #ifdef DATASET
+  loss_args.target = dataset.label;
+  #else
   loss_args.target = LABEL;
+  #endif
   loss_args.wr_loss = &loss;
   /**
    * EXERCISE 2 - LOSS FUNCTION
@@ -191,13 +693,67 @@ void compute_loss()
   /**
    * END OF EXERCISE 2 - LOSS FUNCTION
   */
+
+  #ifdef AMP
+  // The fp16 backward starts from the scaled output gradient
+  pulp_amp_scale_grad(&amp, l2_out_diff, l2_out_diff_fp16, Tout_C_l2*Tout_H_l2*Tout_W_l2);
+  #endif
+}
+
+#ifdef REPLAY
+// Class of a sample, as the argmax of its label
+int label_class(float * label)
+{
+  int class = 0;
+  for (int i=1; i<Tout_C_l2*Tout_H_l2*Tout_W_l2; i++)
+    if (label[i] > label[class]) class = i;
+  return class;
+}
+
+// Trains the tail (layer 2) on a latent activation from the replay buffer
+void replay_step()
+{
+  pulp_replay_next(&replay);
+  pulp_linear_fp32_fw_cl(&l2_args);
+
+  loss_args.output = &layer2_out;
+  loss_args.target = replay.label;
+  loss_args.wr_loss = &loss;
+  pulp_MSELoss(&loss_args);
+
+  pulp_linear_fp32_bw_param_grads_cl(&l2_args);
+  #ifdef NET_CHAIN
+  // Same update as in the chain (frozen weights, bias, adapter)
+  struct net_args tail_args = net_args;
+  tail_args.layers = &net_layers[2];
+  tail_args.num_layers = 1;
+  pulp_net_fp32_update(&tail_args, LEARNING_RATE);
+  #else
+  struct optim_args opt_l2;
+  opt_l2.weights = &layer2_wgt;
+  opt_l2.learning_rate = LEARNING_RATE;
+  pi_cl_team_fork(NUM_CORES, pulp_gradient_descent_fp32, &opt_l2);
+  #endif
 }
+#endif
 
 /**
  * EXERCISE 4 - WEIGHT UPDATE
 */
 void update_weights()
 {
+  #ifdef AMP
+  // Skipped if the scaled gradients overflow
+  pulp_amp_update(&amp, amp_params, amp_num_params, LEARNING_RATE);
+  return;
+  #endif
+
+  #ifdef NET_CHAIN
+  // Frozen layers are skipped
+  pulp_net_fp32_update(&net_args, LEARNING_RATE);
+  return;
+  #endif
+
   struct optim_args opt_l0;
   opt_l0.weights = /* YOUR CODE HERE, REMOVE NULL; */ NULL;
   opt_l0.learning_rate = LEARNING_RATE;
@@ -239,13 +795,27 @@ void print_gradients()
   printf("Layer 2 output gradient:\n");
   for (int i=0; i<Tout_C_l2*Tout_H_l2*Tout_W_l2; i++) printf("%f ", l2_out_diff[i]);
   printf("\n\nLayer 2 weight gradient:\n");
+  #ifdef AMP
+  for (int i=0; i<Tout_C_l2*Tin_C_l2*Tker_H_l2*Tker_W_l2; i++) printf("%f ", (float) l2_ker_diff_fp16[i]);
+  #else
   for (int i=0; i<Tout_C_l2*Tin_C_l2*Tker_H_l2*Tker_W_l2; i++) printf("%f ", l2_ker_diff[i]);
+  #endif
   printf("\n\nLayer 2 input gradient:\n");
+  #ifdef AMP
+  for (int i=0; i<Tin_C_l2*Tout_H_l2*Tout_W_l2; i++) printf("%f ", (float) l2_in_diff_fp16[i]);
+  printf("\n\nLayer 1 input gradient:\n");
+  for (int i=0; i<Tout_C_l2*Tout_H_l2*Tout_W_l2; i++) printf("%f ", (float) l1_in_diff_fp16[i]);
+  #else
   for (int i=0; i<Tin_C_l2*Tout_H_l2*Tout_W_l2; i++) printf("%f ", l2_in_diff[i]);
   printf("\n\nLayer 1 input gradient:\n");
   for (int i=0; i<Tout_C_l2*Tout_H_l2*Tout_W_l2; i++) printf("%f ", l1_in_diff[i]);
+  #endif
   printf("\n\nLayer 0 weight gradient:\n");
-  for (int i=0; i<Tout_C_l0*Tin_C_l0*Tker_H_l0*Tker_W_l0; i++) printf("%f ", l0_ker_diff[i]);
+  #ifdef AMP
+  for (int i=0; i<UPDATE_CHANNELS_L0*Tin_C_l0*Tker_H_l0*Tker_W_l0; i++) printf("%f ", (float) l0_ker_diff_fp16[i]);
+  #else
+  for (int i=0; i<UPDATE_CHANNELS_L0*Tin_C_l0*Tker_H_l0*Tker_W_l0; i++) printf("%f ", l0_ker_diff[i]);
+  #endif
   printf("\n\n");
 }
 
@@ -300,6 +870,16 @@ void check_post_training_output()
 
 
 
+#ifdef DATASET_HOSTFS
+// Reads the dataset dumped by GM.py into L2 (called by the fabric controller)
+int load_dataset()
+{
+  return pulp_dataset_load_file("dataset.bin", DATASET_SAMPLES, sizeof(DATASET_SAMPLES));
+}
+#endif
+
+
+
 /**
  * DNN MODEL TRAINING
 **/
@@ -348,42 +928,91 @@ void net_step()
    * END OF EXERCISE 5 - DNN TRAINING
   */
 
+  #ifdef SELECTIVE_BP
+  // Cycle counter for the backward and update of the selected samples. Only differences of pi_perf_read() are used,
+  // so the counters are started but not reset (START_STATS() around the training loop keeps its count)
+  #if !defined(STATS) && !defined(BOARD)
+  pi_perf_conf(1<<PI_PERF_CYCLES);
+  #endif
+  pi_perf_start();
+  #endif
+
 
   for (int epoch=0; epoch<EPOCHS; epoch++)
   {
-    forward();
-
-    /**
-     * EXERCISE 2 - LOSS FUNCTION
-    */
-    compute_loss();
-    /**
-     * END OF EXERCISE 2 - LOSS FUNCTION
-    */
+    for (int sample=0; sample<NUM_SAMPLES; sample++)
+    {
+      #ifdef DATASET
+      // Train on the prefetched sample while the next one is loaded
+      pulp_dataset_next(&dataset);
+      #endif
+
+      forward();
+
+      /**
+       * EXERCISE 2 - LOSS FUNCTION
+      */
+      compute_loss();
+      /**
+       * END OF EXERCISE 2 - LOSS FUNCTION
+      */
+
+      #ifdef SELECTIVE_BP
+      // Easy samples skip backward, update and replay
+      if (!pulp_selective_select(&selective, loss)) continue;
+      unsigned long bp_start = pi_perf_read(PI_PERF_CYCLES);
+      #endif
     
-    /**
-     * EXERCISE 3 - BACKWARD
-    */
-    //START_STATS();
-    backward();
-    //STOP_STATS();
-    /**
-     * END OF EXERCISE 3 - BACKWARD
-    */
-
-    /**
-     * EXERCISE 4 - UPDATE WEIGHTS
-    */
-    //printf("Weights BEFORE the update:\n");
-    //print_weights();
-    update_weights();
-    //printf("Weights AFTER the update:\n");
-    //print_weights();
-    /**
-     * END OF EXERCISE 4 - UPDATE WEIGHTS
-    */
+      /**
+       * EXERCISE 3 - BACKWARD
+      */
+      //START_STATS();
+      backward();
+      //STOP_STATS();
+      /**
+       * END OF EXERCISE 3 - BACKWARD
+      */
+
+      /**
+       * EXERCISE 4 - UPDATE WEIGHTS
+      */
+      //printf("Weights BEFORE the update:\n");
+      //print_weights();
+      update_weights();
+      //printf("Weights AFTER the update:\n");
+      //print_weights();
+      /**
+       * END OF EXERCISE 4 - UPDATE WEIGHTS
+      */
+
+      #ifdef SELECTIVE_BP
+      // A START_STATS() around the backward resets the counters: count from there
+      unsigned long bp_stop = pi_perf_read(PI_PERF_CYCLES);
+      selective.bp_cycles += bp_stop >= bp_start ? bp_stop - bp_start : bp_stop;
+      #endif
+
+      #ifdef REPLAY
+      // Store the latent activation of the new sample, then rehearse stored ones
+      pulp_replay_add(&replay, layer2_in.data, loss_args.target, label_class(loss_args.target));
+      for (int r=0; r<REPLAY_PER_STEP; r++) replay_step();
+      #endif
+    }
   }
 
+  #ifdef SELECTIVE_BP
+  pulp_selective_report(&selective);
+  #endif
+
+  #ifdef AMP
+  pulp_amp_report(&amp);
+  #endif
+
+  #ifdef DATASET
+  // Wait for the sample prefetched after the last one, then validate on the reference input
+  pulp_dataset_finish(&dataset);
+  layer0_in.data = l0_in;
+  #endif
+
   /**
    * EXERCISE 5 - DNN TRAINING
   */
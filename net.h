@@ -11,6 +11,13 @@ void update_weights();
 void forward();
 void backward();
 void net_step();
+#ifdef REPLAY
+int label_class(float * label);
+void replay_step();
+#endif
+#ifdef DATASET_HOSTFS
+int load_dataset();
+#endif
 
 // Print and check functions
 void print_input();
@@ -18,3 +25,9 @@ void print_label();
 void print_gradients();
 void print_output();
 void check_post_training_output();
+
+// Library checks (checks.c), run instead of net_step()
+#if defined(CHECK_MHSA_KV) || defined(CHECK_RNN_FP16) || defined(CHECK_BF16) || defined(CHECK_NET_OFFLOAD)
+#define CHECKS
+void check_step();
+#endif
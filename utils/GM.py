@@ -8,6 +8,28 @@ import math
 learning_rate = 0.1			# CHANGE ME
 batch_size = 1				# DO NOT CHANGE ME
 epochs = 1					# CHANGE ME
+dataset_size = 0			# CHANGE ME: if > 0, trains over a random dataset of this size (compile with -DDATASET)
+dataset_in_file = False		# CHANGE ME: if True, the dataset is dumped to dataset.bin and read from the host (compile with -DDATASET_HOSTFS)
+rnn_check = False			# CHANGE ME: if True, dumps the golden model of a tanh nn.RNN to rnn_data.h (compile with -DCHECK_RNN_FP16)
+bf16_check = False			# CHANGE ME: if True, dumps torch.bfloat16 golden models of the bf16 primitives to bf16_data.h (compile with -DCHECK_BF16)
+
+# RNN CHECK SIZES (timesteps, input size, hidden size)
+rnn_seq_len = 8
+rnn_in_size = 4
+rnn_hidden = 7
+
+# BF16 CHECK SIZES (matmul N*K times K*M, 3x3 conv2d with stride 2 and padding 1, linear, activations and losses)
+bf16_mm_n = 6
+bf16_mm_k = 16
+bf16_mm_m = 5
+bf16_conv_in_ch = 2
+bf16_conv_out_ch = 4
+bf16_conv_hin = 7
+bf16_conv_win = 6
+bf16_lin_in = 20
+bf16_lin_out = 6
+bf16_act_size = 24
+bf16_loss_size = 6
 
 # LAYER 0 SIZES
 l0_in_ch = 3
@@ -128,13 +150,22 @@ f.close()
 optimizer = optim.SGD(net.parameters(), lr=learning_rate, momentum=0)
 loss_fn = nn.MSELoss()
 
+# Dataset (visited in order, as with -DDATASET and no shuffling)
+if dataset_size > 0:
+	data_inp = torch.rand(dataset_size, l0_in_ch, l0_hin, l0_win)
+	data_lab = torch.rand(dataset_size, l2_out_ch)
+	samples = [(data_inp[i:i+1], data_lab[i]) for i in range(dataset_size)]
+else:
+	samples = [(inp, label)]
+
 # Train the DNN
 for batch in range(epochs):
-	optimizer.zero_grad()
-	out = net(inp)
-	loss = loss_fn(out, label)
-	loss.backward()
-	optimizer.step()
+	for x, y in samples:
+		optimizer.zero_grad()
+		out = net(x)
+		loss = loss_fn(out, y)
+		loss.backward()
+		optimizer.step()
 
 # Inference once after training
 out = net(inp)
@@ -147,4 +178,137 @@ out_size = (int(math.floor(l2_hin-l2_hk+2*l2_hpad+l2_hstr)/l2_hstr)) * (int(math
 f.write('#define OUT_SIZE '+str(out_size)+'\n')
 f.write('PI_L2 float REFERENCE_OUTPUT[OUT_SIZE] = {'+dump.tensor_to_string(out)+'};\n')
 f.write('PI_L1 float LABEL[OUT_SIZE] = {'+dump.tensor_to_string(label)+'};\n')
+if dataset_size > 0:
+	f.write('// Dataset (all the inputs, then all the labels)\n')
+	f.write('#define DATASET_SIZE '+str(dataset_size)+'\n')
+	if dataset_in_file:
+		torch.cat((data_inp.flatten(), data_lab.flatten())).numpy().astype('float32').tofile('dataset.bin')
+		f.write('PI_L2 float DATASET_SAMPLES[DATASET_SIZE*(IN_SIZE+OUT_SIZE)];\n')
+	else:
+		f.write('PI_L2 float DATASET_SAMPLES[DATASET_SIZE*(IN_SIZE+OUT_SIZE)] = {'+dump.tensor_to_string(data_inp.flatten())+dump.tensor_to_string(data_lab.flatten())+'};\n')
 f.close()
+
+
+# Golden model of the fp16 RNN (h_t = tanh(x_t*Wx + h_(t-1)*Ws), so Wx and Ws are the transposed weight_ih and weight_hh)
+if rnn_check:
+	rnn = nn.RNN(input_size=rnn_in_size, hidden_size=rnn_hidden, nonlinearity='tanh', bias=False, batch_first=True)
+	rnn_inp = (torch.rand(1, rnn_seq_len, rnn_in_size) - 0.5).requires_grad_()
+	rnn_h0 = torch.rand(1, 1, rnn_hidden) - 0.5
+	rnn_out, _ = rnn(rnn_inp, rnn_h0)
+	rnn_out_diff = torch.rand_like(rnn_out) - 0.5
+	rnn_out.backward(rnn_out_diff)
+
+	f = open('rnn_data.h', 'w')
+	f.write('// RNN golden model\n')
+	f.write('#define RNN_N '+str(rnn_seq_len)+'\n')
+	f.write('#define RNN_K '+str(rnn_in_size)+'\n')
+	f.write('#define RNN_M '+str(rnn_hidden)+'\n')
+	f.write('PI_L2 float RNN_INPUT[RNN_N*RNN_K] = {'+dump.tensor_to_string(rnn_inp.data[0])+'};\n')
+	f.write('PI_L2 float RNN_H0[RNN_M] = {'+dump.tensor_to_string(rnn_h0[0][0])+'};\n')
+	f.write('PI_L2 float RNN_WX[RNN_K*RNN_M] = {'+dump.tensor_to_string(rnn.weight_ih_l0.data.t())+'};\n')
+	f.write('PI_L2 float RNN_WS[RNN_M*RNN_M] = {'+dump.tensor_to_string(rnn.weight_hh_l0.data.t())+'};\n')
+	f.write('PI_L2 float RNN_OUTPUT[RNN_N*RNN_M] = {'+dump.tensor_to_string(rnn_out.data[0])+'};\n')
+	f.write('PI_L2 float RNN_OUTPUT_DIFF[RNN_N*RNN_M] = {'+dump.tensor_to_string(rnn_out_diff[0])+'};\n')
+	f.write('PI_L2 float RNN_INPUT_DIFF[RNN_N*RNN_K] = {'+dump.tensor_to_string(rnn_inp.grad[0])+'};\n')
+	f.write('PI_L2 float RNN_WX_DIFF[RNN_K*RNN_M] = {'+dump.tensor_to_string(rnn.weight_ih_l0.grad.t())+'};\n')
+	f.write('PI_L2 float RNN_WS_DIFF[RNN_M*RNN_M] = {'+dump.tensor_to_string(rnn.weight_hh_l0.grad.t())+'};\n')
+	f.close()
+
+# Golden models of the bf16 primitives: every reference is computed by torch in torch.bfloat16 (weights are dumped in the torch layout, conv2d in CHW)
+if bf16_check:
+	bf16 = torch.bfloat16
+	def bf16_rand(*size, scale=1.0):
+		return ((torch.rand(*size) - 0.5) * scale).to(bf16)
+
+	# Matmul
+	mm_a = bf16_rand(bf16_mm_n, bf16_mm_k)
+	mm_b = bf16_rand(bf16_mm_k, bf16_mm_m)
+	mm_c = torch.mm(mm_a, mm_b)
+
+	# Conv2d
+	conv = nn.Conv2d(bf16_conv_in_ch, bf16_conv_out_ch, kernel_size=3, stride=2, padding=1, bias=False).to(bf16)
+	conv_in = bf16_rand(1, bf16_conv_in_ch, bf16_conv_hin, bf16_conv_win).requires_grad_()
+	conv_out = conv(conv_in)
+	conv_out_diff = bf16_rand(*conv_out.size())
+	conv_out.backward(conv_out_diff)
+
+	# Linear
+	lin = nn.Linear(bf16_lin_in, bf16_lin_out, bias=False).to(bf16)
+	lin_in = bf16_rand(bf16_lin_in).requires_grad_()
+	lin_out = lin(lin_in)
+	lin_out_diff = bf16_rand(bf16_lin_out)
+	lin_out.backward(lin_out_diff)
+
+	# ReLU and sigmoid
+	act_in = bf16_rand(bf16_act_size, scale=8.0)
+	act_out_diff = bf16_rand(bf16_act_size)
+	relu_in = act_in.clone().requires_grad_()
+	relu_out = torch.relu(relu_in)
+	relu_out.backward(act_out_diff)
+	sigmoid_in = act_in.clone().requires_grad_()
+	sigmoid_out = torch.sigmoid(sigmoid_in)
+	sigmoid_out.backward(act_out_diff)
+
+	# MSE on the output, cross entropy on the softmax of the logits (the gradient of the library is taken at the logits)
+	loss_target = bf16_rand(bf16_loss_size)
+	mse_out = bf16_rand(bf16_loss_size).requires_grad_()
+	mse_loss = nn.MSELoss()(mse_out, loss_target)
+	mse_loss.backward()
+	ce_logits = bf16_rand(bf16_loss_size, scale=4.0).requires_grad_()
+	ce_target = torch.softmax(bf16_rand(bf16_loss_size, scale=4.0), dim=0)
+	ce_out = torch.softmax(ce_logits, dim=0)
+	ce_loss = -(ce_target * torch.log_softmax(ce_logits, dim=0)).sum()
+	ce_loss.backward()
+
+	# SGD step on the linear layer
+	sgd_wgt = lin.weight.data.clone()
+	sgd = optim.SGD(lin.parameters(), lr=learning_rate)
+	sgd.step()
+
+	f = open('bf16_data.h', 'w')
+	f.write('// BF16 golden models\n')
+	f.write('#define BF16_MM_N '+str(bf16_mm_n)+'\n')
+	f.write('#define BF16_MM_K '+str(bf16_mm_k)+'\n')
+	f.write('#define BF16_MM_M '+str(bf16_mm_m)+'\n')
+	f.write('#define BF16_CONV_CIN '+str(bf16_conv_in_ch)+'\n')
+	f.write('#define BF16_CONV_COUT '+str(bf16_conv_out_ch)+'\n')
+	f.write('#define BF16_CONV_HIN '+str(bf16_conv_hin)+'\n')
+	f.write('#define BF16_CONV_WIN '+str(bf16_conv_win)+'\n')
+	f.write('#define BF16_CONV_HOUT '+str(conv_out.size()[2])+'\n')
+	f.write('#define BF16_CONV_WOUT '+str(conv_out.size()[3])+'\n')
+	f.write('#define BF16_LIN_IN '+str(bf16_lin_in)+'\n')
+	f.write('#define BF16_LIN_OUT '+str(bf16_lin_out)+'\n')
+	f.write('#define BF16_ACT_SIZE '+str(bf16_act_size)+'\n')
+	f.write('#define BF16_LOSS_SIZE '+str(bf16_loss_size)+'\n')
+	f.write('#define BF16_LR '+str(learning_rate)+'f\n')
+	f.write('PI_L2 float BF16_MM_A[BF16_MM_N*BF16_MM_K] = {'+dump.tensor_to_string(mm_a.float())+'};\n')
+	f.write('PI_L2 float BF16_MM_B[BF16_MM_K*BF16_MM_M] = {'+dump.tensor_to_string(mm_b.float())+'};\n')
+	f.write('PI_L2 float BF16_MM_C[BF16_MM_N*BF16_MM_M] = {'+dump.tensor_to_string(mm_c.float())+'};\n')
+	f.write('PI_L2 float BF16_CONV_IN[BF16_CONV_CIN*BF16_CONV_HIN*BF16_CONV_WIN] = {'+dump.tensor_to_string(conv_in.data[0].float())+'};\n')
+	f.write('PI_L2 float BF16_CONV_WGT[BF16_CONV_COUT*BF16_CONV_CIN*3*3] = {'+dump.tensor_to_string(conv.weight.data.float())+'};\n')
+	f.write('PI_L2 float BF16_CONV_OUT[BF16_CONV_COUT*BF16_CONV_HOUT*BF16_CONV_WOUT] = {'+dump.tensor_to_string(conv_out.data[0].float())+'};\n')
+	f.write('PI_L2 float BF16_CONV_OUT_DIFF[BF16_CONV_COUT*BF16_CONV_HOUT*BF16_CONV_WOUT] = {'+dump.tensor_to_string(conv_out_diff[0].float())+'};\n')
+	f.write('PI_L2 float BF16_CONV_IN_DIFF[BF16_CONV_CIN*BF16_CONV_HIN*BF16_CONV_WIN] = {'+dump.tensor_to_string(conv_in.grad[0].float())+'};\n')
+	f.write('PI_L2 float BF16_CONV_WGT_DIFF[BF16_CONV_COUT*BF16_CONV_CIN*3*3] = {'+dump.tensor_to_string(conv.weight.grad.float())+'};\n')
+	f.write('PI_L2 float BF16_LIN_IN_DATA[BF16_LIN_IN] = {'+dump.tensor_to_string(lin_in.data.float())+'};\n')
+	f.write('PI_L2 float BF16_LIN_WGT[BF16_LIN_OUT*BF16_LIN_IN] = {'+dump.tensor_to_string(sgd_wgt.float())+'};\n')
+	f.write('PI_L2 float BF16_LIN_OUT_DATA[BF16_LIN_OUT] = {'+dump.tensor_to_string(lin_out.data.float())+'};\n')
+	f.write('PI_L2 float BF16_LIN_OUT_DIFF[BF16_LIN_OUT] = {'+dump.tensor_to_string(lin_out_diff.float())+'};\n')
+	f.write('PI_L2 float BF16_LIN_IN_DIFF[BF16_LIN_IN] = {'+dump.tensor_to_string(lin_in.grad.float())+'};\n')
+	f.write('PI_L2 float BF16_LIN_WGT_DIFF[BF16_LIN_OUT*BF16_LIN_IN] = {'+dump.tensor_to_string(lin.weight.grad.float())+'};\n')
+	f.write('PI_L2 float BF16_LIN_WGT_UPDATED[BF16_LIN_OUT*BF16_LIN_IN] = {'+dump.tensor_to_string(lin.weight.data.float())+'};\n')
+	f.write('PI_L2 float BF16_ACT_IN[BF16_ACT_SIZE] = {'+dump.tensor_to_string(act_in.float())+'};\n')
+	f.write('PI_L2 float BF16_ACT_OUT_DIFF[BF16_ACT_SIZE] = {'+dump.tensor_to_string(act_out_diff.float())+'};\n')
+	f.write('PI_L2 float BF16_RELU_OUT[BF16_ACT_SIZE] = {'+dump.tensor_to_string(relu_out.data.float())+'};\n')
+	f.write('PI_L2 float BF16_RELU_IN_DIFF[BF16_ACT_SIZE] = {'+dump.tensor_to_string(relu_in.grad.float())+'};\n')
+	f.write('PI_L2 float BF16_SIGMOID_OUT[BF16_ACT_SIZE] = {'+dump.tensor_to_string(sigmoid_out.data.float())+'};\n')
+	f.write('PI_L2 float BF16_SIGMOID_IN_DIFF[BF16_ACT_SIZE] = {'+dump.tensor_to_string(sigmoid_in.grad.float())+'};\n')
+	f.write('PI_L2 float BF16_LOSS_TARGET[BF16_LOSS_SIZE] = {'+dump.tensor_to_string(loss_target.float())+'};\n')
+	f.write('PI_L2 float BF16_MSE_OUT[BF16_LOSS_SIZE] = {'+dump.tensor_to_string(mse_out.data.float())+'};\n')
+	f.write('PI_L2 float BF16_MSE_OUT_DIFF[BF16_LOSS_SIZE] = {'+dump.tensor_to_string(mse_out.grad.float())+'};\n')
+	f.write('PI_L2 float BF16_MSE_LOSS = '+str(mse_loss.item())+'f;\n')
+	f.write('PI_L2 float BF16_CE_TARGET[BF16_LOSS_SIZE] = {'+dump.tensor_to_string(ce_target.float())+'};\n')
+	f.write('PI_L2 float BF16_CE_OUT[BF16_LOSS_SIZE] = {'+dump.tensor_to_string(ce_out.data.float())+'};\n')
+	f.write('PI_L2 float BF16_CE_OUT_DIFF[BF16_LOSS_SIZE] = {'+dump.tensor_to_string(ce_logits.grad.float())+'};\n')
+	f.write('PI_L2 float BF16_CE_LOSS = '+str(ce_loss.item())+'f;\n')
+	f.close()